@@ -27,6 +27,7 @@
 #include <kni.h>
 #include <string.h>
 #include <midpMalloc.h>
+#include <midpArena.h>
 #include <midpAMS.h>
 #include <midpStorage.h>
 #include <midpResourceLimit.h>
@@ -49,12 +50,22 @@
 #include <suitestore_icon_cache.h>
 #endif
 
+#if ENABLE_MONET
+#include <suitestore_installer.h>
+#endif
+
 /**
  * @file
  *
  * Used to initialize the midp runtime.
  */
 
+/**
+ * Number of objects allocated at once by each size class pool of the
+ * string memory tag, which the string conversion buffers are taken from.
+ */
+#define STRING_OBJECTS_PER_CHUNK 16
+
 static int initLevel = NO_INIT;
 
 static char* midpAppDir = NULL;
@@ -197,6 +208,10 @@ int midpInitCallback(int level, int (*init)(void), void (*final)(void)) {
             if (midpInitializeMemory(main_memory_chunk_size) != 0) {
                 break;
             }
+
+            /* Strings are converted on most native calls, pool them */
+            midpEnableSizeClasses(MIDP_MEM_TAG_STRING,
+                                  STRING_OBJECTS_PER_CHUNK);
             initLevel = MEM_LEVEL;
         }
 
@@ -253,6 +268,10 @@ int midpInitCallback(int level, int (*init)(void), void (*final)(void)) {
 
         if (level >= VM_LEVEL && initLevel < VM_LEVEL) {
             /* Do initialization for the next level: VM_LEVEL */
+#if ENABLE_MONET
+            /* the installer may still use the VM for an app image */
+            midp_wait_app_image_generation();
+#endif
             if (init != NULL) {
                 if (init() != 0) {
                     break;
@@ -290,6 +309,9 @@ void midpFinalize() {
         }
     }
 
+#if ENABLE_MONET
+    midp_wait_app_image_generation();
+#endif
 #if ENABLE_ICON_CACHE
     midp_free_suites_icons();
 #endif    
@@ -320,6 +342,8 @@ void midpFinalize() {
     pcsl_network_finalize_start(NULL);
 #endif
     midpAppDir = NULL;
+    midpReleaseSizeClasses(MIDP_MEM_TAG_STRING);
+    midpReportMemoryTags();
     midpFinalizeMemory();
 
     initLevel = NO_INIT;
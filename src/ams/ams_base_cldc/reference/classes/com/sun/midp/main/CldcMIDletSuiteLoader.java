@@ -24,9 +24,7 @@
 
 package com.sun.midp.main;
 
-import java.io.ByteArrayInputStream;
 import java.io.DataInputStream;
-import java.io.InputStream;
 
 import javax.microedition.io.Connector;
 
@@ -234,11 +232,9 @@ abstract class CldcMIDletSuiteLoader extends AbstractMIDletSuiteLoader {
                 DataInputStream dis = storage.openDataInputStream();
                 try {
                     dis.readFully(buffer);
-                    InputStream is = new ByteArrayInputStream(buffer);
                     jadProps = new JadProperties();
-                    jadProps.load(is, null);
+                    jadProps.load(buffer, null);
                     buffer = null;
-                    is = null;
                 } finally {
                     dis.close();
                 }
@@ -288,7 +284,7 @@ abstract class CldcMIDletSuiteLoader extends AbstractMIDletSuiteLoader {
             byte[] manifest =
                 JarReader.readJarEntry(jarPath, MIDletSuite.JAR_MANIFEST);
             jarProps = new ManifestProperties();
-            jarProps.load(new ByteArrayInputStream(manifest));
+            jarProps.load(manifest);
         } catch (Throwable t) {
             t.printStackTrace();
         }
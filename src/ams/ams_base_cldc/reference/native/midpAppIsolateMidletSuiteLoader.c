@@ -30,8 +30,10 @@
 
 #include <midpError.h>
 #include <midpMalloc.h>
+#include <midpArena.h>
 #include <midpEvents.h>
 #include <midpResourceLimit.h>
+#include <midpServices.h>
 
 /**
  * Native cleanup code, called when this isolate is done,
@@ -40,6 +42,7 @@
 KNIEXPORT KNI_RETURNTYPE_VOID
 KNIDECL(com_sun_midp_main_AppIsolateMIDletSuiteLoader_finalize) {
     midpFreeReservedResources();
+    midpArenaReleaseOwner(getCurrentIsolateId());
     KNI_ReturnVoid();
 }
 
@@ -96,6 +96,7 @@ KNIDECL(com_sun_midp_main_MIDletSuiteVerifier_useClassVerifier) {
 
 /**
  * Compare hash value of the JAR with provided hash value.
+ * The JAR is only hashed if it has changed since it was last verified.
  * <p>
  * Java declaration:
  * <pre>
@@ -110,8 +111,8 @@ KNIDECL(com_sun_midp_main_MIDletSuiteVerifier_useClassVerifier) {
  */
 KNIEXPORT KNI_RETURNTYPE_BOOLEAN
 KNIDECL(com_sun_midp_main_MIDletSuiteVerifier_checkJarHash) {
-    unsigned char *jar_hash = NULL;
-    int jar_hash_len = 0;
+    unsigned char *hash = NULL;
+    int hash_len;
     jboolean res = KNI_FALSE;
     int status;
 
@@ -119,18 +120,22 @@ KNIDECL(com_sun_midp_main_MIDletSuiteVerifier_checkJarHash) {
     KNI_DeclareHandle(hashValue);
     KNI_GetParameterAsObject(2, hashValue);
     GET_PARAMETER_AS_PCSL_STRING(1, jar_path) {
-        status = midp_get_file_hash(&jar_path, &jar_hash, &jar_hash_len);
-        if (status == MIDP_HASH_OK) {
-            unsigned char *hash = (unsigned char *)JavaByteArray(hashValue);
-            int hash_len = KNI_GetArrayLength(hashValue);
-            if (hash_len == jar_hash_len) {
-                res = (memcmp(jar_hash, hash, hash_len) == 0);
-            }
-            midpFree(jar_hash);
-        } else if (status == MIDP_HASH_IO_ERROR) {
-            KNI_ThrowNew(midpIOException, NULL);
-        } else {
+        /* Copy the expected value out of the Java heap before any I/O. */
+        hash_len = KNI_GetArrayLength(hashValue);
+        hash = (unsigned char *)midpMalloc(hash_len > 0 ? hash_len : 1);
+        if (hash == NULL) {
             KNI_ThrowNew(midpOutOfMemoryError, NULL);
+        } else {
+            KNI_GetRawArrayRegion(hashValue, 0, hash_len, (jbyte *)hash);
+            status = midp_check_file_hash(&jar_path, hash, hash_len);
+            if (status == MIDP_HASH_OK) {
+                res = KNI_TRUE;
+            } else if (status == MIDP_HASH_IO_ERROR) {
+                KNI_ThrowNew(midpIOException, NULL);
+            } else if (status == MIDP_HASH_OUT_OF_MEM_ERROR) {
+                KNI_ThrowNew(midpOutOfMemoryError, NULL);
+            }
+            midpFree(hash);
         }
     } RELEASE_PCSL_STRING_PARAMETER;
 
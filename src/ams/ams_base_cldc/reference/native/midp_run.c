@@ -163,7 +163,9 @@ void monitorHeap() {
 #if ENABLE_MONET
 /**
  * Convert Java classes to Monet bundle (In-Place Execution format)
- * upon the first run of a newly installed MIDletSuite.
+ * upon the first run of a newly installed MIDletSuite. Normally the
+ * installer has already created the bundle, then it is only put on
+ * the class path.
  *
  * @param userClassPath pointer to current classpath string.
  */
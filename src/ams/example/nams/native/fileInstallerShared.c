@@ -166,6 +166,185 @@ void convertJChar2Char(jchar* jchar_buf, char* char_buf, int jchar_buf_size) {
     }
 }/* end of convertJChar2Char */
 
+/**
+ * Decodes the next logical line of a JAD or a manifest straight from the
+ * raw file data. Line breaks are CR, LF or CR LF; blank lines and lines
+ * starting with '#' are skipped. UTF-8 sequences are decoded as the line
+ * is scanned; a byte that does not start a well-formed sequence is taken
+ * as a single ISO-8859-1 character.
+ *
+ * @param pPos pointer to the current position in the file data; it is
+ *             moved past the line that was read
+ * @param end end of the file data
+ * @param isManifest if true, a line break followed by a space continues
+ *                   the line and lines starting with a space are skipped
+ * @param line buffer for the decoded line; it must hold at least as many
+ *             jchars as there are bytes between *pPos and end
+ * @return length of the line in jchars, or -1 if the end of the data
+ *         has been reached
+ */
+int readDescriptorLine(const unsigned char** pPos, const unsigned char* end,
+                       jboolean isManifest, jchar* line) {
+    const unsigned char* p = *pPos;
+    unsigned long c;
+    int skip;
+    int len;
+
+    do {
+        if (p >= end) {
+            *pPos = p;
+            return -1;
+        }
+
+        skip = (*p == RESHET || *p == CR || *p == LF ||
+                (isManifest && *p == SP));
+        len = 0;
+
+        while (p < end) {
+            c = *p++;
+
+            if (c == CR || c == LF) {
+                if (c == CR && p < end && *p == LF) {
+                    p++;
+                }
+
+                if (isManifest && p < end && *p == SP) {
+                    /* continuation: drop the line break and the space */
+                    p++;
+                    continue;
+                }
+
+                break;
+            }
+
+            if (c >= 0xC0) {
+                if (c < 0xE0 && p < end && (p[0] & 0xC0) == 0x80) {
+                    c = ((c & 0x1F) << 6) | (p[0] & 0x3F);
+                    p++;
+                } else if (c < 0xF0 && end - p >= 2 &&
+                           (p[0] & 0xC0) == 0x80 && (p[1] & 0xC0) == 0x80) {
+                    c = ((c & 0x0F) << 12) | ((p[0] & 0x3F) << 6) |
+                        (p[1] & 0x3F);
+                    p += 2;
+                } else if (c < 0xF8 && end - p >= 3 &&
+                           (p[0] & 0xC0) == 0x80 && (p[1] & 0xC0) == 0x80 &&
+                           (p[2] & 0xC0) == 0x80) {
+                    c = ((c & 0x07) << 18) | ((p[0] & 0x3F) << 12) |
+                        ((p[1] & 0x3F) << 6) | (p[2] & 0x3F);
+                    p += 3;
+
+                    /* four bytes in, two jchars out: a surrogate pair */
+                    c -= 0x10000;
+                    line[len++] = (jchar)(0xD800 | (c >> 10));
+                    c = 0xDC00 | (c & 0x3FF);
+                }
+            }
+
+            line[len++] = (jchar)c;
+        }
+    } while (skip);
+
+    *pPos = p;
+    return len;
+} /* end of readDescriptorLine */
+
+/**
+ * Splits a decoded descriptor line into a key and a value, both trimmed
+ * of leading and trailing white space. Nothing is copied; the results
+ * point into the line.
+ *
+ * @param line decoded line
+ * @param len length of the line
+ * @param pKey receives the start of the key
+ * @param pKeyLen receives the length of the key
+ * @param pValue receives the start of the value
+ * @param pValueLen receives the length of the value
+ * @return 0 on success, -1 if there is no ':' or it starts the line
+ */
+int splitDescriptorLine(const jchar* line, int len,
+                        const jchar** pKey, int* pKeyLen,
+                        const jchar** pValue, int* pValueLen) {
+    int colon;
+    int start;
+    int stop;
+
+    for (colon = 0; colon < len && line[colon] != ':'; colon++) {
+    }
+
+    if (colon <= 0 || colon == len) {
+        return -1;
+    }
+
+    for (start = 0; start < colon && line[start] <= SP; start++) {
+    }
+    for (stop = colon; stop > start && line[stop - 1] <= SP; stop--) {
+    }
+    *pKey = line + start;
+    *pKeyLen = stop - start;
+
+    for (start = colon + 1; start < len && line[start] <= SP; start++) {
+    }
+    for (stop = len; stop > start && line[stop - 1] <= SP; stop--) {
+    }
+    *pValue = line + start;
+    *pValueLen = stop - start;
+
+    return 0;
+} /* end of splitDescriptorLine */
+
+/**
+ * Appends a key/value pair to a property list, growing the list as
+ * needed. Only here are strings created for the key and the value.
+ *
+ * @param pProps property list; numberOfProperties is the number of
+ *               pairs stored so far
+ * @param pCapacity pointer to the number of pairs pStringArr has room
+ *                  for; updated when the list grows
+ * @param key start of the key
+ * @param keyLen length of the key
+ * @param value start of the value
+ * @param valueLen length of the value
+ * @return ALL_OK or OUT_OF_MEMORY
+ */
+MIDPError addDescriptorProperty(MidpProperties* pProps, int* pCapacity,
+                                const jchar* key, int keyLen,
+                                const jchar* value, int valueLen) {
+    pcsl_string* pStrings;
+    int i;
+
+    if (pProps->numberOfProperties == *pCapacity) {
+        int newCapacity = (*pCapacity < 16) ? 16 : *pCapacity * 2;
+
+        pStrings = alloc_pcsl_string_list(newCapacity * 2);
+        if (pStrings == NULL) {
+            return OUT_OF_MEMORY;
+        }
+
+        for (i = 0; i < pProps->numberOfProperties * 2; i++) {
+            pStrings[i] = pProps->pStringArr[i];
+        }
+
+        midpFree(pProps->pStringArr);
+        pProps->pStringArr = pStrings;
+        *pCapacity = newCapacity;
+    }
+
+    pStrings = pProps->pStringArr + pProps->numberOfProperties * 2;
+    if (PCSL_STRING_OK !=
+            pcsl_string_convert_from_utf16(key, keyLen, &pStrings[0])) {
+        return OUT_OF_MEMORY;
+    }
+
+    if (PCSL_STRING_OK !=
+            pcsl_string_convert_from_utf16(value, valueLen, &pStrings[1])) {
+        pcsl_string_free(&pStrings[0]);
+        return OUT_OF_MEMORY;
+    }
+
+    pProps->numberOfProperties++;
+    return ALL_OK;
+} /* end of addDescriptorProperty */
+
 /**
  * Version string may looks like Major:Minor:Micro
  *
@@ -187,6 +187,56 @@ void convertChar2JChar(char* char_buf, jchar* jchar_buf, int char_buf_size);
  */
 void convertJChar2Char(jchar* jchar_buf, char* char_buf, int jchar_buf_size);
 
+/**
+ * Decodes the next logical line of a JAD or a manifest straight from the
+ * raw file data: UTF-8 decoding, line breaks, comments and, for a
+ * manifest, continuation lines are handled in the same scan.
+ *
+ * @param pPos pointer to the current position in the file data; it is
+ *             moved past the line that was read
+ * @param end end of the file data
+ * @param isManifest if true, a line break followed by a space continues
+ *                   the line
+ * @param line buffer for the decoded line; it must hold at least as many
+ *             jchars as there are bytes between *pPos and end
+ * @return length of the line in jchars, or -1 at the end of the data
+ */
+int readDescriptorLine(const unsigned char** pPos, const unsigned char* end,
+                       jboolean isManifest, jchar* line);
+
+/**
+ * Splits a decoded descriptor line into a trimmed key and value that
+ * point into the line.
+ *
+ * @param line decoded line
+ * @param len length of the line
+ * @param pKey receives the start of the key
+ * @param pKeyLen receives the length of the key
+ * @param pValue receives the start of the value
+ * @param pValueLen receives the length of the value
+ * @return 0 on success, -1 if there is no ':' or it starts the line
+ */
+int splitDescriptorLine(const jchar* line, int len,
+                        const jchar** pKey, int* pKeyLen,
+                        const jchar** pValue, int* pValueLen);
+
+/**
+ * Appends a key/value pair to a property list, growing the list as
+ * needed.
+ *
+ * @param pProps property list; numberOfProperties is the number of
+ *               pairs stored so far
+ * @param pCapacity pointer to the number of pairs the list has room for
+ * @param key start of the key
+ * @param keyLen length of the key
+ * @param value start of the value
+ * @param valueLen length of the value
+ * @return ALL_OK or OUT_OF_MEMORY
+ */
+MIDPError addDescriptorProperty(MidpProperties* pProps, int* pCapacity,
+                                const jchar* key, int keyLen,
+                                const jchar* value, int valueLen);
+
 /**
  * Opens a file and fills the content of the file in the result_buf. <BR>
  * This function made memory allocation inside.
@@ -78,79 +78,42 @@ static MidpProperties verifyJadMustProperties(MidpProperties jadsmp);
  * This method will try to continue after a format error and load as
  * many properties it can, but return the last error encountered.
  *
- * @param jchar_buffer Buffer of jchars that contains jad file data
- *                     (null-terminated jchars string)
+ * @param jadbuf raw UTF-8 jad file data
+ * @param jadsize size of the jad file data in bytes
  * @return MidpProperties structure filled with keys and values from the jad
  */
-static MidpProperties midpParseJad(jchar* jchar_buffer);
-
-/**
- * Reads a line from a jad file.
- *
- * @param jadbuf pointer to the jad jchar_buffer; this pointer will move to
- *               the next line
- * @param result pointer to pcsl_string where the new line from jad file
- *               will be stored, the caller is responsible for freeing this
- *               string
- * @return error code
- */
-static MIDPError readJadLine(jchar** jadbuf, pcsl_string * result);
+static MidpProperties midpParseJad(const unsigned char* jadbuf, int jadsize);
 
 /**
  * Check to see if all the chars in the key of a property are valid.
  *
- * @param jadkey key to check
+ * @param key key to check
+ * @param len length of the key
  * @return BAD_JAD_KEY if a character is not valid for a key
  */
-static MIDPError checkJadKeyChars(const pcsl_string * jadkey);
+static MIDPError checkJadKeyChars(const jchar* key, int len);
 
 /**
  * Check to see if all the chars in the value of a property are valid.
  *
- * @param jadvalue value to check
+ * @param value value to check
+ * @param len length of the value
  * @return BAD_JAD_VALUE if a character is not valid for a value
  */
-static MIDPError checkJadValueChars(const pcsl_string * jadvalue);
-
-/**
- * Counts a lines in jad file. Skips commented out and blank lines.
- *
- * @param buf buffer that contains the jad file
- * @return number of lines
- */
-static int count_jad_lines(jchar* buf);
+static MIDPError checkJadValueChars(const jchar* value, int len);
 
 MidpProperties jad_main(char* jadbuf, int jadsize) {
 
     MidpProperties jadsmp = {0,ALL_OK,NULL};
-    jchar* jchar_buffer = NULL;
-    jchar* save_jchar_buffer = NULL;
-    int jbufsize = -1;
 #if REPORT_LEVEL <= LOG_INFORMATION
     int res = 0;
 #endif
-    jbufsize = jadsize * sizeof(jchar);
-
-    jchar_buffer = (jchar*)midpMalloc(jbufsize+2);
-    if (!jchar_buffer) {
-        midpFree(jadbuf);
-        jadsmp.status = OUT_OF_MEMORY;
-        return jadsmp;
-    }
-    memset(jchar_buffer,0,(jbufsize + 2));
-
-    convertChar2JChar(jadbuf,jchar_buffer,jadsize);
-    midpFree(jadbuf);
-    save_jchar_buffer = jchar_buffer;
-
-
 
     REPORT_INFO(LC_AMS, "####################### Start JAD parsing");
 
-    /* during execution of this function jadbuf pointer will be changed
-       status will be set during midpParseJad() execution */
-    jadsmp = midpParseJad(jchar_buffer);
-    midpFree(save_jchar_buffer);
+    /* status will be set during midpParseJad() execution */
+    jadsmp = midpParseJad((const unsigned char*)jadbuf, jadsize);
+    midpFree(jadbuf);
     switch (jadsmp.status) {
     case OUT_OF_STORAGE:
         REPORT_WARN1(LC_AMS, "OUT_OF_STORAGE by JAD %d", jadsmp.status);
@@ -238,161 +201,93 @@ MidpProperties jad_main(char* jadbuf, int jadsize) {
  * This method will try to continue after a format error and load as
  * many properties it can, but return the last error encountered.
  *
- * @param jchar_buffer Buffer of jchars that contains jad file data
- *                     (null-terminated jchars string)
+ * @param jadbuf raw UTF-8 jad file data
+ * @param jadsize size of the jad file data in bytes
  * @return MidpProperties structure filled with keys and values from the jad
  */
 
-static MidpProperties midpParseJad(jchar* jchar_buffer) {
+static MidpProperties midpParseJad(const unsigned char* jadbuf, int jadsize) {
     MidpProperties jadsmp = {0, ALL_OK, NULL};
-    pcsl_string jadkey;
-    pcsl_string jadkey_trimmed;
-    pcsl_string jadvalue;
-    pcsl_string jadvalue_trimmed;
-    pcsl_string jadline;
+    const unsigned char* end;
+    jchar* line;
+    const jchar* key;
+    const jchar* value;
+    int lineLen;
+    int keyLen;
+    int valueLen;
+    int capacity = 0;
     MIDPError err;
-    pcsl_string_status rc;
-
-    int countLines = 0;
-    jint index = 0;
-    int count = 0;
 
-    if (!jchar_buffer) {
+    if (!jadbuf || jadsize <= 0) {
         jadsmp.status = BAD_PARAMS;
         return jadsmp;
     }
 
-    countLines = count_jad_lines(jchar_buffer);
-
-    if (countLines <= 0) {
-        REPORT_INFO(LC_AMS, "midpParseJad(): Empty jad file.");
-        jadsmp.status = OUT_OF_MEMORY;
-        return jadsmp;
-    }
-
-    jadsmp.pStringArr = alloc_pcsl_string_list(countLines * 2);
-    if (jadsmp.pStringArr == NULL) {
+    /* one decoded jchar never takes less than one byte of UTF-8 */
+    line = (jchar*)midpMalloc(jadsize * sizeof (jchar));
+    if (line == NULL) {
         jadsmp.status = OUT_OF_MEMORY;
         return jadsmp;
     }
 
-    jadsmp.numberOfProperties = countLines;
+    end = jadbuf + jadsize;
 
-    for (count = 0; count < countLines * 2 ;
-        /* count increased at the end of for */ ) {
-        /* memory for the line is allocated here */
-        err = readJadLine(&jchar_buffer, &jadline);
-        if (OUT_OF_MEMORY == err) {
-            midp_free_properties(&jadsmp);
-            jadsmp.status = OUT_OF_MEMORY;
-            return jadsmp;
-        } else if (END_OF_JAD == err) {
+    for (;;) {
+        lineLen = readDescriptorLine(&jadbuf, end, KNI_FALSE, line);
+        if (lineLen < 0) {
             /* we are done */
-            jadsmp.status = ALL_OK;
             break;
         }
 
-        index = pcsl_string_index_of(&jadline, ':');
-        if (index <= 0) {
+        if (splitDescriptorLine(line, lineLen, &key, &keyLen,
+                                &value, &valueLen) != 0) {
             jadsmp.status = BAD_JAD_KEY;
-            pcsl_string_free(&jadline);
             continue;
         }
 
-        /* memory for key is allocated here */
-        if (PCSL_STRING_OK !=
-            pcsl_string_substring(&jadline, 0, index, &jadkey)) {
-            midp_free_properties(&jadsmp);
-            jadsmp.status = OUT_OF_MEMORY;
-            pcsl_string_free(&jadline);
-            return jadsmp;
-        }
-
-        rc = pcsl_string_trim(&jadkey, &jadkey_trimmed);
-        pcsl_string_free(&jadkey);
-        if (PCSL_STRING_OK != rc) {
-            jadsmp.status = OUT_OF_MEMORY;
-            midp_free_properties(&jadsmp);
-            pcsl_string_free(&jadline);
-            return jadsmp;
-        }
-
-        if (pcsl_string_length(&jadkey_trimmed) < 1) {
+        if (keyLen < 1) {
             jadsmp.status = BAD_PARAMS;
-            pcsl_string_free(&jadline);
-            pcsl_string_free(&jadkey_trimmed);
             continue;
         }
 
-        err = checkJadKeyChars(&jadkey_trimmed);
-        if (OUT_OF_MEMORY == err) {
-            jadsmp.status = OUT_OF_MEMORY;
-            midp_free_properties(&jadsmp);
-            pcsl_string_free(&jadline);
-            pcsl_string_free(&jadkey_trimmed);
-            return jadsmp;
-        } else if (BAD_JAD_KEY == err) {
+        if (checkJadKeyChars(key, keyLen) != ALL_OK) {
             jadsmp.status = BAD_JAD_KEY;
-            pcsl_string_free(&jadline);
-            pcsl_string_free(&jadkey_trimmed);
             continue;
         }
 
-        rc = pcsl_string_substring(&jadline, index + 1,
-                                   pcsl_string_length(&jadline), &jadvalue);
-        /* free the jadline once we have got the key and value */
-        pcsl_string_free(&jadline);
-        if (PCSL_STRING_OK != rc) {
-            jadsmp.status = OUT_OF_MEMORY;
-            midp_free_properties(&jadsmp);
-            pcsl_string_free(&jadkey_trimmed);
-            return jadsmp;
-        }
-
-        /* memory for value is allocated here */
-        rc = pcsl_string_trim(&jadvalue, &jadvalue_trimmed);
-        pcsl_string_free(&jadvalue);
-        if (PCSL_STRING_OK != rc) {
-            jadsmp.status = OUT_OF_MEMORY;
-            midp_free_properties(&jadsmp);
-            pcsl_string_free(&jadkey_trimmed);
-            return jadsmp;
-        }
-        if (pcsl_string_is_null(&jadvalue_trimmed)) {
+        if (valueLen < 1) {
             jadsmp.status = NULL_LEN;
-            pcsl_string_free(&jadkey_trimmed);
             continue;
         }
 
-        err = checkJadValueChars(&jadvalue_trimmed);
-        if (OUT_OF_MEMORY == err) {
-            jadsmp.status = OUT_OF_MEMORY;
-            midp_free_properties(&jadsmp);
-            pcsl_string_free(&jadkey_trimmed);
-            pcsl_string_free(&jadvalue_trimmed);
-            return jadsmp;
-        } else if (BAD_JAD_VALUE == err) {
+        if (checkJadValueChars(value, valueLen) != ALL_OK) {
             jadsmp.status = BAD_JAD_VALUE;
-            pcsl_string_free(&jadkey_trimmed);
-            pcsl_string_free(&jadvalue_trimmed);
             continue;
         }
 
-        printPcslStringWithMessage("midpParseJad()", &jadkey_trimmed);
-        printPcslStringWithMessage("midpParseJad()", &jadvalue_trimmed);
-
         /* Store key:value pair. */
-        jadsmp.pStringArr[count] = jadkey_trimmed;
-        jadsmp.pStringArr[count+1] = jadvalue_trimmed;
-
-        count += 2;
+        err = addDescriptorProperty(&jadsmp, &capacity, key, keyLen,
+                                    value, valueLen);
+        if (err != ALL_OK) {
+            midpFree(line);
+            midp_free_properties(&jadsmp);
+            jadsmp.status = OUT_OF_MEMORY;
+            return jadsmp;
+        }
     } /* end of for */
 
+    midpFree(line);
+
+    if (jadsmp.numberOfProperties == 0) {
+        REPORT_INFO(LC_AMS, "midpParseJad(): Empty jad file.");
+        jadsmp.status = OUT_OF_MEMORY;
+        return jadsmp;
+    }
+
     jadsmp = verifyJadMustProperties(jadsmp);
 
-    REPORT_INFO3(LC_AMS,
-                 "End jad parsing. Status=%d, count=%d, countLines=%d.",
-                 jadsmp.status, count, countLines);
+    REPORT_INFO2(LC_AMS, "End jad parsing. Status=%d, count=%d.",
+                 jadsmp.status, jadsmp.numberOfProperties);
 
     return jadsmp;
 } /* end of midpParseJad */
@@ -472,186 +367,67 @@ static MidpProperties verifyJadMustProperties(MidpProperties jadsmp) {
 /**
  * Check to see if all the chars in the key of a property are valid.
  *
- * @param jadkey key to check
+ * @param key key to check
+ * @param len length of the key
  * @return BAD_JAD_KEY if a character is not valid for a key
  */
-static MIDPError checkJadKeyChars(const pcsl_string * jadkey) {
+static MIDPError checkJadKeyChars(const jchar* key, int len) {
     jchar current;
-    int i = 0;
-    MIDPError err = ALL_OK;
-
-    GET_PCSL_STRING_DATA_AND_LENGTH(jadkey)
-    if (PCSL_STRING_PARAMETER_ERROR(jadkey)) {
-        err = OUT_OF_MEMORY;
-    } else {
-        while (i < jadkey_len) {
-            current = jadkey_data[i];
-            if (current <= 0x1F
-             || current == 0x7F
-             || current == '('
-             || current == ')'
-             || current == '<'
-             || current == '>'
-             || current == '@'
-             || current == ','
-             || current == ';'
-             || current == '\''
-             || current == '"'
-             || current == '/'
-             || current == '['
-             || current == ']'
-             || current == '?'
-             || current == '='
-             || current == '{'
-             || current == '}'
-             || current == SP
-             || current == HT) {
-                printPcslStringWithMessage("checkJadKeyChars: BAD_JAD_KEY ",
-                                           jadkey);
-                err = BAD_JAD_KEY;
-                break;
-            }
-            i++;
-        } /* end of while */
-    }
-    RELEASE_PCSL_STRING_DATA_AND_LENGTH
+    int i;
+
+    for (i = 0; i < len; i++) {
+        current = key[i];
+        if (current <= 0x1F
+         || current == 0x7F
+         || current == '('
+         || current == ')'
+         || current == '<'
+         || current == '>'
+         || current == '@'
+         || current == ','
+         || current == ';'
+         || current == '\''
+         || current == '"'
+         || current == '/'
+         || current == '['
+         || current == ']'
+         || current == '?'
+         || current == '='
+         || current == '{'
+         || current == '}'
+         || current == SP
+         || current == HT) {
+            REPORT_INFO1(LC_AMS, "checkJadKeyChars: BAD_JAD_KEY at %d", i);
+            return BAD_JAD_KEY;
+        }
+    } /* end of for */
 
-    return err;
+    return ALL_OK;
 }
 
 /**
  * Check to see if all the chars in the value of a property are valid.
  *
  * @param value value to check
+ * @param len length of the value
  * @return BAD_JAD_VALUE if a character is not valid for a value
  */
-static MIDPError checkJadValueChars(const pcsl_string * jadvalue) {
+static MIDPError checkJadValueChars(const jchar* value, int len) {
     jchar current;
-    int i = 0;
-    MIDPError err = ALL_OK;
-
-    GET_PCSL_STRING_DATA_AND_LENGTH(jadvalue)
-    if (PCSL_STRING_PARAMETER_ERROR(jadvalue)) {
-        err = OUT_OF_MEMORY;
-    } else {
-        while (i < jadvalue_len) {
-            current = jadvalue_data[i];
-            /* if current is a CTL character, return an error */
-            if ((current <= 0x1F || current == 0x7F) && (current != HT)) {
-                printPcslStringWithMessage("checkJadValueChars: BAD_JAD_VALUE ",
-                                           jadvalue);
-                err = BAD_JAD_VALUE;
-                break;
-            }
-            i++;
-        } /* end of while */
-    }
-    RELEASE_PCSL_STRING_DATA_AND_LENGTH
-
-    return err;
-}
-
-
-/**
- * Counts a lines in jad file. Skips commented out and blank lines.
- *
- * @param buf jad file data
- * @return number of lines
- */
-/* IMPL NOTE: Looks like this function counts one line extra sometime. why ? */
-static int count_jad_lines(jchar* buf) {
-    int numberOfLines = 0;
-
-    if ((!buf) || (!*buf)) {
-        return -1;
-    }
-
-    while (*buf) {
-        /* skip commented out lines and lines that start with space */
-        if (COMMENTED_OUT(buf)) {
-            /* run to the end of line */
-            while (!NEW_LINE(buf)) {
-                buf++;
-            }
-            /* skip all the new line characters an the end of line */
-            while (NEW_LINE(buf)) {
-                buf++;
-            }
-        } else {
-            numberOfLines++;
-            while (!NEW_LINE(buf)) {
-                buf++;
-            }
-            while (NEW_LINE(buf)) {
-                buf++;
-            }
+    int i;
+
+    for (i = 0; i < len; i++) {
+        current = value[i];
+        /* if current is a CTL character, return an error */
+        if ((current <= 0x1F || current == 0x7F) && (current != HT)) {
+            REPORT_INFO1(LC_AMS, "checkJadValueChars: BAD_JAD_VALUE at %d",
+                         i);
+            return BAD_JAD_VALUE;
         }
-    } /* end of while */
-
-    return numberOfLines;
-} /* end of count_jad_lines */
-
-/**
- * Reads a line from a jad file.
- *
- * @param jadbuf pointer to the jad jchar_buffer; this pointer will move to
- *               the next line
- * @param result pointer to pcsl_string where the new line from jad file
- *               will be stored, the caller is responsible for freeing this
- *               string
- * @return error code
- */
-static MIDPError readJadLine(jchar** jadbuf, pcsl_string * result) {
-
-    jchar* lineStart = NULL;
-    jchar* p = NULL;
-    int count = 0;
-
-    /* will use p to avoid all the *(*jadbuf) stuff and make it more readable */
-    p = (*jadbuf);
-
-    if (!(*p)) {
-        /* end of jchar_buffer */
-        *result = PCSL_STRING_NULL;
-        return END_OF_JAD;
-    }
-
-    /* skip commented out and blank lines */
-    while (COMMENTED_OUT(p) || NEW_LINE(p)) {
-        while (!NEW_LINE(p)) {
-            /* skip commented out line */
-            p++;
-        }
-        while (NEW_LINE(p)) {
-            /* skip new line */
-            p++;
-        }
-    }
-
-    lineStart = p;
-
-    for (;*p ; ) {
-        count++;
-        p++;
-        if (NEW_LINE(p)) {
-            *p = 0x00; /* cut the line */
-            if (*(p+1)) { /* if not end of jchar_buffer */
-                p++; /* point to the next line beginning */
-                break;
-            } /* end of if */
-        } /* end of if */
     } /* end of for */
 
-    /* move jadbuf to point to the next line */
-    (*jadbuf) = p;
-
-    if (PCSL_STRING_OK !=
-        pcsl_string_convert_from_utf16(lineStart, count, result)) {
-        return OUT_OF_MEMORY;
-    }
-
     return ALL_OK;
-} /* end of readJadLine */
+}
 
 /**
  * Opens a file and fills the content of the file in the result_buf. <BR>
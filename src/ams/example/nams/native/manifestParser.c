@@ -61,65 +61,37 @@
 static MidpProperties verifyMfMustProperties(MidpProperties mfsmp);
 
 /**
- * Takes a jchar buffer with converted manifest there and parses it.<BR>
- * jchar_buffer should be allocated and freed outside of this function.
- * jchar_buffer pointer will be changed during parsing.
- * This pointer should be saved before execution to allow memory freeing after.
+ * Parses a manifest straight from the raw file data in a single scan;
+ * continuation lines are joined and UTF-8 is decoded as each line is
+ * read, and strings are only created for the keys and values kept.
  *
- * @param jchar_buffer Buffer with manifest converted to jchars.
+ * @param mfbuf raw UTF-8 manifest data
+ * @param mflength size of the manifest data in bytes
  * @return MidpProperties struct filled with parsed manifest key:value fields.
  */
-static MidpProperties midpParseMf(jchar* jchar_buffer);
-
-/**
- * Reads a line from a manifest file. Compacts continuation lines.<BR>
- * (Allocates memory for this line.)
- *
- * @param mfbuf  pointer to the manifest jchar_buffer; this pointer will move to
- *               the next line
- * @param result pointer to pcsl_string where the new line from manifest
- *               will be stored
- * @return error code
- */
-static MIDPError readMfLine(jchar** mfbuf, pcsl_string * result);
+static MidpProperties midpParseMf(const unsigned char* mfbuf, int mflength);
 
 /**
  * Check to see if all the chars in the value of a property are valid.
  *
- * @param mfvalue value to check
+ * @param value value to check
+ * @param len length of the value
  * @return BAD_MF_VALUE if a character is not valid for a value
  */
-static MIDPError checkMfValueChars(const pcsl_string * mfvalue);
+static MIDPError checkMfValueChars(const jchar* value, int len);
 
 /**
  * Check to see if all the chars in the key of a property are valid.
  *
- * @param mfkey key to check
+ * @param key key to check
+ * @param len length of the key
  * @return BAD_MF_KEY if a character is not valid for a key
  */
-static MIDPError checkMfKeyChars(const pcsl_string * mfkey);
-
-/**
- * Counts a lines in manifest file. Skips commented out and blank lines.
- * If Manifest contains a line like:
- * #key : vaaaaaaaaaallll
- *  ue
- * I mean line with broken line with new line and space when only
- * the first line was commented out.
- * In this case second line will be skipped too.
- *
- * @param buf    Pointer to the buffer that contains a Manifest.
- *               Manifest should be already parsed to jchars.
- * @return Number of valid lines in Manifest.
- */
-static int count_mf_lines(jchar* buf);
+static MIDPError checkMfKeyChars(const jchar* key, int len);
 
 MidpProperties mf_main(char* mfbuf, int mflength) {
 
     MidpProperties mfsmp      = {0, ALL_OK, NULL};
-    jchar* save_jchar_buffer  = NULL;
-    jchar* jchar_buffer       = NULL;
-    int jbufsize              = -1;
 #if REPORT_LEVEL <= LOG_INFORMATION
     int res                   = 0;
 #endif
@@ -128,28 +100,11 @@ MidpProperties mf_main(char* mfbuf, int mflength) {
         return mfsmp;
     }
 
-    jbufsize = mflength * sizeof(jchar);
-
-    jchar_buffer = (jchar*)midpMalloc(jbufsize+2);
-    if (!jchar_buffer) {
-        midpFree(mfbuf);
-        mfsmp.status = OUT_OF_MEMORY;
-        return mfsmp;
-    }
-    memset(jchar_buffer,0,(jbufsize + 2));
-
-    convertChar2JChar(mfbuf,jchar_buffer,mflength);
-
-    midpFree(mfbuf);
-
-    save_jchar_buffer = jchar_buffer;
-
     REPORT_INFO(LC_AMS,
 		"#########################  Start of manifest parsing");
 
-    /* during execution of this, jchar_buffer pointer will be changed */
-    mfsmp = midpParseMf(jchar_buffer);
-    midpFree(save_jchar_buffer);
+    mfsmp = midpParseMf((const unsigned char*)mfbuf, mflength);
+    midpFree(mfbuf);
     switch (mfsmp.status) {
 
     case NO_SUITE_NAME_PROP:
@@ -210,157 +165,89 @@ MidpProperties mf_main(char* mfbuf, int mflength) {
     return mfsmp;
 } /* end of mf_main */
 
-static MidpProperties midpParseMf(jchar* jchar_buffer) {
+static MidpProperties midpParseMf(const unsigned char* mfbuf, int mflength) {
 
     MidpProperties mfsmp = {0, ALL_OK, NULL};
-    pcsl_string mfkey;
-    pcsl_string mfkey_trimmed;
-    pcsl_string mfvalue;
-    pcsl_string mfvalue_trimmed;
-    pcsl_string mfline;
+    const unsigned char* end;
+    jchar* line;
+    const jchar* key;
+    const jchar* value;
+    int lineLen;
+    int keyLen;
+    int valueLen;
+    int capacity = 0;
     MIDPError err;
-    pcsl_string_status rc;
-
-    int countLines = 0;
-    int index = 0;
-    int count = 0;
 
-    if (!jchar_buffer) {
+    if (!mfbuf) {
         mfsmp.status = BAD_PARAMS;
         return mfsmp;
     }
 
-    countLines = count_mf_lines(jchar_buffer);
-
-    if (countLines <= 0) {
-        REPORT_INFO(LC_AMS, "midpParseMf(): Empty manifest.");
-        mfsmp.status = OUT_OF_MEMORY;
-        return mfsmp;
-    }
-
-    mfsmp.pStringArr = alloc_pcsl_string_list(countLines * 2);
-    if (mfsmp.pStringArr == NULL) {
+    /* one decoded jchar never takes less than one byte of UTF-8 */
+    line = (jchar*)midpMalloc(mflength * sizeof (jchar));
+    if (line == NULL) {
         mfsmp.status = OUT_OF_MEMORY;
         return mfsmp;
     }
 
-    mfsmp.numberOfProperties = countLines;
+    end = mfbuf + mflength;
 
-    for (count = 0; count < countLines * 2 ;
-         /* count increased at the end of for */ ) {
-        /* memory for the line is allocated here */
-        /* line continuation striped out */
-        err = readMfLine(&jchar_buffer, &mfline);
-        if (OUT_OF_MEMORY == err) {
-            midp_free_properties(&mfsmp);
-            mfsmp.status = OUT_OF_MEMORY;
-            return mfsmp;
-        } else if (END_OF_MF == err) {
+    for (;;) {
+        /* line continuation stripped out */
+        lineLen = readDescriptorLine(&mfbuf, end, KNI_TRUE, line);
+        if (lineLen < 0) {
             /* we are done */
-            mfsmp.status = ALL_OK;
             break;
         }
 
-        index = pcsl_string_index_of(&mfline, ':');
-        if (index <= 0) {
+        if (splitDescriptorLine(line, lineLen, &key, &keyLen,
+                                &value, &valueLen) != 0) {
             mfsmp.status = BAD_MF_KEY;
-            pcsl_string_free(&mfline);
             continue;
         }
 
-        /* memory for mfkey is allocated here */
-        if (PCSL_STRING_OK !=
-            pcsl_string_substring(&mfline, 0, index, &mfkey)) {
-            midp_free_properties(&mfsmp);
-            mfsmp.status = OUT_OF_MEMORY;
-            pcsl_string_free(&mfline);
-            return mfsmp;
-        }
-
-        rc = pcsl_string_trim(&mfkey, &mfkey_trimmed);
-        pcsl_string_free(&mfkey);
-        if (PCSL_STRING_OK != rc) {
-            mfsmp.status = OUT_OF_MEMORY;
-            midp_free_properties(&mfsmp);
-            pcsl_string_free(&mfline);
-            return mfsmp;
-        }
-
-        if (pcsl_string_length(&mfkey_trimmed) < 1) {
+        if (keyLen < 1) {
             mfsmp.status = BAD_PARAMS;
-            pcsl_string_free(&mfline);
-            pcsl_string_free(&mfkey_trimmed);
             continue;
         }
 
-        err = checkMfKeyChars(&mfkey_trimmed);
-        if (OUT_OF_MEMORY == err) {
-            mfsmp.status = OUT_OF_MEMORY;
-            midp_free_properties(&mfsmp);
-            pcsl_string_free(&mfline);
-            pcsl_string_free(&mfkey_trimmed);
-            return mfsmp;
-        } else if (BAD_MF_KEY == err) {
+        if (checkMfKeyChars(key, keyLen) != ALL_OK) {
             mfsmp.status = BAD_MF_KEY;
-            pcsl_string_free(&mfline);
-            pcsl_string_free(&mfkey_trimmed);
             continue;
         }
 
-        rc = pcsl_string_substring(&mfline, index + 1,
-                                   pcsl_string_length(&mfline), &mfvalue);
-        /* free the mfline once we have got the key and value */
-        pcsl_string_free(&mfline);
-        if (PCSL_STRING_OK != rc) {
-            mfsmp.status = OUT_OF_MEMORY;
-            midp_free_properties(&mfsmp);
-            pcsl_string_free(&mfkey_trimmed);
-            return mfsmp;
-        }
-
-        /* memory for value is allocated here */
-        rc = pcsl_string_trim(&mfvalue, &mfvalue_trimmed);
-        pcsl_string_free(&mfvalue);
-        if (PCSL_STRING_OK != rc) {
-            mfsmp.status = OUT_OF_MEMORY;
-            midp_free_properties(&mfsmp);
-            pcsl_string_free(&mfkey_trimmed);
-            return mfsmp;
-        }
-        if (pcsl_string_is_null(&mfvalue_trimmed)) {
+        if (valueLen < 1) {
             mfsmp.status = NULL_LEN;
-            pcsl_string_free(&mfkey_trimmed);
             continue;
         }
 
-        err = checkMfValueChars(&mfvalue_trimmed);
-        if (OUT_OF_MEMORY == err) {
-            mfsmp.status = OUT_OF_MEMORY;
-            midp_free_properties(&mfsmp);
-            pcsl_string_free(&mfkey_trimmed);
-            pcsl_string_free(&mfvalue_trimmed);
-            return mfsmp;
-        } else if (BAD_MF_VALUE == err) {
+        if (checkMfValueChars(value, valueLen) != ALL_OK) {
             mfsmp.status = BAD_MF_VALUE;
-            pcsl_string_free(&mfkey_trimmed);
-            pcsl_string_free(&mfvalue_trimmed);
             continue;
         }
 
-        printPcslStringWithMessage("midpParseMf()", &mfkey_trimmed);
-        printPcslStringWithMessage(" = ", &mfvalue_trimmed);
-
         /* Store key:value pair. */
-        mfsmp.pStringArr[count] = mfkey_trimmed;
-        mfsmp.pStringArr[count+1] = mfvalue_trimmed;
-
-        count += 2;
+        err = addDescriptorProperty(&mfsmp, &capacity, key, keyLen,
+                                    value, valueLen);
+        if (err != ALL_OK) {
+            midpFree(line);
+            midp_free_properties(&mfsmp);
+            mfsmp.status = OUT_OF_MEMORY;
+            return mfsmp;
+        }
     } /* end of for */
 
+    midpFree(line);
+
+    if (mfsmp.numberOfProperties == 0) {
+        REPORT_INFO(LC_AMS, "midpParseMf(): Empty manifest.");
+        mfsmp.status = OUT_OF_MEMORY;
+        return mfsmp;
+    }
+
     mfsmp = verifyMfMustProperties(mfsmp);
-    REPORT_INFO3(LC_AMS,
-		 "End of midpParseMf: Status=%d, count=%d, countLines=%d",
-		 mfsmp.status, count, countLines);
+    REPORT_INFO2(LC_AMS, "End of midpParseMf: Status=%d, count=%d",
+		 mfsmp.status, mfsmp.numberOfProperties);
 
     return mfsmp;
 } /* end of midpParseMf */
@@ -427,226 +314,64 @@ static MidpProperties verifyMfMustProperties(MidpProperties mfsmp) {
 
 
 /**
- * Reads a line from a manifest file. Compacts continuation lines.<BR>
- * (Allocates memory for this line.)
+ * Check to see if all the chars in the key of a property are valid.
+ *
+ * @param key key to check
+ * @param len length of the key
  *
- * @param mfbuf  pointer to the manifest jchar_buffer; this pointer will move to
- *               the next line
- * @param result pointer to pcsl_string where the new line from manifest
- *               will be stored
- * @return error code
+ * @return an error if a character is not valid for a key
  */
-static MIDPError readMfLine(jchar** mfbuf, pcsl_string * result) {
-    jchar* lineStart = NULL;
-    int is_broken_line = 0;
-    jchar* p = NULL;
-    int count = 0;
-    int i = 0;
-
-    *result = PCSL_STRING_NULL;
-
-    /* will use p to avoid all the *(*mfbuf) stuff and make it more readable */
-    p = (*mfbuf);
-
-    if (!(*p)) {
-        /* end of jchar_buffer */
-        return END_OF_MF;
-    }
+static MIDPError checkMfKeyChars(const jchar* key, int len) {
+    /* IMPL NOTE: why chars in manifest key are different from jad key? */
+    jchar current;
+    int i;
 
-    /* skip commented out and blank lines */
-    while (COMMENTED_OUT(p) || NEW_LINE(p)) {
+    for (i = 0; i < len; i++) {
+        current = key[i];
 
-        while (!NEW_LINE(p)) {
-            p++; /* skip commented out line */
-        }
-        while (NEW_LINE(p)) {
-            p++; /* skip new line */
+        if (current >= 'A' && current <= 'Z') {
+            continue;
         }
 
-        /* now pointing to the next line */
-        if (MF_SPACE(p)) { /* if starting with space */
-            while (!NEW_LINE(p)) {
-                p++; /* skip the line */
-            }
-        } /* end of if */
-
-    } /* end of while */
-
-    lineStart = p;
-
-    for (;*p ;) {
-        count++;
-        p++;
-        if (NEW_LINE(p) && !MF_BROKEN_LINE(p)) {
-            *p = 0x00; /* cut the line */
-            if (*(p+1)) { /* if not end of the buffer */
-                p++; /* point to the next line beginning */
-                break;
-            }
-        } else if (MF_BROKEN_LINE(p)) {
-            while (!MF_SPACE(p)) { /* look for the space */
-                count++;
-                p++;
-            }
-            /* once space found, point to the next character and go ahead */
-            count++;
-            p++;
-            is_broken_line = 1;
+        if (current >= 'a' && current <= 'z') {
             continue;
-        } /* end of else */
-
-    } /* end of for */
-
-    /* move mfbuf to point to the next line */
-    (*mfbuf) = p;
-
-    pcsl_string_predict_size(result, count);
-    if (is_broken_line) {
-        i = 0;
-        while (*(lineStart+i)) {
-
-            /* here once we have a new line it will be followed by space */
-            if (NEW_LINE_1(lineStart+i)) {
-                i+=3;
-                count-=3;
-            } else if (NEW_LINE(lineStart+i)) {
-                i+=2;
-                count-=2;
-            }
-
-            if (PCSL_STRING_OK !=
-                pcsl_string_append_char(result, lineStart[i])) {
-                pcsl_string_free(result);
-                return OUT_OF_MEMORY;
-            }
-            i++;
         }
-    } else {
-        if (PCSL_STRING_OK !=
-            pcsl_string_convert_from_utf16(lineStart, count, result)) {
-            return OUT_OF_MEMORY;
-        }
-    }
 
-    return ALL_OK;
-} /* end of readMfLine */
-
-/**
- * Counts a lines in manifest file. Skips commented out and blank lines.
- *
- * @param buf
- * @return
- */
-static int count_mf_lines(jchar* buf) {
-    int numberOfLines = 0;
-
-    if ((!buf) || (!*buf)) {
-        return -1;
-    }
+        if (current >= '0' && current <= '9') {
+            continue;
+        }
 
-    while (*buf) {
-        /* skip commented out lines and lines that start with space */
-        if ((COMMENTED_OUT(buf)) || (MF_SPACE(buf))) {
-            /* run to the end of line */
-            while (!NEW_LINE(buf)) {
-                buf++;
-            }
-            /* skip all the new line characters an the end of line */
-            while (NEW_LINE(buf)) {
-                buf++;
-            }
-        } else {
-            numberOfLines++;
-            while (!NEW_LINE(buf)) {
-                buf++;
-            }
-            while (NEW_LINE(buf)) {
-                buf++;
-            }
+        if (i > 0 && (current == '-' || current == '_')) {
+            continue;
         }
-    } /* end of while */
-    return numberOfLines;
-} /* end of count_mf_lines */
 
-/**
- * Check to see if all the chars in the key of a property are valid.
- *
- * @param key key to check
- *
- * @return an error if a character is not valid for a key
- */
-static MIDPError checkMfKeyChars(const pcsl_string * mfkey) {
-    /* IMPL NOTE: why chars in manifest key are different from jad key? */
-    jchar current;
-    int i = 0;
-    MIDPError err = ALL_OK;
-
-    GET_PCSL_STRING_DATA_AND_LENGTH(mfkey)
-    if (PCSL_STRING_PARAMETER_ERROR(mfkey)) {
-        err = OUT_OF_MEMORY;
-    } else {
-        while (i < mfkey_len) {
-            current = mfkey_data[i];
-            i++;
-
-            if (current >= 'A' && current <= 'Z') {
-                continue;
-            }
-
-            if (current >= 'a' && current <= 'z') {
-                continue;
-            }
-
-            if (current >= '0' && current <= '9') {
-                continue;
-            }
-
-            if ((i - 1) > 0 && (current == '-' || current == '_')) {
-                continue;
-            }
-
-            printPcslStringWithMessage("checkMfKeyChars: BAD_MF_KEY ", mfkey);
-            err = BAD_MF_KEY;
-            break;
-        } /* end of while */
-    }
-    RELEASE_PCSL_STRING_DATA_AND_LENGTH
+        REPORT_INFO1(LC_AMS, "checkMfKeyChars: BAD_MF_KEY at %d", i);
+        return BAD_MF_KEY;
+    } /* end of for */
 
-    return err;
+    return ALL_OK;
 } /* end of checkMfKeyChars */
 
 /**
  * Check to see if all the chars in the value of a property are valid.
  *
  * @param value value to check
+ * @param len length of the value
  *
- * @return false if a character is not valid for a value
+ * @return BAD_MF_VALUE if a character is not valid for a value
  */
-static MIDPError checkMfValueChars(const pcsl_string * mfvalue) {
+static MIDPError checkMfValueChars(const jchar* value, int len) {
     jchar current;
-    int i = 0;
-    MIDPError err = ALL_OK;
-
-    GET_PCSL_STRING_DATA_AND_LENGTH(mfvalue)
-    if (PCSL_STRING_PARAMETER_ERROR(mfvalue)) {
-        err = OUT_OF_MEMORY;
-    } else {
-        while (i < mfvalue_len) {
-            current = mfvalue_data[i];
-            /* if current is a CTL character, return an error */
-            if ((current <= 0x1F || current == 0x7F) && (current != HT)) {
-                printPcslStringWithMessage("checkMfValueChars: BAD_MF_VALUE ",
-                                           mfvalue);
-                err = BAD_MF_VALUE;
-                break;
-            }
-            i++;
-        } /* end of while */
-    }
-    RELEASE_PCSL_STRING_DATA_AND_LENGTH
+    int i;
+
+    for (i = 0; i < len; i++) {
+        current = value[i];
+        /* if current is a CTL character, return an error */
+        if ((current <= 0x1F || current == 0x7F) && (current != HT)) {
+            REPORT_INFO1(LC_AMS, "checkMfValueChars: BAD_MF_VALUE at %d", i);
+            return BAD_MF_VALUE;
+        }
+    } /* end of for */
 
-    return err;
+    return ALL_OK;
 } /* end of checkMfValueChars */
-
-
-
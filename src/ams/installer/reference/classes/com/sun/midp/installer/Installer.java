@@ -31,7 +31,6 @@ import java.util.Vector;
 import java.io.IOException;
 import java.io.InputStream;
 import java.io.OutputStream;
-import java.io.ByteArrayInputStream;
 
 import javax.microedition.io.ConnectionNotFoundException;
 
@@ -186,6 +185,19 @@ public abstract class Installer {
      */
     protected String additionalPermissions;
 
+    /**
+     * If true, the JAR signature digest is computed while the JAR is
+     * transferred and the signature is checked while the manifest is
+     * parsed.
+     */
+    private boolean pipelined = true;
+
+    /** True while transferData is passing JAR bytes to the verifier. */
+    private boolean digestingJar;
+
+    /** Number of JAR bytes passed to the verifier during the transfer. */
+    private int jarBytesDigested;
+
     /**
      * Constructor of the Installer.
      */
@@ -387,6 +399,28 @@ public abstract class Installer {
         return verifier.isOCSPCheckEnabled();
     }
 
+    /**
+     * Enables or disables the pipelined installation mode, in which the
+     * JAR signature digest is computed while the JAR is transferred and
+     * the signature is checked while the manifest is parsed. The mode is
+     * enabled by default.
+     *
+     * @param enable true to enable the pipelined mode, false to run
+     *               every step after the previous one
+     */
+    public void enablePipelining(boolean enable) {
+        pipelined = enable;
+    }
+
+    /**
+     * Returns true if the pipelined installation mode is enabled.
+     *
+     * @return true if the pipelined mode is enabled, false otherwise
+     */
+    public boolean isPipeliningEnabled() {
+        return pipelined;
+    }
+
     /**
      * Performs an install.
      *
@@ -548,8 +582,7 @@ public abstract class Installer {
 
         state.jadProps = new JadProperties();
         try {
-            state.jadProps.load(new ByteArrayInputStream(state.jad),
-                                state.jadEncoding);
+            state.jadProps.load(state.jad, state.jadEncoding);
         } catch (OutOfMemoryError e) {
             state.jad = null;
             try {
@@ -724,6 +757,7 @@ public abstract class Installer {
         int bytesDownloaded;
         MIDletInfo midletInfo;
         String midlet;
+        JarVerification verification = null;
         
         // Send out delete notifications that have been queued, first
         OtaNotifier.postQueuedDeleteMsgsBackToProvider(state.proxyUsername,
@@ -735,7 +769,19 @@ public abstract class Installer {
         state.storageRoot = File.getStorageRoot(state.storageId);
         info.jarFilename = state.storageRoot + TMP_FILENAME;
 
-        bytesDownloaded = downloadJAR(info.jarFilename);
+        /*
+         * In the pipelined mode the signature digest of the JAR is
+         * computed by transferData as the JAR is written, instead of
+         * reading the JAR back afterwards.
+         */
+        jarBytesDigested = 0;
+        digestingJar = pipelined && verifier.startJarDigest();
+
+        try {
+            bytesDownloaded = downloadJAR(info.jarFilename);
+        } finally {
+            digestingJar = false;
+        }
 
         if (state.exception != null) {
             return;
@@ -744,75 +790,93 @@ public abstract class Installer {
         try {
             state.storage = new RandomAccessStream();
 
-            state.installInfo.authPath =
-                verifier.verifyJar(state.storage, info.jarFilename);
+            if (jarBytesDigested > 0 && jarBytesDigested == bytesDownloaded) {
+                // Only the signature check is left, overlap it with the
+                // reading and parsing of the manifest
+                verification = new JarVerification(verifier, state.storage,
+                                                   info.jarFilename);
+                verification.start();
+            } else {
+                state.installInfo.authPath =
+                    verifier.verifyJar(state.storage, info.jarFilename);
+            }
 
             if (state.listener != null) {
                 state.listener.updateStatus(VERIFYING_SUITE, state);
             }
 
-            // Create JAR Properties (From .jar file's MANIFEST)
             try {
-                state.manifest = JarReader.readJarEntry(info.jarFilename,
-                    MIDletSuite.JAR_MANIFEST);
-                if (state.manifest == null) {
+                // Create JAR Properties (From .jar file's MANIFEST)
+                try {
+                    state.manifest = JarReader.readJarEntry(info.jarFilename,
+                        MIDletSuite.JAR_MANIFEST);
+                    if (state.manifest == null) {
+                        postInstallMsgBackToProvider(
+                            OtaNotifier.INVALID_JAR_MSG);
+                        throw new
+                            InvalidJadException(InvalidJadException.CORRUPT_JAR,
+                                                MIDletSuite.JAR_MANIFEST);
+                    }
+                } catch (OutOfMemoryError e) {
+                    try {
+                        postInstallMsgBackToProvider(
+                            OtaNotifier.INSUFFICIENT_MEM_MSG);
+                    } catch (Throwable t) {
+                        if (Logging.REPORT_LEVEL <= Logging.WARNING) {
+                            Logging.report(Logging.WARNING, LogChannels.LC_AMS,
+                            "Throwable during posting the install message");
+                        }
+                    }
+
+                    throw new
+                        InvalidJadException(InvalidJadException.TOO_MANY_PROPS);
+                } catch (IOException ioe) {
                     postInstallMsgBackToProvider(
                         OtaNotifier.INVALID_JAR_MSG);
                     throw new
                         InvalidJadException(InvalidJadException.CORRUPT_JAR,
                                             MIDletSuite.JAR_MANIFEST);
                 }
-            } catch (OutOfMemoryError e) {
-                try {
-                    postInstallMsgBackToProvider(
-                        OtaNotifier.INSUFFICIENT_MEM_MSG);
-                } catch (Throwable t) {
-                    if (Logging.REPORT_LEVEL <= Logging.WARNING) {
-                        Logging.report(Logging.WARNING, LogChannels.LC_AMS,
-                        "Throwable during posting the install message");
-                    }
-                }
-
-                throw new
-                    InvalidJadException(InvalidJadException.TOO_MANY_PROPS);
-            } catch (IOException ioe) {
-                postInstallMsgBackToProvider(
-                    OtaNotifier.INVALID_JAR_MSG);
-                throw new
-                    InvalidJadException(InvalidJadException.CORRUPT_JAR,
-                                        MIDletSuite.JAR_MANIFEST);
-            }
 
-            state.jarProps = new ManifestProperties();
+                state.jarProps = new ManifestProperties();
 
-            try {
-                state.jarProps.load(new ByteArrayInputStream(state.manifest));
-                state.manifest = null;
-            } catch (OutOfMemoryError e) {
-                state.manifest = null;
                 try {
-                    postInstallMsgBackToProvider(
-                        OtaNotifier.INSUFFICIENT_MEM_MSG);
-                } catch (Throwable t) {
-                    if (Logging.REPORT_LEVEL <= Logging.WARNING) {
-                        Logging.report(Logging.WARNING, LogChannels.LC_AMS,
-                        "Throwable while posting install message ");
+                    state.jarProps.load(state.manifest);
+                    state.manifest = null;
+                } catch (OutOfMemoryError e) {
+                    state.manifest = null;
+                    try {
+                        postInstallMsgBackToProvider(
+                            OtaNotifier.INSUFFICIENT_MEM_MSG);
+                    } catch (Throwable t) {
+                        if (Logging.REPORT_LEVEL <= Logging.WARNING) {
+                            Logging.report(Logging.WARNING, LogChannels.LC_AMS,
+                            "Throwable while posting install message ");
+                        }
                     }
-                }
 
-                throw new
-                    InvalidJadException(InvalidJadException.TOO_MANY_PROPS);
-            } catch (InvalidJadException ije) {
-                state.manifest = null;
+                    throw new
+                        InvalidJadException(InvalidJadException.TOO_MANY_PROPS);
+                } catch (InvalidJadException ije) {
+                    state.manifest = null;
 
-                try {
-                    postInstallMsgBackToProvider(
-                        OtaNotifier.INVALID_JAR_MSG);
-                } catch (Throwable t) {
-                    // ignore
-                }
+                    try {
+                        postInstallMsgBackToProvider(
+                            OtaNotifier.INVALID_JAR_MSG);
+                    } catch (Throwable t) {
+                        // ignore
+                    }
 
-                throw ije;
+                    throw ije;
+                }
+            } finally {
+                /*
+                 * A signature error takes precedence over a manifest
+                 * error, as when the steps run one after another.
+                 */
+                if (verification != null) {
+                    state.installInfo.authPath = verification.finish();
+                }
             }
 
             for (int i = 1; ; i++) {
@@ -1696,6 +1760,11 @@ public abstract class Installer {
 
                 out.write(buffer, 0, bytesRead);
                 totalBytesWritten += bytesRead;
+
+                if (digestingJar) {
+                    verifier.updateJarDigest(buffer, 0, bytesRead);
+                    jarBytesDigested += bytesRead;
+                }
             }
         } catch (IOException ioe) {
             if (state.stopInstallation) {
@@ -2754,6 +2823,92 @@ class AccessControl extends AccessControlContextAdapter {
     }
 }
 
+/**
+ * Finishes the check of a JAR signature on its own thread, so that it
+ * runs while the installer reads and parses the manifest.
+ */
+class JarVerification extends Thread {
+    /** Verifier holding the digest of the JAR. */
+    private Verifier verifier;
+
+    /** Storage used to read the JAR if it has to be read again. */
+    private RandomAccessStream storage;
+
+    /** Name of the JAR file. */
+    private String jarFilename;
+
+    /** Authorization path found by the verifier. */
+    private String[] authPath;
+
+    /** Error thrown by the verifier, or null. */
+    private Throwable error;
+
+    /**
+     * Initializes the JarVerification object.
+     *
+     * @param theVerifier verifier that was passed the JAR bytes
+     * @param theStorage storage for reading the JAR
+     * @param theJarFilename name of the JAR file
+     */
+    JarVerification(Verifier theVerifier, RandomAccessStream theStorage,
+                    String theJarFilename) {
+        verifier = theVerifier;
+        storage = theStorage;
+        jarFilename = theJarFilename;
+    }
+
+    /**
+     * Verifies the JAR.
+     */
+    public void run() {
+        try {
+            authPath = verifier.verifyJar(storage, jarFilename);
+        } catch (Throwable t) {
+            error = t;
+        }
+    }
+
+    /**
+     * Waits for the verification to end and returns its result.
+     *
+     * @return authorization path: a list of authority names begining with
+     *         the most trusted, or null if jar is not signed
+     *
+     * @exception IOException if any error prevented the reading
+     *   of the JAR
+     * @exception InvalidJadException if the JAR is not valid or the
+     *   provider certificate is missing
+     */
+    String[] finish() throws IOException, InvalidJadException {
+        for (;;) {
+            try {
+                join();
+                break;
+            } catch (InterruptedException ie) {
+                // keep waiting, the result is needed
+            }
+        }
+
+        if (error instanceof IOException) {
+            throw (IOException)error;
+        }
+
+        if (error instanceof InvalidJadException) {
+            throw (InvalidJadException)error;
+        }
+
+        if (error instanceof RuntimeException) {
+            throw (RuntimeException)error;
+        }
+
+        if (error instanceof Error) {
+            throw (Error)error;
+        }
+
+        return authPath;
+    }
+}
+
 /*
  * Holds the state of an installation, so it can restarted after it has
  * been stopped.
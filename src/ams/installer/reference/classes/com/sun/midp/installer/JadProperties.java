@@ -26,12 +26,13 @@
 
 package com.sun.midp.installer;
 
+import java.io.ByteArrayInputStream;
 import java.io.IOException;
 import java.io.InputStream;
 import java.io.InputStreamReader;
 import java.io.Reader;
 
-import java.util.Vector;
+import java.util.Hashtable;
 
 import com.sun.midp.util.Properties;
 
@@ -97,6 +98,16 @@ public class JadProperties extends Properties {
     /** Buffers one line from the stream. */
     protected char[] lineBuffer = null;
 
+    /** Position of the next byte to decode when loading from bytes. */
+    protected int dataPos;
+
+    /**
+     * Maps the keys stored by the load in progress to their index, so
+     * that a long descriptor is not loaded in quadratic time. Null when
+     * not loading or when the load started with a non-empty list.
+     */
+    private Hashtable loadIndex;
+
     /**
      * Constructor - creates an empty property list.
      */
@@ -143,6 +154,23 @@ public class JadProperties extends Properties {
             partialLoad(inStream, enc, Integer.MAX_VALUE);
     } 
 
+    /**
+     * Reads a JAD (key and element pairs) from an array of bytes.
+     * The syntax is the same as for {@link #load(InputStream, String)},
+     * but UTF-8 and ISO 8859-1 data is decoded in the same scan that
+     * splits the lines, without a reader and without a string per line.
+     *
+     * @param      data       the JAD bytes
+     * @param      enc        character encoding of the data,
+     *                        can be null to get the default (UTF-8)
+     * @exception  IOException  if the encoding is not supported
+     * @exception  InvalidJadException if the JAD is not formatted correctly.
+     */
+    public synchronized void load(byte[] data, String enc)
+	throws IOException, InvalidJadException {
+            partialLoad(data, enc, Integer.MAX_VALUE);
+    } 
+
     /**
      * Loads up a given number of properties from a JAD.
      * Used when authenticating a JAD.
@@ -159,11 +187,8 @@ public class JadProperties extends Properties {
             int propertiesToLoad) throws IOException,
             InvalidJadException {
         Reader in;
-        String line;
-        int endOfKey;
-        String key = null;
-        int startOfValue;
-        String value = null;
+        int length;
+        InvalidJadException lineException;
         InvalidJadException jadException = null;
 
         if (enc == null) {
@@ -172,66 +197,76 @@ public class JadProperties extends Properties {
             in = new InputStreamReader(inStream, enc);
         }
 
-	lineBuffer = new char[512];
+        startLoad();
 
 	for (int i = 0; i < propertiesToLoad; i++) {
             // Get next line
-            line = readLine(in);
-            if (line == null) {
+            length = readLine(in);
+            if (length < 0) {
                 break;
             }
 
-            // blank line separate groups of properties
-            if (line.length() == 0) {
-                continue;
+            lineException = storeLine(length);
+            if (lineException != null) {
+                jadException = lineException;
             }
+	}
 
-            endOfKey = line.indexOf(":");
-            if (endOfKey == -1) {
-                jadException =
-                    new InvalidJadException(InvalidJadException.INVALID_KEY,
-                                            line);
-                continue;
-            }
+        endLoad();
 
-            key = line.substring(0, endOfKey);
+        if (jadException != null) {
+            throw jadException;
+        }
+    }
 
-            if (key == null || key.length() == 0) {
-                jadException =
-                    new InvalidJadException(InvalidJadException.INVALID_KEY,
-                                            line);
-                continue;
-            }
+    /**
+     * Loads up a given number of properties from a JAD held in an array
+     * of bytes. UTF-8 and ISO 8859-1 are decoded as the lines are
+     * scanned; other encodings are read through a reader.
+     *
+     * @param      data       the JAD bytes
+     * @param      enc        character encoding of the data,
+     *                        null for the default encoding (UTF-8)
+     * @param      propertiesToLoad maximum number of properties to load
+     * @exception  IOException  if the encoding is not supported
+     * @exception  InvalidJadException if the JAD is not formatted correctly.
+     */
+    public void partialLoad(byte[] data, String enc, int propertiesToLoad)
+            throws IOException, InvalidJadException {
+        boolean utf8;
+        int length;
+        InvalidJadException lineException;
+        InvalidJadException jadException = null;
 
-            if (!checkKeyChars(key)) {
-                jadException =
-                    new InvalidJadException(InvalidJadException.INVALID_KEY,
-                                            line);
-                continue;
-            }
+        if (enc == null || enc.equalsIgnoreCase("UTF-8") ||
+                enc.equalsIgnoreCase("UTF8")) {
+            utf8 = true;
+        } else if (enc.equalsIgnoreCase("ISO-8859-1") ||
+                   enc.equalsIgnoreCase("ISO8859_1")) {
+            utf8 = false;
+        } else {
+            partialLoad(new ByteArrayInputStream(data), enc,
+                        propertiesToLoad);
+            return;
+        }
 
-            startOfValue = endOfKey + 1;
-            value = line.substring(startOfValue, line.length());
-            value = value.trim();
-            if (value == null) {
-                jadException =
-                    new InvalidJadException(InvalidJadException.INVALID_VALUE,
-                                            key);
-                continue;
-            }
+        startLoad();
+        dataPos = 0;
 
-            if (!checkValueChars(value)) {
-                jadException = new
-                    InvalidJadException(InvalidJadException.INVALID_VALUE,
-                                        key);
-                continue;
+	for (int i = 0; i < propertiesToLoad; i++) {
+            // Get next line
+            length = readLine(data, utf8);
+            if (length < 0) {
+                break;
             }
 
-            putProperty(key, value);
+            lineException = storeLine(length);
+            if (lineException != null) {
+                jadException = lineException;
+            }
 	}
 
-        // we only need the line buffer while loading, so let it be reclaimed
-	lineBuffer = null;
+        endLoad();
 
         if (jadException != null) {
             throw jadException;
@@ -253,6 +288,20 @@ public class JadProperties extends Properties {
 	load(inStream, null);
     }
 
+    /**
+     * Loads properties from an array of bytes using the default
+     * character encoding. Currently the default encoding is UTF8.
+     *
+     * @see #load(byte[] data, String enc)
+     * @param      data       the JAD bytes
+     * @exception  IOException  if the encoding is not supported
+     * @exception  InvalidJadException if the JAD is not formatted correctly.
+     */
+    public synchronized void load(byte[] data) throws IOException,
+            InvalidJadException {
+	load(data, null);
+    }
+
     /**
      * Store key:value pair.
      *
@@ -261,23 +310,130 @@ public class JadProperties extends Properties {
      * @see #getProperty
      */
     protected void putProperty(String key, String value) {
-	setProperty(key, value);
+        Integer index;
+
+        if (loadIndex == null) {
+            setProperty(key, value);
+            return;
+        }
+
+        index = (Integer)loadIndex.get(key);
+        if (index != null) {
+            setPropertyAt(index.intValue(), value);
+            return;
+        }
+
+        loadIndex.put(key, new Integer(size()));
+        addProperty(key, value);
+    }
+
+    /**
+     * Sets up the state needed while loading.
+     */
+    private void startLoad() {
+	lineBuffer = new char[512];
+
+        if (size() == 0) {
+            loadIndex = new Hashtable();
+        }
+    }
+
+    /**
+     * Drops the state needed while loading.
+     */
+    private void endLoad() {
+        // we only need these while loading, so let them be reclaimed
+	lineBuffer = null;
+        loadIndex = null;
     }
 
     /**
-     * Reads one using a given reader. LF or CR LF end a line.
+     * Parses the line in the line buffer and stores its property.
+     * Strings are only created for the key and value of a valid line.
+     *
+     * @param length number of characters in the line buffer
+     *
+     * @return an exception describing a format error or null
+     */
+    private InvalidJadException storeLine(int length) {
+        int endOfKey;
+        int startOfValue;
+        int endOfValue;
+
+        // blank line separate groups of properties
+        if (length == 0) {
+            return null;
+        }
+
+        for (endOfKey = 0; endOfKey < length; endOfKey++) {
+            if (lineBuffer[endOfKey] == ':') {
+                break;
+            }
+        }
+
+        if (endOfKey == 0 || endOfKey == length ||
+                !checkKeyChars(lineBuffer, 0, endOfKey)) {
+            return new InvalidJadException(InvalidJadException.INVALID_KEY,
+                new String(lineBuffer, 0, length));
+        }
+
+        startOfValue = endOfKey + 1;
+        while (startOfValue < length && lineBuffer[startOfValue] <= SP) {
+            startOfValue++;
+        }
+
+        endOfValue = length;
+        while (endOfValue > startOfValue &&
+                lineBuffer[endOfValue - 1] <= SP) {
+            endOfValue--;
+        }
+
+        if (!checkValueChars(lineBuffer, startOfValue, endOfValue)) {
+            return new InvalidJadException(InvalidJadException.INVALID_VALUE,
+                new String(lineBuffer, 0, endOfKey));
+        }
+
+        putProperty(new String(lineBuffer, 0, endOfKey),
+            new String(lineBuffer, startOfValue, endOfValue - startOfValue));
+        return null;
+    }
+
+    /**
+     * Tells whether a line break followed by a space continues a line.
+     * If it does a CR alone also ends a line.
+     *
+     * @return false, JADs do not have continuation lines
+     */
+    protected boolean hasContinuationLines() {
+        return false;
+    }
+
+    /**
+     * Makes sure the line buffer has room for more characters.
+     *
+     * @param needed number of characters the line buffer must hold
+     */
+    private void growLineBuffer(int needed) {
+        char[] temp;
+
+        if (needed > lineBuffer.length) {
+            temp = new char[needed + 128];
+            System.arraycopy(lineBuffer, 0, temp, 0, lineBuffer.length);
+            lineBuffer = temp;
+        }
+    }
+
+    /**
+     * Reads one line using a given reader into the line buffer.
+     * LF or CR LF end a line.
      * The end of line and end of file characters are dropped.
      * @param in reader for a JAD
-     * @return one line of the JAD or null at the end of the JAD
+     * @return length of the line or -1 at the end of the JAD
      * @exception IOException thrown by the reader
      */
-    protected String readLine(Reader in) throws IOException {
-	int room;
+    protected int readLine(Reader in) throws IOException {
 	int offset = 0;
 	int c = 0;
-        char[] temp;
-
-	room = lineBuffer.length;
 
         for (;;) {
             c = in.read();
@@ -293,36 +449,116 @@ public class JadProperties extends Properties {
                 continue;
             }
 
-            if (--room < 0) {
-                temp = new char[offset + 128];
-                room = temp.length - offset - 1;
-                System.arraycopy(lineBuffer, 0, temp, 0, offset);
-                lineBuffer = temp;
+            if (offset == lineBuffer.length) {
+                growLineBuffer(offset + 1);
             }
 
             lineBuffer[offset++] = (char) c;
 	}
 
 	if ((c == -1) && (offset <= 0)) {
-	    return null;
+	    return -1;
+	}
+
+        return offset;
+    }
+
+    /**
+     * Decodes one line from an array of bytes into the line buffer,
+     * starting at <code>dataPos</code> and leaving it at the start of the
+     * next line. LF or CR LF end a line, and a CR alone as well if
+     * {@link #hasContinuationLines} is true, in which case a line break
+     * followed by a space is dropped together with the space. The end of
+     * line and end of file characters are dropped. A byte that does not
+     * start a well-formed UTF-8 sequence is taken as ISO 8859-1.
+     *
+     * @param data the descriptor bytes
+     * @param utf8 true to decode UTF-8, false for ISO 8859-1
+     * @return length of the line or -1 at the end of the data
+     */
+    protected int readLine(byte[] data, boolean utf8) {
+        boolean continuation = hasContinuationLines();
+        int end = data.length;
+        int pos = dataPos;
+	int offset = 0;
+	int c;
+
+        if (pos >= end) {
+            return -1;
+        }
+
+        while (pos < end) {
+            c = data[pos++] & 0xFF;
+
+            if (c == LF || (c == CR && continuation)) {
+                if (c == CR && pos < end && data[pos] == LF) {
+                    pos++;
+                }
+
+                if (continuation && pos < end && data[pos] == SP) {
+                    // Marks a continuation line, throw away the space
+                    pos++;
+                    continue;
+                }
+
+                break;
+            }
+
+            /*
+             * throw away carriage returns and the end of file character.
+             */
+            if (c == CR || c == EOF) {
+                continue;
+            }
+
+            if (offset + 2 > lineBuffer.length) {
+                growLineBuffer(offset + 2);
+            }
+
+            if (utf8 && c >= 0xC0) {
+                if (c < 0xE0 && pos < end && (data[pos] & 0xC0) == 0x80) {
+                    c = ((c & 0x1F) << 6) | (data[pos] & 0x3F);
+                    pos++;
+                } else if (c < 0xF0 && end - pos >= 2 &&
+                           (data[pos] & 0xC0) == 0x80 &&
+                           (data[pos + 1] & 0xC0) == 0x80) {
+                    c = ((c & 0x0F) << 12) | ((data[pos] & 0x3F) << 6) |
+                        (data[pos + 1] & 0x3F);
+                    pos += 2;
+                } else if (c < 0xF8 && end - pos >= 3 &&
+                           (data[pos] & 0xC0) == 0x80 &&
+                           (data[pos + 1] & 0xC0) == 0x80 &&
+                           (data[pos + 2] & 0xC0) == 0x80) {
+                    c = ((c & 0x07) << 18) | ((data[pos] & 0x3F) << 12) |
+                        ((data[pos + 1] & 0x3F) << 6) | (data[pos + 2] & 0x3F);
+                    pos += 3;
+
+                    // outside of the BMP, store a surrogate pair
+                    c -= 0x10000;
+                    lineBuffer[offset++] = (char)(0xD800 | (c >> 10));
+                    c = 0xDC00 | (c & 0x3FF);
+                }
+            }
+
+            lineBuffer[offset++] = (char) c;
 	}
 
-        return new String(lineBuffer, 0, offset);
+        dataPos = pos;
+        return offset;
     }
 
     /**
      * Check to see if all the chars in the key of a property are valid.
      *
-     * @param key key to check
+     * @param buf buffer holding the key
+     * @param start index of the first character of the key
+     * @param end index after the last character of the key
      *
      * @return false if a character is not valid for a key
      */
-    protected boolean checkKeyChars(String key) {
-        char[] temp = key.toCharArray();
-        int len = temp.length;
-
-        for (int i = 0; i < len; i++) {
-            char current = temp[i];
+    protected boolean checkKeyChars(char[] buf, int start, int end) {
+        for (int i = start; i < end; i++) {
+            char current = buf[i];
 
             if (current <= 0x1F ||
                 current == 0x7F ||
@@ -355,17 +591,16 @@ public class JadProperties extends Properties {
     /**
      * Check to see if all the chars in the value of a property are valid.
      *
-     * @param value value to check
+     * @param buf buffer holding the value
+     * @param start index of the first character of the value
+     * @param end index after the last character of the value
      *
      * @return false if a character is not valid for a value
      */
-    protected boolean checkValueChars(String value) {
-        char[] temp = value.toCharArray();
-        int len = temp.length;
-
+    protected boolean checkValueChars(char[] buf, int start, int end) {
         // assume whitespace and newlines are trimmed
-        for (int i = 0; i < len; i++) {
-            char current = temp[i];
+        for (int i = start; i < end; i++) {
+            char current = buf[i];
              
             // if current is a CTL character, throw exception
             if ((current <= 0x1F || current == 0x7F) && 
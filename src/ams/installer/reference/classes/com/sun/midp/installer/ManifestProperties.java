@@ -123,16 +123,26 @@ public class ManifestProperties extends JadProperties {
         super.partialLoad(inStream, enc, propertiesToLoad);
     }
 
+    /**
+     * Tells whether a line break followed by a space continues a line.
+     *
+     * @return true, manifest headers can be continued
+     */
+    protected boolean hasContinuationLines() {
+        return true;
+    }
+
     /**
      * Reads one line using a given reader. CR, LF, or CR + LF end a line.
      * However lines may be continued by beginning the next line with a space.
      * The end of line and end of file characters and continuation space are
      * dropped.
      * @param in reader for a JAD
-     * @return one line of the JAD or null at the end of the JAD
+     * @return length of the line in the line buffer or -1 at the end of
+     *         the JAD
      * @exception IOException thrown by the reader
      */
-    protected String readLine(Reader in) throws IOException {
+    protected int readLine(Reader in) throws IOException {
         int lastChar = 0;
 	int room;
 	int offset = 0;
@@ -195,25 +205,24 @@ public class ManifestProperties extends JadProperties {
 	}
 
 	if ((c == -1) && (offset <= 0)) {
-	    return null;
+	    return -1;
 	}
 
-        return new String(lineBuffer, 0, offset);
+        return offset;
     }
 
     /**
      * Check to see if all the chars in the key of a property are valid.
      *
-     * @param key key to check
+     * @param buf buffer holding the key
+     * @param start index of the first character of the key
+     * @param end index after the last character of the key
      *
      * @return false if a character is not valid for a key
      */
-    protected boolean checkKeyChars(String key) {
-        char[] temp = key.toCharArray();
-        int len = temp.length;
-
-        for (int i = 0; i < len; i++) {
-            char current = temp[i];
+    protected boolean checkKeyChars(char[] buf, int start, int end) {
+        for (int i = start; i < end; i++) {
+            char current = buf[i];
 
             if (current >= 'A' && current <= 'Z') {
                 continue;
@@ -227,7 +236,7 @@ public class ManifestProperties extends JadProperties {
                 continue;
             }
 
-            if (i > 0 && (current == '-' || current == '_')) {
+            if (i > start && (current == '-' || current == '_')) {
                 continue;
             }
 
@@ -240,17 +249,16 @@ public class ManifestProperties extends JadProperties {
     /**
      * Check to see if all the chars in the value of a property are valid.
      *
-     * @param value value to check
+     * @param buf buffer holding the value
+     * @param start index of the first character of the value
+     * @param end index after the last character of the value
      *
      * @return false if a character is not valid for a value
      */
-    protected boolean checkValueChars(String value) {
-        char[] temp = value.toCharArray();
-        int len = temp.length;
-
+    protected boolean checkValueChars(char[] buf, int start, int end) {
         // assume whitespace and new lines are trimmed
-        for (int i = 0; i < len; i++) {
-            if (temp[i] == 0) {
+        for (int i = start; i < end; i++) {
+            if (buf[i] == 0) {
                 return false;
             }
         }
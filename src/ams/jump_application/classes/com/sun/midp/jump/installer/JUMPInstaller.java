@@ -38,7 +38,6 @@ import java.util.Vector;
 import java.io.IOException;
 import java.io.InputStream;
 import java.io.OutputStream;
-import java.io.ByteArrayInputStream;
 
 import javax.microedition.io.ConnectionNotFoundException;
 
@@ -554,8 +553,7 @@ public abstract class JUMPInstaller {
         state.jadProps = new JadProperties();
 
         try {
-            state.jadProps.load(new ByteArrayInputStream(state.jad),
-                                state.jadEncoding);
+            state.jadProps.load(state.jad, state.jadEncoding);
         } catch (OutOfMemoryError e) {
             state.jad = null;
             try {
@@ -831,7 +829,7 @@ public abstract class JUMPInstaller {
 		//  state.jarProps.readFromAttributes(
 		//    manifest.getMainAttributes());
 
-                state.jarProps.load(new ByteArrayInputStream(state.manifest));
+                state.jarProps.load(state.manifest);
                 state.manifest = null;
             } catch (OutOfMemoryError e) {
                 state.manifest = null;
@@ -38,7 +38,7 @@
 #define MAX_CACHE_ENTRIES_PER_SUITE 1
 
 #define ICON_CACHE_MAGIC   0x41434349
-#define ICON_CACHE_VERSION 0x00010000
+#define ICON_CACHE_VERSION 0x00020000
 
 /** A header of the file containing the cached icons. */
 typedef struct _iconCacheHeader {
@@ -50,15 +50,20 @@ typedef struct _iconCacheHeader {
     int numberOfEntries;
     /** Number of free entries in the file. */
     int numberOfFreeEntries;
+    /** Number of IconCacheEntry slots reserved for the index. */
+    int indexCapacity;
+    /** Number of bytes in the data region not used by any entry. */
+    long wastedBytes;
     /*
-     * The following variable-length data are located in the file
-     * immediately after this structure:
+     * The following data are located in the file immediately after
+     * this structure:
      *
-     * numberOfEntries x IconCacheEntry
+     * indexCapacity x IconCacheEntry (the index, numberOfEntries are used)
+     * the data region, referenced by IconCacheEntry.dataOffset
      */
 } IconCacheHeader;
 
-/** A structure representing a cached icon in the file. */
+/** A structure representing a cached icon in the index of the file. */
 typedef struct _iconCacheEntry {
     /** True if this entry is free, false otherwise. */
     int isFree;
@@ -68,28 +73,30 @@ typedef struct _iconCacheEntry {
     int imageDataLength;
     /** Length of the icon's name, in bytes. */
     jint nameLength;
-    /*
-     * The following variable-length data are located in the file
-     * immediately after this structure:
+    /**
+     * Offset of the icon's data in the file (4-byte aligned):
      *
      * UTF16 string with the icon's name.
      * jchar* pImageName;
      * Icon's binary data.
      * unsigned char* pImageData;
      */
+    long dataOffset;
 } IconCacheEntry;
 
 /** A structure describing a cached image loaded into memory. */
 typedef struct _cachedImageInfo {
     /** True if this entry is free, false otherwise. */
     int isFree;
-    /** The name of the cached icon. */
+    /** The name of the cached icon, PCSL_STRING_NULL until loaded. */
     pcsl_string imageName;
-    /** -1 if unknown */
+    /** Length of the icon's name in the file, in bytes. */
+    jint nameLength;
+    /** Offset of the icon's data in the file, -1 if unknown */
     unsigned long entryOffsetInFile;
     /** Length of the icon's binary data. */
     int imageDataLength;
-    /** Pointer to the image bytes */
+    /** Pointer to the image bytes, NULL until loaded from the file */
     unsigned char* pImageData;
     /** Pointer to the next entry in the linked list. */
     /* struct _cachedImageInfo* nextEntry; */
@@ -103,6 +110,8 @@ typedef struct _iconCache {
     int numberOfCachedImages;
     /** Array of structures describing the cached images. */
     CachedImageInfo pInfo[MAX_CACHE_ENTRIES_PER_SUITE];
+    /** Index of the next entry in the same bucket of the suite ID hash. */
+    int nextEntry;
 } IconCache;
 
 /**
@@ -166,7 +175,9 @@ midp_add_suite_icon(SuiteIdType suiteId, const pcsl_string* pIconName,
 MIDPError midp_remove_suite_icons(SuiteIdType suiteId);
 
 /**
- * Compacts the storage with the cached icons.
+ * Compacts the storage with the cached icons. The file is compacted in
+ * place by a step of bounded length; the next steps are taken when the
+ * cache changes again.
  *
  * @return status code (ALL_OK if successful)
  */
@@ -37,13 +37,16 @@
  */
 #define SUITESTORE_LISTENER_TYPE_INSTALL 1
 #define SUITESTORE_LISTENER_TYPE_REMOVE  2
+#define SUITESTORE_LISTENER_TYPE_APP_IMAGE 3
 
 /**
  * Constants defining when a listener should be called: before executing the
- * operation, after it, or before and after.
+ * operation, after it, or before and after. Long operations may also
+ * report their progress in between.
  */
-#define SUITESTORE_OPERATION_START 1
-#define SUITESTORE_OPERATION_END   2
+#define SUITESTORE_OPERATION_START    1
+#define SUITESTORE_OPERATION_END      2
+#define SUITESTORE_OPERATION_PROGRESS 4
 #define SUITESTORE_WHEN_ALWAYS (SUITESTORE_OPERATION_START | \
                                 SUITESTORE_OPERATION_END)
 
@@ -80,12 +83,17 @@ typedef void (*SUITESTORE_LISTENER)(int listenerType, int when,
  *     SUITESTORE_LISTENER_TYPE_INSTALL - the listener will be called on
  *         the installation of a midlet suite;
  *     SUITESTORE_LISTENER_TYPE_REMOVE - the listener will be called on
- *         the removal of a midlet suite.
+ *         the removal of a midlet suite;
+ *     SUITESTORE_LISTENER_TYPE_APP_IMAGE - the listener will be called on
+ *         the generation of the application image of a midlet suite,
+ *         possibly on a thread other than the one installing the suite.
  * </pre>
- * @param whenToCall defines when the listener should be called:
+ * @param whenToCall defines when the listener should be called, a
+ * combination of:
  * <pre>
  *     SUITESTORE_OPERATION_START - before the operation on the suite;
  *     SUITESTORE_OPERATION_END - after the operation;
+ *     SUITESTORE_OPERATION_PROGRESS - during the operation;
  *     SUITESTORE_WHEN_ALWAYS - before and after the operation.
  * </pre>
  *
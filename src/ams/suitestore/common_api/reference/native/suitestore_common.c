@@ -59,6 +59,33 @@ PCSL_DEFINE_ASCII_STRING_LITERAL_START(APP_IMAGE_EXTENSION)
 PCSL_DEFINE_ASCII_STRING_LITERAL_END(APP_IMAGE_EXTENSION);
 #endif
 
+/** Number of suites whose parsed properties are kept in memory. */
+#define SUITE_PROPERTY_CACHE_SIZE 4
+
+/**
+ * Parsed properties of one suite, with a hash index over the keys.
+ */
+typedef struct _suitePropertyCacheEntry {
+    /** ID of the suite, UNUSED_SUITE_ID if the entry is free */
+    SuiteIdType suiteId;
+    /** key/value pairs read from the suite's property file */
+    MidpProperties properties;
+    /** number of buckets in pBuckets, a power of 2 */
+    int numberOfBuckets;
+    /** first property (pair index) of each bucket, or -1 */
+    int* pBuckets;
+    /** next property in the same bucket, or -1; one per property */
+    int* pNext;
+    /** value of g_propertyCacheClock when the entry was last used */
+    unsigned long lastUsed;
+} SuitePropertyCacheEntry;
+
+/** Parsed properties of the recently used suites. */
+static SuitePropertyCacheEntry g_propertyCache[SUITE_PROPERTY_CACHE_SIZE];
+
+/** Counter used to find the least recently used cache entry. */
+static unsigned long g_propertyCacheClock = 0;
+
 /* Description of these internal functions can be found bellow in the code. */
 static MIDPError suite_in_list(ComponentType type, SuiteIdType suiteId,
                                ComponentIdType componentId);
@@ -75,6 +102,10 @@ static MIDPError get_suite_or_component_id(ComponentType type,
                                            const pcsl_string* vendor,
                                            const pcsl_string* name,
                                            jint* pId);
+static MIDPError get_cached_suite_properties(SuiteIdType suiteId,
+    SuitePropertyCacheEntry** ppEntry);
+static pcsl_string* find_cached_property(SuitePropertyCacheEntry* pEntry,
+                                         const pcsl_string* key);
 
 /**
  * Initializes the subsystem.
@@ -717,35 +748,60 @@ MIDPError
 midp_get_suite_property(SuiteIdType suiteId,
                         const pcsl_string* pKey,
                         pcsl_string* pValue) {
-    MidpProperties prop;
+    SuitePropertyCacheEntry* pEntry;
     pcsl_string* pPropFound;
+    MIDPError status;
 
     if (pKey == NULL || pValue == NULL) {
         return BAD_PARAMS;
     }
 
-    (void)suiteId;
-    (void)pKey;
-
     *pValue = PCSL_STRING_NULL;
 
-    /* IMPL_NOTE: the following implementation should be optimized! */
-    prop = midp_get_suite_properties(suiteId);
-    if (prop.status != ALL_OK) {
-        return prop.status;
+    status = get_cached_suite_properties(suiteId, &pEntry);
+    if (status != ALL_OK) {
+        return status;
     }
 
-    pPropFound = midp_find_property(&prop, pKey);
-// TODO !!!
-//    midp_free_properties(&prop);
-
-    if (pPropFound == NULL) {
+    pPropFound = find_cached_property(pEntry, pKey);
+    if (pcsl_string_is_null(pPropFound)) {
         return NOT_FOUND;
     }
 
-    *pValue = *pPropFound;
+    /* the cached value belongs to the cache, give the caller a copy */
+    if (pcsl_string_dup(pPropFound, pValue) != PCSL_STRING_OK) {
+        return OUT_OF_MEMORY;
+    }
 
-    return ALL_OK;                        
+    return ALL_OK;
+}
+
+/**
+ * Removes the parsed properties of the given suite from the property cache.
+ * Must be called when the suite's property file is rewritten or removed.
+ *
+ * @param suiteId ID of the suite, or UNUSED_SUITE_ID to clear the whole cache
+ */
+void
+invalidate_suite_property_cache(SuiteIdType suiteId) {
+    int i;
+
+    for (i = 0; i < SUITE_PROPERTY_CACHE_SIZE; i++) {
+        SuitePropertyCacheEntry* pEntry = &g_propertyCache[i];
+
+        if (pEntry->suiteId == UNUSED_SUITE_ID ||
+                (suiteId != UNUSED_SUITE_ID && pEntry->suiteId != suiteId)) {
+            continue;
+        }
+
+        midp_free_properties(&pEntry->properties);
+        pcsl_mem_free(pEntry->pBuckets);
+        pEntry->suiteId = UNUSED_SUITE_ID;
+        pEntry->properties.numberOfProperties = 0;
+        pEntry->pBuckets = NULL;
+        pEntry->pNext = NULL;
+        pEntry->numberOfBuckets = 0;
+    }
 }
 
 
@@ -753,6 +809,146 @@ midp_get_suite_property(SuiteIdType suiteId,
 /*                          Implementation                      */
 /* ------------------------------------------------------------ */
 
+/**
+ * Calculates the bucket of a property key in the given hash index.
+ *
+ * @param key property key
+ * @param numberOfBuckets number of buckets, a power of 2
+ *
+ * @return bucket index
+ */
+static int
+property_key_hash(const pcsl_string* key, int numberOfBuckets) {
+    const jchar* pChars;
+    unsigned long hash = 0;
+    jint len, i;
+
+    len = pcsl_string_utf16_length(key);
+    if (len > 0) {
+        pChars = pcsl_string_get_utf16_data(key);
+        if (pChars != NULL) {
+            for (i = 0; i < len; i++) {
+                hash = hash * 31 + pChars[i];
+            }
+            pcsl_string_release_utf16_data(pChars, key);
+        }
+    }
+
+    return (int)((hash ^ (hash >> 16)) & (numberOfBuckets - 1));
+}
+
+/**
+ * Returns the parsed properties of the suite, reading and indexing the
+ * suite's property file if they are not in the cache yet. The least
+ * recently used entry is replaced when the cache is full.
+ *
+ * @param suiteId ID of the suite
+ * @param ppEntry [out] receives the cache entry of the suite
+ *
+ * @return error code (ALL_OK if successful)
+ */
+static MIDPError
+get_cached_suite_properties(SuiteIdType suiteId,
+                            SuitePropertyCacheEntry** ppEntry) {
+    SuitePropertyCacheEntry* pEntry = NULL;
+    MidpProperties prop;
+    int i, n, bucket;
+
+    for (i = 0; i < SUITE_PROPERTY_CACHE_SIZE; i++) {
+        if (g_propertyCache[i].suiteId == suiteId) {
+            g_propertyCache[i].lastUsed = ++g_propertyCacheClock;
+            *ppEntry = &g_propertyCache[i];
+            return ALL_OK;
+        }
+    }
+
+    prop = midp_get_suite_properties(suiteId);
+    if (prop.status != ALL_OK) {
+        return (MIDPError)prop.status;
+    }
+
+    /* find a free or the least recently used entry */
+    for (i = 0; i < SUITE_PROPERTY_CACHE_SIZE; i++) {
+        if (g_propertyCache[i].suiteId == UNUSED_SUITE_ID) {
+            pEntry = &g_propertyCache[i];
+            break;
+        }
+
+        if (pEntry == NULL || g_propertyCache[i].lastUsed < pEntry->lastUsed) {
+            pEntry = &g_propertyCache[i];
+        }
+    }
+
+    if (pEntry->suiteId != UNUSED_SUITE_ID) {
+        invalidate_suite_property_cache(pEntry->suiteId);
+    }
+
+    /* the smallest power of 2 that is not less than the number of keys */
+    n = 1;
+    while (n < prop.numberOfProperties) {
+        n <<= 1;
+    }
+
+    /* buckets and chain links share one allocation */
+    pEntry->pBuckets = (int*)pcsl_mem_malloc(
+        (n + prop.numberOfProperties) * sizeof(int));
+    if (pEntry->pBuckets == NULL) {
+        midp_free_properties(&prop);
+        return OUT_OF_MEMORY;
+    }
+
+    pEntry->pNext = pEntry->pBuckets + n;
+    pEntry->numberOfBuckets = n;
+    for (i = 0; i < n; i++) {
+        pEntry->pBuckets[i] = -1;
+    }
+
+    /*
+     * Insert in reverse order so that the first occurrence of a duplicated
+     * key is found first, as with midp_find_property().
+     */
+    for (i = prop.numberOfProperties - 1; i >= 0; i--) {
+        bucket = property_key_hash(&prop.pStringArr[i * 2], n);
+        pEntry->pNext[i] = pEntry->pBuckets[bucket];
+        pEntry->pBuckets[bucket] = i;
+    }
+
+    pEntry->suiteId = suiteId;
+    pEntry->properties = prop;
+    pEntry->lastUsed = ++g_propertyCacheClock;
+    *ppEntry = pEntry;
+
+    return ALL_OK;
+}
+
+/**
+ * Finds the property with the given key in a cache entry.
+ *
+ * @param pEntry cache entry of the suite
+ * @param key key of property to find
+ *
+ * @return a pointer to the property value,
+ *        or to PCSL_STRING_NULL if not found.
+ */
+static pcsl_string*
+find_cached_property(SuitePropertyCacheEntry* pEntry, const pcsl_string* key) {
+    pcsl_string* pStrings = pEntry->properties.pStringArr;
+    int i;
+
+    if (pEntry->numberOfBuckets == 0) {
+        return (pcsl_string*)&PCSL_STRING_NULL;
+    }
+
+    for (i = pEntry->pBuckets[property_key_hash(key, pEntry->numberOfBuckets)];
+            i != -1; i = pEntry->pNext[i]) {
+        if (pcsl_string_equals(&pStrings[i * 2], key)) {
+            return &pStrings[(i * 2) + 1];
+        }
+    }
+
+    return (pcsl_string*)&PCSL_STRING_NULL;
+}
+
 /**
  * Checks if a midlet suite or dynamic component with the given name
  * created by the given vendor exists.
@@ -802,30 +998,19 @@ get_suite_or_component_id(ComponentType type, SuiteIdType suiteId,
         return status;
     }
 
-    pData = g_pSuitesData;
-
     /* try to find a suite */
-    while (pData != NULL) {
-        if (pcsl_string_equals(&pData->varSuiteData.suiteName, name) &&
-                pcsl_string_equals(&pData->varSuiteData.suiteVendor, vendor)
+    pData = get_suite_data_by_name(type, suiteId, vendor, name);
+    if (pData != NULL) {
 #if ENABLE_DYNAMIC_COMPONENTS
-                    && (type == pData->type) && (type != COMPONENT_DYNAMIC ||
-                        (type == COMPONENT_DYNAMIC && suiteId == pData->suiteId))
-#endif
-        ) {
-#if ENABLE_DYNAMIC_COMPONENTS
-            if (type != COMPONENT_DYNAMIC) {
-                *pId = (jint)pData->suiteId;
-            } else {
-                *pId = (jint)pData->componentId;
-            }
-#else
+        if (type != COMPONENT_DYNAMIC) {
             *pId = (jint)pData->suiteId;
-#endif /* ENABLE_DYNAMIC_COMPONENTS */
-            return ALL_OK; /* IMPL_NOTE: consider SUITE_CORRUPTED_ERROR */
+        } else {
+            *pId = (jint)pData->componentId;
         }
-
-        pData = pData->nextEntry;
+#else
+        *pId = (jint)pData->suiteId;
+#endif /* ENABLE_DYNAMIC_COMPONENTS */
+        return ALL_OK; /* IMPL_NOTE: consider SUITE_CORRUPTED_ERROR */
     }
 
     /* suite or component was not found - create a new suite or component ID */
@@ -46,16 +46,40 @@
  */
 #define MAX_FREE_ENTRIES 10
 
+/**
+ * Maximal number of unused bytes allowed in the data region of the file
+ * containing the cache until it is compacted.
+ */
+#define MAX_WASTED_BYTES (16 * 1024)
+
+/**
+ * Maximal number of icons moved by one step of the compaction of the file
+ * containing the cache. Each move copies one icon or rewrites one slot of
+ * the index, so a step takes a bounded time.
+ */
+#define MAX_COMPACTION_MOVES 4
+
 /**
  * A number of additional free entries that will be allocated in
- * g_pIconCache array to avoid memory reallocations when a new
- * icon is added into the cache.
+ * g_pIconCache array and in the index of the file to avoid memory
+ * reallocations and rewriting the file when a new icon is added
+ * into the cache.
  */
 #define RESERVED_CACHE_ENTRIES_NUM 10
 
+/** Number of buckets in the suite ID hash of the cache entries. */
+#define ICON_HASH_SIZE 32
+
+/** Hash function of the suite ID. */
+#define ICON_HASH(id) (((unsigned long)(id)) & (ICON_HASH_SIZE - 1))
+
+/** Size of the buffer used to copy icon data between files. */
+#define ICON_COPY_BUFFER_SIZE 512
+
 /**
  * An array of IconCache structures representing
- * the icon cache in the memory.
+ * the icon cache in the memory. Entry i describes the i-th slot
+ * of the index in the file.
  */
 static IconCache* g_pIconCache = NULL;
 
@@ -68,9 +92,148 @@ static int g_numberOfIcons = 0;
 /** Number of entries currently allocated in the g_pIconCache array. */
 static int g_numberOfEntries = 0;
 
-#define ADJUST_POS_IN_BUF(pos, bufferLen, n) \
-    pos += n; \
-    bufferLen -= n;
+/** First entry of each bucket of the suite ID hash, or -1. */
+static int g_iconHash[ICON_HASH_SIZE];
+
+/**
+ * Number of index slots in the file, 0 if the file does not exist
+ * or must be rewritten.
+ */
+static int g_iconIndexCapacity = 0;
+
+/** Number of free entries in the index of the file. */
+static int g_numberOfFreeIcons = 0;
+
+/** Number of unused bytes in the data region of the file. */
+static long g_iconWastedBytes = 0;
+
+/** Offset of the end of the data region of the file. */
+static long g_iconDataEnd = 0;
+
+/**
+ * Returns the size occupied by the icon's data in the file.
+ *
+ * @param pInfo the cached icon
+ *
+ * @return aligned size of the icon's name and binary data
+ */
+#define ICON_DATA_SIZE(pInfo) \
+    SUITESTORE_ALIGN_4((long)(pInfo)->nameLength + (pInfo)->imageDataLength)
+
+/**
+ * Returns true if the cached icon is in use and its data are in the file.
+ *
+ * @param pInfo the cached icon
+ */
+#define ICON_IN_FILE(pInfo) \
+    (!(pInfo)->isFree && (pInfo)->entryOffsetInFile != (unsigned long)-1)
+
+/**
+ * Returns the offset of the given slot of the index in the file.
+ */
+#define ICON_INDEX_SLOT_OFFSET(slot) \
+    ((long)sizeof(IconCacheHeader) + (long)(slot) * sizeof(IconCacheEntry))
+
+/**
+ * Returns the offset of the data region in the file.
+ */
+#define ICON_DATA_START() \
+    SUITESTORE_ALIGN_4(ICON_INDEX_SLOT_OFFSET(g_iconIndexCapacity))
+
+/** Forward declaration */
+static MIDPError rewrite_icons_file();
+
+/**
+ * Builds the suite ID hash of the cache entries.
+ */
+static void
+rebuild_icon_hash() {
+    int i;
+    unsigned long bucket;
+
+    for (i = 0; i < ICON_HASH_SIZE; i++) {
+        g_iconHash[i] = -1;
+    }
+
+    for (i = g_numberOfIcons - 1; i >= 0; i--) {
+        if (g_pIconCache[i].pInfo[0].isFree) {
+            continue;
+        }
+
+        bucket = ICON_HASH(g_pIconCache[i].suiteId);
+        g_pIconCache[i].nextEntry = g_iconHash[bucket];
+        g_iconHash[bucket] = i;
+    }
+}
+
+/**
+ * Removes the given entry from the suite ID hash.
+ *
+ * @param index index of the entry in g_pIconCache
+ */
+static void
+unlink_icon_entry(int index) {
+    int* pLink = &g_iconHash[ICON_HASH(g_pIconCache[index].suiteId)];
+
+    while (*pLink != -1) {
+        if (*pLink == index) {
+            *pLink = g_pIconCache[index].nextEntry;
+            break;
+        }
+        pLink = &g_pIconCache[*pLink].nextEntry;
+    }
+}
+
+/**
+ * Recomputes the end of the data region and the number of unused bytes
+ * in it from the entries in use, so that they stay consistent with each
+ * other when the data region shrinks.
+ */
+static void
+update_icon_data_end() {
+    int i;
+    long end, liveBytes = 0;
+
+    g_iconDataEnd = ICON_DATA_START();
+
+    for (i = 0; i < g_numberOfIcons; i++) {
+        CachedImageInfo* pInfo = &g_pIconCache[i].pInfo[0];
+
+        if (!ICON_IN_FILE(pInfo)) {
+            continue;
+        }
+
+        end = (long)pInfo->entryOffsetInFile + ICON_DATA_SIZE(pInfo);
+        if (end > g_iconDataEnd) {
+            g_iconDataEnd = end;
+        }
+        liveBytes += ICON_DATA_SIZE(pInfo);
+    }
+
+    g_iconWastedBytes = g_iconDataEnd - ICON_DATA_START() - liveBytes;
+    if (g_iconWastedBytes < 0) {
+        /* the data of an entry are referenced twice */
+        g_iconWastedBytes = 0;
+    }
+}
+
+/**
+ * Gets a full path to a file of the icon cache.
+ *
+ * @param pName name of the file in the internal storage root
+ * @param pFilename [out] receives the full path
+ *
+ * @return status code (ALL_OK if successful)
+ */
+static MIDPError
+get_icons_file_name(const pcsl_string* pName, pcsl_string* pFilename) {
+    if (pcsl_string_cat(storage_get_root(INTERNAL_STORAGE_ID),
+                        pName, pFilename) != PCSL_STRING_OK) {
+        return OUT_OF_MEMORY;
+    }
+
+    return ALL_OK;
+}
 
 /**
  * Search for a structure containing the cached suite's icon(s)
@@ -83,7 +246,6 @@ static int g_numberOfEntries = 0;
  */
 static IconCache*
 get_icon_cache_for_suite(SuiteIdType suiteId) {
-    IconCache* pData;
     int i;
 
     if (!g_iconsLoaded) {
@@ -93,10 +255,8 @@ get_icon_cache_for_suite(SuiteIdType suiteId) {
         }
     }
 
-    pData = g_pIconCache;
-
-    /* search the given suite Id in the array of cache entries */
-    for (i = 0; i < g_numberOfIcons; i++) {
+    for (i = g_iconHash[ICON_HASH(suiteId)]; i != -1;
+            i = g_pIconCache[i].nextEntry) {
         if (g_pIconCache[i].suiteId == suiteId) {
             return &g_pIconCache[i];
         }
@@ -108,22 +268,22 @@ get_icon_cache_for_suite(SuiteIdType suiteId) {
 /**
  * Initializes the icons cache.
  *
+ * Only the index of the file is read here; the names and the binary data
+ * of the icons are read by midp_get_suite_icon() when they are needed.
+ *
  * @return status code: ALL_OK if no errors,
  *         OUT_OF_MEMORY if malloc failed
  *         IO_ERROR if an IO_ERROR
  */
 MIDPError midp_load_suites_icons() {
-    int i;
-    long bufferLen, pos, alignedOffset;
-    char* buffer = NULL;
+    int i, handle;
+    long bytesRead;
     char* pszError = NULL;
-    unsigned char* pIconBytes;
-    pcsl_string_status rc;
     pcsl_string iconsCacheFile;
-    IconCache *pIconsData, *pData;
-    IconCacheHeader* pCacheFileHeader;
-    IconCacheEntry* pNextCacheEntry;
-    int numOfIcons = 0, numOfEntries = 0;
+    IconCacheHeader header;
+    IconCacheEntry* pIndex = NULL;
+    IconCache* pIconsData = NULL;
+    int numOfEntries;
     MIDPError status;
 
     if (g_iconsLoaded) {
@@ -134,272 +294,669 @@ MIDPError midp_load_suites_icons() {
         return OUT_OF_MEMORY;
     }
 
-    /* get a full path to the _suites.dat */
-    rc = pcsl_string_cat(storage_get_root(INTERNAL_STORAGE_ID),
-                         &ICON_CACHE_FILENAME, &iconsCacheFile);
-    if (rc != PCSL_STRING_OK) {
-        return OUT_OF_MEMORY;
+    status = get_icons_file_name(&ICON_CACHE_FILENAME, &iconsCacheFile);
+    if (status != ALL_OK) {
+        return status;
     }
 
-    /* read the file */
-    status = read_file(&pszError, &iconsCacheFile, &buffer, &bufferLen);
-    pcsl_string_free(&iconsCacheFile);
-    storageFreeError(pszError);
+    g_numberOfIcons     = 0;
+    g_numberOfFreeIcons = 0;
+    g_iconIndexCapacity = 0;
+    g_iconWastedBytes   = 0;
+    g_iconDataEnd       = 0;
 
-    if (status == NOT_FOUND || (status == ALL_OK && bufferLen == 0)) {
-        /* _icons.dat is absent or empty, it's a normal situation */
-        g_pIconCache  = NULL;
+    handle = storage_open(&pszError, &iconsCacheFile, OPEN_READ);
+    pcsl_string_free(&iconsCacheFile);
+    if (pszError != NULL) {
+        /* _icons.dat is absent, it's a normal situation */
+        storageFreeError(pszError);
+        rebuild_icon_hash();
         g_iconsLoaded = 1;
         return ALL_OK;
     }
 
-    if (status == ALL_OK && bufferLen < (long)(sizeof(unsigned long)<<1)) {
-        status = IO_ERROR; /* _icons.dat is corrupted */
-    }
+    do {
+        bytesRead = storageRead(&pszError, handle, (char*)&header,
+                                sizeof(IconCacheHeader));
+        if (pszError != NULL) {
+            status = IO_ERROR;
+            break;
+        }
+
+        if (bytesRead <= 0 ||
+                (bytesRead >= (long)(sizeof(unsigned long) << 1) &&
+                    header.magic == ICON_CACHE_MAGIC &&
+                        header.version != ICON_CACHE_VERSION)) {
+            /*
+             * _icons.dat is empty or was written by a previous version,
+             * it will be rewritten when an icon is added
+             */
+            break;
+        }
+
+        if (bytesRead != sizeof(IconCacheHeader) ||
+                header.magic != ICON_CACHE_MAGIC ||
+                header.numberOfEntries < 0 ||
+                header.numberOfEntries > header.indexCapacity ||
+                header.numberOfFreeEntries < 0 ||
+                header.numberOfFreeEntries > header.numberOfEntries) {
+            status = IO_ERROR; /* _icons.dat is corrupted */
+            break;
+        }
+
+        numOfEntries = header.numberOfEntries + RESERVED_CACHE_ENTRIES_NUM;
+        pIconsData = (IconCache*)pcsl_mem_malloc(sizeof(IconCache) *
+                                                 numOfEntries);
+        if (pIconsData == NULL) {
+            status = OUT_OF_MEMORY;
+            break;
+        }
+
+        if (header.numberOfEntries > 0) {
+            long indexSize = header.numberOfEntries * sizeof(IconCacheEntry);
+
+            pIndex = (IconCacheEntry*)pcsl_mem_malloc(indexSize);
+            if (pIndex == NULL) {
+                status = OUT_OF_MEMORY;
+                break;
+            }
+
+            /* the whole index is read at once */
+            if (storageRead(&pszError, handle, (char*)pIndex, indexSize) !=
+                    indexSize || pszError != NULL) {
+                status = IO_ERROR;
+                break;
+            }
+        }
+
+        for (i = 0; i < header.numberOfEntries; i++) {
+            IconCache* pData = &pIconsData[i];
+
+            pData->suiteId = pIndex[i].suiteId;
+            pData->numberOfCachedImages = 1;
+            pData->pInfo[0].isFree = pIndex[i].isFree;
+            pData->pInfo[0].imageName = PCSL_STRING_NULL;
+            pData->pInfo[0].nameLength = pIndex[i].nameLength;
+            pData->pInfo[0].entryOffsetInFile = pIndex[i].isFree ?
+                (unsigned long)-1 : (unsigned long)pIndex[i].dataOffset;
+            pData->pInfo[0].imageDataLength = pIndex[i].imageDataLength;
+            pData->pInfo[0].pImageData = NULL;
+        }
+
+        g_pIconCache        = pIconsData;
+        g_numberOfEntries   = numOfEntries;
+        g_numberOfIcons     = header.numberOfEntries;
+        g_numberOfFreeIcons = header.numberOfFreeEntries;
+        g_iconIndexCapacity = header.indexCapacity;
+        update_icon_data_end();
+        pIconsData = NULL;
+    } while (0);
+
+    storageFreeError(pszError);
+    pszError = NULL;
+    storageClose(&pszError, handle);
+    storageFreeError(pszError);
+
+    pcsl_mem_free(pIndex);
+
     if (status != ALL_OK) {
-        pcsl_mem_free(buffer);
+        pcsl_mem_free(pIconsData);
         return status;
     }
 
-    /* parse its contents */
-    pos = 0;
+    rebuild_icon_hash();
+    g_iconsLoaded = 1;
 
-    /* checking the file header */
-    pCacheFileHeader = (IconCacheHeader*)buffer;
-    if (pCacheFileHeader->magic   != ICON_CACHE_MAGIC ||
-        pCacheFileHeader->version != ICON_CACHE_VERSION ||
-        pCacheFileHeader->numberOfFreeEntries >
-            pCacheFileHeader->numberOfEntries) {
-        pcsl_mem_free(buffer);
-        return IO_ERROR;
+    if (g_numberOfFreeIcons > MAX_FREE_ENTRIES ||
+            g_iconWastedBytes > MAX_WASTED_BYTES) {
+        (void)midp_compact_icons();
     }
 
-    numOfIcons   = pCacheFileHeader->numberOfEntries -
-                       pCacheFileHeader->numberOfFreeEntries;
-    numOfEntries = numOfIcons + RESERVED_CACHE_ENTRIES_NUM;
+    return ALL_OK;
+}
 
-    ADJUST_POS_IN_BUF(pos, bufferLen, sizeof(IconCacheHeader));
+/**
+ * Reads the name and the binary data of the cached icon from the file
+ * if they are not in memory yet.
+ *
+ * @param pInfo the cached icon
+ *
+ * @return status code (ALL_OK if successful)
+ */
+static MIDPError
+load_icon_data(CachedImageInfo* pInfo) {
+    pcsl_string iconsCacheFile;
+    char* pszError = NULL;
+    jchar* pName = NULL;
+    unsigned char* pImageData = NULL;
+    MIDPError status;
+    int handle;
 
-    pIconsData = (IconCache*) pcsl_mem_malloc(sizeof(IconCache) * numOfEntries);
-    if (pIconsData == NULL) {
-        pcsl_mem_free(buffer);
-        return OUT_OF_MEMORY;
+    if (pInfo->pImageData != NULL) {
+        return ALL_OK;
     }
 
-    /* iterating through the cache entries */
-    for (i = 0; i < pCacheFileHeader->numberOfEntries; i++) {
-        if ((long)sizeof(IconCacheEntry) > bufferLen) {
-            status = IO_ERROR;
-            break;
-        }
-
-        pNextCacheEntry = (IconCacheEntry*)&buffer[pos];
+    if (pInfo->entryOffsetInFile == (unsigned long)-1 ||
+            pInfo->nameLength <= 0 || pInfo->imageDataLength <= 0) {
+        return IO_ERROR;
+    }
 
-        if (pNextCacheEntry->isFree) {
-            alignedOffset = sizeof(IconCacheEntry) +
-                pNextCacheEntry->nameLength + pNextCacheEntry->imageDataLength;
-            alignedOffset = SUITESTORE_ALIGN_4(alignedOffset);
-            ADJUST_POS_IN_BUF(pos, bufferLen, alignedOffset);
-            continue;
-        }
+    status = get_icons_file_name(&ICON_CACHE_FILENAME, &iconsCacheFile);
+    if (status != ALL_OK) {
+        return status;
+    }
 
-        pData = &pIconsData[i];
-        pData->suiteId = pNextCacheEntry->suiteId;
-        pData->numberOfCachedImages = 1;
+    handle = storage_open(&pszError, &iconsCacheFile, OPEN_READ);
+    pcsl_string_free(&iconsCacheFile);
+    if (pszError != NULL) {
+        storageFreeError(pszError);
+        return IO_ERROR;
+    }
 
-        pData->pInfo[0].isFree = 0;
-        pData->pInfo[0].entryOffsetInFile = pos;
-        pData->pInfo[0].pImageData = (unsigned char*)pcsl_mem_malloc(
-            pNextCacheEntry->imageDataLength);
-        if (pData->pInfo[0].pImageData == NULL) {
+    do {
+        pName = (jchar*)pcsl_mem_malloc(pInfo->nameLength);
+        pImageData = (unsigned char*)pcsl_mem_malloc(pInfo->imageDataLength);
+        if (pName == NULL || pImageData == NULL) {
             status = OUT_OF_MEMORY;
             break;
         }
 
-        pIconBytes = (unsigned char*)pNextCacheEntry + sizeof(IconCacheEntry) +
-            pNextCacheEntry->nameLength;
-        if (sizeof(IconCacheEntry) + pNextCacheEntry->nameLength +
-                pNextCacheEntry->imageDataLength > (unsigned long)bufferLen) {
+        storagePosition(&pszError, handle, (long)pInfo->entryOffsetInFile);
+        if (pszError != NULL) {
             status = IO_ERROR;
             break;
         }
 
-        pData->pInfo[0].imageDataLength = pNextCacheEntry->imageDataLength;
+        if (storageRead(&pszError, handle, (char*)pName,
+                pInfo->nameLength) != pInfo->nameLength || pszError != NULL) {
+            status = IO_ERROR;
+            break;
+        }
 
-        memcpy(pData->pInfo[0].pImageData, pIconBytes,
-               pNextCacheEntry->imageDataLength);
+        if (storageRead(&pszError, handle, (char*)pImageData,
+                pInfo->imageDataLength) != pInfo->imageDataLength ||
+                    pszError != NULL) {
+            status = IO_ERROR;
+            break;
+        }
 
-        rc = pcsl_string_convert_from_utf16(
-            (jchar*)((char*)pNextCacheEntry + sizeof(IconCacheEntry)),
-            pNextCacheEntry->nameLength >> 1,
-            &pData->pInfo[0].imageName);
-        if (rc != PCSL_STRING_OK) {
+        if (pcsl_string_convert_from_utf16(pName, pInfo->nameLength >> 1,
+                &pInfo->imageName) != PCSL_STRING_OK) {
             status = OUT_OF_MEMORY;
             break;
         }
 
-        alignedOffset = sizeof(IconCacheEntry) +
-            pNextCacheEntry->nameLength + pNextCacheEntry->imageDataLength;
-        alignedOffset = SUITESTORE_ALIGN_4(alignedOffset);
-        ADJUST_POS_IN_BUF(pos, bufferLen, alignedOffset);
-    } /* end for (numOfEntries) */
+        pInfo->pImageData = pImageData;
+        pImageData = NULL;
+    } while (0);
 
-    if (status == ALL_OK) {
-        g_numberOfIcons = numOfIcons;
-        g_numberOfEntries = numOfEntries;
-        g_pIconCache    = pIconsData;
-        g_iconsLoaded   = 1;
+    storageFreeError(pszError);
+    pszError = NULL;
+    storageClose(&pszError, handle);
+    storageFreeError(pszError);
+
+    pcsl_mem_free(pName);
+    pcsl_mem_free(pImageData);
+
+    return status;
+}
+
+/**
+ * Writes the name and the binary data of the cached icon into the file
+ * at the current position, padding them to the 4-byte boundary.
+ *
+ * @param handle handle of the file opened for writing
+ * @param pInfo the cached icon, its name and data must be in memory
+ *
+ * @return status code (ALL_OK if successful)
+ */
+static MIDPError
+write_icon_data(int handle, const CachedImageInfo* pInfo) {
+    char* pszError = NULL;
+    jchar* pName;
+    jsize nameLength = 0;
+    jint padding = 0;
+    long padLength;
+
+    pName = (jchar*)pcsl_mem_malloc(pInfo->nameLength);
+    if (pName == NULL) {
+        return OUT_OF_MEMORY;
+    }
+
+    if (pcsl_string_convert_to_utf16(&pInfo->imageName, pName,
+            pInfo->nameLength >> 1, &nameLength) != PCSL_STRING_OK) {
+        pcsl_mem_free(pName);
+        return OUT_OF_MEMORY;
+    }
+
+    storageWrite(&pszError, handle, (char*)pName, pInfo->nameLength);
+    pcsl_mem_free(pName);
+
+    if (pszError == NULL) {
+        storageWrite(&pszError, handle, (char*)pInfo->pImageData,
+                     pInfo->imageDataLength);
+    }
+
+    padLength = ICON_DATA_SIZE(pInfo) -
+        (pInfo->nameLength + pInfo->imageDataLength);
+    if (pszError == NULL && padLength > 0) {
+        storageWrite(&pszError, handle, (char*)&padding, padLength);
+    }
+
+    if (pszError != NULL) {
+        storageFreeError(pszError);
+        return IO_ERROR;
+    }
 
-        if (pCacheFileHeader->numberOfFreeEntries > MAX_FREE_ENTRIES) {
-            (void)midp_compact_icons();
+    return ALL_OK;
+}
+
+/**
+ * Copies the name and the binary data of the cached icon from one file
+ * into the current position of another one without loading them into
+ * memory.
+ *
+ * @param srcHandle handle of the file containing the icon
+ * @param dstHandle handle of the file opened for writing
+ * @param pInfo the cached icon
+ *
+ * @return status code (ALL_OK if successful)
+ */
+static MIDPError
+copy_icon_data(int srcHandle, int dstHandle, const CachedImageInfo* pInfo) {
+    char buffer[ICON_COPY_BUFFER_SIZE];
+    char* pszError = NULL;
+    long remaining = ICON_DATA_SIZE(pInfo);
+    long n;
+
+    storagePosition(&pszError, srcHandle, (long)pInfo->entryOffsetInFile);
+
+    while (pszError == NULL && remaining > 0) {
+        n = (remaining > ICON_COPY_BUFFER_SIZE) ?
+            ICON_COPY_BUFFER_SIZE : remaining;
+        if (storageRead(&pszError, srcHandle, buffer, n) != n) {
+            break;
         }
-    } else {
-        /* IMPL_NOTE: free the memory allocated for the image itself */
-        pcsl_mem_free(pIconsData);
+        if (pszError == NULL) {
+            storageWrite(&pszError, dstHandle, buffer, n);
+        }
+        remaining -= n;
     }
 
-    pcsl_mem_free(buffer);
+    if (pszError != NULL || remaining > 0) {
+        storageFreeError(pszError);
+        return IO_ERROR;
+    }
 
-    return status;
+    return ALL_OK;
+}
+
+/**
+ * Writes the header of the file and the given slot of the index.
+ *
+ * @param handle handle of the file opened for writing
+ * @param slot index of the entry in g_pIconCache to write,
+ *             -1 to write the header only
+ *
+ * @return status code (ALL_OK if successful)
+ */
+static MIDPError
+write_icons_index(int handle, int slot) {
+    char* pszError = NULL;
+    IconCacheHeader header;
+    IconCacheEntry entry;
+
+    if (slot >= 0) {
+        const CachedImageInfo* pInfo = &g_pIconCache[slot].pInfo[0];
+
+        entry.isFree = pInfo->isFree;
+        entry.suiteId = g_pIconCache[slot].suiteId;
+        entry.imageDataLength = pInfo->imageDataLength;
+        entry.nameLength = pInfo->nameLength;
+        entry.dataOffset = (long)pInfo->entryOffsetInFile;
+
+        storagePosition(&pszError, handle, ICON_INDEX_SLOT_OFFSET(slot));
+        if (pszError == NULL) {
+            storageWrite(&pszError, handle, (char*)&entry,
+                         sizeof(IconCacheEntry));
+        }
+    }
+
+    if (pszError == NULL) {
+        header.magic = ICON_CACHE_MAGIC;
+        header.version = ICON_CACHE_VERSION;
+        header.numberOfEntries = g_numberOfIcons;
+        header.numberOfFreeEntries = g_numberOfFreeIcons;
+        header.indexCapacity = g_iconIndexCapacity;
+        header.wastedBytes = g_iconWastedBytes;
+
+        storagePosition(&pszError, handle, 0);
+        if (pszError == NULL) {
+            storageWrite(&pszError, handle, (char*)&header,
+                         sizeof(IconCacheHeader));
+        }
+    }
+
+    if (pszError != NULL) {
+        storageFreeError(pszError);
+        return IO_ERROR;
+    }
+
+    return ALL_OK;
 }
 
 /**
- * Writes the cache contents into the icon cache file.
+ * Writes the changes of one cache entry into the icon cache file.
+ * If the entry is in use, its data are appended to the data region;
+ * then the entry's slot of the index and the header are updated in place.
+ * The whole file is rewritten only if the index has no room for the
+ * entry.
  *
- * @param pIconCache currently unused; may be useful to optimize
- *                   the writing of the file
+ * @param slot index of the changed entry in g_pIconCache
  *
  * @return status code: ALL_OK if no errors,
  *         OUT_OF_MEMORY if malloc failed
  *         IO_ERROR if an IO_ERROR
  */
-static MIDPError store_suites_icons(const IconCache* pIconCache) {
-    MIDPError status = ALL_OK;
-    int i;
-    long bufferLen, pos, alignedOffset;
-    char* buffer = NULL;
+static MIDPError store_suite_icon(int slot) {
+    MIDPError status;
     char *pszError = NULL;
-    pcsl_string_status rc;
     pcsl_string iconsCacheFile;
-    IconCache *pData;
-    IconCacheHeader* pCacheFileHeader;
-    IconCacheEntry* pNextCacheEntry;
+    CachedImageInfo* pInfo = &g_pIconCache[slot].pInfo[0];
+    int handle;
 
-    if (pIconCache == NULL) {
-        return BAD_PARAMS;
+    if (slot >= g_iconIndexCapacity) {
+        /* no room in the index of the file */
+        return rewrite_icons_file();
     }
 
-    /* IMPL_NOTE: currently the whole file is rewritten */
+    status = get_icons_file_name(&ICON_CACHE_FILENAME, &iconsCacheFile);
+    if (status != ALL_OK) {
+        return status;
+    }
 
-    /* get a full path to the _icons.dat */
-    rc = pcsl_string_cat(storage_get_root(INTERNAL_STORAGE_ID),
-                         &ICON_CACHE_FILENAME, &iconsCacheFile);
-    if (rc != PCSL_STRING_OK) {
-        return OUT_OF_MEMORY;
+    handle = storage_open(&pszError, &iconsCacheFile, OPEN_READ_WRITE);
+    pcsl_string_free(&iconsCacheFile);
+    if (pszError != NULL) {
+        storageFreeError(pszError);
+        return rewrite_icons_file();
+    }
+
+    if (!pInfo->isFree) {
+        storagePosition(&pszError, handle, g_iconDataEnd);
+        if (pszError != NULL) {
+            storageFreeError(pszError);
+            status = IO_ERROR;
+        } else {
+            status = write_icon_data(handle, pInfo);
+            if (status == ALL_OK) {
+                pInfo->entryOffsetInFile = (unsigned long)g_iconDataEnd;
+                g_iconDataEnd += ICON_DATA_SIZE(pInfo);
+            }
+        }
+    }
+
+    if (status == ALL_OK) {
+        status = write_icons_index(handle, slot);
     }
 
-    if (!g_numberOfIcons) {
-        /* there are no icons to cache, truncate the file */
-        status = write_file(&pszError, &iconsCacheFile, buffer, 0);
+    storageClose(&pszError, handle);
+    storageFreeError(pszError);
+
+    return status;
+}
+
+/**
+ * Moves the name and the binary data of the cached icon to another place
+ * of the same file. The places must not overlap.
+ *
+ * @param handle handle of the file opened for reading and writing
+ * @param pInfo the cached icon
+ * @param dstOffset offset the data are moved to
+ *
+ * @return status code (ALL_OK if successful)
+ */
+static MIDPError
+move_icon_data(int handle, const CachedImageInfo* pInfo, long dstOffset) {
+    char buffer[ICON_COPY_BUFFER_SIZE];
+    char* pszError = NULL;
+    long srcOffset = (long)pInfo->entryOffsetInFile;
+    long remaining = ICON_DATA_SIZE(pInfo);
+    long n;
+
+    while (remaining > 0) {
+        n = (remaining > ICON_COPY_BUFFER_SIZE) ?
+            ICON_COPY_BUFFER_SIZE : remaining;
+
+        storagePosition(&pszError, handle, srcOffset);
+        if (pszError != NULL ||
+                storageRead(&pszError, handle, buffer, n) != n ||
+                    pszError != NULL) {
+            break;
+        }
+
+        storagePosition(&pszError, handle, dstOffset);
+        if (pszError == NULL) {
+            storageWrite(&pszError, handle, buffer, n);
+        }
+        if (pszError != NULL) {
+            break;
+        }
+
+        srcOffset += n;
+        dstOffset += n;
+        remaining -= n;
+    }
+
+    if (pszError != NULL || remaining > 0) {
         storageFreeError(pszError);
-        pcsl_string_free(&iconsCacheFile);
-        return status;
+        return IO_ERROR;
     }
 
-    /* allocate a buffer to store icons data */
-    bufferLen = g_numberOfIcons * sizeof(IconCacheEntry) +
-        sizeof(IconCacheHeader);
+    return ALL_OK;
+}
 
-    for (i = 0; i < g_numberOfIcons; i++) {
-        long strLen, dataLen = 0;
-        pData = &g_pIconCache[i];
-        if (pData->pInfo[0].isFree) {
+/**
+ * Finds the lowest place of the data region, ending before the given
+ * offset, that is not used by any icon and can hold the given number
+ * of bytes.
+ *
+ * @param size number of bytes to place
+ * @param limit offset the place must end at or before
+ *
+ * @return offset of the place, -1 if there is none
+ */
+static long
+find_icon_hole(long size, long limit) {
+    long best = -1;
+    long candidate;
+    int i, j;
+
+    /* a hole starts at the beginning of the region or after an icon */
+    for (i = -1; i < g_numberOfIcons; i++) {
+        if (i == -1) {
+            candidate = ICON_DATA_START();
+        } else if (ICON_IN_FILE(&g_pIconCache[i].pInfo[0])) {
+            candidate = (long)g_pIconCache[i].pInfo[0].entryOffsetInFile +
+                ICON_DATA_SIZE(&g_pIconCache[i].pInfo[0]);
+        } else {
+            continue;
+        }
+
+        if (candidate + size > limit || (best != -1 && candidate >= best)) {
             continue;
         }
 
-        dataLen += pData->pInfo[0].imageDataLength;
+        for (j = 0; j < g_numberOfIcons; j++) {
+            const CachedImageInfo* pInfo = &g_pIconCache[j].pInfo[0];
 
-        strLen = pcsl_string_utf16_length(&pData->pInfo[0].imageName);
-        strLen <<= 1;
-        if (strLen > 0) {
-            dataLen += strLen;
+            if (ICON_IN_FILE(pInfo) &&
+                    (long)pInfo->entryOffsetInFile < candidate + size &&
+                    candidate < (long)pInfo->entryOffsetInFile +
+                        ICON_DATA_SIZE(pInfo)) {
+                break;
+            }
         }
 
-        bufferLen += SUITESTORE_ALIGN_4(dataLen);
+        if (j == g_numberOfIcons) {
+            best = candidate;
+        }
     }
 
-    buffer = pcsl_mem_malloc(bufferLen);
-    if (buffer == NULL) {
-        pcsl_string_free(&iconsCacheFile);
-        return OUT_OF_MEMORY;
-    }
+    return best;
+}
 
-    /* assemble the information about all icons into the allocated buffer */
-    pos = 0;
+/**
+ * Compacts the storage with the cached icons.
+ *
+ * The file is compacted in place by a bounded step of at most
+ * MAX_COMPACTION_MOVES moves, further steps follow on later changes:
+ * <ul>
+ *   <li>the icon at the end of the data region is moved into the lowest
+ *       hole below it that can hold it, then the end of the region and
+ *       the number of unused bytes are recomputed;</li>
+ *   <li>the free slots at the end of the index are dropped and the
+ *       other ones are filled with the last entries of the index.</li>
+ * </ul>
+ * Each move leaves the file consistent: the data of an icon are copied
+ * before its slot of the index refers to them. Holes smaller than the
+ * last icon are only reclaimed by a rewrite of the file, which happens
+ * when the index has to grow.
+ *
+ * @return status code (ALL_OK if successful)
+ */
+MIDPError midp_compact_icons() {
+    MIDPError status;
+    char* pszError = NULL;
+    pcsl_string iconsCacheFile;
+    CachedImageInfo* pInfo;
+    unsigned long oldOffset;
+    long hole, fileSize;
+    int handle, i, tail;
+    int moves = 0;
 
-    pCacheFileHeader = (IconCacheHeader*)buffer;
-    pCacheFileHeader->magic   = ICON_CACHE_MAGIC;
-    pCacheFileHeader->version = ICON_CACHE_VERSION;
-    pCacheFileHeader->numberOfEntries = g_numberOfIcons;
-    pCacheFileHeader->numberOfFreeEntries = 0;
+    if (!g_iconsLoaded) {
+        return ALL_OK;
+    }
 
-    ADJUST_POS_IN_BUF(pos, bufferLen, sizeof(IconCacheHeader));
+    if (g_iconIndexCapacity == 0) {
+        /* the file is absent or must be rewritten */
+        return rewrite_icons_file();
+    }
 
-    for (i = 0; i < g_numberOfIcons; i++) {
-        pData = &g_pIconCache[i];
+    status = get_icons_file_name(&ICON_CACHE_FILENAME, &iconsCacheFile);
+    if (status != ALL_OK) {
+        return status;
+    }
 
-        if (pData->pInfo[0].isFree) {
-            if (pCacheFileHeader->numberOfEntries > 0) {
-                pCacheFileHeader->numberOfEntries--;
+    handle = storage_open(&pszError, &iconsCacheFile, OPEN_READ_WRITE);
+    pcsl_string_free(&iconsCacheFile);
+    if (pszError != NULL) {
+        storageFreeError(pszError);
+        return rewrite_icons_file();
+    }
+
+    /* move the icons at the end of the data region into the holes */
+    while (status == ALL_OK && moves < MAX_COMPACTION_MOVES &&
+            g_iconWastedBytes > 0) {
+        tail = -1;
+        for (i = 0; i < g_numberOfIcons; i++) {
+            if (ICON_IN_FILE(&g_pIconCache[i].pInfo[0]) && (tail == -1 ||
+                    g_pIconCache[i].pInfo[0].entryOffsetInFile >
+                        g_pIconCache[tail].pInfo[0].entryOffsetInFile)) {
+                tail = i;
             }
-            continue;
         }
 
-        pNextCacheEntry = (IconCacheEntry*)&buffer[pos];
-        pNextCacheEntry->isFree = 0;
-        pNextCacheEntry->suiteId = pData->suiteId;
-        pNextCacheEntry->imageDataLength = pData->pInfo[0].imageDataLength;
+        if (tail == -1) {
+            break;
+        }
 
-        rc = pcsl_string_convert_to_utf16(&pData->pInfo[0].imageName,
-            (jchar*)((char*)pNextCacheEntry + sizeof(IconCacheEntry)),
-                bufferLen / sizeof(jchar),
-                    &(pNextCacheEntry->nameLength));
-        if (rc != PCSL_STRING_OK) {
-            status = OUT_OF_MEMORY;
+        pInfo = &g_pIconCache[tail].pInfo[0];
+        hole = find_icon_hole(ICON_DATA_SIZE(pInfo),
+                              (long)pInfo->entryOffsetInFile);
+        if (hole == -1) {
             break;
         }
 
-        /* convert UTF16 length to size in bytes */
-        pNextCacheEntry->nameLength <<= 1;
-        if (pNextCacheEntry->nameLength <= 0) {
-            status = IO_ERROR;
+        status = move_icon_data(handle, pInfo, hole);
+        if (status == ALL_OK) {
+            oldOffset = pInfo->entryOffsetInFile;
+            pInfo->entryOffsetInFile = (unsigned long)hole;
+            update_icon_data_end();
+
+            status = write_icons_index(handle, tail);
+            if (status != ALL_OK) {
+                /* the old copy is still intact */
+                pInfo->entryOffsetInFile = oldOffset;
+                update_icon_data_end();
+            }
+        }
+
+        moves++;
+    }
+
+    /* fill the free slots of the index with its last entries */
+    while (status == ALL_OK && g_numberOfIcons > 0) {
+        tail = g_numberOfIcons - 1;
+
+        if (g_pIconCache[tail].pInfo[0].isFree) {
+            g_numberOfIcons--;
+            g_numberOfFreeIcons--;
+            continue;
+        }
+
+        if (g_numberOfFreeIcons == 0 || moves >= MAX_COMPACTION_MOVES) {
             break;
         }
 
-        memcpy((char*)pNextCacheEntry + sizeof(IconCacheEntry) +
-            pNextCacheEntry->nameLength, pData->pInfo[0].pImageData,
-                pNextCacheEntry->imageDataLength);
+        for (i = 0; !g_pIconCache[i].pInfo[0].isFree; i++) {
+        }
 
-        alignedOffset = sizeof(IconCacheEntry) +
-            pNextCacheEntry->nameLength + pNextCacheEntry->imageDataLength;
-        alignedOffset = SUITESTORE_ALIGN_4(alignedOffset);
-        ADJUST_POS_IN_BUF(pos, bufferLen, alignedOffset);
+        g_pIconCache[i] = g_pIconCache[tail];
+        g_numberOfIcons--;
+        g_numberOfFreeIcons--;
+
+        /*
+         * The header drops the last slot first: if the step is
+         * interrupted, the entry is lost from the cache rather than
+         * listed twice in the index.
+         */
+        status = write_icons_index(handle, -1);
+        if (status == ALL_OK) {
+            status = write_icons_index(handle, i);
+        }
+
+        moves++;
+    }
+
+    if (status == ALL_OK) {
+        status = write_icons_index(handle, -1);
     }
 
     if (status == ALL_OK) {
-        /* write the buffer into the file */
-        status = write_file(&pszError, &iconsCacheFile, buffer, pos);
+        /* give the space after the data region back */
+        fileSize = storageSizeOf(&pszError, handle);
+        if (pszError == NULL && fileSize > g_iconDataEnd) {
+            storageTruncate(&pszError, handle, g_iconDataEnd);
+        }
         storageFreeError(pszError);
+        pszError = NULL;
+    } else {
+        /* the file is rewritten on the next change */
+        g_iconIndexCapacity = 0;
     }
 
-    /* cleanup */
-    pcsl_mem_free(buffer);
-    pcsl_string_free(&iconsCacheFile);
+    storageClose(&pszError, handle);
+    storageFreeError(pszError);
+
+    rebuild_icon_hash();
 
     return status;
 }
 
-#undef ADJUST_POS_IN_BUF
+#undef ICON_DATA_START
+#undef ICON_INDEX_SLOT_OFFSET
 
 /**
  * Frees the memory allocated for icons cache.
@@ -429,10 +986,14 @@ void midp_free_suites_icons() {
         pcsl_mem_free(g_pIconCache);
     }
 
-    g_pIconCache      = NULL;
-    g_iconsLoaded     = 0;
-    g_numberOfIcons   = 0;
-    g_numberOfEntries = 0;
+    g_pIconCache        = NULL;
+    g_iconsLoaded       = 0;
+    g_numberOfIcons     = 0;
+    g_numberOfEntries   = 0;
+    g_numberOfFreeIcons = 0;
+    g_iconIndexCapacity = 0;
+    g_iconWastedBytes   = 0;
+    g_iconDataEnd       = 0;
 }
 
 /**
@@ -453,6 +1014,7 @@ MIDPError
 midp_get_suite_icon(SuiteIdType suiteId, const pcsl_string* pIconName,
                     unsigned char** ppImageData, int* pImageDataLen) {
     IconCache* pIconCache;
+    MIDPError status;
     int i;
 
     if (pIconName == NULL || ppImageData == NULL || pImageDataLen == NULL ||
@@ -467,6 +1029,12 @@ midp_get_suite_icon(SuiteIdType suiteId, const pcsl_string* pIconName,
 
     /* iterate through the icons cache */
     for (i = 0; i < pIconCache->numberOfCachedImages; i++) {
+        /* the icon is read from the file when it is requested first */
+        status = load_icon_data(&pIconCache->pInfo[i]);
+        if (status != ALL_OK) {
+            return status;
+        }
+
         if (pcsl_string_equals(pIconName, &(pIconCache->pInfo[i].imageName))) {
             *pImageDataLen = pIconCache->pInfo[i].imageDataLength;
             *ppImageData = pIconCache->pInfo[i].pImageData;
@@ -508,6 +1076,7 @@ midp_add_suite_icon(SuiteIdType suiteId, const pcsl_string* pIconName,
 
     do {
         IconCache* pIconCache = get_icon_cache_for_suite(suiteId);
+        unsigned long bucket;
 
         if (pIconCache == NULL) {
             /* try to find a free entry */
@@ -515,6 +1084,7 @@ midp_add_suite_icon(SuiteIdType suiteId, const pcsl_string* pIconName,
             for (n = 0; n < g_numberOfIcons; n++) {
                 if (g_pIconCache[n].pInfo[0].isFree) {
                     pIconCache = &g_pIconCache[n];
+                    g_numberOfFreeIcons--;
                     break;
                 }
             }
@@ -538,34 +1108,50 @@ midp_add_suite_icon(SuiteIdType suiteId, const pcsl_string* pIconName,
                     }
 
                     g_pIconCache = pIconsData;
+                    g_numberOfEntries = numOfEntries;
                 }
 
                 pIconCache = &g_pIconCache[g_numberOfIcons];
                 g_numberOfIcons++;
             }
+
+            pIconCache->suiteId = suiteId;
+            bucket = ICON_HASH(suiteId);
+            pIconCache->nextEntry = g_iconHash[bucket];
+            g_iconHash[bucket] = pIconCache - g_pIconCache;
         } else {
             /* cache entry for this suite already exists, free it first */
+            if (pIconCache->pInfo[0].entryOffsetInFile != (unsigned long)-1) {
+                g_iconWastedBytes += ICON_DATA_SIZE(&pIconCache->pInfo[0]);
+            }
             pcsl_string_free(&pIconCache->pInfo[0].imageName);
             pcsl_mem_free(pIconCache->pInfo[0].pImageData);
         }
 
         /* until the entry is filled, consider it as free */
         pIconCache->pInfo[0].isFree = 1;
-
-        pIconCache->suiteId = suiteId;
+        pIconCache->pInfo[0].pImageData = NULL;
         pIconCache->numberOfCachedImages = 1;
 
         res = pcsl_string_dup(pIconName, &pIconCache->pInfo[0].imageName);
         if (res != PCSL_STRING_OK) {
+            unlink_icon_entry(pIconCache - g_pIconCache);
+            g_numberOfFreeIcons++;
             status = OUT_OF_MEMORY;
             break;
         }
         pIconCache->pInfo[0].isFree = 0;
+        pIconCache->pInfo[0].nameLength =
+            pcsl_string_utf16_length(pIconName) << 1;
         pIconCache->pInfo[0].entryOffsetInFile = (unsigned long)-1;
         pIconCache->pInfo[0].imageDataLength = imageDataLen;
         pIconCache->pInfo[0].pImageData = pImageData;
 
-        status = store_suites_icons(pIconCache);
+        status = store_suite_icon(pIconCache - g_pIconCache);
+
+        if (status == ALL_OK && g_iconWastedBytes > MAX_WASTED_BYTES) {
+            status = midp_compact_icons();
+        }
     } while (0);
 
     return status;
@@ -580,26 +1166,203 @@ midp_add_suite_icon(SuiteIdType suiteId, const pcsl_string* pIconName,
  */
 MIDPError midp_remove_suite_icons(SuiteIdType suiteId) {
     IconCache* pIconCache = get_icon_cache_for_suite(suiteId);
+    MIDPError status;
+    int slot;
 
-    if (pIconCache != NULL) {
-        pcsl_string_free(&pIconCache->pInfo[0].imageName);
-        pcsl_mem_free(pIconCache->pInfo[0].pImageData);
-        pIconCache->pInfo[0].pImageData = NULL;
-        pIconCache->pInfo[0].isFree = 1;
+    if (pIconCache == NULL) {
+        return ALL_OK;
+    }
+
+    slot = pIconCache - g_pIconCache;
+    unlink_icon_entry(slot);
+
+    if (pIconCache->pInfo[0].entryOffsetInFile != (unsigned long)-1) {
+        g_iconWastedBytes += ICON_DATA_SIZE(&pIconCache->pInfo[0]);
     }
 
-    return store_suites_icons(pIconCache);
+    pcsl_string_free(&pIconCache->pInfo[0].imageName);
+    pcsl_mem_free(pIconCache->pInfo[0].pImageData);
+    pIconCache->pInfo[0].pImageData = NULL;
+    pIconCache->pInfo[0].isFree = 1;
+    g_numberOfFreeIcons++;
+
+    /* only the slot of the index and the header are rewritten */
+    status = store_suite_icon(slot);
+
+    if (status == ALL_OK && (g_numberOfFreeIcons > MAX_FREE_ENTRIES ||
+            g_iconWastedBytes > MAX_WASTED_BYTES)) {
+        status = midp_compact_icons();
+    }
+
+    return status;
 }
 
 /**
- * Compacts the storage with the cached icons.
+ * Rewrites the storage with the cached icons.
  *
- * IMPL_NOTE: currently does nothing because the whole file
- *            containing the cached icons is overwritten, so
- *            there are no free entries in it.
+ * The file is rewritten without free entries and unused data into a
+ * temporary file that then replaces the original one. The icons that
+ * have not been loaded into memory are copied between the files in
+ * small portions. This is done only when the file is absent or its
+ * index has no room for a new entry, midp_compact_icons() compacts
+ * the file in place otherwise.
  *
  * @return status code (ALL_OK if successful)
  */
-MIDPError midp_compact_icons() {
-    return ALL_OK;
+static MIDPError rewrite_icons_file() {
+    MIDPError status = ALL_OK;
+    char* pszError = NULL;
+    pcsl_string iconsCacheFile, tmpFile;
+    int srcHandle = -1, dstHandle;
+    int i, n;
+    long dataEnd;
+    unsigned long* pOffsets = NULL;
+    unsigned long offset;
+    int offsetsSwitched = 0;
+
+    if (!g_iconsLoaded) {
+        return ALL_OK;
+    }
+
+    status = get_icons_file_name(&ICON_CACHE_FILENAME, &iconsCacheFile);
+    if (status != ALL_OK) {
+        return status;
+    }
+
+    status = get_icons_file_name(&ICON_CACHE_TMP_FILENAME, &tmpFile);
+    if (status != ALL_OK) {
+        pcsl_string_free(&iconsCacheFile);
+        return status;
+    }
+
+    dstHandle = storage_open(&pszError, &tmpFile, OPEN_READ_WRITE_TRUNCATE);
+    if (pszError != NULL) {
+        storageFreeError(pszError);
+        pcsl_string_free(&iconsCacheFile);
+        pcsl_string_free(&tmpFile);
+        return IO_ERROR;
+    }
+
+    /* the source is not needed if all the icons are in memory */
+    for (i = 0; i < g_numberOfIcons; i++) {
+        if (!g_pIconCache[i].pInfo[0].isFree &&
+                g_pIconCache[i].pInfo[0].pImageData == NULL) {
+            srcHandle = storage_open(&pszError, &iconsCacheFile, OPEN_READ);
+            if (pszError != NULL) {
+                storageFreeError(pszError);
+                pszError = NULL;
+                srcHandle = -1;
+                status = IO_ERROR;
+            }
+            break;
+        }
+    }
+
+    /* remove the free entries from the memory */
+    for (i = 0, n = 0; i < g_numberOfIcons; i++) {
+        if (!g_pIconCache[i].pInfo[0].isFree) {
+            g_pIconCache[n++] = g_pIconCache[i];
+        }
+    }
+
+    g_numberOfIcons = n;
+    g_numberOfFreeIcons = 0;
+    g_iconWastedBytes = 0;
+    g_iconIndexCapacity = n + RESERVED_CACHE_ENTRIES_NUM;
+    dataEnd = SUITESTORE_ALIGN_4((long)sizeof(IconCacheHeader) +
+        (long)g_iconIndexCapacity * sizeof(IconCacheEntry));
+
+    if (n > 0 && status == ALL_OK) {
+        pOffsets = (unsigned long*)pcsl_mem_malloc(n * sizeof(unsigned long));
+        if (pOffsets == NULL) {
+            status = OUT_OF_MEMORY;
+        }
+    }
+
+    /* write the data region, the old offsets are needed until it's done */
+    for (i = 0; i < g_numberOfIcons && status == ALL_OK; i++) {
+        CachedImageInfo* pInfo = &g_pIconCache[i].pInfo[0];
+
+        storagePosition(&pszError, dstHandle, dataEnd);
+        if (pszError != NULL) {
+            storageFreeError(pszError);
+            pszError = NULL;
+            status = IO_ERROR;
+            break;
+        }
+
+        if (pInfo->pImageData != NULL) {
+            status = write_icon_data(dstHandle, pInfo);
+        } else {
+            status = copy_icon_data(srcHandle, dstHandle, pInfo);
+        }
+
+        pOffsets[i] = (unsigned long)dataEnd;
+        dataEnd += ICON_DATA_SIZE(pInfo);
+    }
+
+    /* switch to the new offsets and write the index and the header */
+    if (status == ALL_OK) {
+        for (i = 0; i < g_numberOfIcons; i++) {
+            offset = g_pIconCache[i].pInfo[0].entryOffsetInFile;
+            g_pIconCache[i].pInfo[0].entryOffsetInFile = pOffsets[i];
+            pOffsets[i] = offset;
+        }
+        offsetsSwitched = 1;
+
+        for (i = 0; i < g_numberOfIcons && status == ALL_OK; i++) {
+            status = write_icons_index(dstHandle, i);
+        }
+    }
+
+    if (status == ALL_OK) {
+        status = write_icons_index(dstHandle, -1);
+    }
+
+    if (srcHandle != -1) {
+        storageClose(&pszError, srcHandle);
+        storageFreeError(pszError);
+        pszError = NULL;
+    }
+
+    storageClose(&pszError, dstHandle);
+    storageFreeError(pszError);
+    pszError = NULL;
+
+    if (status == ALL_OK) {
+        storage_delete_file(&pszError, &iconsCacheFile);
+        storageFreeError(pszError);
+        pszError = NULL;
+
+        storage_rename_file(&pszError, &tmpFile, &iconsCacheFile);
+        if (pszError != NULL) {
+            storageFreeError(pszError);
+            status = IO_ERROR;
+        }
+    } else {
+        storage_delete_file(&pszError, &tmpFile);
+        storageFreeError(pszError);
+
+        if (offsetsSwitched) {
+            /* the index was being written, restore the old offsets */
+            for (i = 0; i < g_numberOfIcons; i++) {
+                g_pIconCache[i].pInfo[0].entryOffsetInFile = pOffsets[i];
+            }
+        }
+    }
+
+    if (status == ALL_OK) {
+        g_iconDataEnd = dataEnd;
+    } else {
+        /* the file is rewritten on the next change */
+        g_iconIndexCapacity = 0;
+    }
+
+    pcsl_mem_free(pOffsets);
+    rebuild_icon_hash();
+
+    pcsl_string_free(&iconsCacheFile);
+    pcsl_string_free(&tmpFile);
+
+    return status;
 }
@@ -74,7 +74,7 @@ suite_listeners_notify(int listenerType, int when, MIDPError status,
 
     while (pListener) {
         if (pListener->genericListener.listenerType == listenerType &&
-                pListener->whenToCall == when) {
+                (pListener->whenToCall & when) != 0) {
             ((SUITESTORE_LISTENER)pListener->genericListener.fn_callback)(
                 listenerType, when, status, pSuiteData);
         }
@@ -95,12 +95,17 @@ suite_listeners_notify(int listenerType, int when, MIDPError status,
  *     SUITESTORE_LISTENER_TYPE_INSTALL - the listener will be called on
  *         the installation of a midlet suite;
  *     SUITESTORE_LISTENER_TYPE_REMOVE - the listener will be called on
- *         the removal of a midlet suite.
+ *         the removal of a midlet suite;
+ *     SUITESTORE_LISTENER_TYPE_APP_IMAGE - the listener will be called on
+ *         the generation of the application image of a midlet suite,
+ *         possibly on a thread other than the one installing the suite.
  * </pre>
- * @param whenToCall defines when the listener should be called:
+ * @param whenToCall defines when the listener should be called, a
+ * combination of:
  * <pre>
  *     SUITESTORE_OPERATION_START - before the operation on the suite;
  *     SUITESTORE_OPERATION_END - after the operation;
+ *     SUITESTORE_OPERATION_PROGRESS - during the operation;
  *     SUITESTORE_WHEN_ALWAYS - before and after the operation.
  * </pre>
  *
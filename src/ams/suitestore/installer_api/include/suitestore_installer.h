@@ -114,6 +114,46 @@ typedef struct _MidpSuiteSettings {
 MIDPError
 midp_create_suite_id(SuiteIdType* pSuiteId);
 
+#if ENABLE_MONET
+/**
+ * Progress of the generation of an application image, in percent, see
+ * midp_get_app_image_progress(). JVM_CreateAppImage() does not report
+ * its own progress, so the whole conversion is a single step.
+ */
+#define APP_IMAGE_PROGRESS_STARTED    0
+#define APP_IMAGE_PROGRESS_CONVERTING 10
+#define APP_IMAGE_PROGRESS_DONE       100
+
+/**
+ * Cancels the generation of the application image of the suite being
+ * installed. May be called at any time from a listener of
+ * SUITESTORE_LISTENER_TYPE_APP_IMAGE type or from another thread while
+ * the image is generated. If the conversion is already running, it is
+ * completed and its result is dropped. The image is then created on the
+ * first run of the suite.
+ */
+void
+midp_cancel_app_image_generation();
+
+/**
+ * Returns the progress of the generation of the application image,
+ * meaningful in a listener of SUITESTORE_LISTENER_TYPE_APP_IMAGE type.
+ *
+ * @return one of the APP_IMAGE_PROGRESS_ values
+ */
+int
+midp_get_app_image_progress();
+
+/**
+ * Waits until the application image started by the last installation
+ * has been generated. The image is generated on a separate thread that
+ * uses the VM and reads the suite list: this must be called before the
+ * VM is started and before the suite list is modified.
+ */
+void
+midp_wait_app_image_generation();
+#endif /* ENABLE_MONET */
+
 #if ENABLE_DYNAMIC_COMPONENTS
 /**
  * Returns a unique identifier of a MIDlet suite's dynamic component.
@@ -48,6 +48,48 @@
 #include <suitestore_installer.h>
 #include <suitestore_task_manager.h>
 
+#if ENABLE_MONET
+#include <jvm.h>
+#include <midpMalloc.h>
+#include <midpNativeThread.h>
+
+/**
+ * Generation of the application image of an installed suite, run on
+ * the app image thread.
+ */
+typedef struct _AppImageTask {
+    /** suite the image is generated for, an entry of the suite list */
+    const MidletSuiteData* pSuiteData;
+    /** path of the JAR file of the suite */
+    JvmPathChar* pJarFile;
+    /** path of the application image to create */
+    JvmPathChar* pBinFile;
+    /** the same path as pBinFile, to remove a cancelled image */
+    pcsl_string binPath;
+} AppImageTask;
+
+/** The generation in progress, there is at most one at a time. */
+static AppImageTask appImageTask;
+
+/** Set if the generation of the application image has been cancelled. */
+static volatile jboolean appImageCancelled = KNI_FALSE;
+
+/** Progress of the generation, one of the APP_IMAGE_PROGRESS_ values. */
+static volatile int appImageProgress = APP_IMAGE_PROGRESS_STARTED;
+
+/** Set while the app image thread runs or has not been waited for. */
+static jboolean appImagePending = KNI_FALSE;
+
+/** Set once appImageDone has been initialized. */
+static jboolean appImageEventReady = KNI_FALSE;
+
+/** Signaled by the app image thread when the generation is finished. */
+static midp_NativeEvent appImageDone;
+
+static void create_app_image(SuiteIdType suiteId, StorageIdType storageId);
+static void free_app_image_task();
+#endif /* ENABLE_MONET */
+
 #if ENABLE_ICON_CACHE
 #include <suitestore_icon_cache.h>
 
@@ -367,6 +409,11 @@ midp_store_suite(const MidpInstallInfo* pInstallInfo,
         return BAD_PARAMS;
     }
 
+#if ENABLE_MONET
+    /* the suite list is about to change */
+    midp_wait_app_image_generation();
+#endif
+
     suiteId = pSuiteData->suiteId;
 
 #if ENABLE_DYNAMIC_COMPONENTS
@@ -576,6 +623,17 @@ midp_store_suite(const MidpInstallInfo* pInstallInfo,
     if (status != ALL_OK) {
         midp_remove_suite(suiteId);
     }
+#if ENABLE_MONET
+    else {
+#if ENABLE_DYNAMIC_COMPONENTS
+        if (pSuiteData->type == COMPONENT_REGULAR_SUITE)
+#endif
+        {
+            /* The suite is committed, prepare it for the first run. */
+            create_app_image(suiteId, pSuiteData->storageId);
+        }
+    }
+#endif
 
     /* notify the listeners that the installation finished */
     suite_listeners_notify(SUITESTORE_LISTENER_TYPE_INSTALL,
@@ -584,6 +642,47 @@ midp_store_suite(const MidpInstallInfo* pInstallInfo,
     return status;
 }
 
+#if ENABLE_MONET
+/**
+ * Cancels the generation of the application image of the suite being
+ * installed. May be called at any time from a listener of
+ * SUITESTORE_LISTENER_TYPE_APP_IMAGE type or from another thread while
+ * the image is generated. If the conversion is already running, it is
+ * completed and its result is dropped. The image is then created on the
+ * first run of the suite.
+ */
+void
+midp_cancel_app_image_generation() {
+    appImageCancelled = KNI_TRUE;
+}
+
+/**
+ * Returns the progress of the generation of the application image,
+ * meaningful in a listener of SUITESTORE_LISTENER_TYPE_APP_IMAGE type.
+ *
+ * @return one of the APP_IMAGE_PROGRESS_ values
+ */
+int
+midp_get_app_image_progress() {
+    return appImageProgress;
+}
+
+/**
+ * Waits until the application image started by the last installation
+ * has been generated. The image is generated on a separate thread that
+ * uses the VM and reads the suite list: this must be called before the
+ * VM is started and before the suite list is modified.
+ */
+void
+midp_wait_app_image_generation() {
+    if (appImagePending) {
+        midp_waitNativeEvent(&appImageDone);
+        appImagePending = KNI_FALSE;
+        free_app_image_task();
+    }
+}
+#endif /* ENABLE_MONET */
+
 /* ------------------------------------------------------------ */
 /*                          Implementation                      */
 /* ------------------------------------------------------------ */
@@ -864,6 +963,9 @@ add_to_suite_list_and_save(MidletSuiteData* pMsd) {
         free_suite_data_entry(pExistingSuite);
     }
 
+    /* the list has changed */
+    invalidate_suite_index();
+
     status = write_suites_data(&pszError);
     storageFreeError(pszError);
 
@@ -877,6 +979,7 @@ add_to_suite_list_and_save(MidletSuiteData* pMsd) {
         }
         pMsd->nextEntry = NULL;
         g_pSuitesData = pPrev;
+        invalidate_suite_index();
     }
 
     return status;
@@ -1078,9 +1181,223 @@ store_install_properties(SuiteIdType suiteId,
     storageClose(&pszError, handle);
     storageFreeError(pszError);
 
+    /* the property file has been rewritten */
+    invalidate_suite_property_cache(suiteId);
+
     return status;
 }
 
+#if ENABLE_MONET
+/**
+ * Copies the given path into a newly allocated zero-terminated
+ * JvmPathChar string. The caller is responsible for freeing it
+ * using midpFree().
+ *
+ * @param pPath path to copy
+ *
+ * @return the copy or NULL if out of memory
+ */
+static JvmPathChar*
+get_jvm_path(const pcsl_string* pPath) {
+    jint len = pcsl_string_utf16_length(pPath);
+    const jchar* pData;
+    JvmPathChar* pResult;
+    jint i;
+
+    pResult = (JvmPathChar*)midpMalloc((len + 1) * sizeof (JvmPathChar));
+    if (pResult == NULL) {
+        return NULL;
+    }
+
+    pData = pcsl_string_get_utf16_data(pPath);
+    if (pData == NULL) {
+        midpFree(pResult);
+        return NULL;
+    }
+
+    for (i = 0; i < len; i++) {
+        pResult[i] = (JvmPathChar)pData[i];
+    }
+    pResult[len] = 0;
+
+    pcsl_string_release_utf16_data(pData, pPath);
+
+    return pResult;
+}
+
+/**
+ * Notifies the listeners of SUITESTORE_LISTENER_TYPE_APP_IMAGE type of
+ * the progress of the generation.
+ *
+ * @param progress one of the APP_IMAGE_PROGRESS_ values
+ */
+static void
+notify_app_image_progress(int progress) {
+    appImageProgress = progress;
+    suite_listeners_notify(SUITESTORE_LISTENER_TYPE_APP_IMAGE,
+        SUITESTORE_OPERATION_PROGRESS, ALL_OK, appImageTask.pSuiteData);
+}
+
+/**
+ * Converts the classes of the suite of appImageTask and notifies the
+ * listeners of the result. Cancellation is checked before each step;
+ * an image completed after the generation was cancelled is removed.
+ */
+static void
+run_app_image_task() {
+    MIDPError status = GENERAL_ERROR;
+    char* pszError;
+
+    do {
+        if (appImageCancelled) {
+            break;
+        }
+
+        notify_app_image_progress(APP_IMAGE_PROGRESS_CONVERTING);
+        if (appImageCancelled) {
+            break;
+        }
+
+        /*
+         * The classes are left in the JAR, like the Java installer does:
+         * a cancelled or broken image can be removed and the suite still
+         * runs, the image is then created on its first run.
+         */
+        if (JVM_CreateAppImage(appImageTask.pJarFile,
+                               appImageTask.pBinFile, 0) != 0) {
+            break;
+        }
+
+        if (appImageCancelled) {
+            storage_delete_file(&pszError, &appImageTask.binPath);
+            storageFreeError(pszError);
+            break;
+        }
+
+        notify_app_image_progress(APP_IMAGE_PROGRESS_DONE);
+        status = ALL_OK;
+    } while (0);
+
+    suite_listeners_notify(SUITESTORE_LISTENER_TYPE_APP_IMAGE,
+        SUITESTORE_OPERATION_END, status, appImageTask.pSuiteData);
+}
+
+/**
+ * App image thread routine: generates the image of appImageTask, then
+ * signals appImageDone.
+ *
+ * @param param not used
+ */
+static MIDP_THREAD_ROUTINE(appImageThread, param) {
+    (void)param;
+
+    run_app_image_task();
+    midp_signalNativeEvent(&appImageDone);
+
+    return MIDP_THREAD_ROUTINE_RESULT;
+}
+
+/**
+ * Frees the paths of appImageTask.
+ */
+static void
+free_app_image_task() {
+    midpFree(appImageTask.pJarFile);
+    midpFree(appImageTask.pBinFile);
+    pcsl_string_free(&appImageTask.binPath);
+    appImageTask.pJarFile = NULL;
+    appImageTask.pBinFile = NULL;
+    appImageTask.pSuiteData = NULL;
+}
+
+/**
+ * Starts the conversion of the classes of a newly installed suite to a
+ * Monet application image, so the first run of the suite does not have
+ * to do it.
+ *
+ * The conversion runs on a separate thread, midp_wait_app_image_generation()
+ * waits for it. Only if the thread cannot be started, as with the stub
+ * native thread implementation, it runs before this function returns.
+ *
+ * Listeners of SUITESTORE_LISTENER_TYPE_APP_IMAGE type are notified
+ * before, during and after the conversion; the status passed at the end
+ * is ALL_OK if the image was created. If the image is not created the
+ * suite is still usable, the image is then created on its first run.
+ *
+ * Nothing is done when the VM is running: JVM_CreateAppImage() cannot
+ * run next to it, and the Java installer creates the image in its own
+ * installation step.
+ *
+ * @param suiteId ID of the installed suite
+ * @param storageId ID of the storage where the suite is installed
+ */
+static void
+create_app_image(SuiteIdType suiteId, StorageIdType storageId) {
+    pcsl_string jarPath = PCSL_STRING_NULL;
+    MIDPError status;
+
+    if (getMidpInitLevel() >= VM_LEVEL) {
+        return;
+    }
+
+    appImageTask.pSuiteData = get_suite_data(suiteId);
+    appImageTask.binPath = PCSL_STRING_NULL;
+    appImageCancelled = KNI_FALSE;
+    appImageProgress = APP_IMAGE_PROGRESS_STARTED;
+
+    suite_listeners_notify(SUITESTORE_LISTENER_TYPE_APP_IMAGE,
+        SUITESTORE_OPERATION_START, ALL_OK, appImageTask.pSuiteData);
+
+    do {
+        if (appImageCancelled) {
+            status = GENERAL_ERROR;
+            break;
+        }
+
+        status = midp_suite_get_class_path(suiteId, storageId, KNI_FALSE,
+                                           &jarPath);
+        if (status != ALL_OK) {
+            break;
+        }
+
+        status = midp_suite_get_bin_app_path(suiteId, storageId,
+                                             &appImageTask.binPath);
+        if (status != ALL_OK) {
+            break;
+        }
+
+        appImageTask.pJarFile = get_jvm_path(&jarPath);
+        appImageTask.pBinFile = get_jvm_path(&appImageTask.binPath);
+        if (appImageTask.pJarFile == NULL || appImageTask.pBinFile == NULL) {
+            status = OUT_OF_MEMORY;
+            break;
+        }
+
+        if (!appImageEventReady) {
+            appImageEventReady =
+                (midp_initNativeEvent(&appImageDone) == 0);
+        }
+
+        if (appImageEventReady &&
+                midp_startNativeThread((midp_ThreadRoutine*)&appImageThread,
+                    NULL) != MIDP_INVALID_NATIVE_THREAD_ID) {
+            appImagePending = KNI_TRUE;
+        } else {
+            run_app_image_task();
+            free_app_image_task();
+        }
+    } while (0);
+
+    pcsl_string_free(&jarPath);
+
+    if (status != ALL_OK) {
+        suite_listeners_notify(SUITESTORE_LISTENER_TYPE_APP_IMAGE,
+            SUITESTORE_OPERATION_END, status, appImageTask.pSuiteData);
+        free_app_image_task();
+    }
+}
+#endif /* ENABLE_MONET */
+
 #if ENABLE_ICON_CACHE
 /**
  * Loads a native image from cache or jar file into memory.
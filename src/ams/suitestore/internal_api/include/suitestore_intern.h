@@ -182,6 +182,39 @@ MidletSuiteData* get_suite_data(SuiteIdType suiteId);
 MidletSuiteData* get_component_data(ComponentIdType componentId);
 #endif /* ENABLE_DYNAMIC_COMPONENTS */
 
+/**
+ * Search for a structure describing the suite or the dynamic component
+ * by its vendor and name.
+ *
+ * @param type type of the component
+ * @param suiteId if type == COMPONENT_DYNAMIC, contains ID of the suite
+ *                the component belongs to; unused otherwise
+ * @param vendor vendor of the suite or component
+ * @param name name of the suite or component
+ *
+ * @return pointer to the MidletSuiteData structure containing
+ * the attributes or NULL if nothing was found
+ */
+MidletSuiteData* get_suite_data_by_name(ComponentType type,
+                                        SuiteIdType suiteId,
+                                        const pcsl_string* vendor,
+                                        const pcsl_string* name);
+
+/**
+ * Marks the hash indexes of the suite list as out of date. Must be called
+ * after entries are added to or removed from g_pSuitesData; the indexes
+ * are rebuilt by the next lookup.
+ */
+void invalidate_suite_index();
+
+/**
+ * Removes the parsed properties of the given suite from the property cache.
+ * Must be called when the suite's property file is rewritten or removed.
+ *
+ * @param suiteId ID of the suite, or UNUSED_SUITE_ID to clear the whole cache
+ */
+void invalidate_suite_property_cache(SuiteIdType suiteId);
+
 /**
  * Reads the file with information about the installed suites.
  *
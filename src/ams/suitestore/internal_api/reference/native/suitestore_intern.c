@@ -152,6 +152,45 @@ MidletSuiteData* g_pSuitesData = NULL;
 /** Indicates if the suite storage is already initialized. */
 static int g_suiteStorageInitDone = 0;
 
+/** Number of buckets in each of the suite list hash indexes. */
+#define SUITE_INDEX_SIZE 64
+
+/** Hash function of the suite ID and component ID indexes. */
+#define SUITE_ID_HASH(id) \
+    ((((unsigned long)(id)) ^ (((unsigned long)(id)) >> 8)) & \
+     (SUITE_INDEX_SIZE - 1))
+
+/** An entry of the suite list hash indexes. */
+typedef struct _suiteIndexNode {
+    /** The indexed suite or component. */
+    MidletSuiteData* pData;
+    /** Next node in the same bucket of the suite ID index, or -1. */
+    int nextById;
+#if ENABLE_DYNAMIC_COMPONENTS
+    /** Next node in the same bucket of the component ID index, or -1. */
+    int nextByComponentId;
+#endif
+    /** Next node in the same bucket of the vendor and name index, or -1. */
+    int nextByName;
+} SuiteIndexNode;
+
+/**
+ * Nodes of the suite list hash indexes, one per entry of g_pSuitesData.
+ * NULL if the indexes have to be rebuilt.
+ */
+static SuiteIndexNode* g_pSuiteIndexNodes = NULL;
+
+/** First node of each bucket of the suite ID index, or -1. */
+static int g_suiteIdIndex[SUITE_INDEX_SIZE];
+
+#if ENABLE_DYNAMIC_COMPONENTS
+/** First node of each bucket of the component ID index, or -1. */
+static int g_componentIdIndex[SUITE_INDEX_SIZE];
+#endif
+
+/** First node of each bucket of the vendor and name index, or -1. */
+static int g_suiteNameIndex[SUITE_INDEX_SIZE];
+
 /** Indicates if a transaction was started. */
 static int g_transactionStarted = 0;
 
@@ -182,6 +221,7 @@ suite_storage_init_impl() {
     }
 
     g_suiteStorageInitDone = 1;
+    invalidate_suite_index();
     g_pSuitesData        = NULL;
     g_numberOfSuites     = 0;
     g_isSuitesDataLoaded = 0;
@@ -233,6 +273,8 @@ suite_storage_cleanup_impl() {
     remove_all_storage_lock();
 
     suite_remove_all_listeners();
+
+    invalidate_suite_property_cache(UNUSED_SUITE_ID);
     
     if (g_isSuitesDataLoaded) {
         MidletSuiteData* pData = g_pSuitesData;
@@ -245,6 +287,7 @@ suite_storage_cleanup_impl() {
         }
     }
 
+    invalidate_suite_index();
     g_pSuitesData        = NULL;
     g_numberOfSuites     = 0;
     g_isSuitesDataLoaded = 0;
@@ -310,11 +353,130 @@ free_suites_data() {
         pData = pNextData;
     }
 
+    invalidate_suite_index();
     g_pSuitesData        = NULL;
     g_numberOfSuites     = 0;
     g_isSuitesDataLoaded = 0;
 }
 
+/**
+ * Marks the hash indexes of the suite list as out of date. Must be called
+ * after entries are added to or removed from g_pSuitesData; the indexes
+ * are rebuilt by the next lookup.
+ */
+void
+invalidate_suite_index() {
+    if (g_pSuiteIndexNodes != NULL) {
+        pcsl_mem_free(g_pSuiteIndexNodes);
+        g_pSuiteIndexNodes = NULL;
+    }
+}
+
+/**
+ * Calculates the hash of a suite's vendor and name.
+ *
+ * @param vendor vendor of the suite
+ * @param name name of the suite
+ *
+ * @return bucket of the vendor and name index
+ */
+static unsigned long
+suite_name_hash(const pcsl_string* vendor, const pcsl_string* name) {
+    const pcsl_string* strings[2];
+    const jchar* pChars;
+    unsigned long hash = 0;
+    jint len, i, j;
+
+    strings[0] = vendor;
+    strings[1] = name;
+
+    for (i = 0; i < 2; i++) {
+        len = pcsl_string_utf16_length(strings[i]);
+        if (len <= 0) {
+            continue;
+        }
+
+        pChars = pcsl_string_get_utf16_data(strings[i]);
+        if (pChars == NULL) {
+            continue;
+        }
+
+        for (j = 0; j < len; j++) {
+            hash = hash * 31 + pChars[j];
+        }
+
+        pcsl_string_release_utf16_data(pChars, strings[i]);
+    }
+
+    return (hash ^ (hash >> 16)) & (SUITE_INDEX_SIZE - 1);
+}
+
+/**
+ * Builds the hash indexes of the suite list if they are out of date.
+ *
+ * @return 1 if the indexes can be used, 0 if out of memory (the list
+ *         has to be searched sequentially then)
+ */
+static int
+build_suite_index() {
+    MidletSuiteData* pData;
+    unsigned long bucket;
+    int count = 0;
+    int i;
+
+    if (g_pSuiteIndexNodes != NULL) {
+        return 1;
+    }
+
+    for (pData = g_pSuitesData; pData != NULL; pData = pData->nextEntry) {
+        count++;
+    }
+
+    g_pSuiteIndexNodes = (SuiteIndexNode*)
+        pcsl_mem_malloc((count > 0 ? count : 1) * sizeof(SuiteIndexNode));
+    if (g_pSuiteIndexNodes == NULL) {
+        return 0;
+    }
+
+    for (i = 0; i < SUITE_INDEX_SIZE; i++) {
+        g_suiteIdIndex[i] = -1;
+#if ENABLE_DYNAMIC_COMPONENTS
+        g_componentIdIndex[i] = -1;
+#endif
+        g_suiteNameIndex[i] = -1;
+    }
+
+    /*
+     * Nodes are linked in reverse order, so the buckets are filled from
+     * the end of the list to keep the list order within a bucket.
+     */
+    for (i = 0, pData = g_pSuitesData; pData != NULL;
+            i++, pData = pData->nextEntry) {
+        g_pSuiteIndexNodes[i].pData = pData;
+    }
+
+    for (i = count - 1; i >= 0; i--) {
+        SuiteIndexNode* pNode = &g_pSuiteIndexNodes[i];
+
+        bucket = SUITE_ID_HASH(pNode->pData->suiteId);
+        pNode->nextById = g_suiteIdIndex[bucket];
+        g_suiteIdIndex[bucket] = i;
+
+#if ENABLE_DYNAMIC_COMPONENTS
+        bucket = SUITE_ID_HASH(pNode->pData->componentId);
+        pNode->nextByComponentId = g_componentIdIndex[bucket];
+        g_componentIdIndex[bucket] = i;
+#endif
+
+        bucket = suite_name_hash(&pNode->pData->varSuiteData.suiteVendor,
+                                 &pNode->pData->varSuiteData.suiteName);
+        pNode->nextByName = g_suiteNameIndex[bucket];
+        g_suiteNameIndex[bucket] = i;
+    }
+
+    return 1;
+}
+
 /**
  * Search for a structure describing the suite by the suite's ID.
  *
@@ -326,6 +488,24 @@ free_suites_data() {
 MidletSuiteData*
 get_suite_data(SuiteIdType suiteId) {
     MidletSuiteData* pData;
+    int i;
+
+    if (build_suite_index()) {
+        for (i = g_suiteIdIndex[SUITE_ID_HASH(suiteId)]; i != -1;
+                i = g_pSuiteIndexNodes[i].nextById) {
+            pData = g_pSuiteIndexNodes[i].pData;
+            if (pData->suiteId == suiteId
+#if ENABLE_DYNAMIC_COMPONENTS
+                && (pData->type == COMPONENT_REGULAR_SUITE ||
+                    pData->type == COMPONENT_PREINSTALLED_SUITE)
+#endif
+            ) {
+                return pData;
+            }
+        }
+
+        return NULL;
+    }
 
     pData = g_pSuitesData;
 
@@ -357,6 +537,20 @@ get_suite_data(SuiteIdType suiteId) {
 MidletSuiteData*
 get_component_data(ComponentIdType componentId) {
     MidletSuiteData* pData;
+    int i;
+
+    if (build_suite_index()) {
+        for (i = g_componentIdIndex[SUITE_ID_HASH(componentId)]; i != -1;
+                i = g_pSuiteIndexNodes[i].nextByComponentId) {
+            pData = g_pSuiteIndexNodes[i].pData;
+            if (pData->type == COMPONENT_DYNAMIC &&
+                    pData->componentId == componentId) {
+                return pData;
+            }
+        }
+
+        return NULL;
+    }
 
     pData = g_pSuitesData;
 
@@ -373,6 +567,61 @@ get_component_data(ComponentIdType componentId) {
 }
 #endif /* ENABLE_DYNAMIC_COMPONENTS */
 
+/**
+ * Search for a structure describing the suite or the dynamic component
+ * by its vendor and name.
+ *
+ * @param type type of the component
+ * @param suiteId if type == COMPONENT_DYNAMIC, contains ID of the suite
+ *                the component belongs to; unused otherwise
+ * @param vendor vendor of the suite or component
+ * @param name name of the suite or component
+ *
+ * @return pointer to the MidletSuiteData structure containing
+ * the attributes or NULL if nothing was found
+ */
+MidletSuiteData*
+get_suite_data_by_name(ComponentType type, SuiteIdType suiteId,
+                       const pcsl_string* vendor, const pcsl_string* name) {
+    MidletSuiteData* pData;
+    int useIndex;
+    int i = -1;
+
+#if !ENABLE_DYNAMIC_COMPONENTS
+    (void)type;
+    (void)suiteId;
+#endif
+
+    useIndex = build_suite_index();
+    if (useIndex) {
+        i = g_suiteNameIndex[suite_name_hash(vendor, name)];
+        pData = (i != -1) ? g_pSuiteIndexNodes[i].pData : NULL;
+    } else {
+        pData = g_pSuitesData;
+    }
+
+    while (pData != NULL) {
+        if (pcsl_string_equals(&pData->varSuiteData.suiteName, name) &&
+                pcsl_string_equals(&pData->varSuiteData.suiteVendor, vendor)
+#if ENABLE_DYNAMIC_COMPONENTS
+                    && (type == pData->type) && (type != COMPONENT_DYNAMIC ||
+                        (type == COMPONENT_DYNAMIC && suiteId == pData->suiteId))
+#endif
+        ) {
+            return pData;
+        }
+
+        if (useIndex) {
+            i = g_pSuiteIndexNodes[i].nextByName;
+            pData = (i != -1) ? g_pSuiteIndexNodes[i].pData : NULL;
+        } else {
+            pData = pData->nextEntry;
+        }
+    }
+
+    return NULL;
+}
+
 /**
  * Allocates a memory buffer enough to hold the whole file
  * and reads the given file into the buffer.
@@ -718,6 +967,7 @@ read_suites_data(char** ppszError) {
 
     pcsl_mem_free(buffer);
 
+    invalidate_suite_index();
     g_numberOfSuites = numOfSuites;
     g_pSuitesData = pSuitesData;
     g_isSuitesDataLoaded = 1;
@@ -1376,6 +1626,8 @@ remove_from_list_and_save_impl(SuiteIdType suiteId, ComponentIdType componentId,
 
             /* free the memory allocated for the entry */
             free_suite_data_entry(pData);
+            invalidate_suite_index();
+            invalidate_suite_property_cache(suiteId);
 
             /* decrease the number of the installed suites and components */
             g_numberOfSuites--;
@@ -50,6 +50,10 @@
 #include <suitestore_otanotifier_db.h>
 #include <suitestore_listeners.h>
 
+#if ENABLE_MONET
+#include <suitestore_installer.h>
+#endif
+
 #if ENABLE_ICON_CACHE
 #include <suitestore_icon_cache.h>
 #endif
@@ -360,6 +364,11 @@ midp_remove_suite(SuiteIdType suiteId) {
         return OUT_OF_MEMORY;
     }
 
+#if ENABLE_MONET
+    /* the suite may still be converted to an application image */
+    midp_wait_app_image_generation();
+#endif
+
     do {
         int rc; /* return code for rmsdb_... and storage_... */
 
@@ -97,7 +97,9 @@ public interface Verifier {
 
     /**
      * Verifies a Jar. On success set the name of the domain owner in the
-     * install state. Post any error back to the server.
+     * install state. Post any error back to the server. If the whole JAR
+     * has been passed to {@link #updateJarDigest} the JAR is not read
+     * again.
      *
      * @param jarStorage System store for applications
      * @param jarFilename name of the jar to read.
@@ -113,6 +115,31 @@ public interface Verifier {
     public String[] verifyJar(RandomAccessStream jarStorage,
         String jarFilename) throws IOException, InvalidJadException;
 
+    /**
+     * Prepares to compute the JAR signature digest while the JAR is being
+     * transferred, so that {@link #verifyJar} does not have to read the
+     * JAR again. The provider certificate is found and checked here,
+     * before the transfer.
+     *
+     * @return true if the JAR is signed and its bytes should be passed
+     *         to {@link #updateJarDigest}, false if there is nothing
+     *         to compute
+     *
+     * @exception InvalidJadException if the provider certificate is
+     *   missing or not valid
+     */
+    public boolean startJarDigest() throws InvalidJadException;
+
+    /**
+     * Adds the next piece of the JAR, in order, to the digest started by
+     * {@link #startJarDigest}. Does nothing if no digest was started.
+     *
+     * @param data buffer holding the JAR bytes
+     * @param offset offset of the first byte in <code>data</code>
+     * @param length number of bytes
+     */
+    public void updateJarDigest(byte[] data, int offset, int length);
+
     /**
      * Enables or disables certificate revocation checking using OCSP.
      *
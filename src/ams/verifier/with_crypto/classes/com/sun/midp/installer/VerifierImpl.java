@@ -46,6 +46,7 @@ import com.sun.midp.publickeystore.PublicKeyInfo;
 
 import com.sun.midp.crypto.PublicKey;
 import com.sun.midp.crypto.Signature;
+import com.sun.midp.crypto.SignatureException;
 import com.sun.midp.crypto.GeneralSecurityException;
 
 import com.sun.midp.security.Permissions;
@@ -82,6 +83,15 @@ public class VerifierImpl implements Verifier {
      */
     private boolean isOCSPEnabled;
 
+    /**
+     * Signature fed with the JAR while it is transferred, null if no
+     * digest was started or it has been used.
+     */
+    private Signature jarDigest;
+
+    /** Number of JAR bytes passed to <code>jarDigest</code>. */
+    private int jarDigestLength;
+
     /**
      * Constructor.
      *
@@ -147,6 +157,8 @@ public class VerifierImpl implements Verifier {
             String jarFilename) throws IOException, InvalidJadException {
         InputStream jarStream;
         String jarSig;
+        Signature digest;
+        int jarSize;
 
         jarSig = state.getAppProperty(SIG_PROP);
         if (jarSig == null) {
@@ -154,14 +166,26 @@ public class VerifierImpl implements Verifier {
             return null;
         }
 
-        authPath = null;
-
-        // This will fill in the cpCert and authPath fields
-        findProviderCert();
+        digest = jarDigest;
+        jarDigest = null;
 
         jarStorage.connect(jarFilename, Connector.READ);
 
         try {
+            if (digest != null) {
+                jarSize = jarStorage.getSizeOf();
+                if (jarSize == jarDigestLength) {
+                    // the whole JAR went through the digest, no need to read it
+                    checkSignature(digest, jarSig);
+                    return authPath;
+                }
+            }
+
+            authPath = null;
+
+            // This will fill in the cpCert and authPath fields
+            findProviderCert();
+
             jarStream = jarStorage.openInputStream();
 
             try {
@@ -176,6 +200,57 @@ public class VerifierImpl implements Verifier {
         return authPath;
     }
 
+    /**
+     * Prepares to compute the JAR signature digest while the JAR is being
+     * transferred. The provider certificate is found and checked here,
+     * before the transfer.
+     *
+     * @return true if the JAR is signed and its bytes should be passed
+     *         to {@link #updateJarDigest}, false if there is nothing
+     *         to compute
+     *
+     * @exception InvalidJadException if the provider certificate is
+     *   missing or not valid
+     */
+    public boolean startJarDigest() throws InvalidJadException {
+        jarDigest = null;
+        jarDigestLength = 0;
+
+        if (state.getAppProperty(SIG_PROP) == null) {
+            return false;
+        }
+
+        authPath = null;
+
+        // This will fill in the cpCert and authPath fields
+        findProviderCert();
+
+        jarDigest = initSignature();
+        return true;
+    }
+
+    /**
+     * Adds the next piece of the JAR, in order, to the digest started by
+     * {@link #startJarDigest}. Does nothing if no digest was started.
+     *
+     * @param data buffer holding the JAR bytes
+     * @param offset offset of the first byte in <code>data</code>
+     * @param length number of bytes
+     */
+    public void updateJarDigest(byte[] data, int offset, int length) {
+        if (jarDigest == null) {
+            return;
+        }
+
+        try {
+            jarDigest.update(data, offset, length);
+            jarDigestLength += length;
+        } catch (SignatureException e) {
+            // verifyJar will read the JAR instead
+            jarDigest = null;
+        }
+    }
+
     /**
      * Enables or disables certificate revocation checking using OCSP.
      *
@@ -432,12 +507,42 @@ public class VerifierImpl implements Verifier {
      */
     private void verifyStream(InputStream stream, String base64Signature)
             throws InvalidJadException, IOException {
-        PublicKey cpKey;
-        byte[] sig;
         Signature sigVerifier;
         byte[] temp;
         int bytesRead;
-        byte[] hash;
+
+        sigVerifier = initSignature();
+
+        try {
+            temp = new byte[1024];
+            for (; ; ) {
+                bytesRead = stream.read(temp);
+                if (bytesRead == -1) {
+                    break;
+                }
+
+                sigVerifier.update(temp, 0, bytesRead);
+            }
+        } catch (GeneralSecurityException e) {
+            throw new
+                InvalidJadException(InvalidJadException.INVALID_SIGNATURE);
+        }
+
+        checkSignature(sigVerifier, base64Signature);
+    }
+
+    /**
+     * Creates a signature verifier for the content provider's key.
+     * The cpCert field must be set before calling.
+     *
+     * @return signature ready to be updated with the JAR
+     *
+     * @exception InvalidJadException if the provider certificate's key
+     *   cannot be used
+     */
+    private Signature initSignature() throws InvalidJadException {
+        PublicKey cpKey;
+        Signature sigVerifier;
 
         try {
             cpKey = cpCert.getPublicKey();
@@ -446,6 +551,30 @@ public class VerifierImpl implements Verifier {
                 InvalidJadException(InvalidJadException.INVALID_PROVIDER_CERT);
         }
 
+        try {
+            sigVerifier = Signature.getInstance("SHA1withRSA");
+            sigVerifier.initVerify(cpKey);
+        } catch (GeneralSecurityException e) {
+            throw new
+                InvalidJadException(InvalidJadException.INVALID_SIGNATURE);
+        }
+
+        return sigVerifier;
+    }
+
+    /**
+     * Checks a signature that has been updated with the whole JAR.
+     *
+     * @param sigVerifier signature updated with the JAR
+     * @param base64Signature The base64 encoding of the PKCS v1.5 SHA with
+     *        RSA signature of the JAR.
+     *
+     * @exception InvalidJadException the JAR signature is not valid
+     */
+    private void checkSignature(Signature sigVerifier, String base64Signature)
+            throws InvalidJadException {
+        byte[] sig;
+
         try {
             sig = Base64.decode(base64Signature);
         } catch (IOException e) {
@@ -454,20 +583,6 @@ public class VerifierImpl implements Verifier {
         }
 
         try {
-            // verify the jad signature
-            sigVerifier = Signature.getInstance("SHA1withRSA");
-            sigVerifier.initVerify(cpKey);
-
-            temp = new byte[1024];
-            for (; ; ) {
-                bytesRead = stream.read(temp);
-                if (bytesRead == -1) {
-                    break;
-                }
-
-                sigVerifier.update(temp, 0, bytesRead);
-            }
-
             if (!sigVerifier.verify(sig)) {
                 throw new
                     InvalidJadException(InvalidJadException.INVALID_SIGNATURE);
@@ -81,6 +81,26 @@ public class VerifierImpl implements Verifier {
         return null;
     }
 
+    /**
+     * Prepares to compute the JAR signature digest while the JAR is being
+     * transferred. There is no signature to check without crypto.
+     *
+     * @return false, the JAR bytes are not needed
+     */
+    public boolean startJarDigest() {
+        return false;
+    }
+
+    /**
+     * Adds the next piece of the JAR to the digest. Does nothing.
+     *
+     * @param data buffer holding the JAR bytes
+     * @param offset offset of the first byte in <code>data</code>
+     * @param length number of bytes
+     */
+    public void updateJarDigest(byte[] data, int offset, int length) {
+    }
+
     /**
      * Enables or disables certificate revocation checking using OCSP.
      *
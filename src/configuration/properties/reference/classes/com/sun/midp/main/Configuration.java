@@ -26,8 +26,19 @@
 
 package com.sun.midp.main;
 
+import java.util.Hashtable;
+
 /** access the implementation configuration file parameters. */
 public class Configuration {
+    /** Cached value of a property that is not defined. */
+    private static final Object NO_VALUE = new Object();
+
+    /** Property values already read from native code, keyed by name. */
+    private static Hashtable cache = new Hashtable();
+
+    /** Property generation the cache is valid for. */
+    private static int cacheGeneration = -1;
+
     /** Don't let anyone instantiate this class */
     private Configuration() {
     }
@@ -48,7 +59,29 @@ public class Configuration {
         if (key.length() ==  0) {
             throw new IllegalArgumentException("key can't be empty");
         }
-        return getProperty0(key);
+
+        int generation = getGeneration0();
+
+        if (generation < 0) {
+            // values can change without notice, don't cache them
+            return getProperty0(key);
+        }
+
+        synchronized (cache) {
+            if (generation != cacheGeneration) {
+                cache.clear();
+                cacheGeneration = generation;
+            }
+
+            Object value = cache.get(key);
+
+            if (value == null) {
+                value = getProperty0(key);
+                cache.put(key, value != null ? value : NO_VALUE);
+            }
+
+            return value != NO_VALUE ? (String)value : null;
+        }
     }
 
     /**
@@ -170,4 +203,14 @@ public class Configuration {
      *             or <code>null</code> if there is no property with that key.
      */
     private native static String getProperty0(String key);
+
+    /**
+     * Gets the generation of the native property sets. It changes
+     * whenever a property is set. This is a quick native, checking it
+     * costs far less than reading a property from native code.
+     *
+     * @return the generation, or <code>-1</code> if property values
+     *         must not be cached
+     */
+    private native static int getGeneration0();
 }
@@ -122,3 +122,21 @@ KNIDECL(com_sun_midp_main_Configuration_getProperty0) {
     }
     KNI_EndHandlesAndReturnObject(result);
 }
+
+/**
+ * Gets the current generation of the property sets. It is called on
+ * every property read, so it is declared a quick native and must not
+ * allocate, throw or use handles.
+ * <p>
+ * Java declaration:
+ * <pre>
+ *     getGeneration0()I
+ * <pre>
+ *
+ * @return the generation, or <tt>-1<tt> if property values must not
+ *         be cached
+ */
+KNIEXPORT KNI_RETURNTYPE_INT
+KNIDECL(com_sun_midp_main_Configuration_getGeneration0) {
+    KNI_ReturnInt(getPropertyGeneration());
+}
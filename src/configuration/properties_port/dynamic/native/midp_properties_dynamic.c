@@ -85,22 +85,51 @@ PCSL_DEFINE_STATIC_ASCII_STRING_LITERAL_START(APPL_PROPERTY_FILE)
      'c', 'o', 'n', 'f', 'i', 'g', '\0'}
 PCSL_DEFINE_STATIC_ASCII_STRING_LITERAL_END(APPL_PROPERTY_FILE);
 
-/** Storage structure for a property set */
+/** Storage structure for a property */
 typedef struct _configproperty {
-    struct _configproperty *next ;
     const char *key;
     const char *value;
+    /** hash code of the key, see hashKey() */
+    unsigned int hash;
+    unsigned char flags;
 } Property ;
 
+/** Flag to signify the property's key has been allocated */
+#define NEW_KEY_FLAG   0x01
+/** Flag to signify the property's value has been allocated */
+#define NEW_VALUE_FLAG 0x02
+
+/**
+ * A property set: an open-addressing hash table with linear probing.
+ * Properties read from a configuration file point into the file
+ * contents, which are kept for the lifetime of the set.
+ */
+typedef struct _propertyset {
+    /** table slots, an empty slot has a NULL key */
+    Property *entries;
+    /** number of slots, zero or a power of two */
+    int capacity;
+    /** number of used slots */
+    int count;
+    /** contents of the configuration file */
+    char *fileData;
+} PropertySet ;
+
+/** Initial number of slots in a property set */
+#define MIN_PROPERTY_SET_CAPACITY 32
+
 /*
- * Use a simple linked list of name value pairs for application level and
- * implementation targeted properties. The space is partitioned to provide
- * some separation of values that can be protected.
+ * The space is partitioned to provide some separation of values
+ * that can be protected.
  */
 /** Application property set */
-static Property * applicationProperties = NULL ;
+static PropertySet applicationProperties;
 /** Internal property set */
-static Property * implementationProperties = NULL ;
+static PropertySet implementationProperties;
+/** Non-zero after initializeConfig() has succeeded */
+static int configInitialized = 0;
+/** Incremented every time a property is set, see getPropertyGeneration */
+static int propertyGeneration = 0;
 
 /** Configuration property name, as defined by the CLDC specification */
 #define DEFAULT_CONFIGURATION "microedition.configuration"
@@ -143,9 +172,168 @@ void trim_WhiteSpace(char *str) {
     memmove(str, s, strlen(s) + 1);
 }
 
+/**
+ * Computes the hash code of a property key.
+ *
+ * @param key The key
+ *
+ * @return The hash code of <tt>key</tt>
+ */
+static unsigned int
+hashKey(const char* key) {
+    unsigned int hash = 0;
+
+    while (*key) {
+        hash = hash * 31 + (unsigned char)*key++;
+    }
+
+    return hash;
+}
+
+/**
+ * Finds the slot of a key in a property set.
+ *
+ * @param props The property set to search, must have slots
+ * @param key The key to search for
+ * @param hash The hash code of <tt>key</tt>
+ *
+ * @return The slot holding <tt>key</tt>, or the empty slot where it
+ *         would be inserted
+ */
+static Property*
+findSlot(PropertySet* props, const char* key, unsigned int hash) {
+    unsigned int mask = (unsigned int)props->capacity - 1;
+    unsigned int i = hash & mask;
+    Property* p;
+
+    for (;;) {
+        p = &props->entries[i];
+        if (p->key == NULL ||
+                (p->hash == hash && strcmp(key, p->key) == 0)) {
+            return p;
+        }
+        i = (i + 1) & mask;
+    }
+}
+
+/**
+ * Makes sure a property set can hold the given number of properties
+ * without exceeding a 3/4 load factor.
+ *
+ * @param props The property set
+ * @param count The number of properties to hold
+ *
+ * @return <tt>0</tt> for success, otherwise <tt>-1</tt>
+ */
+static int
+ensureCapacity(PropertySet* props, int count) {
+    Property *oldEntries = props->entries;
+    int oldCapacity = props->capacity;
+    int capacity;
+    int i;
+
+    if (count * 4 <= props->capacity * 3) {
+        return 0;
+    }
+
+    capacity = MIN_PROPERTY_SET_CAPACITY;
+    while (count * 4 > capacity * 3) {
+        capacity *= 2;
+    }
+
+    props->entries = (Property*)midpMalloc(capacity * sizeof(Property));
+    if (props->entries == NULL) {
+        props->entries = oldEntries;
+        return -1;
+    }
+
+    memset(props->entries, 0, capacity * sizeof(Property));
+    props->capacity = capacity;
+
+    for (i = 0; i < oldCapacity; i++) {
+        if (oldEntries[i].key != NULL) {
+            *findSlot(props, oldEntries[i].key, oldEntries[i].hash) =
+                oldEntries[i];
+        }
+    }
+
+    midpFree(oldEntries);
+    return 0;
+}
+
+/**
+ * Adds a property to a set or replaces the value of an existing one.
+ * The set takes ownership of the key and the value as given by
+ * <tt>flags</tt>; if the key is already present, the new key is not
+ * used and must be released by the caller if it was allocated.
+ *
+ * @param props The property set
+ * @param key The key
+ * @param value The value
+ * @param flags <tt>NEW_KEY_FLAG</tt> and <tt>NEW_VALUE_FLAG</tt> for
+ *              allocated strings
+ *
+ * @return The property, or <tt>NULL</tt> if the key is new and the set
+ *         could not grow
+ */
+static Property*
+putProp(PropertySet* props, const char* key, const char* value,
+        unsigned char flags) {
+    unsigned int hash = hashKey(key);
+    Property *p = NULL;
+
+    if (props->capacity > 0) {
+        p = findSlot(props, key, hash);
+    }
+
+    if (p == NULL || p->key == NULL) {
+        /* Only a new key needs room, replacing a value never fails */
+        if (ensureCapacity(props, props->count + 1) != 0) {
+            return NULL;
+        }
+
+        p = findSlot(props, key, hash);
+        p->key = key;
+        p->hash = hash;
+        p->flags = flags & NEW_KEY_FLAG;
+        props->count++;
+    } else if (p->flags & NEW_VALUE_FLAG) {
+        midpFree((void*)p->value);
+    }
+
+    p->value = value;
+    p->flags = (p->flags & NEW_KEY_FLAG) | (flags & NEW_VALUE_FLAG);
+    return p;
+}
+
+/**
+ * Trims leading and trailing white space from a string in place.
+ *
+ * @param str The string
+ *
+ * @return The first non-white space character of <tt>str</tt>
+ */
+static char*
+trimInPlace(char* str) {
+    char* end;
+
+    while (isspace((unsigned char)*str)) {
+        str++;
+    }
+
+    end = str + strlen(str);
+    while (end > str && isspace((unsigned char)end[-1])) {
+        end--;
+    }
+    *end = '\0';
+
+    return str;
+}
+
 /**
  * Reads in a property file and makes the key/value pairs available
- * to MIDP as a property set.
+ * to MIDP as a property set. The file is read in one pass and the
+ * properties point into its contents, which the set keeps.
  *
  * @param fd An open file descriptor of the property file to read.
  * @param props A property set to hold the key/value pairs read from
@@ -153,17 +341,15 @@ void trim_WhiteSpace(char *str) {
  * @return <tt>0</tt> for success, otherwise <tt>-1</tt>
  */
 static int
-parseConfig(int fd, Property** props) {
+parseConfig(int fd, PropertySet* props) {
     char *buffer;
     int bufferSize;
+    int lines;
     int i;
-    int j;
-    int key_index;
-    int value_index;
     int len;
     char *errStr = NULL;
-    int startPos;
-    int endPos;
+    char *line;
+    char *colon;
 
     bufferSize = storageSizeOf(&errStr, fd);
     buffer = (char *)midpMalloc(bufferSize);
@@ -184,63 +370,44 @@ parseConfig(int fd, Property** props) {
         return 0;
     }
 
-    startPos = 0;
-    for (i = startPos; i < bufferSize; i++) {
+    /* Size the table once for all the lines of the file */
+    for (i = 0, lines = 0; i < bufferSize; i++) {
         if (buffer[i] == '\n') {
-            
-            buffer[i] = 0;
-
-            /* Skip comment lines which begin  with '#'*/
-            if (buffer[startPos] != '#') {
-                
-                /* Parse the line */
-                key_index = startPos;
-                for (j = key_index; buffer[j]; j++){
-
-                    Property *prop;
-
-                    if (buffer[j] == ':') {
-                        buffer[j] = 0;
-                        value_index = ++j;
-
-                        prop = (Property *) midpMalloc(sizeof(Property));
-                        if (NULL != prop) {
-                            char *key, *value;
-                            key = midpStrdup(buffer + key_index);
-                            value = midpStrdup(buffer + value_index);
-                            
-                            /* trim leading and trailing white spaces */
-                            trim_WhiteSpace(key);
-                            trim_WhiteSpace(value);
-
-                            prop->next = *props;
-                            prop->key = key;
-                            prop->value = value;
-        
-                            if ((prop->key == NULL) || (prop->value == NULL)) {
-                                midpFree((void*)prop->key);
-                                midpFree((void*)prop->value);
-                                midpFree(prop);
-
-                                /*
-                                 * since we are freeing memory, we're not
-                                 * exactly out of memory at this point
-                                 */
-                                break;
-                            }
-
-                            *props = prop;
-                        }
-
-                        break;
-                    }
-                }
+            lines++;
+        }
+    }
+
+    if (ensureCapacity(props, props->count + lines) != 0) {
+        midpFree(buffer);
+        return -1;
+    }
+
+    line = buffer;
+    for (i = 0; i < bufferSize; i++) {
+        if (buffer[i] != '\n') {
+            continue;
+        }
+
+        buffer[i] = 0;
+
+        /* Skip comment lines which begin  with '#'*/
+        if (line[0] != '#') {
+            colon = strchr(line, ':');
+            if (colon != NULL) {
+                *colon = 0;
+
+                /*
+                 * A later line for the same key replaces the value.
+                 * The table was sized for all lines, so this can't fail.
+                 */
+                putProp(props, trimInPlace(line), trimInPlace(colon + 1), 0);
             }
-            endPos = i;
-            startPos = endPos + 1;
         }
+
+        line = buffer + i + 1;
     }
-    midpFree(buffer);
+
+    props->fileData = buffer;
     return 0;
 }
 
@@ -256,7 +423,7 @@ parseConfig(int fd, Property** props) {
  * @return <tt>0</tt> for success, otherwise <tt>-1</tt>
  */
 static int
-initProps(Property** props, const pcsl_string * name,
+initProps(PropertySet* props, const pcsl_string * name,
     const pcsl_string * configRoot) {
 
     pcsl_string pathname;
@@ -294,17 +461,23 @@ initProps(Property** props, const pcsl_string * name,
  * @param props The property set to finalize
  */
 static void
-finalizeProps(Property* props) {
-    Property *prop, *tmp;
+finalizeProps(PropertySet* props) {
+    int i;
 
-    if (props != NULL) {
-    for (prop = props ; prop ; prop = tmp ){
-        tmp = prop->next;
-        midpFree((void*)prop->key);
-        midpFree((void*)prop->value);
-        midpFree(prop);
-    }
+    for (i = 0; i < props->capacity; i++) {
+        Property* p = &props->entries[i];
+
+        if (p->flags & NEW_KEY_FLAG) {
+            midpFree((void*)p->key);
+        }
+        if (p->flags & NEW_VALUE_FLAG) {
+            midpFree((void*)p->value);
+        }
     }
+
+    midpFree(props->entries);
+    midpFree(props->fileData);
+    memset(props, 0, sizeof(PropertySet));
 }
 
 /**
@@ -315,60 +488,58 @@ finalizeProps(Property* props) {
  * @param value The value to set <tt>key</tt> to
  */
 static void
-setProp(Property** props, const char* key , const char* value) {
-    /* Try to find the property in the current pool. */
+setProp(PropertySet* props, const char* key , const char* value) {
+    char *newKey;
+    char *newValue;
     Property *p;
-    for (p= *props; p; p = p->next) {
-        if (strcmp(key, p->key) == 0) {
-            midpFree((void*)p->value);
-            p->value = midpStrdup(value);
-            /*
-             * if midpStrdup fails we will just return without setting
-             * the value to anything other than NULL
-             */
+
+    newValue = midpStrdup(value);
+    if (newValue == NULL) {
+        /* do nothing if there is no memory */
+        return;
+    }
+
+    propertyGeneration++;
+
+    /* Try to find the property in the current pool. */
+    if (props->capacity > 0) {
+        p = findSlot(props, key, hashKey(key));
+        if (p->key != NULL) {
+            if (putProp(props, p->key, newValue, NEW_VALUE_FLAG) == NULL) {
+                midpFree(newValue);
+            }
             return;
         }
     }
 
     /* If the value is not defined, add it now */
-    p = (Property*)midpMalloc(sizeof(Property));
-    if (NULL != p){
-        p->next = *props ;
-        p->key = midpStrdup(key);
-        p->value = midpStrdup(value);
-
-        if ((p->key == NULL) || (p->value == NULL)) {
-            /* do nothing if there is no memory */
-            midpFree((void*)p->key);
-            midpFree((void*)p->value);
-            midpFree(p);
-            return;
-        }
-        *props = p ;
+    newKey = midpStrdup(key);
+    if (newKey == NULL ||
+            putProp(props, newKey, newValue,
+                    NEW_KEY_FLAG | NEW_VALUE_FLAG) == NULL) {
+        /* do nothing if there is no memory */
+        midpFree(newKey);
+        midpFree(newValue);
     }
 }
 
 /**
  * Finds a property key and returns its value.
  *
- * @param prop The property set to search
+ * @param props The property set to search
  * @param key The key to search for
+ * @param hash The hash code of <tt>key</tt>
  *
  * @return The value associated with <tt>key</tt> if found, otherwise
  *         <tt>NULL</tt>
  */
 static const char*
-findProp(Property* prop, const char* key) {
-    Property* p;
-
-    p = prop;
-    while (p) {
-        if (strcmp(key, p->key) == 0) {
-            return (p->value);
-        }
-        p = p->next;
+findProp(PropertySet* props, const char* key, unsigned int hash) {
+    if (props->capacity == 0) {
+        return NULL;
     }
-    return (NULL);
+
+    return findSlot(props, key, hash)->value;
 }
 
 /**
@@ -378,7 +549,7 @@ findProp(Property* prop, const char* key) {
  */
 int
 initializeConfig(void) {
-    if (implementationProperties != NULL) {
+    if (configInitialized) {
         /* Already initialized. */
         return 0;
     }
@@ -410,6 +581,7 @@ initializeConfig(void) {
         setSystemProperty(ENCODING_PROP_NAME, DEFAULT_CHARACTER_ENCODING);
     }
 
+    configInitialized = 1;
     return 0;
 }
 
@@ -420,10 +592,10 @@ initializeConfig(void) {
  */
 void
 finalizeConfig(void) {
-    finalizeProps(implementationProperties);
-    implementationProperties = NULL;
-    finalizeProps(applicationProperties);
-    applicationProperties = NULL;
+    finalizeProps(&implementationProperties);
+    finalizeProps(&applicationProperties);
+    configInitialized = 0;
+    propertyGeneration++;
 }
 
 /**
@@ -450,11 +622,12 @@ setInternalProperty(const char* key , const char* value) {
  */
 const char*
 getInternalProperty(const char* key) {
+    unsigned int hash = hashKey(key);
     const char *result;
     
-    result = findProp(implementationProperties, key);
+    result = findProp(&implementationProperties, key, hash);
     if (NULL == result) {
-        result = findProp(applicationProperties, key);
+        result = findProp(&applicationProperties, key, hash);
     }
 
     return result;
@@ -474,11 +647,12 @@ getInternalProperty(const char* key) {
  */
 const char*
 getInternalPropertyDefault(const char* key, const char* def) {
+    unsigned int hash = hashKey(key);
     const char *result;
 
-    result = findProp(implementationProperties, key);
+    result = findProp(&implementationProperties, key, hash);
     if (NULL == result) {
-        result = findProp(applicationProperties, key);
+        result = findProp(&applicationProperties, key, hash);
     }
 
     return (NULL == result) ? def : result;
@@ -509,7 +683,7 @@ const char*
 getSystemProperty(const char* key) {
     const char *result;
 
-    result = findProp(applicationProperties, key);
+    result = findProp(&applicationProperties, key, hashKey(key));
     if ((NULL == result) && (strcmp(key, "microedition.hostname") == 0)) {
         /* Get the local hostname from the native networking subsystem */
         result = getLocalHostName();
@@ -517,3 +691,15 @@ getSystemProperty(const char* key) {
 
     return result;
 }
+
+/**
+ * Gets the current generation of the property sets. The generation
+ * changes whenever a property is set, so a caller may cache values
+ * for as long as the generation stays the same.
+ *
+ * @return The current generation, never negative
+ */
+int
+getPropertyGeneration(void) {
+    return propertyGeneration & 0x7fffffff;
+}
@@ -87,6 +87,16 @@ void  setSystemProperty(const char* key, const char* value);
  */
 void  setInternalProperty (const char* key, const char* value);
 
+/**
+ * Gets the current generation of the property sets. The generation
+ * changes whenever a property is set, so property values may be cached
+ * for as long as it stays the same.
+ *
+ * @return The current generation, or <tt>-1</tt> if property values
+ *         can change without notice and must not be cached
+ */
+int getPropertyGeneration(void);
+
 /**
  * Finalize the configuration subsystem by releasing all the
  * allocating memory buffers. This method should only be called by
@@ -184,3 +184,13 @@ getSystemProperty(const char* key) {
     return doCallout(key);
 }
 
+/**
+ * Gets the current generation of the property sets.
+ * The platform can change property values at any time.
+ *
+ * @return <tt>-1</tt>, property values must not be cached
+ */
+int
+getPropertyGeneration(void) {
+    return -1;
+}
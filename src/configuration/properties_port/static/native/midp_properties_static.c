@@ -384,3 +384,14 @@ const char*
 getSystemProperty(const char* key) {
     return getProp(&systemPropertySet, key);
 }
+
+/**
+ * Gets the current generation of the property sets.
+ * Values obtained from callouts can change at any time.
+ *
+ * @return <tt>-1</tt>, property values must not be cached
+ */
+int
+getPropertyGeneration(void) {
+    return -1;
+}
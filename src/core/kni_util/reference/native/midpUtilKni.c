@@ -33,10 +33,10 @@
 #include <kni.h>
 #include <midp_logging.h>
 #include <midpMalloc.h>
+#include <midpArena.h>
 #include <midpString.h>
 #include <midpUtilKni.h>
 #include <string.h>
-#include <pcsl_memory.h>
 
 #if ENABLE_DEBUG
 
@@ -265,7 +265,8 @@ pcsl_string_status midp_jstring_to_pcsl_string(jstring java_str,
       * pcsl_str = PCSL_STRING_EMPTY;
       return PCSL_STRING_OK;
     } else {
-      jchar * buffer = pcsl_mem_malloc(length * sizeof(jchar));
+      jchar * buffer = midpTaggedMalloc(length * sizeof(jchar),
+                                        MIDP_MEM_TAG_STRING);
 
       if (buffer == NULL) {
 	* pcsl_str = PCSL_STRING_NULL;
@@ -278,7 +279,7 @@ pcsl_string_status midp_jstring_to_pcsl_string(jstring java_str,
 	pcsl_string_status status =
 	  pcsl_string_convert_from_utf16(buffer, length, pcsl_str);
 
-	pcsl_mem_free(buffer);
+	midpTaggedFree(buffer);
 
 	return status;
       }
@@ -312,7 +313,8 @@ midp_jchar_array_to_pcsl_string(jcharArray java_arr, jint length,
         *pcsl_str = PCSL_STRING_EMPTY;
         return PCSL_STRING_OK;
     } else {
-        jchar * buffer = pcsl_mem_malloc(length * sizeof(jchar));
+        jchar * buffer = midpTaggedMalloc(length * sizeof(jchar),
+                                          MIDP_MEM_TAG_STRING);
 
         if (buffer == NULL) {
               * pcsl_str = PCSL_STRING_NULL;
@@ -327,7 +329,7 @@ midp_jchar_array_to_pcsl_string(jcharArray java_arr, jint length,
             pcsl_string_status status =
                   pcsl_string_convert_from_utf16(buffer, length, pcsl_str);
 
-              pcsl_mem_free(buffer);
+              midpTaggedFree(buffer);
 
             return status;
         }
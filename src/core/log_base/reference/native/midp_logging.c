@@ -26,6 +26,7 @@
 
 #include <kni.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <stdarg.h>
 #include <string.h>
 #include <midpMalloc.h>
@@ -73,6 +74,19 @@
 /** Array containing the numbers of channels selected for logging */
 static int piChannelList[MAX_LOG_CHANNELS];
 
+/** Channel IDs in midp_constants_data.h are multiples of this value */
+#define LOG_CHANNEL_STEP 100
+
+/** Number of channels covered by the channel bitmap */
+#define LOG_CHANNEL_BITS 256
+
+/**
+ * Bitmap of the selected channels, indexed by channel ID divided by
+ * LOG_CHANNEL_STEP. Channel IDs outside of the bitmap are looked up in
+ * piChannelList.
+ */
+static unsigned char channelBitmap[LOG_CHANNEL_BITS / 8];
+
 /** Buffer used by logging facility */
 #define LOGGING_BUFFER_SIZE 400
 
@@ -100,6 +114,249 @@ static int channelInList(int channelId);
 /** Forward declaration */
 static void createLogChannelsList(const char* pStrChannelList);
 
+#if ENABLE_ASYNC_LOGGING
+
+/*
+ * Asynchronous logging.
+ *
+ * The thread that first reports a message becomes the producer: it
+ * formats the message and appends a binary record to a preallocated
+ * ring. Appending to an empty ring signals an event that wakes a native
+ * drain thread, which prints the records until the ring is empty again;
+ * records appended meanwhile cost the producer no system call. The
+ * producer only
+ * advances ringWrite and the drain thread only advances ringRead, so
+ * no lock is needed. Messages from other threads, errors and critical
+ * messages are printed synchronously as before. If the ring is full
+ * the message is dropped and counted in the next record.
+ */
+
+/** Size of the log ring in bytes, a power of two */
+#define LOG_RING_SIZE 16384
+
+/** Seconds to wait for the drain thread when the process exits */
+#define LOG_FLUSH_SECONDS 2
+
+/** Header of a record in the log ring, followed by the message text */
+typedef struct _LogRecordHeader {
+    /** record size including header and padding, 0 marks a wrap */
+    unsigned short size;
+    /** length of the message text including the terminating zero */
+    unsigned short textLength;
+    /** severity level of the message */
+    int severity;
+    /** channel of the message */
+    int channelID;
+    /** number of messages dropped before this one */
+    unsigned int dropped;
+} LogRecordHeader;
+
+/** Rounds a record size up so that every header stays aligned */
+#define LOG_RECORD_ALIGN(n) \
+    (((n) + sizeof (LogRecordHeader) - 1) & ~(sizeof (LogRecordHeader) - 1))
+
+/*
+ * Orders the record contents against the index updates on
+ * multiprocessor targets.
+ */
+#if defined(__GNUC__) && \
+    (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 1))
+#define LOG_RING_BARRIER() __sync_synchronize()
+#elif defined(_WIN32) || defined(_WIN32_WCE)
+/* interlocked operations are full barriers on every Windows target */
+static LONG logRingFence;
+#define LOG_RING_BARRIER() InterlockedExchange(&logRingFence, 0)
+#else
+/* IMPL_NOTE: add the barrier of the compiler for multiprocessor targets */
+#define LOG_RING_BARRIER()
+#endif
+
+/** Ring states */
+#define LOG_RING_OFF      0
+#define LOG_RING_STARTING 1
+#define LOG_RING_RUNNING  2
+#define LOG_RING_FAILED   3
+
+/** Storage of the log ring, the long members keep it aligned */
+static union {
+    long align;
+    char bytes[LOG_RING_SIZE];
+} logRing;
+
+/** Total bytes written to the ring, advanced by the producer only */
+static volatile unsigned int ringWrite;
+
+/** Total bytes drained from the ring, advanced by the drain thread only */
+static volatile unsigned int ringRead;
+
+/** Messages dropped since the last record, producer only */
+static unsigned int ringDropped;
+
+/** Current LOG_RING_* state */
+static int ringState = LOG_RING_OFF;
+
+/** The only thread allowed to append records */
+static midp_ThreadId ringProducer;
+
+/** Signaled by the producer when it appends to an empty ring */
+static midp_NativeEvent ringEvent;
+
+/**
+ * Prints the records in the ring until it is empty.
+ * Called on the drain thread only.
+ */
+static void drainLogRing(void) {
+    char prefix[80];
+    unsigned int offset;
+    LogRecordHeader* header;
+
+    while (ringRead != ringWrite) {
+        LOG_RING_BARRIER();
+
+        offset = ringRead & (LOG_RING_SIZE - 1);
+        header = (LogRecordHeader*)&logRing.bytes[offset];
+
+        if (header->size == 0) {
+            /* the rest of the ring was skipped by the producer */
+            ringRead += LOG_RING_SIZE - offset;
+            continue;
+        }
+
+        if (header->dropped != 0) {
+            midp_snprintf(prefix, sizeof (prefix),
+                "REPORT: <%u messages dropped>\n", header->dropped);
+            pcsl_print(prefix);
+        }
+
+        midp_snprintf(prefix, sizeof (prefix),
+            "REPORT: <level:%d> <channel:%d> ",
+            header->severity, header->channelID);
+        pcsl_print(prefix);
+        pcsl_print((char*)(header + 1));
+        pcsl_print("\n");
+
+        LOG_RING_BARRIER();
+        ringRead += header->size;
+
+        /*
+         * Publish ringRead before reading ringWrite again: either this
+         * loop sees the next record or the producer sees an empty ring
+         * and signals, see appendToLogRing().
+         */
+        LOG_RING_BARRIER();
+    }
+}
+
+/**
+ * Drain thread routine: prints the ring, waiting for the producer
+ * while it is empty. A record appended to the ring once it was found
+ * empty leaves the event signaled, so it is never missed.
+ *
+ * @param param not used
+ */
+static MIDP_THREAD_ROUTINE(logDrainThread, param) {
+    (void)param;
+
+    for (;;) {
+        midp_waitNativeEvent(&ringEvent);
+        drainLogRing();
+    }
+
+    /* NOTREACHED */
+    return MIDP_THREAD_ROUTINE_RESULT;
+}
+
+/**
+ * Gives the drain thread a bounded time to print the remaining records
+ * when the process exits.
+ */
+static void flushLogRing(void) {
+    int i;
+
+    for (i = 0; i < LOG_FLUSH_SECONDS && ringRead != ringWrite; i++) {
+        midp_sleepNativeThread(1);
+    }
+}
+
+/**
+ * Starts the drain thread and makes the calling thread the producer.
+ * Falls back to synchronous logging if the thread cannot be started.
+ */
+static void startLogRing(void) {
+    midp_ThreadId drainer;
+
+    /* reports made while starting the thread are printed synchronously */
+    ringState = LOG_RING_STARTING;
+    ringProducer = midp_getCurrentThreadId();
+
+    if (midp_initNativeEvent(&ringEvent) != 0) {
+        ringState = LOG_RING_FAILED;
+        return;
+    }
+
+    drainer = midp_startNativeThread(
+        (midp_ThreadRoutine*)&logDrainThread, NULL);
+    if (drainer == MIDP_INVALID_NATIVE_THREAD_ID) {
+        ringState = LOG_RING_FAILED;
+        return;
+    }
+
+    atexit(flushLogRing);
+    ringState = LOG_RING_RUNNING;
+}
+
+/**
+ * Appends a message to the log ring. Called on the producer thread only.
+ *
+ * @param severity severity level of the message
+ * @param channelID channel of the message
+ * @param text zero-terminated message text
+ */
+static void appendToLogRing(int severity, int channelID, const char* text) {
+    unsigned int textLength = strlen(text) + 1;
+    unsigned int size =
+        LOG_RECORD_ALIGN(sizeof (LogRecordHeader) + textLength);
+    unsigned int oldWrite = ringWrite;
+    unsigned int offset = oldWrite & (LOG_RING_SIZE - 1);
+    unsigned int tail = LOG_RING_SIZE - offset;
+    unsigned int needed = (tail < size) ? tail + size : size;
+    LogRecordHeader* header;
+
+    if (needed > LOG_RING_SIZE - (oldWrite - ringRead)) {
+        ringDropped++;
+        return;
+    }
+
+    if (tail < size) {
+        /* records are contiguous, skip the rest of the ring */
+        ((LogRecordHeader*)&logRing.bytes[offset])->size = 0;
+        offset = 0;
+    }
+
+    header = (LogRecordHeader*)&logRing.bytes[offset];
+    header->size = (unsigned short)size;
+    header->textLength = (unsigned short)textLength;
+    header->severity = severity;
+    header->channelID = channelID;
+    header->dropped = ringDropped;
+    memcpy(header + 1, text, textLength);
+    ringDropped = 0;
+
+    LOG_RING_BARRIER();
+    ringWrite = oldWrite + needed;
+
+    /*
+     * Only wake the drain thread if it may have found the ring empty;
+     * otherwise it sees the new record before it waits again.
+     */
+    LOG_RING_BARRIER();
+    if (ringRead == oldWrite) {
+        midp_signalNativeEvent(&ringEvent);
+    }
+}
+
+#endif /* ENABLE_ASYNC_LOGGING */
+
 /**
  * Initializes the logging subsystem with the list of channels to log.
  *
@@ -153,21 +410,41 @@ reportToLog(int severity, int channelID, char* message, ...) {
         fChannelSetupDone = 1;
     }
 
-    if (message != NULL && channelInList(channelID)) {
-        midp_snprintf(gLoggingBuffer, LOGGING_BUFFER_SIZE,
-                "REPORT: <level:%d> <channel:%d> ",
-                severity,  channelID);
-        pcsl_print(gLoggingBuffer);
+    if (message == NULL || !channelInList(channelID)) {
+        return;
+    }
 
-        va_start(ap, message);
+#if ENABLE_ASYNC_LOGGING
+    if (ringState == LOG_RING_OFF) {
+        startLogRing();
+    }
 
-        midp_vsnprintf(gLoggingBuffer, LOGGING_BUFFER_SIZE, message, ap);
-        pcsl_print(gLoggingBuffer);
+    if (severity < LOG_ERROR && ringState == LOG_RING_RUNNING &&
+            midp_getCurrentThreadId() == ringProducer) {
+        char text[LOGGING_BUFFER_SIZE];
 
+        va_start(ap, message);
+        midp_vsnprintf(text, sizeof (text), message, ap);
         va_end(ap);
 
-        pcsl_print("\n");
+        appendToLogRing(severity, channelID, text);
+        return;
     }
+#endif
+
+    midp_snprintf(gLoggingBuffer, LOGGING_BUFFER_SIZE,
+            "REPORT: <level:%d> <channel:%d> ",
+            severity,  channelID);
+    pcsl_print(gLoggingBuffer);
+
+    va_start(ap, message);
+
+    midp_vsnprintf(gLoggingBuffer, LOGGING_BUFFER_SIZE, message, ap);
+    pcsl_print(gLoggingBuffer);
+
+    va_end(ap);
+
+    pcsl_print("\n");
 }
 
 /**
@@ -177,6 +454,7 @@ reportToLog(int severity, int channelID, char* message, ...) {
  * @return 1 if logging is enabled for the channel, 0 otherwise.
  */
 static int channelInList(int channelId) {
+    unsigned int index;
     int i;
 
     /* assert(iChannelsNum <= MAX_LOG_CHANNELS); */
@@ -186,6 +464,12 @@ static int channelInList(int channelId) {
         return 1; /* TRUE */
     }
 
+    index = (unsigned int)channelId / LOG_CHANNEL_STEP;
+    if (index < LOG_CHANNEL_BITS &&
+            index * LOG_CHANNEL_STEP == (unsigned int)channelId) {
+        return (channelBitmap[index >> 3] >> (index & 7)) & 1;
+    }
+
     for (i = 0; i < iChannelsNum; i++) {
         if (piChannelList[i] == channelId) {
             return 1; /* TRUE */
@@ -203,10 +487,12 @@ static int channelInList(int channelId) {
 static void createLogChannelsList(const char* pStrChannelList) {
     int  isLastEntry = 0;
     int  iChannelId = 0;
+    unsigned int index;
     const char *pChannelStart;
     char *pChannelEnd;
 
     iChannelsNum = 0;
+    memset(channelBitmap, 0, sizeof (channelBitmap));
 
     pChannelStart = pStrChannelList;
 
@@ -236,6 +522,11 @@ static void createLogChannelsList(const char* pStrChannelList) {
         if (!channelInList(iChannelId)) {
             /* printf(">>> Adding channel %d...\n", iChannelId); */
             piChannelList[iChannelsNum++] = iChannelId;
+            index = (unsigned int)iChannelId / LOG_CHANNEL_STEP;
+            if (index < LOG_CHANNEL_BITS &&
+                    index * LOG_CHANNEL_STEP == (unsigned int)iChannelId) {
+                channelBitmap[index >> 3] |= (unsigned char)(1 << (index & 7));
+            }
 
             if (iChannelsNum == MAX_LOG_CHANNELS) {
                 /* Other channel values will be ignored. */
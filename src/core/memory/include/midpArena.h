@@ -0,0 +1,289 @@
+/*
+ *
+ *
+ * Copyright  1990-2007 Sun Microsystems, Inc. All Rights Reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 only, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details (a copy is
+ * included at /legal/license.txt).
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this work; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ * Please contact Sun Microsystems, Inc., 4150 Network Circle, Santa
+ * Clara, CA 95054 or visit www.sun.com if you need additional
+ * information or have any questions.
+ */
+
+/**
+ * @file
+ * @brief Arena and size-class pool allocators with per-subsystem
+ * accounting.
+ *
+ * <p>The general heap behind <tt>midpMalloc</tt> is a poor fit for the
+ * many short-lived buffers some subsystems allocate. Such a subsystem can
+ * pick one of the allocators below instead:</p>
+ *
+ * <ul>
+ * <li>an <b>arena</b> hands out memory by bumping a pointer inside large
+ *     chunks; nothing is freed one by one, the whole arena is released
+ *     at the end of an operation, or, if it has an owner, when the owner
+ *     (normally an isolate) ends;</li>
+ * <li>a <b>pool</b> hands out objects of one size from chunks and keeps
+ *     the freed ones on a free list, optionally up to a maximum number
+ *     of objects;</li>
+ * <li><tt>midpTaggedMalloc</tt> is a plain allocation that is only
+ *     counted against a tag; a subsystem that makes many small
+ *     allocations can call <tt>midpEnableSizeClasses</tt> so that those
+ *     of its tag are served from pools of a few fixed sizes.</li>
+ * </ul>
+ *
+ * <p>Every allocator is given a tag naming the subsystem. The counters
+ * of each tag can be read at run time with
+ * <tt>midpGetMemoryTagStats</tt> and logged with
+ * <tt>midpReportMemoryTags</tt>.</p>
+ *
+ * @warning This code is not thread safe, like <tt>midpMalloc</tt>.
+ */
+
+#ifndef _MIDP_ARENA_H_
+#define _MIDP_ARENA_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Subsystems whose native memory is counted separately. */
+typedef enum {
+    MIDP_MEM_TAG_GENERAL = 0,
+    MIDP_MEM_TAG_IMAGE,
+    MIDP_MEM_TAG_RMS,
+    MIDP_MEM_TAG_PUSH,
+    MIDP_MEM_TAG_STRING,
+    MIDP_MEM_TAG_COUNT
+} MidpMemoryTag;
+
+/** Counters kept for each tag. */
+typedef struct {
+    /** Bytes currently taken from the heap for the tag. */
+    long bytes;
+    /** Highest value <tt>bytes</tt> has had. */
+    long peakBytes;
+    /** Number of allocations made by users of the tag. */
+    long allocations;
+    /** Number of those that had to go to the heap. */
+    long heapAllocations;
+} MidpMemoryTagStats;
+
+/** A chunk of memory owned by an arena or a pool. */
+typedef struct _MidpArenaChunk MidpArenaChunk;
+
+struct _MidpArena;
+
+/**
+ * Function called instead of releasing the memory of an arena when its
+ * owner ends, see <tt>midpArenaSetReleaseHook</tt>.
+ */
+typedef void (*MidpArenaReleaseHook)(struct _MidpArena* pArena);
+
+/** A bump-pointer allocator released all at once. */
+typedef struct _MidpArena {
+    /** Chunks of the arena, the one being filled first. */
+    MidpArenaChunk* chunks;
+    /** Usual size of a chunk, in bytes. */
+    unsigned int chunkSize;
+    /** Tag the memory is counted against. */
+    MidpMemoryTag tag;
+    /** Owner of the arena, -1 if the arena is not owned. */
+    int owner;
+    /** Called when the owner ends, NULL to just release the memory. */
+    MidpArenaReleaseHook releaseHook;
+    /** Next arena in the list of owned arenas. */
+    struct _MidpArena* nextOwned;
+} MidpArena;
+
+/** An allocator of objects that all have the same size. */
+typedef struct {
+    /** Freed objects, linked through their first word. */
+    void* freeList;
+    /** Chunks the objects are carved from. */
+    MidpArenaChunk* chunks;
+    /** Size of an object, rounded up for alignment. */
+    unsigned int objectSize;
+    /** Number of objects carved from one chunk. */
+    unsigned int objectsPerChunk;
+    /** Maximum number of objects, 0 for no limit. */
+    unsigned int maxObjects;
+    /** Number of objects in all the chunks. */
+    unsigned int capacity;
+    /** Number of objects handed out and not freed. */
+    unsigned int inUse;
+    /** Tag the memory is counted against. */
+    MidpMemoryTag tag;
+} MidpPool;
+
+/**
+ * Allocates memory counted against a tag. The memory must be freed with
+ * <tt>midpTaggedFree</tt>.
+ *
+ * @param size number of bytes to allocate
+ * @param tag subsystem the memory is for
+ *
+ * @return pointer to the memory, or NULL if there is not enough memory
+ */
+void* midpTaggedMalloc(unsigned int size, MidpMemoryTag tag);
+
+/**
+ * Frees memory allocated with <tt>midpTaggedMalloc</tt>.
+ *
+ * @param ptr pointer to the memory, may be NULL
+ */
+void midpTaggedFree(void* ptr);
+
+/**
+ * Makes <tt>midpTaggedMalloc</tt> serve the small requests of a tag from
+ * pools of 16, 32, 64, 128 and 256 bytes instead of the heap. A request
+ * takes an object of the smallest size that fits; larger requests still
+ * go to the heap.
+ *
+ * @param tag subsystem whose allocations are pooled
+ * @param objectsPerChunk number of objects each pool takes from the heap
+ *        at once
+ */
+void midpEnableSizeClasses(MidpMemoryTag tag, unsigned int objectsPerChunk);
+
+/**
+ * Stops pooling the allocations of a tag and releases the memory of its
+ * pools. Everything allocated from them must have been freed.
+ *
+ * @param tag subsystem given to <tt>midpEnableSizeClasses</tt>
+ */
+void midpReleaseSizeClasses(MidpMemoryTag tag);
+
+/**
+ * Initializes an arena. No memory is taken until the first allocation.
+ *
+ * @param pArena arena to initialize
+ * @param tag subsystem the memory is for
+ * @param chunkSize usual size of the chunks taken from the heap; larger
+ *        requests get a chunk of their own
+ * @param owner identifier of the owner whose end releases the arena,
+ *        see <tt>midpArenaReleaseOwner</tt>; -1 if the arena has no owner
+ */
+void midpArenaInit(MidpArena* pArena, MidpMemoryTag tag,
+                   unsigned int chunkSize, int owner);
+
+/**
+ * Allocates memory from an arena. The memory stays valid until the arena
+ * is reset or destroyed.
+ *
+ * @param pArena arena to allocate from
+ * @param size number of bytes to allocate
+ *
+ * @return pointer to the memory, or NULL if there is not enough memory
+ */
+void* midpArenaAlloc(MidpArena* pArena, unsigned int size);
+
+/**
+ * Releases all the memory allocated from an arena at once, at the end of
+ * an operation. One chunk is kept for the next operation.
+ *
+ * @param pArena arena to reset
+ */
+void midpArenaReset(MidpArena* pArena);
+
+/**
+ * Releases all the memory of an arena and detaches it from its owner.
+ * The arena can be initialized again afterwards.
+ *
+ * @param pArena arena to destroy
+ */
+void midpArenaDestroy(MidpArena* pArena);
+
+/**
+ * Sets the function called for an owned arena when its owner ends. A
+ * subsystem that must finish its work with the memory of the arena, such
+ * as writing out cached data, does it in the hook and then releases the
+ * arena itself, normally with <tt>midpArenaDestroy</tt>.
+ *
+ * @param pArena arena the hook is for
+ * @param hook function to call, NULL to just release the memory
+ */
+void midpArenaSetReleaseHook(MidpArena* pArena, MidpArenaReleaseHook hook);
+
+/**
+ * Releases the memory of every arena that belongs to an owner, for
+ * instance when an isolate ends. An arena without a release hook stays
+ * usable and starts empty; an arena with one is handed to the hook.
+ *
+ * @param owner identifier given to <tt>midpArenaInit</tt>
+ */
+void midpArenaReleaseOwner(int owner);
+
+/**
+ * Initializes a pool. No memory is taken until the first allocation.
+ *
+ * @param pPool pool to initialize
+ * @param tag subsystem the memory is for
+ * @param objectSize size of the objects, in bytes
+ * @param objectsPerChunk number of objects taken from the heap at once
+ * @param maxObjects maximum number of objects the pool may hold,
+ *        0 for no limit
+ */
+void midpPoolInit(MidpPool* pPool, MidpMemoryTag tag,
+                  unsigned int objectSize, unsigned int objectsPerChunk,
+                  unsigned int maxObjects);
+
+/**
+ * Takes an object from a pool.
+ *
+ * @param pPool pool to allocate from
+ *
+ * @return pointer to the object, or NULL if the pool has reached its
+ *         maximum or there is not enough memory
+ */
+void* midpPoolAlloc(MidpPool* pPool);
+
+/**
+ * Returns an object to the pool it was taken from.
+ *
+ * @param pPool pool of the object
+ * @param ptr object to return, may be NULL
+ */
+void midpPoolFree(MidpPool* pPool, void* ptr);
+
+/**
+ * Releases all the memory of a pool. Every object must have been
+ * returned. The pool can be used again afterwards.
+ *
+ * @param pPool pool to destroy
+ */
+void midpPoolDestroy(MidpPool* pPool);
+
+/**
+ * Reads the counters of a tag.
+ *
+ * @param tag tag to read
+ * @param pStats receives the counters
+ */
+void midpGetMemoryTagStats(MidpMemoryTag tag, MidpMemoryTagStats* pStats);
+
+/**
+ * Logs the counters of every tag on the <tt>LC_MALLOC</tt> channel.
+ */
+void midpReportMemoryTags(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _MIDP_ARENA_H_ */
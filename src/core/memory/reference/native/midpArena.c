@@ -0,0 +1,580 @@
+/*
+ *
+ *
+ * Copyright  1990-2007 Sun Microsystems, Inc. All Rights Reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 only, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details (a copy is
+ * included at /legal/license.txt).
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this work; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ * Please contact Sun Microsystems, Inc., 4150 Network Circle, Santa
+ * Clara, CA 95054 or visit www.sun.com if you need additional
+ * information or have any questions.
+ */
+
+/**
+ * @file
+ *
+ * Arena and pool allocators on top of <tt>midpMalloc</tt>.
+ *
+ * <p>Arenas and pools take their memory from the heap in chunks. A chunk
+ * starts with a small header, the rest is handed out in pieces aligned
+ * to <tt>ARENA_ALIGNMENT</tt> bytes. An arena keeps the chunk it is
+ * filling at the head of its list; a request too large for the usual
+ * chunk size gets a chunk of its own, linked after the head so the head
+ * can still be filled.</p>
+ *
+ * <p>Memory from <tt>midpTaggedMalloc</tt> is preceded by a header that
+ * remembers its size and tag, so that it can be uncounted when freed, and
+ * the size class it was taken from, if any, so that it can be returned to
+ * the right pool.</p>
+ *
+ * @warning This code is not thread safe.
+ */
+
+#include <midpMalloc.h>
+#include <midpArena.h>
+#include <midp_logging.h>
+
+/** Alignment of the memory handed out. */
+#define ARENA_ALIGNMENT 8
+
+/** Rounds a size up to the alignment. */
+#define ARENA_ALIGN(size) \
+    (((size) + (ARENA_ALIGNMENT - 1)) & ~(unsigned int)(ARENA_ALIGNMENT - 1))
+
+/** Header of a chunk. */
+struct _MidpArenaChunk {
+    /** Next chunk of the same arena or pool. */
+    struct _MidpArenaChunk* next;
+    /** Number of bytes after the header. */
+    unsigned int size;
+    /** Number of those bytes handed out. */
+    unsigned int used;
+};
+
+/** Space taken by the chunk header. */
+#define CHUNK_HEADER_SIZE ARENA_ALIGN(sizeof (MidpArenaChunk))
+
+/** First byte after the header of a chunk. */
+#define CHUNK_DATA(pChunk) ((unsigned char*)(pChunk) + CHUNK_HEADER_SIZE)
+
+/** Header of memory from midpTaggedMalloc. */
+typedef union {
+    struct {
+        unsigned int size;
+        MidpMemoryTag tag;
+        /** Index of the size class pool, -1 for the heap. */
+        int sizeClass;
+    } info;
+    /* Keeps the memory after the header aligned. */
+    double align;
+} TaggedHeader;
+
+/** Space taken by the tagged memory header. */
+#define TAGGED_HEADER_SIZE ARENA_ALIGN(sizeof (TaggedHeader))
+
+/** Number of size classes. */
+#define SIZE_CLASS_COUNT 5
+
+/** Usable size of the smallest class; each next class doubles it. */
+#define SIZE_CLASS_MIN 16
+
+/** Usable size of the largest class. */
+#define SIZE_CLASS_MAX (SIZE_CLASS_MIN << (SIZE_CLASS_COUNT - 1))
+
+/** Size class pools of every tag. */
+static MidpPool sizeClassPools[MIDP_MEM_TAG_COUNT][SIZE_CLASS_COUNT];
+
+/** Whether the small allocations of a tag go to its size class pools. */
+static int sizeClassesEnabled[MIDP_MEM_TAG_COUNT];
+
+/** Counters of every tag. */
+static MidpMemoryTagStats tagStats[MIDP_MEM_TAG_COUNT];
+
+/** Arenas that have an owner. */
+static MidpArena* ownedArenas = NULL;
+
+/**
+ * Counts memory taken from the heap for a tag.
+ *
+ * @param tag tag of the memory
+ * @param size number of bytes taken
+ */
+static void countHeapAlloc(MidpMemoryTag tag, unsigned int size) {
+    MidpMemoryTagStats* pStats = &tagStats[tag];
+
+    pStats->bytes += size;
+    pStats->heapAllocations++;
+    if (pStats->bytes > pStats->peakBytes) {
+        pStats->peakBytes = pStats->bytes;
+    }
+}
+
+/**
+ * Allocates a chunk and counts it against a tag.
+ *
+ * @param tag tag of the memory
+ * @param size number of bytes wanted after the header
+ *
+ * @return the chunk, or NULL if there is not enough memory
+ */
+static MidpArenaChunk* allocChunk(MidpMemoryTag tag, unsigned int size) {
+    MidpArenaChunk* pChunk;
+
+    pChunk = (MidpArenaChunk*)midpMalloc(CHUNK_HEADER_SIZE + size);
+    if (pChunk == NULL) {
+        REPORT_WARN2(LC_MALLOC, "Cannot allocate a chunk of %d bytes"
+                     " for memory tag %d", size, tag);
+        return NULL;
+    }
+
+    pChunk->next = NULL;
+    pChunk->size = size;
+    pChunk->used = 0;
+    countHeapAlloc(tag, CHUNK_HEADER_SIZE + size);
+    return pChunk;
+}
+
+/**
+ * Frees a list of chunks and uncounts them.
+ *
+ * @param tag tag of the memory
+ * @param pChunk first chunk of the list, may be NULL
+ */
+static void freeChunks(MidpMemoryTag tag, MidpArenaChunk* pChunk) {
+    MidpArenaChunk* pNext;
+
+    while (pChunk != NULL) {
+        pNext = pChunk->next;
+        tagStats[tag].bytes -= CHUNK_HEADER_SIZE + pChunk->size;
+        midpFree(pChunk);
+        pChunk = pNext;
+    }
+}
+
+/**
+ * Allocates memory counted against a tag.
+ *
+ * @param size number of bytes to allocate
+ * @param tag subsystem the memory is for
+ *
+ * @return pointer to the memory, or NULL if there is not enough memory
+ */
+void* midpTaggedMalloc(unsigned int size, MidpMemoryTag tag) {
+    TaggedHeader* pHeader;
+    unsigned int classSize;
+    int i;
+
+    if (sizeClassesEnabled[tag] && size <= SIZE_CLASS_MAX) {
+        i = 0;
+        classSize = SIZE_CLASS_MIN;
+        while (classSize < size) {
+            i++;
+            classSize <<= 1;
+        }
+
+        pHeader = (TaggedHeader*)midpPoolAlloc(&sizeClassPools[tag][i]);
+        if (pHeader == NULL) {
+            return NULL;
+        }
+
+        pHeader->info.sizeClass = i;
+    } else {
+        pHeader = (TaggedHeader*)midpMalloc(TAGGED_HEADER_SIZE + size);
+        if (pHeader == NULL) {
+            return NULL;
+        }
+
+        pHeader->info.sizeClass = -1;
+        tagStats[tag].allocations++;
+        countHeapAlloc(tag, size);
+    }
+
+    pHeader->info.size = size;
+    pHeader->info.tag = tag;
+    return (unsigned char*)pHeader + TAGGED_HEADER_SIZE;
+}
+
+/**
+ * Frees memory allocated with midpTaggedMalloc.
+ *
+ * @param ptr pointer to the memory, may be NULL
+ */
+void midpTaggedFree(void* ptr) {
+    TaggedHeader* pHeader;
+
+    if (ptr == NULL) {
+        return;
+    }
+
+    pHeader = (TaggedHeader*)((unsigned char*)ptr - TAGGED_HEADER_SIZE);
+    if (pHeader->info.sizeClass >= 0) {
+        midpPoolFree(&sizeClassPools[pHeader->info.tag]
+                     [pHeader->info.sizeClass], pHeader);
+        return;
+    }
+
+    tagStats[pHeader->info.tag].bytes -= pHeader->info.size;
+    midpFree(pHeader);
+}
+
+/**
+ * Serves the small tagged allocations of a tag from size class pools.
+ *
+ * @param tag subsystem whose allocations are pooled
+ * @param objectsPerChunk number of objects each pool takes at once
+ */
+void midpEnableSizeClasses(MidpMemoryTag tag, unsigned int objectsPerChunk) {
+    int i;
+
+    if (sizeClassesEnabled[tag]) {
+        return;
+    }
+
+    for (i = 0; i < SIZE_CLASS_COUNT; i++) {
+        midpPoolInit(&sizeClassPools[tag][i], tag,
+                     TAGGED_HEADER_SIZE + (SIZE_CLASS_MIN << i),
+                     objectsPerChunk, 0);
+    }
+
+    sizeClassesEnabled[tag] = 1;
+}
+
+/**
+ * Stops pooling the tagged allocations of a tag and releases its pools.
+ *
+ * @param tag subsystem given to midpEnableSizeClasses
+ */
+void midpReleaseSizeClasses(MidpMemoryTag tag) {
+    int i;
+
+    if (!sizeClassesEnabled[tag]) {
+        return;
+    }
+
+    for (i = 0; i < SIZE_CLASS_COUNT; i++) {
+        midpPoolDestroy(&sizeClassPools[tag][i]);
+    }
+
+    sizeClassesEnabled[tag] = 0;
+}
+
+/**
+ * Initializes an arena.
+ *
+ * @param pArena arena to initialize
+ * @param tag subsystem the memory is for
+ * @param chunkSize usual size of the chunks taken from the heap
+ * @param owner identifier of the owner, -1 if the arena has no owner
+ */
+void midpArenaInit(MidpArena* pArena, MidpMemoryTag tag,
+                   unsigned int chunkSize, int owner) {
+    pArena->chunks = NULL;
+    pArena->chunkSize = ARENA_ALIGN(chunkSize);
+    pArena->tag = tag;
+    pArena->owner = owner;
+    pArena->releaseHook = NULL;
+    pArena->nextOwned = NULL;
+
+    if (owner >= 0) {
+        pArena->nextOwned = ownedArenas;
+        ownedArenas = pArena;
+    }
+}
+
+/**
+ * Allocates memory from an arena.
+ *
+ * @param pArena arena to allocate from
+ * @param size number of bytes to allocate
+ *
+ * @return pointer to the memory, or NULL if there is not enough memory
+ */
+void* midpArenaAlloc(MidpArena* pArena, unsigned int size) {
+    MidpArenaChunk* pChunk = pArena->chunks;
+    void* ptr;
+
+    size = ARENA_ALIGN(size);
+    tagStats[pArena->tag].allocations++;
+
+    if (pChunk != NULL && pChunk->size - pChunk->used >= size) {
+        ptr = CHUNK_DATA(pChunk) + pChunk->used;
+        pChunk->used += size;
+        return ptr;
+    }
+
+    if (size > pArena->chunkSize / 2) {
+        /* A large request gets its own chunk behind the head. */
+        pChunk = allocChunk(pArena->tag, size);
+        if (pChunk == NULL) {
+            return NULL;
+        }
+
+        pChunk->used = size;
+        if (pArena->chunks != NULL) {
+            pChunk->next = pArena->chunks->next;
+            pArena->chunks->next = pChunk;
+        } else {
+            pArena->chunks = pChunk;
+        }
+
+        return CHUNK_DATA(pChunk);
+    }
+
+    pChunk = allocChunk(pArena->tag, pArena->chunkSize);
+    if (pChunk == NULL) {
+        return NULL;
+    }
+
+    pChunk->used = size;
+    pChunk->next = pArena->chunks;
+    pArena->chunks = pChunk;
+    return CHUNK_DATA(pChunk);
+}
+
+/**
+ * Releases all the memory allocated from an arena, keeping one chunk of
+ * the usual size for the next operation.
+ *
+ * @param pArena arena to reset
+ */
+void midpArenaReset(MidpArena* pArena) {
+    MidpArenaChunk* pKept = NULL;
+    MidpArenaChunk* pChunk = pArena->chunks;
+    MidpArenaChunk* pNext;
+
+    while (pChunk != NULL) {
+        pNext = pChunk->next;
+        if (pKept == NULL && pChunk->size == pArena->chunkSize) {
+            pKept = pChunk;
+            pKept->next = NULL;
+            pKept->used = 0;
+        } else {
+            tagStats[pArena->tag].bytes -= CHUNK_HEADER_SIZE + pChunk->size;
+            midpFree(pChunk);
+        }
+
+        pChunk = pNext;
+    }
+
+    pArena->chunks = pKept;
+}
+
+/**
+ * Releases all the memory of an arena and detaches it from its owner.
+ *
+ * @param pArena arena to destroy
+ */
+void midpArenaDestroy(MidpArena* pArena) {
+    MidpArena** ppArena;
+
+    freeChunks(pArena->tag, pArena->chunks);
+    pArena->chunks = NULL;
+
+    if (pArena->owner >= 0) {
+        for (ppArena = &ownedArenas; *ppArena != NULL;
+                ppArena = &(*ppArena)->nextOwned) {
+            if (*ppArena == pArena) {
+                *ppArena = pArena->nextOwned;
+                break;
+            }
+        }
+
+        pArena->owner = -1;
+        pArena->nextOwned = NULL;
+    }
+}
+
+/**
+ * Sets the function called for an owned arena when its owner ends.
+ *
+ * @param pArena arena the hook is for
+ * @param hook function to call, NULL to just release the memory
+ */
+void midpArenaSetReleaseHook(MidpArena* pArena, MidpArenaReleaseHook hook) {
+    pArena->releaseHook = hook;
+}
+
+/**
+ * Releases the memory of every arena that belongs to an owner.
+ *
+ * @param owner identifier given to midpArenaInit
+ */
+void midpArenaReleaseOwner(int owner) {
+    MidpArena* pArena;
+    MidpArena* pNext;
+
+    for (pArena = ownedArenas; pArena != NULL; pArena = pNext) {
+        /* The hook may destroy the arena, even free the memory it is in. */
+        pNext = pArena->nextOwned;
+        if (pArena->owner != owner) {
+            continue;
+        }
+
+        if (pArena->releaseHook != NULL) {
+            pArena->releaseHook(pArena);
+        } else {
+            freeChunks(pArena->tag, pArena->chunks);
+            pArena->chunks = NULL;
+        }
+    }
+}
+
+/**
+ * Initializes a pool.
+ *
+ * @param pPool pool to initialize
+ * @param tag subsystem the memory is for
+ * @param objectSize size of the objects, in bytes
+ * @param objectsPerChunk number of objects taken from the heap at once
+ * @param maxObjects maximum number of objects, 0 for no limit
+ */
+void midpPoolInit(MidpPool* pPool, MidpMemoryTag tag,
+                  unsigned int objectSize, unsigned int objectsPerChunk,
+                  unsigned int maxObjects) {
+    if (objectSize < sizeof (void*)) {
+        objectSize = sizeof (void*);
+    }
+
+    if (objectsPerChunk == 0) {
+        objectsPerChunk = 1;
+    }
+
+    pPool->freeList = NULL;
+    pPool->chunks = NULL;
+    pPool->objectSize = ARENA_ALIGN(objectSize);
+    pPool->objectsPerChunk = objectsPerChunk;
+    pPool->maxObjects = maxObjects;
+    pPool->capacity = 0;
+    pPool->inUse = 0;
+    pPool->tag = tag;
+}
+
+/**
+ * Takes an object from a pool.
+ *
+ * @param pPool pool to allocate from
+ *
+ * @return pointer to the object, or NULL if the pool has reached its
+ *         maximum or there is not enough memory
+ */
+void* midpPoolAlloc(MidpPool* pPool) {
+    MidpArenaChunk* pChunk;
+    unsigned char* pObject;
+    unsigned int count;
+    unsigned int i;
+    void* ptr;
+
+    if (pPool->freeList == NULL) {
+        count = pPool->objectsPerChunk;
+        if (pPool->maxObjects > 0) {
+            if (pPool->capacity >= pPool->maxObjects) {
+                return NULL;
+            }
+
+            if (count > pPool->maxObjects - pPool->capacity) {
+                count = pPool->maxObjects - pPool->capacity;
+            }
+        }
+
+        pChunk = allocChunk(pPool->tag, count * pPool->objectSize);
+        if (pChunk == NULL) {
+            return NULL;
+        }
+
+        pChunk->used = pChunk->size;
+        pChunk->next = pPool->chunks;
+        pPool->chunks = pChunk;
+        pPool->capacity += count;
+
+        /* Thread the new objects onto the free list, first one on top. */
+        pObject = CHUNK_DATA(pChunk) + (count - 1) * pPool->objectSize;
+        for (i = 0; i < count; i++) {
+            *(void**)pObject = pPool->freeList;
+            pPool->freeList = pObject;
+            pObject -= pPool->objectSize;
+        }
+    }
+
+    ptr = pPool->freeList;
+    pPool->freeList = *(void**)ptr;
+    pPool->inUse++;
+    tagStats[pPool->tag].allocations++;
+    return ptr;
+}
+
+/**
+ * Returns an object to its pool.
+ *
+ * @param pPool pool of the object
+ * @param ptr object to return, may be NULL
+ */
+void midpPoolFree(MidpPool* pPool, void* ptr) {
+    if (ptr == NULL) {
+        return;
+    }
+
+    *(void**)ptr = pPool->freeList;
+    pPool->freeList = ptr;
+    pPool->inUse--;
+}
+
+/**
+ * Releases all the memory of a pool.
+ *
+ * @param pPool pool to destroy
+ */
+void midpPoolDestroy(MidpPool* pPool) {
+    if (pPool->inUse != 0) {
+        REPORT_ERROR2(LC_MALLOC, "Pool of memory tag %d destroyed with"
+                      " %d objects in use", pPool->tag, pPool->inUse);
+    }
+
+    freeChunks(pPool->tag, pPool->chunks);
+    pPool->chunks = NULL;
+    pPool->freeList = NULL;
+    pPool->capacity = 0;
+    pPool->inUse = 0;
+}
+
+/**
+ * Reads the counters of a tag.
+ *
+ * @param tag tag to read
+ * @param pStats receives the counters
+ */
+void midpGetMemoryTagStats(MidpMemoryTag tag, MidpMemoryTagStats* pStats) {
+    *pStats = tagStats[tag];
+}
+
+/**
+ * Logs the counters of every tag.
+ */
+void midpReportMemoryTags(void) {
+#if REPORT_LEVEL <= LOG_INFORMATION
+    static const char* const tagNames[MIDP_MEM_TAG_COUNT] = {
+        "general", "image", "rms", "push", "string"
+    };
+    int i;
+
+    for (i = 0; i < MIDP_MEM_TAG_COUNT; i++) {
+        REPORT_INFO5(LC_MALLOC, "memory tag %s: %ld bytes, peak %ld,"
+                     " %ld allocations, %ld from the heap", tagNames[i],
+                     tagStats[i].bytes, tagStats[i].peakBytes,
+                     tagStats[i].allocations, tagStats[i].heapAllocations);
+    }
+#endif
+}
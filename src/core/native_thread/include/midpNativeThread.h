@@ -55,14 +55,17 @@ extern "C" {
  */
 #include <midpNativeThreadImpl.h> 
 
-#if ENABLE_NATIVE_APP_MANAGER && ENABLE_I3_TEST
+#if (ENABLE_NATIVE_APP_MANAGER && ENABLE_I3_TEST) || ENABLE_ASYNC_LOGGING || \
+    ENABLE_MONET
 
 /**
  * starts another native thread.
  *
  * The primary usage of this function is testing of NAMS subsystem - 
  * additional thread is used to throw initial midlet start events 
- * to main application thread (where VM runs).
+ * to main application thread (where VM runs). The asynchronous logging
+ * backend also uses it to run its drain thread, and the installer to
+ * generate Monet application images.
  *
  * @param thread thread routine
  * @param param thread routine parameter
@@ -75,6 +78,39 @@ extern midp_ThreadId midp_startNativeThread(
 
 #endif
 
+#if ENABLE_ASYNC_LOGGING || ENABLE_MONET
+
+/**
+ * Initializes an event a native thread can wait for. The event is
+ * auto-reset: a signal sent while no thread waits is remembered and
+ * releases the next wait, several such signals release only one.
+ *
+ * The asynchronous logging backend uses it to wake its drain thread
+ * when a message is queued, the installer to wait for the end of the
+ * generation of an application image.
+ *
+ * @param event the event to initialize
+ *
+ * @return 0 if successful, -1 if the event cannot be created
+ */
+extern int midp_initNativeEvent(midp_NativeEvent* event);
+
+/**
+ * Signals an event, releasing the thread waiting for it.
+ *
+ * @param event the event to signal
+ */
+extern void midp_signalNativeEvent(midp_NativeEvent* event);
+
+/**
+ * Suspends the current thread until the event is signaled.
+ *
+ * @param event the event to wait for
+ */
+extern void midp_waitNativeEvent(midp_NativeEvent* event);
+
+#endif
+
 /**
  * suspends current thread for a given number of seconds.
  *
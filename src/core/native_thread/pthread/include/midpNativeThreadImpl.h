@@ -55,6 +55,20 @@ typedef void* midp_ThreadRoutineParameter;
 /** platform independent thread routine type */
 typedef void* midp_ThreadRoutine(midp_ThreadRoutineParameter param);
 
+/** defines a thread routine of the midp_ThreadRoutine type */
+#define MIDP_THREAD_ROUTINE(name, param) \
+    void* name(midp_ThreadRoutineParameter param)
+
+/** value returned by a thread routine */
+#define MIDP_THREAD_ROUTINE_RESULT ((void*)0)
+
+/** platform independent event type, see midp_initNativeEvent() */
+typedef struct _midp_NativeEvent {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    int signaled;
+} midp_NativeEvent;
+
 #ifdef __cplusplus
 }
 #endif
@@ -45,7 +45,8 @@
  * Platform specific system services for work with native threads.
  */
 
-#if ENABLE_NATIVE_APP_MANAGER && ENABLE_I3_TEST
+#if (ENABLE_NATIVE_APP_MANAGER && ENABLE_I3_TEST) || ENABLE_ASYNC_LOGGING || \
+    ENABLE_MONET
 
 /**
  * starts another native thread.
@@ -76,6 +77,55 @@ midp_ThreadId midp_startNativeThread(midp_ThreadRoutine thread,
 
 #endif
 
+#if ENABLE_ASYNC_LOGGING || ENABLE_MONET
+
+/**
+ * Initializes an auto-reset event.
+ *
+ * @param event the event to initialize
+ *
+ * @return 0 if successful, -1 if the event cannot be created
+ */
+int midp_initNativeEvent(midp_NativeEvent* event) {
+    if (pthread_mutex_init(&event->mutex, NULL) != 0) {
+        return -1;
+    }
+    if (pthread_cond_init(&event->cond, NULL) != 0) {
+        pthread_mutex_destroy(&event->mutex);
+        return -1;
+    }
+    event->signaled = 0;
+    return 0;
+}
+
+/**
+ * Signals an event, releasing the thread waiting for it.
+ *
+ * @param event the event to signal
+ */
+void midp_signalNativeEvent(midp_NativeEvent* event) {
+    pthread_mutex_lock(&event->mutex);
+    event->signaled = 1;
+    pthread_cond_signal(&event->cond);
+    pthread_mutex_unlock(&event->mutex);
+}
+
+/**
+ * Suspends the current thread until the event is signaled.
+ *
+ * @param event the event to wait for
+ */
+void midp_waitNativeEvent(midp_NativeEvent* event) {
+    pthread_mutex_lock(&event->mutex);
+    while (!event->signaled) {
+        pthread_cond_wait(&event->cond, &event->mutex);
+    }
+    event->signaled = 0;
+    pthread_mutex_unlock(&event->mutex);
+}
+
+#endif
+
 /**
  * suspends current thread for a given number of seconds.
  * Used to place java stack to suspended state in default suspend/resume
@@ -39,7 +39,8 @@
  * Platform specific system services for work with native threads.
  */
 
-#if ENABLE_NATIVE_APP_MANAGER && ENABLE_I3_TEST
+#if (ENABLE_NATIVE_APP_MANAGER && ENABLE_I3_TEST) || ENABLE_ASYNC_LOGGING || \
+    ENABLE_MONET
 /**
  * starts another native thread.
  * The primary usage of this function is testing of NAMS subsystem 
@@ -67,6 +68,47 @@ midp_ThreadId midp_startNativeThread(midp_ThreadRoutine thread,
 
 #endif
 
+#if ENABLE_ASYNC_LOGGING || ENABLE_MONET
+
+/**
+ * Initializes an auto-reset event.
+ *
+ * ATTENTION: this is a stub ! 
+ *
+ * @param event the event to initialize
+ *
+ * @return -1, events are not supported
+ */
+int midp_initNativeEvent(midp_NativeEvent* event) {
+    (void)event;
+    REPORT_WARN(LC_AMS, "midp_initNativeEvent: Stubbed out."); 
+    return -1;
+}
+
+/**
+ * Signals an event, releasing the thread waiting for it.
+ *
+ * ATTENTION: this is a stub ! 
+ *
+ * @param event the event to signal
+ */
+void midp_signalNativeEvent(midp_NativeEvent* event) {
+    (void)event;
+}
+
+/**
+ * Suspends the current thread until the event is signaled.
+ *
+ * ATTENTION: this is a stub ! 
+ *
+ * @param event the event to wait for
+ */
+void midp_waitNativeEvent(midp_NativeEvent* event) {
+    (void)event;
+}
+
+#endif
+
 /**
  * suspends current thread for a given number of seconds.
  * Used to place java stack to suspended state in default suspend/resume
@@ -44,7 +44,8 @@
 #include <midp_constants_data.h>
 #include <midpNativeThread.h>
 
-#if ENABLE_NATIVE_APP_MANAGER && ENABLE_I3_TEST
+#if (ENABLE_NATIVE_APP_MANAGER && ENABLE_I3_TEST) || ENABLE_ASYNC_LOGGING || \
+    ENABLE_MONET
 
 /**
  * starts another native thread.
@@ -74,6 +75,40 @@ midp_ThreadId midp_startNativeThread(midp_ThreadRoutine thread,
 
 #endif
 
+#if ENABLE_ASYNC_LOGGING || ENABLE_MONET
+
+/**
+ * Initializes an auto-reset event.
+ *
+ * @param event the event to initialize
+ *
+ * @return 0 if successful, -1 if the event cannot be created
+ */
+int midp_initNativeEvent(midp_NativeEvent* event) {
+    *event = CreateEvent(NULL, FALSE, FALSE, NULL);
+    return (*event == NULL) ? -1 : 0;
+}
+
+/**
+ * Signals an event, releasing the thread waiting for it.
+ *
+ * @param event the event to signal
+ */
+void midp_signalNativeEvent(midp_NativeEvent* event) {
+    SetEvent(*event);
+}
+
+/**
+ * Suspends the current thread until the event is signaled.
+ *
+ * @param event the event to wait for
+ */
+void midp_waitNativeEvent(midp_NativeEvent* event) {
+    WaitForSingleObject(*event, INFINITE);
+}
+
+#endif
+
 /**
  * Suspends current thread for a given number of seconds.
  * Used to place java stack to suspended state in default suspend/resume
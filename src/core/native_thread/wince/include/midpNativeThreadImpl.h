@@ -54,6 +54,16 @@ typedef LPVOID midp_ThreadRoutineParameter;
 /** platform independent thread routine type */
 typedef DWORD WINAPI midp_ThreadRoutine(midp_ThreadRoutineParameter param);
 
+/** defines a thread routine of the midp_ThreadRoutine type */
+#define MIDP_THREAD_ROUTINE(name, param) \
+    DWORD WINAPI name(midp_ThreadRoutineParameter param)
+
+/** value returned by a thread routine */
+#define MIDP_THREAD_ROUTINE_RESULT ((DWORD)0)
+
+/** platform independent event type, see midp_initNativeEvent() */
+typedef HANDLE midp_NativeEvent;
+
 
 #ifdef __cplusplus
 }
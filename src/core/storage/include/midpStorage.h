@@ -334,6 +334,19 @@ long storageSizeOf(char** ppszError, int handle);
 long storage_size_of_file_by_name(char** ppszError,
                                   const pcsl_string* pFileName);
 
+/*
+ * Return the time of the last modification of the file with the given
+ * name in storage.
+ *
+ * If not successful *ppszError will set to point to an error string,
+ * on success it will be set to NULL.
+ *
+ * @return time of the last modification in seconds if successful,
+ *         -1 otherwise
+ */
+long storage_get_last_modified(char** ppszError,
+                               const pcsl_string* pFileName);
+
 /**
  * Truncates the size of the given open native-storage file to the
  * given number of bytes.
@@ -684,6 +684,30 @@ storage_size_of_file_by_name(char** ppszError, const pcsl_string* pFileName) {
     return size;
 }
 
+/*
+ * Return the time of the last modification of the file with the given
+ * name in storage.
+ *
+ * If not successful *ppszError will set to point to an error string,
+ * on success it will be set to NULL.
+ *
+ * @return time of the last modification in seconds if successful,
+ *         -1 otherwise
+ */
+long
+storage_get_last_modified(char** ppszError, const pcsl_string* pFileName) {
+    long time;
+
+    if (pcsl_file_get_time(pFileName, PCSL_FILE_TIME_LAST_MODIFIED,
+                           &time) != 0) {
+        *ppszError = getLastError("storage_get_last_modified()");
+        return -1;
+    }
+
+    *ppszError = NULL;
+    return time;
+}
+
 /*
  * Truncate the size of an open file in storage.
  *
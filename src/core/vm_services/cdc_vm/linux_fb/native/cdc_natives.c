@@ -681,6 +681,7 @@ DUMMY(CNIcom_sun_midp_io_NetworkConnectionBase_initializeInternal)
 
 DUMMY(CNIcom_sun_midp_events_EventQueue_handleFatalError)
 DUMMY(CNIcom_sun_midp_events_NativeEventMonitor_readNativeEvent)
+DUMMY(CNIcom_sun_midp_events_NativeEventMonitor_readNativeEvents)
 
 KNIEXPORT KNI_RETURNTYPE_VOID
 KNIDECL(com_sun_midp_events_EventQueue_resetNativeEventQueue) {
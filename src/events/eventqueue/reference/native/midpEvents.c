@@ -49,6 +49,7 @@
 #include <pcsl_string.h>
 #include <midpUtilKni.h>
 #include <midp_properties_port.h>
+#include <keymap_input.h>
 
 
 typedef struct Java_com_sun_midp_events_EventQueue _eventQueue;
@@ -483,6 +484,74 @@ midp_resetEvents(void) {
 #endif
 }
 
+/**
+ * Tries to merge a new event into the most recently queued event of
+ * the same queue, so the Java event thread only has to process the latest
+ * state of a continuous input. Only the tail of the queue is examined,
+ * so the relative order of the events is never changed.
+ * <p>
+ * The following events are coalesced:
+ * <ul>
+ * <li>pointer drags for the same display: the coordinates of the queued
+ *     drag are replaced with the new ones;</li>
+ * <li>repeats of the same key for the same display;</li>
+ * <li>screen repaint requests for the same display.</li>
+ * </ul>
+ * None of these events carry string parameters, so nothing has to be
+ * freed when the new event is discarded.
+ * Must be called with the event queue locked.
+ *
+ * @param pEventQueue queue the event is about to be stored in
+ * @param pEvent the new event
+ *
+ * @return KNI_TRUE if the event was merged into the queued one and must
+ *         not be stored, KNI_FALSE otherwise
+ */
+static jboolean coalesceMIDPEvent(EventQueue* pEventQueue,
+                                  const MidpEvent* pEvent) {
+    MidpEvent* pLast;
+    int lastIndex;
+
+    if (pEventQueue->numEvents == 0) {
+        return KNI_FALSE;
+    }
+
+    lastIndex = pEventQueue->eventIn - 1;
+    if (lastIndex < 0) {
+        /* This is a circular queue, the tail may be at the end. */
+        lastIndex = MAX_EVENTS - 1;
+    }
+
+    pLast = &pEventQueue->events[lastIndex];
+
+    if (pLast->type != pEvent->type || pLast->DISPLAY != pEvent->DISPLAY) {
+        return KNI_FALSE;
+    }
+
+    switch (pEvent->type) {
+    case MIDP_PEN_EVENT:
+        if (pLast->ACTION != MIDP_DRAGGED || pEvent->ACTION != MIDP_DRAGGED) {
+            return KNI_FALSE;
+        }
+
+        pLast->X_POS = pEvent->X_POS;
+        pLast->Y_POS = pEvent->Y_POS;
+        return KNI_TRUE;
+
+    case MIDP_KEY_EVENT:
+        return (pLast->ACTION == KEYMAP_STATE_REPEATED &&
+                pEvent->ACTION == KEYMAP_STATE_REPEATED &&
+                pLast->CHR == pEvent->CHR) ? KNI_TRUE : KNI_FALSE;
+
+    case SCREEN_REPAINT_EVENT:
+        /* The whole screen is going to be repainted anyway */
+        return KNI_TRUE;
+
+    default:
+        return KNI_FALSE;
+    }
+}
+
 /**
  * Helper function used by StoreMIDPEventInVmThread. Enqueues an event 
  * to be processed by the Java event thread for a given event queue.
@@ -499,7 +568,13 @@ static void StoreMIDPEventInVmThreadImp(MidpEvent event, jint queueId) {
 
     midp_waitAndLockEventQueue();
 
-    if (pEventQueue->numEvents != MAX_EVENTS) {
+    if (coalesceMIDPEvent(pEventQueue, &event)) {
+        /*
+         * The event was merged into the queued one which is not consumed
+         * yet, so the monitor thread is not blocked and need not be
+         * unblocked.
+         */
+    } else if (pEventQueue->numEvents != MAX_EVENTS) {
 
         pEventQueue->events[pEventQueue->eventIn] = event;
         pEventQueue->eventIn++;
@@ -654,6 +729,45 @@ void handleFatalError(void) {
     KNI_ReturnVoid();
 }
 
+/**
+ * Copies a dequeued native event into a Java event object and frees
+ * the native fields of the event. The Java event is expected to be
+ * cleared, so string fields that are not set in the native event are
+ * left untouched and no Java string is allocated for them.
+ *
+ * @param pEvent native event to copy
+ * @param eventObj handle to the NativeEvent Java object to fill in
+ * @param stringObj handle used as temporary storage for strings
+ * @param classObj handle used as temporary storage for the event class
+ */
+static void fillNativeEventObject(MidpEvent* pEvent, jobject eventObj,
+                                  jobject stringObj, jclass classObj) {
+    cacheEventFieldIDs(eventObj, classObj);    
+
+    KNI_SetIntField(eventObj, typeFieldID, pEvent->type);
+
+    KNI_SetIntField(eventObj, intParam1FieldID, pEvent->intParam1);
+    KNI_SetIntField(eventObj, intParam2FieldID, pEvent->intParam2);
+    KNI_SetIntField(eventObj, intParam3FieldID, pEvent->intParam3);
+    KNI_SetIntField(eventObj, intParam4FieldID, pEvent->intParam4);
+    KNI_SetIntField(eventObj, intParam5FieldID, pEvent->intParam5);
+
+    SET_STRING_EVENT_FIELD(pEvent->stringParam1, stringObj, eventObj,
+                           stringParam1FieldID);
+    SET_STRING_EVENT_FIELD(pEvent->stringParam2, stringObj, eventObj,
+                           stringParam2FieldID);
+    SET_STRING_EVENT_FIELD(pEvent->stringParam3, stringObj, eventObj,
+                           stringParam3FieldID);
+    SET_STRING_EVENT_FIELD(pEvent->stringParam4, stringObj, eventObj,
+                           stringParam4FieldID);
+    SET_STRING_EVENT_FIELD(pEvent->stringParam5, stringObj, eventObj,
+                           stringParam5FieldID);
+    SET_STRING_EVENT_FIELD(pEvent->stringParam6, stringObj, eventObj,
+                           stringParam6FieldID);
+
+    freeMIDPEventFields(*pEvent);
+}
+
 /**
  * Reads a native event without blocking. Must be called from a KNI method.
  *
@@ -680,30 +794,7 @@ static int readNativeEventCommon(jint queueId) {
 
     KNI_GetParameterAsObject(1, eventObj);
 
-    cacheEventFieldIDs(eventObj, classObj);    
-
-    KNI_SetIntField(eventObj, typeFieldID, event.type);
-
-    KNI_SetIntField(eventObj, intParam1FieldID, event.intParam1);
-    KNI_SetIntField(eventObj, intParam2FieldID, event.intParam2);
-    KNI_SetIntField(eventObj, intParam3FieldID, event.intParam3);
-    KNI_SetIntField(eventObj, intParam4FieldID, event.intParam4);
-    KNI_SetIntField(eventObj, intParam5FieldID, event.intParam5);
-
-    SET_STRING_EVENT_FIELD(event.stringParam1, stringObj, eventObj,
-                           stringParam1FieldID);
-    SET_STRING_EVENT_FIELD(event.stringParam2, stringObj, eventObj,
-                           stringParam2FieldID);
-    SET_STRING_EVENT_FIELD(event.stringParam3, stringObj, eventObj,
-                           stringParam3FieldID);
-    SET_STRING_EVENT_FIELD(event.stringParam4, stringObj, eventObj,
-                           stringParam4FieldID);
-    SET_STRING_EVENT_FIELD(event.stringParam5, stringObj, eventObj,
-                           stringParam5FieldID);
-    SET_STRING_EVENT_FIELD(event.stringParam6, stringObj, eventObj,
-                           stringParam6FieldID);
-
-    freeMIDPEventFields(event);
+    fillNativeEventObject(&event, eventObj, stringObj, classObj);
 
     KNI_EndHandles();
 
@@ -765,6 +856,60 @@ Java_com_sun_midp_events_NativeEventMonitor_readNativeEvent(void) {
     KNI_ReturnBoolean(readNativeEventCommon(queueId) != -1);
 }
 
+/**
+ * Reads up to <tt>count</tt> native events without blocking, so a burst
+ * of events can be moved to Java with a single native call.
+ *
+ * @param events array of empty events to be filled in, the array
+ *               elements are filled in starting from index 0
+ * @param count maximum number of events to read
+ * @param queueId queue ID
+ *
+ * @return number of events read
+ */
+KNIEXPORT KNI_RETURNTYPE_INT
+Java_com_sun_midp_events_NativeEventMonitor_readNativeEvents(void) {
+    MidpEvent event;
+    jint count;
+    jint queueId;
+    jint eventsRead = 0;
+
+    count = KNI_GetParameterAsInt(2);
+    queueId = KNI_GetParameterAsInt(3);
+
+    KNI_StartHandles(4);
+    KNI_DeclareHandle(eventArray);
+    KNI_DeclareHandle(eventObj);
+    KNI_DeclareHandle(stringObj);
+    KNI_DeclareHandle(classObj);
+
+    KNI_GetParameterAsObject(1, eventArray);
+
+    if (!KNI_IsNullHandle(eventArray)) {
+        if (count > KNI_GetArrayLength(eventArray)) {
+            count = KNI_GetArrayLength(eventArray);
+        }
+
+        while (eventsRead < count) {
+            KNI_GetObjectArrayElement(eventArray, eventsRead, eventObj);
+            if (KNI_IsNullHandle(eventObj)) {
+                break;
+            }
+
+            if (getPendingMIDPEvent(&event, queueId) == -1) {
+                break;
+            }
+
+            fillNativeEventObject(&event, eventObj, stringObj, classObj);
+            eventsRead++;
+        }
+    }
+
+    KNI_EndHandles();
+
+    KNI_ReturnInt(eventsRead);
+}
+
 /**
  * Sends a native event a given Isolate.
  *
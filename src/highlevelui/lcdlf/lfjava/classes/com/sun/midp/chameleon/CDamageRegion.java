@@ -0,0 +1,163 @@
+/*
+ *  
+ *
+ * Copyright  1990-2007 Sun Microsystems, Inc. All Rights Reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 only, as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details (a copy is
+ * included at /legal/license.txt).
+ * 
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this work; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ * 
+ * Please contact Sun Microsystems, Inc., 4150 Network Circle, Santa
+ * Clara, CA 95054 or visit www.sun.com if you need additional
+ * information or have any questions.
+ */
+
+package com.sun.midp.chameleon;
+
+/**
+ * An area of a window needing repaint, kept as a list of rectangles
+ * that do not overlap each other. Unlike a single bounding rectangle,
+ * the region can have holes, e.g. where an opaque layer hides the
+ * layers below it.
+ */
+class CDamageRegion {
+
+    /**
+     * Rectangles of the region, 4 ints per rectangle: x, y, width
+     * and height, as indexed by CWindow.X, Y, W and H
+     */
+    int[] rects;
+
+    /** Number of rectangles in the region */
+    int count;
+
+    /** Spare array used to build the result of a subtraction */
+    private int[] spare;
+
+    /** Construct an empty region */
+    CDamageRegion() {
+        rects = new int[4 * 4];
+        spare = new int[4 * 4];
+    }
+
+    /**
+     * Make this region a single rectangle.
+     *
+     * @param x the x coordinate of the rectangle
+     * @param y the y coordinate of the rectangle
+     * @param w the width of the rectangle
+     * @param h the height of the rectangle
+     */
+    void set(int x, int y, int w, int h) {
+        count = 0;
+        if (w > 0 && h > 0) {
+            rects[CWindow.X] = x;
+            rects[CWindow.Y] = y;
+            rects[CWindow.W] = w;
+            rects[CWindow.H] = h;
+            count = 1;
+        }
+    }
+
+    /**
+     * Determines whether the region is empty.
+     *
+     * @return true if the region has no rectangles
+     */
+    boolean isEmpty() {
+        return count == 0;
+    }
+
+    /**
+     * Remove a rectangle from the region. Each rectangle of the region
+     * that intersects the removed one is replaced by up to four pieces:
+     * the full width bands above and below it, and the parts on its
+     * left and right.
+     *
+     * @param x the x coordinate of the removed rectangle
+     * @param y the y coordinate of the removed rectangle
+     * @param w the width of the removed rectangle
+     * @param h the height of the removed rectangle
+     */
+    void subtract(int x, int y, int w, int h) {
+        if (w <= 0 || h <= 0) {
+            return;
+        }
+
+        int x2 = x + w;
+        int y2 = y + h;
+        int n = 0;
+
+        for (int i = 0; i < count * 4; i += 4) {
+            int rx = rects[i];
+            int ry = rects[i + 1];
+            int rx2 = rx + rects[i + 2];
+            int ry2 = ry + rects[i + 3];
+
+            if (x >= rx2 || y >= ry2 || x2 <= rx || y2 <= ry) {
+                // Not touched, keep the whole rectangle
+                n = put(n, rx, ry, rx2, ry2);
+                continue;
+            }
+
+            // Band above the removed rectangle
+            if (ry < y) {
+                n = put(n, rx, ry, rx2, y);
+                ry = y;
+            }
+            // Band below the removed rectangle
+            if (ry2 > y2) {
+                n = put(n, rx, y2, rx2, ry2);
+                ry2 = y2;
+            }
+            // Parts on the left and on the right
+            if (rx < x) {
+                n = put(n, rx, ry, x, ry2);
+            }
+            if (rx2 > x2) {
+                n = put(n, x2, ry, rx2, ry2);
+            }
+        }
+
+        int[] t = rects;
+        rects = spare;
+        spare = t;
+        count = n / 4;
+    }
+
+    /**
+     * Append a rectangle given by its corners to the spare array,
+     * growing it if needed.
+     *
+     * @param n the index to store the rectangle at
+     * @param x1 the left edge of the rectangle
+     * @param y1 the top edge of the rectangle
+     * @param x2 the right edge of the rectangle, exclusive
+     * @param y2 the bottom edge of the rectangle, exclusive
+     * @return the index following the stored rectangle
+     */
+    private int put(int n, int x1, int y1, int x2, int y2) {
+        if (n + 4 > spare.length) {
+            int[] t = new int[spare.length * 2];
+            System.arraycopy(spare, 0, t, 0, n);
+            spare = t;
+        }
+        spare[n]     = x1;
+        spare[n + 1] = y1;
+        spare[n + 2] = x2 - x1;
+        spare[n + 3] = y2 - y1;
+        return n + 4;
+    }
+}
@@ -44,6 +44,12 @@ public class CGraphicsQ {
     
     /** A queue of refresh areas, represented by 4 element arrays */
     protected Vector refreshQ;
+
+    /**
+     * Maximal number of refresh areas in the queue. Past it the two
+     * areas whose bounding box adds the fewest pixels are merged.
+     */
+    protected static final int MAX_REGIONS = 8;
     
     /**
      * Construct a new Graphics queue. 
@@ -66,20 +72,17 @@ public class CGraphicsQ {
      * @param h the height of the region
      */
     public void queueRefresh(int x, int y, int w, int h) {
+        if (w <= 0 || h <= 0) {
+            return;
+        }
+
         synchronized (refreshQ) {
             int[] region;
-            for (int i = 0; i < refreshQ.size(); i++) {
+            for (int i = refreshQ.size() - 1; i >= 0; i--) {
                 region = (int[])refreshQ.elementAt(i);
-                
-                // We test to see if we already have the dirty region
-                if (region[0] == x && region[1] == y &&
-                    region[2] == w && region[3] == h)
-                {
-                    return;
-                }
 
-                // We also test to see if the dirty region is wholely
-                // contained within another region
+                // We test to see if the dirty region is wholely
+                // contained within another region (or is the same)
                 if (x >= region[0] && y >= region[1] &&                
                     (x + w) <= (region[0] + region[2]) && 
                     (y + h) <= (region[1] + region[3])) 
@@ -87,12 +90,27 @@ public class CGraphicsQ {
                     return;                    
                 }
 
+                // Regions wholely contained within the new one are
+                // not needed any more
+                if (region[0] >= x && region[1] >= y &&
+                    (region[0] + region[2]) <= (x + w) &&
+                    (region[1] + region[3]) <= (y + h))
+                {
+                    refreshQ.removeElementAt(i);
+                }
+            }
+
+            for (int i = 0; i < refreshQ.size(); i++) {
+                region = (int[])refreshQ.elementAt(i);
+
                 // Lastly, we do a special case whereby the region
                 // is congruent with a previous region. For instance,
                 // when changing screens, the title area will repaint,
                 // the body area will repaint, and the soft button
                 // area will repaint. All 3 areas are congruent and
-                // can be coalesced.
+                // can be coalesced. The same holds for regions side
+                // by side with the same rows, e.g. the pieces of a
+                // layer partly hidden by a popup.
                 if (x == region[0] && w == region[2]) {
                     if ((region[1] + region[3]) == y ||
                         (y + h) == region[1]) 
@@ -104,10 +122,65 @@ public class CGraphicsQ {
                         return;
                     } 
                 }
+                if (y == region[1] && h == region[3]) {
+                    if ((region[0] + region[2]) == x ||
+                        (x + w) == region[0])
+                    {
+                        if (region[0] > x) {
+                            region[0] = x;
+                        }
+                        region[2] += w;
+                        return;
+                    }
+                }
             }
             refreshQ.addElement(new int[] {x, y, w, h});
+
+            if (refreshQ.size() > MAX_REGIONS) {
+                mergeClosestRegions();
+            }
         }
     }
+
+    /**
+     * Replace the two regions of the queue whose bounding box adds
+     * the fewest pixels to them by that bounding box. The caller
+     * must hold the queue lock.
+     */
+    private void mergeClosestRegions() {
+        int size = refreshQ.size();
+        int best1 = 0, best2 = 1;
+        long bestWaste = Long.MAX_VALUE;
+        int[] r1, r2;
+
+        for (int i = 0; i < size - 1; i++) {
+            r1 = (int[])refreshQ.elementAt(i);
+            for (int j = i + 1; j < size; j++) {
+                r2 = (int[])refreshQ.elementAt(j);
+                int x1 = Math.min(r1[0], r2[0]);
+                int y1 = Math.min(r1[1], r2[1]);
+                int x2 = Math.max(r1[0] + r1[2], r2[0] + r2[2]);
+                int y2 = Math.max(r1[1] + r1[3], r2[1] + r2[3]);
+                long waste = (long)(x2 - x1) * (y2 - y1)
+                    - (long)r1[2] * r1[3] - (long)r2[2] * r2[3];
+                if (waste < bestWaste) {
+                    bestWaste = waste;
+                    best1 = i;
+                    best2 = j;
+                }
+            }
+        }
+
+        r1 = (int[])refreshQ.elementAt(best1);
+        r2 = (int[])refreshQ.elementAt(best2);
+        int x1 = Math.min(r1[0], r2[0]);
+        int y1 = Math.min(r1[1], r2[1]);
+        r1[2] = Math.max(r1[0] + r1[2], r2[0] + r2[2]) - x1;
+        r1[3] = Math.max(r1[1] + r1[3], r2[1] + r2[3]) - y1;
+        r1[0] = x1;
+        r1[1] = y1;
+        refreshQ.removeElementAt(best2);
+    }
     
     /**
      * Get the queue of all areas of the screen to be refreshed
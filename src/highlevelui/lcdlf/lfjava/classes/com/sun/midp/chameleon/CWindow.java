@@ -77,6 +77,13 @@ public abstract class CWindow {
     /** Layers replication to not keep the lock on painting */
     protected CLayer[] dirtyLayers = new CLayer[dirtyMaxCount];
 
+    /**
+     * Visible parts of the dirty regions of the copied layers, in the
+     * coordinate space of this window. The i-th region belongs to the
+     * i-th layer of <code>dirtyLayers</code>.
+     */
+    protected CDamageRegion[] dirtyRegions = new CDamageRegion[dirtyMaxCount];
+
     /** Layer currently accepting pen events */
     protected CLayer layerUnderPen;
 
@@ -462,6 +469,11 @@ public abstract class CWindow {
             
             l2 = le2.getLayer();
             if (l2.visible) {
+                // The layers from an opaque layer covering the whole
+                // dirty region upwards are not changed by it
+                if (l2.opaque && covers(l2, dx, dy, dw, dh)) {
+                    break;
+                }
                 if (l2.addDirtyRegion(
                         dx-l2.bounds[X], dy-l2.bounds[Y], dw, dh)) {
                     // Remember the highest changed layer
@@ -493,6 +505,22 @@ public abstract class CWindow {
         return res;
     }
 
+    /**
+     * Check whether a layer covers the whole given area.
+     *
+     * @param l the layer to check
+     * @param x the x coordinate of the area in window coordinates
+     * @param y the y coordinate of the area in window coordinates
+     * @param w the width of the area
+     * @param h the height of the area
+     * @return true if the area lies entirely within the layer bounds
+     */
+    private static boolean covers(CLayer l, int x, int y, int w, int h) {
+        return x >= l.bounds[X] && y >= l.bounds[Y] &&
+            x + w <= l.bounds[X] + l.bounds[W] &&
+            y + h <= l.bounds[Y] + l.bounds[H];
+    }
+
     // Heuristic Explanation: Any layer that needs painting also
     // requires all layers below and above that region to be painted.
     // This is required because layers may be transparent or even
@@ -512,7 +540,10 @@ public abstract class CWindow {
     // After doing this initial iteration, all layers will now be
     // marked dirty where appropriate and have their individual dirty
     // regions set. We then make another iteration from the bottom
-    // most layer to the top, painting the dirty region of each layer.
+    // most layer to the top, removing from the dirty region of each
+    // layer the parts hidden by visible opaque layers above it, and
+    // painting what remains rectangle by rectangle. A layer hidden
+    // entirely is not painted at all.
 
     /**
      * First Pass: We do sweep and mark of all layers requiring a repaint,
@@ -561,6 +592,8 @@ public abstract class CWindow {
      * layers painting will happen. Dirty states of the layers are
      * cleaned after the copying. Layers painting can change layers
      * state again, but it will be served on next repaint only.
+     * The visible part of the dirty region of each layer is copied
+     * along, layers with no visible part are skipped.
      */
     private void copyAndCleanDirtyLayers() {
         if (CGraphicsQ.DEBUG) {
@@ -573,6 +606,10 @@ public abstract class CWindow {
         if (layersCount > dirtyMaxCount) {
             dirtyMaxCount += layersCount;
             dirtyLayers = new CLayer[dirtyMaxCount];
+            CDamageRegion[] regions = new CDamageRegion[dirtyMaxCount];
+            System.arraycopy(dirtyRegions, 0, regions, 0,
+                dirtyRegions.length);
+            dirtyRegions = regions;
         }
         // Copy dirty layer references and reset dirty layer states
         for (CLayerElement le = layers.getBottom();
@@ -580,7 +617,32 @@ public abstract class CWindow {
             l = le.getLayer();
             if (l.visible && l.isDirty()) {
                 l.copyAndCleanDirtyState();
-                dirtyLayers[dirtyCount++] = l;
+
+                CDamageRegion r = dirtyRegions[dirtyCount];
+                if (r == null) {
+                    r = new CDamageRegion();
+                    dirtyRegions[dirtyCount] = r;
+                }
+                r.set(l.boundsCopy[X] + l.dirtyBoundsCopy[X],
+                      l.boundsCopy[Y] + l.dirtyBoundsCopy[Y],
+                      l.dirtyBoundsCopy[W], l.dirtyBoundsCopy[H]);
+
+                // Remove the parts hidden by opaque layers above
+                CLayer l2;
+                for (CLayerElement le2 = le.getUpper();
+                        le2 != null && !r.isEmpty(); le2 = le2.getUpper()) {
+                    l2 = le2.getLayer();
+                    if (l2.visible && l2.opaque) {
+                        r.subtract(l2.bounds[X], l2.bounds[Y],
+                                   l2.bounds[W], l2.bounds[H]);
+                    }
+                }
+
+                if (!r.isEmpty()) {
+                    dirtyLayers[dirtyCount++] = l;
+                } else if (CGraphicsQ.DEBUG) {
+                    System.err.println("Skip Hidden Layer: " + l);
+                }
             } else { // !(visible && dirty)
                 if (CGraphicsQ.DEBUG) {
                     System.err.println("Skip Layer: " + l);
@@ -608,13 +670,25 @@ public abstract class CWindow {
 
         for (int i = 0; i < dirtyCount; i++) {
             CLayer l = dirtyLayers[i];
-
-            // Prepare relative dirty region coordinates
-            // of the current layer
-            int dx = l.dirtyBoundsCopy[X];
-            int dy = l.dirtyBoundsCopy[Y];
-            int dw = l.dirtyBoundsCopy[W];
-            int dh = l.dirtyBoundsCopy[H];
+            CDamageRegion r = dirtyRegions[i];
+
+            // Prepare relative coordinates of the clip. A region of one
+            // rectangle is clipped to exactly, a region with holes is
+            // clipped to the whole dirty rectangle of the layer so that
+            // it is painted only once; the opaque layers partly covering
+            // it are dirty as well and are painted over it afterwards
+            int dx, dy, dw, dh;
+            if (r.count == 1) {
+                dx = r.rects[X] - l.boundsCopy[X];
+                dy = r.rects[Y] - l.boundsCopy[Y];
+                dw = r.rects[W];
+                dh = r.rects[H];
+            } else {
+                dx = l.dirtyBoundsCopy[X];
+                dy = l.dirtyBoundsCopy[Y];
+                dw = l.dirtyBoundsCopy[W];
+                dh = l.dirtyBoundsCopy[H];
+            }
 
             // Before we call into the layer to paint, we
             // translate the graphics context into the layer's
@@ -627,12 +701,14 @@ public abstract class CWindow {
                     dx + ", " + dy + ", " + dw + ", " + dh);
             }
 
-            // Clip the graphics to only contain the dirty region of
-            // the layer (if the dirty region isn't set, clip to the
-            // whole layer contents).
+            // Clip the graphics to only contain the dirty bounds
             g.clipRect(dx, dy, dw, dh);
-            refreshQ.queueRefresh(
-                l.boundsCopy[X] + dx, l.boundsCopy[Y] + dy, dw, dh);
+
+            // Only the visible rectangles need to be refreshed
+            for (int j = 0; j < r.count * 4; j += 4) {
+                refreshQ.queueRefresh(r.rects[j + X], r.rects[j + Y],
+                                      r.rects[j + W], r.rects[j + H]);
+            }
             l.paint(g);
 
             // We restore our graphics context to prepare
@@ -254,6 +254,8 @@ class CanvasLFImpl extends DisplayableLFImpl implements CanvasLF, VirtualKeyList
                 // let the helper class invoke video rendering
                 // Update frames of any video players displayed on this Canvas
                 if (mmHelper != null) {
+                    // Video frames go over what the canvas painted
+                    g.flushCommands();
                     for (Enumeration e = embeddedVideos.elements(); 
                                                   e.hasMoreElements();) {
                         mmHelper.paintVideo(e.nextElement(), g);
@@ -0,0 +1,212 @@
+/*
+ *
+ *
+ * Copyright  1990-2007 Sun Microsystems, Inc. All Rights Reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 only, as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details (a copy is
+ * included at /legal/license.txt).
+ * 
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this work; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ * 
+ * Please contact Sun Microsystems, Inc., 4150 Network Circle, Santa
+ * Clara, CA 95054 or visit www.sun.com if you need additional
+ * information or have any questions.
+ */
+
+package com.sun.midp.chameleon;
+
+import com.sun.midp.i3test.*;
+
+/**
+ * Tests of CDamageRegion.subtract(). After each subtraction the
+ * rectangles of the region must not overlap each other, must not
+ * intersect the removed rectangle and must cover the expected area.
+ */
+public class TestCDamageRegion extends TestCase {
+
+    /** Subtracting a disjoint rectangle keeps the region unchanged */
+    void testNoOverlap() {
+        CDamageRegion r = new CDamageRegion();
+        r.set(0, 0, 10, 10);
+        r.subtract(20, 20, 5, 5);
+        assertEquals("count", 1, r.count);
+        assertEquals("x", 0, r.rects[0]);
+        assertEquals("y", 0, r.rects[1]);
+        assertEquals("w", 10, r.rects[2]);
+        assertEquals("h", 10, r.rects[3]);
+
+        // Touching edges do not overlap
+        r.subtract(10, 0, 5, 10);
+        assertEquals("count after touching", 1, r.count);
+        assertEquals("area after touching", 100, area(r));
+    }
+
+    /** A hole in the middle leaves four pieces around it */
+    void testHole() {
+        CDamageRegion r = new CDamageRegion();
+        r.set(0, 0, 10, 10);
+        r.subtract(3, 3, 4, 4);
+        assertEquals("count", 4, r.count);
+        assertEquals("area", 100 - 16, area(r));
+        checkRegion(r, 0, 0, 10, 10, 3, 3, 4, 4);
+    }
+
+    /** A rectangle covering the region empties it */
+    void testFullCover() {
+        CDamageRegion r = new CDamageRegion();
+        r.set(5, 5, 10, 10);
+        r.subtract(0, 0, 20, 20);
+        assertTrue("empty", r.isEmpty());
+
+        r.set(5, 5, 10, 10);
+        r.subtract(5, 5, 10, 10);
+        assertTrue("empty on same rectangle", r.isEmpty());
+    }
+
+    /** Partial overlaps on the edges and corners */
+    void testEdges() {
+        CDamageRegion r = new CDamageRegion();
+
+        // Covering the right half
+        r.set(0, 0, 10, 10);
+        r.subtract(5, -5, 10, 20);
+        assertEquals("right count", 1, r.count);
+        assertEquals("right w", 5, r.rects[2]);
+        assertEquals("right h", 10, r.rects[3]);
+
+        // Covering the top band
+        r.set(0, 0, 10, 10);
+        r.subtract(-5, -5, 20, 8);
+        assertEquals("top count", 1, r.count);
+        assertEquals("top y", 3, r.rects[1]);
+        assertEquals("top h", 7, r.rects[3]);
+
+        // Covering the bottom right corner
+        r.set(0, 0, 10, 10);
+        r.subtract(6, 6, 10, 10);
+        assertEquals("corner count", 2, r.count);
+        assertEquals("corner area", 100 - 16, area(r));
+        checkRegion(r, 0, 0, 10, 10, 6, 6, 10, 10);
+
+        // Empty rectangles are ignored
+        r.set(0, 0, 10, 10);
+        r.subtract(2, 2, 0, 5);
+        r.subtract(2, 2, 5, -1);
+        assertEquals("empty subtract count", 1, r.count);
+        assertEquals("empty subtract area", 100, area(r));
+
+        // Setting an empty rectangle gives an empty region
+        r.set(0, 0, 0, 10);
+        assertTrue("empty set", r.isEmpty());
+    }
+
+    /** Several subtractions grow the region past its initial storage */
+    void testMany() {
+        CDamageRegion r = new CDamageRegion();
+        r.set(0, 0, 100, 100);
+        int removed = 0;
+        for (int i = 0; i < 5; i++) {
+            r.subtract(10 + i * 18, 10 + i * 18, 8, 8);
+            removed += 64;
+            checkRegion(r, 0, 0, 100, 100,
+                        10 + i * 18, 10 + i * 18, 8, 8);
+        }
+        assertTrue("count grew", r.count > 4);
+        assertEquals("area", 100 * 100 - removed, area(r));
+    }
+
+    /**
+     * Computes the total area of the rectangles of a region.
+     *
+     * @param r the region
+     * @return the sum of the areas of its rectangles
+     */
+    int area(CDamageRegion r) {
+        int a = 0;
+        for (int i = 0; i < r.count * 4; i += 4) {
+            a += r.rects[i + 2] * r.rects[i + 3];
+        }
+        return a;
+    }
+
+    /**
+     * Checks that the rectangles of a region are not empty, lie within
+     * the given bounds, do not overlap each other and do not intersect
+     * the removed rectangle.
+     *
+     * @param r the region
+     * @param bx the x coordinate of the bounds
+     * @param by the y coordinate of the bounds
+     * @param bw the width of the bounds
+     * @param bh the height of the bounds
+     * @param x the x coordinate of the removed rectangle
+     * @param y the y coordinate of the removed rectangle
+     * @param w the width of the removed rectangle
+     * @param h the height of the removed rectangle
+     */
+    void checkRegion(CDamageRegion r, int bx, int by, int bw, int bh,
+                     int x, int y, int w, int h) {
+        int[] q = r.rects;
+        for (int i = 0; i < r.count * 4; i += 4) {
+            assertTrue("not empty", q[i + 2] > 0 && q[i + 3] > 0);
+            assertTrue("within bounds",
+                       q[i] >= bx && q[i + 1] >= by &&
+                       q[i] + q[i + 2] <= bx + bw &&
+                       q[i + 1] + q[i + 3] <= by + bh);
+            assertTrue("outside removed",
+                       !intersects(q, i, x, y, w, h));
+            for (int j = i + 4; j < r.count * 4; j += 4) {
+                assertTrue("disjoint", !intersects(q, i,
+                           q[j], q[j + 1], q[j + 2], q[j + 3]));
+            }
+        }
+    }
+
+    /**
+     * Determines whether a rectangle of an array intersects another one.
+     *
+     * @param q the array of rectangles
+     * @param i the index of the rectangle in the array
+     * @param x the x coordinate of the other rectangle
+     * @param y the y coordinate of the other rectangle
+     * @param w the width of the other rectangle
+     * @param h the height of the other rectangle
+     * @return true if the rectangles share at least one pixel
+     */
+    boolean intersects(int[] q, int i, int x, int y, int w, int h) {
+        return q[i] < x + w && x < q[i] + q[i + 2] &&
+            q[i + 1] < y + h && y < q[i + 1] + q[i + 3];
+    }
+
+    /**
+     * Overridden from TestCase parent. This method will kick off each
+     * individual test
+     */
+    public void runTests() {
+        declare("testNoOverlap");
+        testNoOverlap();
+
+        declare("testHole");
+        testHole();
+
+        declare("testFullCover");
+        testFullCover();
+
+        declare("testEdges");
+        testEdges();
+
+        declare("testMany");
+        testMany();
+    }
+}
@@ -0,0 +1,149 @@
+/*
+ *
+ *
+ * Copyright  1990-2007 Sun Microsystems, Inc. All Rights Reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 only, as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details (a copy is
+ * included at /legal/license.txt).
+ * 
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this work; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ * 
+ * Please contact Sun Microsystems, Inc., 4150 Network Circle, Santa
+ * Clara, CA 95054 or visit www.sun.com if you need additional
+ * information or have any questions.
+ */
+
+package com.sun.midp.chameleon;
+
+import com.sun.midp.i3test.*;
+
+/**
+ * Tests of the coalescing done by CGraphicsQ.queueRefresh():
+ * dropping contained regions, joining adjacent regions and merging
+ * the closest regions past CGraphicsQ.MAX_REGIONS.
+ */
+public class TestCGraphicsQ extends TestCase {
+
+    /** Empty regions are not queued */
+    void testEmpty() {
+        CGraphicsQ q = new CGraphicsQ();
+        q.queueRefresh(0, 0, 0, 10);
+        q.queueRefresh(0, 0, 10, -1);
+        assertEquals("count", 0, q.getRefreshRegions().length);
+    }
+
+    /** Contained regions are dropped, containing ones replace them */
+    void testContainment() {
+        CGraphicsQ q = new CGraphicsQ();
+        q.queueRefresh(0, 0, 10, 10);
+        q.queueRefresh(2, 2, 3, 3);
+        q.queueRefresh(0, 0, 10, 10);
+        Object[] r = q.getRefreshRegions();
+        assertEquals("contained count", 1, r.length);
+        checkRegion("contained", r[0], 0, 0, 10, 10);
+
+        q.queueRefresh(5, 5, 2, 2);
+        q.queueRefresh(50, 50, 2, 2);
+        q.queueRefresh(12, 0, 2, 2);
+        q.queueRefresh(0, 0, 20, 20);
+        r = q.getRefreshRegions();
+        assertEquals("containing count", 2, r.length);
+        checkRegion("kept", r[0], 50, 50, 2, 2);
+        checkRegion("containing", r[1], 0, 0, 20, 20);
+    }
+
+    /** Regions of the same columns one above the other are joined */
+    void testVertical() {
+        CGraphicsQ q = new CGraphicsQ();
+        q.queueRefresh(0, 0, 10, 5);
+        q.queueRefresh(0, 5, 10, 5);
+        q.queueRefresh(0, -5, 10, 5);
+        Object[] r = q.getRefreshRegions();
+        assertEquals("count", 1, r.length);
+        checkRegion("joined", r[0], 0, -5, 10, 15);
+    }
+
+    /** Regions of the same rows side by side are joined */
+    void testSideBySide() {
+        CGraphicsQ q = new CGraphicsQ();
+        q.queueRefresh(10, 0, 5, 10);
+        q.queueRefresh(5, 0, 5, 10);
+        q.queueRefresh(15, 0, 5, 10);
+        Object[] r = q.getRefreshRegions();
+        assertEquals("count", 1, r.length);
+        checkRegion("joined", r[0], 5, 0, 15, 10);
+
+        // Different rows are not joined
+        q.queueRefresh(0, 0, 5, 10);
+        q.queueRefresh(5, 0, 5, 8);
+        assertEquals("different rows", 2, q.getRefreshRegions().length);
+    }
+
+    /** Past MAX_REGIONS the two closest regions are merged */
+    void testMaxRegions() {
+        CGraphicsQ q = new CGraphicsQ();
+        int i;
+        for (i = 0; i < CGraphicsQ.MAX_REGIONS; i++) {
+            q.queueRefresh(i * 100, i * 100, 10, 10);
+        }
+        // Close to the first region but not adjacent to it
+        q.queueRefresh(0, 12, 10, 10);
+
+        Object[] r = q.getRefreshRegions();
+        assertEquals("count", CGraphicsQ.MAX_REGIONS, r.length);
+        checkRegion("merged", r[0], 0, 0, 10, 22);
+        for (i = 1; i < r.length; i++) {
+            checkRegion("kept", r[i], i * 100, i * 100, 10, 10);
+        }
+    }
+
+    /**
+     * Checks the coordinates of a refresh region.
+     *
+     * @param msg the message prefix
+     * @param o the region, an int[] of x, y, w and h
+     * @param x the expected x coordinate
+     * @param y the expected y coordinate
+     * @param w the expected width
+     * @param h the expected height
+     */
+    void checkRegion(String msg, Object o, int x, int y, int w, int h) {
+        int[] region = (int[])o;
+        assertEquals(msg + " x", x, region[0]);
+        assertEquals(msg + " y", y, region[1]);
+        assertEquals(msg + " w", w, region[2]);
+        assertEquals(msg + " h", h, region[3]);
+    }
+
+    /**
+     * Overridden from TestCase parent. This method will kick off each
+     * individual test
+     */
+    public void runTests() {
+        declare("testEmpty");
+        testEmpty();
+
+        declare("testContainment");
+        testContainment();
+
+        declare("testVertical");
+        testVertical();
+
+        declare("testSideBySide");
+        testSideBySide();
+
+        declare("testMaxRegions");
+        testMaxRegions();
+    }
+}
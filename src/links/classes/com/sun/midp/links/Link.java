@@ -34,9 +34,50 @@ public class Link {
 
     private Link emptyLinkCache; // = null
 
+    private LinkBuffer emptyBufferCache; // = null
+
     private int nativePointer; // set and get only by native code
 
     public static Link newLink(Isolate sender, Isolate receiver) {
+        return newLink(sender, receiver, 0);
+    }
+
+    /**
+     * Creates a new buffered link. Up to <code>maxQueued</code> messages
+     * sent over a buffered link are queued in native memory, so send()
+     * returns as soon as the message is queued and blocks only while the
+     * queue is full. The contents of the messages are copied when they are
+     * sent rather than when they are received.
+     *
+     * When the sender closes a buffered link, the messages still queued
+     * are delivered to the receiver before receive() reports the link
+     * closed. When the receiver closes it, they are discarded.
+     *
+     * @param sender the sending isolate
+     * @param receiver the receiving isolate
+     * @param maxQueued maximum number of queued messages, must be positive
+     * @return the new link
+     */
+    public static Link newBufferedLink(Isolate sender, Isolate receiver,
+                                       int maxQueued) {
+        if (maxQueued <= 0) {
+            throw new IllegalArgumentException();
+        }
+
+        return newLink(sender, receiver, maxQueued);
+    }
+
+    /**
+     * Creates a new link.
+     *
+     * @param sender the sending isolate
+     * @param receiver the receiving isolate
+     * @param maxQueued maximum number of queued messages, 0 for a link
+     *        where the sender waits until the receiver gets the message
+     * @return the new link
+     */
+    private static Link newLink(Isolate sender, Isolate receiver,
+                                int maxQueued) {
         int rid = receiver.id();  // throws NullPointerException
         int sid = sender.id();    // throws NullPointerException
 
@@ -51,7 +92,7 @@ public class Link {
          */
 
         Link link = new Link();
-        link.init0(sender.id(), receiver.id());
+        link.init0(sender.id(), receiver.id(), maxQueued);
         return link;
     }
 
@@ -83,6 +124,7 @@ public class Link {
                    InterruptedIOException,
                    IOException {
         Link emptyLink;
+        LinkBuffer emptyBuffer;
         LinkMessage msg = new LinkMessage();
 
         synchronized (this) {
@@ -92,15 +134,24 @@ public class Link {
                 emptyLink = emptyLinkCache;
                 emptyLinkCache = null;
             }
+
+            if (emptyBufferCache == null) {
+                emptyBuffer = new LinkBuffer();
+            } else {
+                emptyBuffer = emptyBufferCache;
+                emptyBufferCache = null;
+            }
         }
 
-        receive0(msg, emptyLink);
+        receive0(msg, emptyLink, emptyBuffer);
+
+        synchronized (this) {
+            if (!msg.containsLink() && emptyLinkCache == null) {
+                emptyLinkCache = emptyLink;
+            }
 
-        if (!msg.containsLink()) {
-            synchronized (this) {
-                if (emptyLinkCache == null) {
-                    emptyLinkCache = emptyLink;
-                }
+            if (!msg.containsBuffer() && emptyBufferCache == null) {
+                emptyBufferCache = emptyBuffer;
             }
         }
 
@@ -135,9 +186,10 @@ public class Link {
 
     private native void finalize();
 
-    private native void init0(int sender, int receiver);
+    private native void init0(int sender, int receiver, int maxQueued);
 
-    private native void receive0(LinkMessage msg, Link link)
+    private native void receive0(LinkMessage msg, Link link,
+                                 LinkBuffer buffer)
             throws ClosedLinkException,
                    InterruptedIOException,
                    IOException;
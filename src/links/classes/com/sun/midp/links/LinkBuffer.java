@@ -0,0 +1,142 @@
+/*
+ *
+ *
+ * Copyright  1990-2007 Sun Microsystems, Inc. All Rights Reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 only, as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details (a copy is
+ * included at /legal/license.txt).
+ * 
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this work; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ * 
+ * Please contact Sun Microsystems, Inc., 4150 Network Circle, Santa
+ * Clara, CA 95054 or visit www.sun.com if you need additional
+ * information or have any questions.
+ */
+
+package com.sun.midp.links;
+
+/**
+ * A block of native memory that can be sent between Isolates through a Link
+ * without being copied. Sending a LinkBuffer in a LinkMessage moves the
+ * ownership of the memory to the receiver: the sender's LinkBuffer object
+ * becomes detached and can no longer be used, and the receiver gets a
+ * LinkBuffer object referring to the same memory.
+ */
+public class LinkBuffer {
+
+    private int nativePointer; // set and get only by native code
+
+    private int size; // set by native code along with nativePointer
+
+    /**
+     * Allocates a new buffer of the given size.
+     *
+     * @param newSize size of the buffer in bytes
+     * @throws IllegalArgumentException if newSize is negative
+     * @throws OutOfMemoryError if there is not enough native memory
+     */
+    public LinkBuffer(int newSize) {
+        if (newSize < 0) {
+            throw new IllegalArgumentException();
+        }
+
+        init0(newSize);
+    }
+
+    /**
+     * Creates a new, detached buffer. This buffer is filled in by native
+     * code when a LinkBuffer is received.
+     */
+    LinkBuffer() {
+    }
+
+    /**
+     * Queries whether this buffer still owns its memory, that is, it
+     * has been neither sent nor released.
+     */
+    public boolean isAttached() {
+        return nativePointer != 0;
+    }
+
+    /**
+     * Returns the size of the buffer in bytes, or 0 if it is detached.
+     */
+    public int size() {
+        return nativePointer == 0 ? 0 : size;
+    }
+
+    /**
+     * Copies bytes from an array into this buffer.
+     *
+     * @param position where to start writing in this buffer
+     * @param src the source array
+     * @param offset where to start reading in src
+     * @param length number of bytes to copy
+     * @throws IllegalStateException if this buffer is detached
+     * @throws IndexOutOfBoundsException if a range is out of bounds
+     */
+    public synchronized void write(int position, byte[] src, int offset,
+                                   int length) {
+        checkRange(position, src, offset, length);
+        write0(position, src, offset, length);
+    }
+
+    /**
+     * Copies bytes from this buffer into an array.
+     *
+     * @param position where to start reading in this buffer
+     * @param dst the destination array
+     * @param offset where to start writing in dst
+     * @param length number of bytes to copy
+     * @throws IllegalStateException if this buffer is detached
+     * @throws IndexOutOfBoundsException if a range is out of bounds
+     */
+    public synchronized void read(int position, byte[] dst, int offset,
+                                  int length) {
+        checkRange(position, dst, offset, length);
+        read0(position, dst, offset, length);
+    }
+
+    /**
+     * Frees the memory of this buffer. Does nothing if the buffer is
+     * detached.
+     */
+    public synchronized native void release();
+
+    /**
+     * Checks the arguments of read() and write().
+     */
+    private void checkRange(int position, byte[] array, int offset,
+                            int length) {
+        if (nativePointer == 0) {
+            throw new IllegalStateException();
+        }
+
+        if (position < 0 || offset < 0 || length < 0
+                || position + length < 0 || position + length > size
+                || offset + length < 0 || offset + length > array.length) {
+            throw new IndexOutOfBoundsException();
+        }
+    }
+
+    private native void finalize();
+
+    private native void init0(int newSize);
+
+    private native void write0(int position, byte[] src, int offset,
+                               int length);
+
+    private native void read0(int position, byte[] dst, int offset,
+                              int length);
+}
@@ -69,6 +69,13 @@ public class LinkMessage {
         return contents instanceof byte[];
     }
 
+    /**
+     * Queries whether the LinkMessage contains a LinkBuffer.
+     */
+    public boolean containsBuffer() {
+        return contents instanceof LinkBuffer;
+    }
+
     /**
      * Queries whether the LinkMessage contains a Link.
      */
@@ -114,6 +121,19 @@ public class LinkMessage {
         return newData;
     }
 
+    /**
+     * Returns the contents of the LinkMessage if it contains a LinkBuffer. If
+     * the message does not contain a LinkBuffer, throws
+     * IllegalStateException.
+     */
+    public LinkBuffer extractBuffer() {
+        if (contents instanceof LinkBuffer) {
+            return (LinkBuffer)contents;
+        } else {
+            throw new IllegalStateException();
+        }
+    }
+
     /**
      * Returns the contents of the LinkMessage if it contains is a Link. If 
      * the message does not contain a Link, throws IllegalStateException.
@@ -155,6 +175,19 @@ public class LinkMessage {
         return new LinkMessage(data, offset, length);
     }
 
+    /**
+     * Creates a message that moves the given buffer to the receiver without
+     * copying its contents. Once the message is sent, the buffer is detached
+     * in the sending Isolate.
+     */
+    public static LinkMessage newBufferMessage(LinkBuffer buffer) {
+        if (!buffer.isAttached()) {  // throws NullPointerException
+            throw new IllegalStateException();
+        }
+
+        return new LinkMessage(buffer, 0, 0);
+    }
+
     public static LinkMessage newLinkMessage(Link link) {
         return new LinkMessage(link, 0, 0);
     }
@@ -0,0 +1,234 @@
+/*
+ *
+ *
+ * Copyright  1990-2007 Sun Microsystems, Inc. All Rights Reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 only, as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details (a copy is
+ * included at /legal/license.txt).
+ * 
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this work; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ * 
+ * Please contact Sun Microsystems, Inc., 4150 Network Circle, Santa
+ * Clara, CA 95054 or visit www.sun.com if you need additional
+ * information or have any questions.
+ */
+
+package com.sun.midp.links;
+
+import com.sun.cldc.isolate.Isolate;
+import com.sun.cldc.isolate.IsolateStartupException;
+import com.sun.midp.i3test.TestCase;
+import java.io.IOException;
+
+/**
+ * Tests buffered links: messages are queued without a receiver, are
+ * received in the order they were sent, and the sender blocks only while
+ * the queue is full. All but the last test use a single isolate.
+ */
+public class TestBufferedLink extends TestCase {
+
+    /** Queue size of the links used by the tests. */
+    static final int QUEUE_SIZE = 4;
+
+
+    /**
+     * Tests that several messages of different kinds can be sent before
+     * they are received, and that they are received in order.
+     */
+    void testQueued() throws IOException {
+        Isolate i = Isolate.currentIsolate();
+        Link link = Link.newBufferedLink(i, i, QUEUE_SIZE);
+        Link payload = Link.newLink(i, i);
+        byte[] sendarr = new byte[100];
+        Utils.fillRandom(sendarr);
+
+        link.send(LinkMessage.newStringMessage("foo"));
+        link.send(LinkMessage.newDataMessage(sendarr));
+        link.send(LinkMessage.newDataMessage(sendarr, 17, 32));
+        link.send(LinkMessage.newLinkMessage(payload));
+
+        assertEquals("first message should be the string",
+            "foo", link.receive().extractString());
+
+        byte[] recvarr = link.receive().extractData();
+        assertTrue("arrays shouldn't be identical", sendarr != recvarr);
+        assertTrue("arrays should be equal",
+            Utils.bytesEqual(sendarr, recvarr));
+
+        recvarr = link.receive().extractData();
+        assertTrue("subrange should be equal",
+            Utils.bytesEqual(sendarr, 17, 32, recvarr));
+
+        Link recvlink = link.receive().extractLink();
+        assertTrue("links should be equal", payload.equals(recvlink));
+
+        link.close();
+        payload.close();
+        recvlink.close();
+    }
+
+
+    /**
+     * Tests that the contents are copied when the message is sent.
+     */
+    void testCopyOnSend() throws IOException {
+        Isolate i = Isolate.currentIsolate();
+        Link link = Link.newBufferedLink(i, i, QUEUE_SIZE);
+        byte[] sendarr = new byte[10];
+        byte[] expected = new byte[10];
+        Utils.fillRandom(sendarr);
+        System.arraycopy(sendarr, 0, expected, 0, sendarr.length);
+
+        link.send(LinkMessage.newDataMessage(sendarr));
+        sendarr[0] ^= 0xff;
+
+        assertTrue("received data should be as sent",
+            Utils.bytesEqual(expected, link.receive().extractData()));
+        link.close();
+    }
+
+
+    /**
+     * Tests that a sender blocks when the queue is full and continues
+     * when a message is received.
+     */
+    void testFull() throws IOException {
+        Isolate i = Isolate.currentIsolate();
+        Link link = Link.newBufferedLink(i, i, QUEUE_SIZE);
+        int n;
+
+        for (n = 0; n < QUEUE_SIZE; n++) {
+            link.send(LinkMessage.newStringMessage("msg" + n));
+        }
+
+        Sender sender = new Sender(link,
+            LinkMessage.newStringMessage("msg" + n));
+        assertFalse("sender should be blocked", sender.done);
+
+        for (n = 0; n <= QUEUE_SIZE; n++) {
+            assertEquals("messages should be received in order",
+                "msg" + n, link.receive().extractString());
+        }
+
+        sender.await();
+        assertTrue("sender should be done", sender.done);
+        assertNull("sender should have no exceptions", sender.exception);
+        link.close();
+    }
+
+
+    /**
+     * Tests that a receiver waits for a message on an empty queue.
+     */
+    void testReceiveWaits() throws IOException {
+        Isolate i = Isolate.currentIsolate();
+        Link link = Link.newBufferedLink(i, i, QUEUE_SIZE);
+        Receiver receiver = new Receiver(link);
+
+        assertFalse("receiver should be blocked", receiver.done);
+        link.send(LinkMessage.newStringMessage("bar"));
+        receiver.await();
+
+        assertTrue("receiver should be done", receiver.done);
+        assertNull("receiver should have no exceptions", receiver.exception);
+        assertEquals("strings should be equal",
+            "bar", receiver.msg.extractString());
+        link.close();
+    }
+
+
+    /**
+     * Tests that closing the link in the receiving isolate discards the
+     * queued messages.
+     */
+    void testClose() throws IOException {
+        Isolate i = Isolate.currentIsolate();
+        Link link = Link.newBufferedLink(i, i, QUEUE_SIZE);
+        boolean thrown = false;
+
+        link.send(LinkMessage.newStringMessage("lost"));
+        link.close();
+
+        try {
+            link.receive();
+        } catch (ClosedLinkException cle) {
+            thrown = true;
+        }
+
+        assertTrue("receive on a closed link should throw", thrown);
+    }
+
+
+    /**
+     * Tests that messages queued by another isolate are still received,
+     * in order, after that isolate has closed its side of the link, and
+     * that the receiver then gets ClosedLinkException.
+     */
+    void testSenderClose() throws IOException, IsolateStartupException {
+        Isolate us = Isolate.currentIsolate();
+        Isolate them = new Isolate("com.sun.midp.links.QueueAndClose",
+            new String[] { Integer.toString(QUEUE_SIZE) });
+        them.start();
+        Link link = Link.newBufferedLink(them, us, QUEUE_SIZE);
+        Link done = Link.newLink(them, us);
+        boolean thrown = false;
+
+        LinkPortal.setLinks(them, new Link[] { link, done });
+
+        assertEquals("sender should have closed the link",
+            "closed", done.receive().extractString());
+
+        for (int n = 0; n < QUEUE_SIZE; n++) {
+            assertEquals("queued messages should be received in order",
+                "msg" + n, link.receive().extractString());
+        }
+
+        try {
+            link.receive();
+        } catch (ClosedLinkException cle) {
+            thrown = true;
+        }
+
+        assertTrue("receive after the queue is drained should throw",
+            thrown);
+
+        LinkPortal.setLinks(them, null);
+        them.waitForExit();
+        done.close();
+    }
+
+
+    /**
+     * Runs all tests.
+     */
+    public void runTests() throws IOException, IsolateStartupException {
+        declare("testQueued");
+        testQueued();
+
+        declare("testCopyOnSend");
+        testCopyOnSend();
+
+        declare("testFull");
+        testFull();
+
+        declare("testReceiveWaits");
+        testReceiveWaits();
+
+        declare("testClose");
+        testClose();
+
+        declare("testSenderClose");
+        testSenderClose();
+    }
+}
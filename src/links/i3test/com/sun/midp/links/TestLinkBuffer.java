@@ -0,0 +1,172 @@
+/*
+ *
+ *
+ * Copyright  1990-2007 Sun Microsystems, Inc. All Rights Reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 only, as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details (a copy is
+ * included at /legal/license.txt).
+ * 
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this work; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ * 
+ * Please contact Sun Microsystems, Inc., 4150 Network Circle, Santa
+ * Clara, CA 95054 or visit www.sun.com if you need additional
+ * information or have any questions.
+ */
+
+package com.sun.midp.links;
+
+import com.sun.cldc.isolate.Isolate;
+import com.sun.midp.i3test.TestCase;
+import java.io.IOException;
+
+/**
+ * Tests sending LinkBuffers, whose memory is moved to the receiver
+ * instead of being copied.
+ */
+public class TestLinkBuffer extends TestCase {
+
+    /**
+     * Creates a buffer filled with the given bytes.
+     */
+    LinkBuffer newBuffer(byte[] contents) {
+        LinkBuffer buffer = new LinkBuffer(contents.length);
+        buffer.write(0, contents, 0, contents.length);
+        return buffer;
+    }
+
+    /**
+     * Checks that the received buffer holds the expected bytes.
+     */
+    void checkReceived(LinkMessage lm, byte[] expected) {
+        assertTrue("message should contain a buffer", lm.containsBuffer());
+
+        LinkBuffer recvbuf = lm.extractBuffer();
+        assertTrue("received buffer should be attached",
+            recvbuf.isAttached());
+        assertEquals("sizes should be equal",
+            expected.length, recvbuf.size());
+
+        byte[] recvarr = new byte[expected.length];
+        recvbuf.read(0, recvarr, 0, recvarr.length);
+        assertTrue("contents should be equal",
+            Utils.bytesEqual(expected, recvarr));
+
+        recvbuf.release();
+        assertFalse("released buffer should be detached",
+            recvbuf.isAttached());
+    }
+
+
+    /**
+     * Tests reading and writing a buffer, and the range checks.
+     */
+    void testReadWrite() {
+        byte[] sendarr = new byte[64];
+        byte[] recvarr = new byte[16];
+        Utils.fillRandom(sendarr);
+        LinkBuffer buffer = newBuffer(sendarr);
+        boolean thrown = false;
+
+        buffer.read(10, recvarr, 0, 16);
+        assertTrue("subrange should be equal",
+            Utils.bytesEqual(sendarr, 10, 16, recvarr));
+
+        try {
+            buffer.read(60, recvarr, 0, 16);
+        } catch (IndexOutOfBoundsException ioobe) {
+            thrown = true;
+        }
+        assertTrue("read past the end should throw", thrown);
+
+        buffer.release();
+        assertEquals("released buffer should be empty", 0, buffer.size());
+    }
+
+
+    /**
+     * Tests send-then-receive of a buffer over a rendezvous link.
+     */
+    void testSendBuffer() throws IOException {
+        Isolate i = Isolate.currentIsolate();
+        Link link = Link.newLink(i, i);
+        byte[] sendarr = new byte[1000];
+        Utils.fillRandom(sendarr);
+        LinkBuffer sendbuf = newBuffer(sendarr);
+        Sender sender = new Sender(link,
+            LinkMessage.newBufferMessage(sendbuf));
+
+        LinkMessage lm = link.receive();
+        sender.await();
+
+        assertTrue("sender should be done", sender.done);
+        assertNull("sender should have no exceptions", sender.exception);
+        assertFalse("sent buffer should be detached", sendbuf.isAttached());
+        checkReceived(lm, sendarr);
+        link.close();
+    }
+
+
+    /**
+     * Tests sending a buffer over a buffered link.
+     */
+    void testQueuedBuffer() throws IOException {
+        Isolate i = Isolate.currentIsolate();
+        Link link = Link.newBufferedLink(i, i, 2);
+        byte[] sendarr = new byte[1000];
+        Utils.fillRandom(sendarr);
+        LinkBuffer sendbuf = newBuffer(sendarr);
+
+        link.send(LinkMessage.newBufferMessage(sendbuf));
+        assertFalse("sent buffer should be detached", sendbuf.isAttached());
+
+        checkReceived(link.receive(), sendarr);
+        link.close();
+    }
+
+
+    /**
+     * Tests that a detached buffer can't be put into a message.
+     */
+    void testDetached() {
+        LinkBuffer buffer = new LinkBuffer(10);
+        boolean thrown = false;
+
+        buffer.release();
+        try {
+            LinkMessage.newBufferMessage(buffer);
+        } catch (IllegalStateException ise) {
+            thrown = true;
+        }
+
+        assertTrue("detached buffer should be rejected", thrown);
+    }
+
+
+    /**
+     * Runs all tests.
+     */
+    public void runTests() throws IOException {
+        declare("testReadWrite");
+        testReadWrite();
+
+        declare("testSendBuffer");
+        testSendBuffer();
+
+        declare("testQueuedBuffer");
+        testQueuedBuffer();
+
+        declare("testDetached");
+        testDetached();
+    }
+}
@@ -61,6 +61,10 @@ static const char* const midpClosedLinkException =
  * they're sending the same object, it doesn't matter which thread is 
  * considered to have processed it -- the order of execution doesn't matter.
  *
+ * A link created with a positive queue size is buffered instead: send()
+ * copies the message into a native queue and returns without waiting for
+ * a receiver. See the rendezvous structure below.
+ *
  * IMPL_NOTE - use AddStrongReference or AddWeakReference?
  *
  * IMPL_NOTE - test for out-of-memory after AddStrongReference
@@ -68,6 +72,23 @@ static const char* const midpClosedLinkException =
 
 #define INVALID_REFERENCE_ID (-1)
 
+/**
+ * Size of the slab of native memory that holds the contents of the
+ * messages queued in a buffered link. Contents that don't fit into the
+ * slab are allocated separately.
+ */
+#ifndef LINK_SLAB_SIZE
+#define LINK_SLAB_SIZE 8192
+#endif
+
+/** Maximum number of messages that can be queued in a buffered link. */
+#ifndef LINK_MAX_QUEUED
+#define LINK_MAX_QUEUED 64
+#endif
+
+/** Rounds the length of queued contents up to the slab alignment. */
+#define SLAB_ALIGN(n) (((n) + 3) & ~3)
+
 /**
  * The current state of the rendezvous point.  The initial state is IDLE. 
  * There are two normal paths through the state machine, depending upon 
@@ -126,9 +147,54 @@ typedef enum {
 } retcode_t;
 
 
+/**
+ * The kind of contents of a message queued in a buffered link.
+ */
+typedef enum {
+    MSG_DATA,       /* a byte array */
+    MSG_STRING,     /* a String, stored as jchars */
+    MSG_LINK,       /* a Link */
+    MSG_BUFFER      /* a LinkBuffer, data points to its linkbuf */
+} msgtype_t;
+
+
+/**
+ * The native memory of a LinkBuffer. The memory is owned by exactly one
+ * LinkBuffer object (or by a message queued in a buffered link) at a time;
+ * sending the LinkBuffer moves the pointer to the receiver's object.
+ */
+typedef struct _linkbuf {
+    int         size;       /* size of data in bytes */
+    jbyte       data[1];    /* the contents, size bytes */
+} linkbuf;
+
+
+/**
+ * A message queued in a buffered link. The contents of byte array and
+ * String messages are copied into the link's slab, or into a separately
+ * allocated buffer if the slab is full. A Link message holds a reference
+ * to the rendezvous point of the link being sent.
+ */
+typedef struct _queuedmsg {
+    msgtype_t   type;       /* kind of contents */
+    int         length;     /* length of the contents in bytes */
+    char        *data;      /* the contents, for MSG_DATA and MSG_STRING */
+    int         slabOffset; /* offset of data in the slab, -1 if not in it */
+    int         slabSize;   /* slab bytes used, including skipped ones */
+    struct _rendezvous *link; /* the link being sent, for MSG_LINK */
+} queuedmsg;
+
+
 /**
  * Implements the concept of a "rendezvous point" as defined in the JSR-121 
  * specification.
+ *
+ * A buffered link (maxQueued > 0) doesn't use the rendezvous states other
+ * than IDLE and CLOSED. Its sender copies the message into a bounded
+ * queue and continues; the receiver takes the messages from the queue.
+ * The contents are kept in a slab used as a FIFO ring: they are always
+ * released in the order they were allocated. A buffered link closed by
+ * its sender keeps its queue until the receiver has taken every message.
  */
 typedef struct _rendezvous {
     state_t     state;      /* current state */
@@ -137,6 +203,14 @@ typedef struct _rendezvous {
     jint        msg;        /* refId for the sender's pending message */
     int         sender;     /* the isolate ID of the sender */
     int         receiver;   /* the isolate ID of the receiver */
+    int         maxQueued;  /* queue capacity, 0 if not buffered */
+    int         qhead;      /* index of the oldest queued message */
+    int         qcount;     /* number of queued messages */
+    queuedmsg   *queue;     /* ring of queued messages */
+    char        *slab;      /* storage for the queued contents */
+    int         slabHead;   /* offset of the oldest contents in the slab */
+    int         slabTail;   /* offset of the slab's free space */
+    int         slabUsed;   /* number of slab bytes in use */
 } rendezvous;
 
 
@@ -168,11 +242,13 @@ static void log_rp_free(rendezvous *);
 
 
 /**
- * Creates a new rendezvous point with the given sender and receiver. Returns 
- * a pointer to the rendezvous point, otherwise NULL if out of memory.
+ * Creates a new rendezvous point with the given sender and receiver. If
+ * maxQueued is positive, the rendezvous point is buffered and can queue
+ * that many messages. Returns a pointer to the rendezvous point, otherwise
+ * NULL if out of memory.
  */
 static rendezvous *
-rp_create(int sender, int receiver) {
+rp_create(int sender, int receiver, int maxQueued) {
     rendezvous *rp;
 
     rp = (rendezvous *)pcsl_mem_malloc(sizeof(rendezvous));
@@ -186,11 +262,134 @@ rp_create(int sender, int receiver) {
     rp->msg = INVALID_REFERENCE_ID;
     rp->sender = sender;
     rp->receiver = receiver;
+    rp->maxQueued = 0;
+    rp->qhead = 0;
+    rp->qcount = 0;
+    rp->queue = NULL;
+    rp->slab = NULL;
+    rp->slabHead = 0;
+    rp->slabTail = 0;
+    rp->slabUsed = 0;
+
+    if (maxQueued > 0) {
+        if (maxQueued > LINK_MAX_QUEUED) {
+            maxQueued = LINK_MAX_QUEUED;
+        }
+
+        rp->queue =
+            (queuedmsg *)pcsl_mem_malloc(maxQueued * sizeof(queuedmsg));
+        rp->slab = (char *)pcsl_mem_malloc(LINK_SLAB_SIZE);
+        if (rp->queue == NULL || rp->slab == NULL) {
+            pcsl_mem_free(rp->queue);
+            pcsl_mem_free(rp->slab);
+            pcsl_mem_free(rp);
+            return NULL;
+        }
+
+        rp->maxQueued = maxQueued;
+    }
 
     return rp;
 }
 
 
+static void rp_decref(rendezvous *rp);
+
+
+/**
+ * Allocates space for n bytes of contents of the message qm. The space is
+ * taken from the slab if possible, otherwise it's allocated separately.
+ * Returns a pointer to the space, or NULL if out of memory.
+ */
+static char *
+slab_alloc(rendezvous *rp, int n, queuedmsg *qm) {
+    int size = SLAB_ALIGN(n);
+    int offset = -1;
+    int skipped = 0;
+
+    if (rp->slabUsed == 0) {
+        rp->slabHead = 0;
+        rp->slabTail = 0;
+    }
+
+    if (rp->slabUsed == 0 || rp->slabTail > rp->slabHead) {
+        /* free space is at the end and at the start of the slab */
+        if (rp->slabTail + size <= LINK_SLAB_SIZE) {
+            offset = rp->slabTail;
+        } else if (size <= rp->slabHead) {
+            /* wrap around, the end of the slab is skipped */
+            skipped = LINK_SLAB_SIZE - rp->slabTail;
+            offset = 0;
+        }
+    } else if (rp->slabTail < rp->slabHead) {
+        /* free space is between the tail and the head */
+        if (rp->slabTail + size <= rp->slabHead) {
+            offset = rp->slabTail;
+        }
+    }
+
+    if (offset == -1) {
+        qm->slabOffset = -1;
+        qm->slabSize = 0;
+        return (char *)pcsl_mem_malloc(n > 0 ? n : 1);
+    }
+
+    qm->slabOffset = offset;
+    qm->slabSize = size + skipped;
+    rp->slabTail = offset + size;
+    rp->slabUsed += size + skipped;
+
+    return rp->slab + offset;
+}
+
+
+/**
+ * Releases the queued message qm, which must be the oldest message in the
+ * queue of rp.
+ */
+static void
+msg_free(rendezvous *rp, queuedmsg *qm) {
+    if (qm->type == MSG_LINK) {
+        if (qm->link != NULL) {
+            rp_decref(qm->link);
+            qm->link = NULL;
+        }
+    } else if (qm->type == MSG_BUFFER) {
+        /* the buffer was not received, nobody else owns it */
+        pcsl_mem_free(qm->data);
+    } else if (qm->slabOffset == -1) {
+        pcsl_mem_free(qm->data);
+    } else {
+        rp->slabHead = qm->slabOffset + SLAB_ALIGN(qm->length);
+        rp->slabUsed -= qm->slabSize;
+    }
+
+    qm->data = NULL;
+}
+
+
+/**
+ * Removes the oldest message from the queue of rp and releases it.
+ */
+static void
+queue_pop(rendezvous *rp) {
+    msg_free(rp, &rp->queue[rp->qhead]);
+    rp->qhead = (rp->qhead + 1) % rp->maxQueued;
+    rp->qcount -= 1;
+}
+
+
+/**
+ * Discards all messages queued in rp.
+ */
+static void
+queue_drain(rendezvous *rp) {
+    while (rp->qcount > 0) {
+        queue_pop(rp);
+    }
+}
+
+
 static void
 rp_incref(rendezvous *rp)
 {
@@ -210,6 +409,11 @@ rp_decref(rendezvous *rp)
 #if ENABLE_I3_TEST
         log_rp_free(rp);
 #endif
+        if (rp->maxQueued > 0) {
+            queue_drain(rp);
+            pcsl_mem_free(rp->queue);
+            pcsl_mem_free(rp->slab);
+        }
         pcsl_mem_free(rp);
     }
 }
@@ -273,6 +477,46 @@ getNativePointer(jobject linkObj)
 }
 
 
+static linkbuf *
+getBufferPointer(jobject bufferObj)
+{
+    linkbuf *lb;
+    jfieldID nativePointerField;
+
+    KNI_StartHandles(1);
+    KNI_DeclareHandle(bufferClass);
+
+    KNI_GetObjectClass(bufferObj, bufferClass);
+    nativePointerField = KNI_GetFieldID(bufferClass, "nativePointer", "I");
+    lb = (linkbuf *)KNI_GetIntField(bufferObj, nativePointerField);
+
+    KNI_EndHandles();
+    return lb;
+}
+
+
+/*
+ * Makes bufferObj the owner of lb, or detaches it if lb is NULL.
+ */
+static void
+setBufferPointer(jobject bufferObj, linkbuf *lb)
+{
+    jfieldID nativePointerField;
+    jfieldID sizeField;
+
+    KNI_StartHandles(1);
+    KNI_DeclareHandle(bufferClass);
+
+    KNI_GetObjectClass(bufferObj, bufferClass);
+    nativePointerField = KNI_GetFieldID(bufferClass, "nativePointer", "I");
+    sizeField = KNI_GetFieldID(bufferClass, "size", "I");
+    KNI_SetIntField(bufferObj, nativePointerField, (jint)lb);
+    KNI_SetIntField(bufferObj, sizeField, lb == NULL ? 0 : lb->size);
+
+    KNI_EndHandles();
+}
+
+
 static void
 getContents(jobject linkMessageObj, jobject contentsObj)
 {
@@ -348,17 +592,20 @@ setRange(jobject linkMessageObj, int offset, int length)
 /**
  * Copies the contents of fromMsg to the contents of toMsg. Both must be
  * instances of LinkMessage. The toLink object must be an instance of Link.
- * It's filled in if the contents of fromMsg are a Link.  Returns KNI_TRUE if
- * successful, otherwise KNI_FALSE.
+ * It's filled in if the contents of fromMsg are a Link. The toBuffer object
+ * must be an instance of LinkBuffer. If the contents of fromMsg are a
+ * LinkBuffer, its memory is moved to toBuffer without copying. Returns
+ * KNI_TRUE if successful, otherwise KNI_FALSE.
  */
 static jboolean
-copy(jobject fromMsg, jobject toMsg, jobject toLink) {
+copy(jobject fromMsg, jobject toMsg, jobject toLink, jobject toBuffer) {
     jboolean retval;
 
-    KNI_StartHandles(6);
+    KNI_StartHandles(7);
     KNI_DeclareHandle(byteArrayClass);
     KNI_DeclareHandle(stringClass);
     KNI_DeclareHandle(linkClass);
+    KNI_DeclareHandle(bufferClass);
     KNI_DeclareHandle(fromContents);
     KNI_DeclareHandle(newString);
     KNI_DeclareHandle(newByteArray);
@@ -366,6 +613,7 @@ copy(jobject fromMsg, jobject toMsg, jobject toLink) {
     KNI_FindClass("[B", byteArrayClass);
     KNI_FindClass("java/lang/String", stringClass);
     KNI_FindClass("com/sun/midp/links/Link", linkClass);
+    KNI_FindClass("com/sun/midp/links/LinkBuffer", bufferClass);
     getContents(fromMsg, fromContents);
     
     if (KNI_IsInstanceOf(fromContents, byteArrayClass)) {
@@ -386,18 +634,21 @@ copy(jobject fromMsg, jobject toMsg, jobject toLink) {
             retval = KNI_TRUE;
         }
     } else if (KNI_IsInstanceOf(fromContents, stringClass)) {
-        /* do a string copy */
+        /*
+         * do a string copy; the characters are staged in native memory
+         * rather than in a temporary Java array
+         */
         jchar *buf;
         jsize slen = KNI_GetStringLength(fromContents);
 
-        SNI_NewArray(SNI_BYTE_ARRAY, slen*sizeof(jchar), newByteArray);
+        buf = (jchar *)pcsl_mem_malloc(slen > 0 ? slen * sizeof(jchar) : 1);
 
-        if (KNI_IsNullHandle(newByteArray)) {
+        if (buf == NULL) {
             retval = KNI_FALSE;
         } else {
-            buf = SNI_GetRawArrayPointer(newByteArray);
             KNI_GetStringRegion(fromContents, 0, slen, buf);
             KNI_NewString(buf, slen, newString);
+            pcsl_mem_free(buf);
             setContents(toMsg, newString);
             retval = KNI_TRUE;
         }
@@ -408,6 +659,19 @@ copy(jobject fromMsg, jobject toMsg, jobject toLink) {
         rp_incref(rp);
         setContents(toMsg, toLink);
         retval = KNI_TRUE;
+    } else if (!KNI_IsNullHandle(bufferClass)
+            && KNI_IsInstanceOf(fromContents, bufferClass)) {
+        /* move the buffer's memory to the receiver */
+        linkbuf *lb = getBufferPointer(fromContents);
+        if (lb == NULL) {
+            /* already sent or released */
+            retval = KNI_FALSE;
+        } else {
+            setBufferPointer(fromContents, NULL);
+            setBufferPointer(toBuffer, lb);
+            setContents(toMsg, toBuffer);
+            retval = KNI_TRUE;
+        }
     } else {
         retval = KNI_FALSE;
     }
@@ -417,6 +681,165 @@ copy(jobject fromMsg, jobject toMsg, jobject toLink) {
 }
 
 
+/**
+ * Copies the contents of msg into a new message at the tail of the queue
+ * of the buffered link rp. Returns KNI_TRUE if successful, otherwise
+ * throws an exception and returns KNI_FALSE.
+ */
+static jboolean
+enqueue(rendezvous *rp, jobject msg) {
+    queuedmsg *qm = &rp->queue[(rp->qhead + rp->qcount) % rp->maxQueued];
+    jboolean retval = KNI_TRUE;
+
+    KNI_StartHandles(5);
+    KNI_DeclareHandle(byteArrayClass);
+    KNI_DeclareHandle(stringClass);
+    KNI_DeclareHandle(linkClass);
+    KNI_DeclareHandle(bufferClass);
+    KNI_DeclareHandle(contents);
+
+    KNI_FindClass("[B", byteArrayClass);
+    KNI_FindClass("java/lang/String", stringClass);
+    KNI_FindClass("com/sun/midp/links/Link", linkClass);
+    KNI_FindClass("com/sun/midp/links/LinkBuffer", bufferClass);
+    getContents(msg, contents);
+
+    qm->data = NULL;
+    qm->link = NULL;
+    qm->slabOffset = -1;
+    qm->slabSize = 0;
+
+    if (KNI_IsInstanceOf(contents, byteArrayClass)) {
+        jint offset;
+        jint length;
+
+        getRange(msg, &offset, &length);
+        qm->type = MSG_DATA;
+        qm->length = length;
+        qm->data = slab_alloc(rp, length, qm);
+        if (qm->data != NULL) {
+            KNI_GetRawArrayRegion(contents, offset, length,
+                (jbyte *)qm->data);
+        }
+    } else if (KNI_IsInstanceOf(contents, stringClass)) {
+        jsize slen = KNI_GetStringLength(contents);
+
+        qm->type = MSG_STRING;
+        qm->length = slen * sizeof(jchar);
+        qm->data = slab_alloc(rp, qm->length, qm);
+        if (qm->data != NULL) {
+            KNI_GetStringRegion(contents, 0, slen, (jchar *)qm->data);
+        }
+    } else if (KNI_IsInstanceOf(contents, linkClass)) {
+        qm->type = MSG_LINK;
+        qm->length = 0;
+        qm->link = getNativePointer(contents);
+        if (qm->link == NULL) {
+            retval = KNI_FALSE;
+            KNI_ThrowNew(midpIOException, NULL);
+        } else {
+            rp_incref(qm->link);
+        }
+    } else if (!KNI_IsNullHandle(bufferClass)
+            && KNI_IsInstanceOf(contents, bufferClass)) {
+        /* the queue takes over the buffer's memory */
+        linkbuf *lb = getBufferPointer(contents);
+
+        qm->type = MSG_BUFFER;
+        qm->length = 0;
+        if (lb == NULL) {
+            retval = KNI_FALSE;
+            KNI_ThrowNew(midpIOException, NULL);
+        } else {
+            setBufferPointer(contents, NULL);
+            qm->data = (char *)lb;
+        }
+    } else {
+        retval = KNI_FALSE;
+        KNI_ThrowNew(midpIOException, NULL);
+    }
+
+    if (retval && qm->type != MSG_LINK && qm->data == NULL) {
+        retval = KNI_FALSE;
+        KNI_ThrowNew(midpOutOfMemoryError, NULL);
+    }
+
+    if (retval) {
+        rp->qcount += 1;
+    }
+
+    KNI_EndHandles();
+    return retval;
+}
+
+
+/**
+ * Fills in toMsg with the oldest message queued in the buffered link rp
+ * and removes that message from the queue. The toLink object must be an
+ * instance of Link; it's filled in if the message contains a Link. The
+ * toBuffer object must be an instance of LinkBuffer; it's filled in if the
+ * message contains a LinkBuffer. Returns KNI_TRUE if successful, otherwise
+ * throws an exception and returns KNI_FALSE, leaving the message in the
+ * queue.
+ */
+static jboolean
+dequeue(rendezvous *rp, jobject toMsg, jobject toLink, jobject toBuffer) {
+    queuedmsg *qm = &rp->queue[rp->qhead];
+    jboolean retval = KNI_TRUE;
+
+    KNI_StartHandles(2);
+    KNI_DeclareHandle(newByteArray);
+    KNI_DeclareHandle(newString);
+
+    switch (qm->type) {
+        case MSG_DATA:
+            SNI_NewArray(SNI_BYTE_ARRAY, qm->length, newByteArray);
+            if (KNI_IsNullHandle(newByteArray)) {
+                retval = KNI_FALSE;
+            } else {
+                KNI_SetRawArrayRegion(newByteArray, 0, qm->length,
+                    (jbyte *)qm->data);
+                setContents(toMsg, newByteArray);
+                setRange(toMsg, 0, qm->length);
+            }
+            break;
+
+        case MSG_STRING:
+            KNI_NewString((jchar *)qm->data, qm->length / sizeof(jchar),
+                newString);
+            if (KNI_IsNullHandle(newString)) {
+                retval = KNI_FALSE;
+            } else {
+                setContents(toMsg, newString);
+            }
+            break;
+
+        case MSG_LINK:
+            /* the queue's reference is passed to the receiver's Link */
+            setNativePointer(toLink, qm->link);
+            qm->link = NULL;
+            setContents(toMsg, toLink);
+            break;
+
+        case MSG_BUFFER:
+            /* the buffer's memory is passed to the receiver's LinkBuffer */
+            setBufferPointer(toBuffer, (linkbuf *)qm->data);
+            qm->data = NULL;
+            setContents(toMsg, toBuffer);
+            break;
+    }
+
+    if (retval) {
+        queue_pop(rp);
+    } else {
+        KNI_ThrowNew(midpOutOfMemoryError, NULL);
+    }
+
+    KNI_EndHandles();
+    return retval;
+}
+
+
 /**
  * public native void close();
  */
@@ -439,6 +862,15 @@ Java_com_sun_midp_links_Link_close(void)
             rp->msg = INVALID_REFERENCE_ID;
         }
 
+        if (rp->maxQueued > 0 && rp->receiver == JVM_CurrentIsolateID()) {
+            /*
+             * Nobody will receive the queued messages, discard them. If
+             * the sender closes the link, they stay queued and are
+             * delivered before the receiver sees the link closed.
+             */
+            queue_drain(rp);
+        }
+
         rp->state = CLOSED;
         midp_thread_signal(LINK_READY_SIGNAL, (int)rp, 0);
         setNativePointer(thisObj, NULL);
@@ -461,13 +893,14 @@ Java_com_sun_midp_links_Link_finalize(void)
 
 
 /**
- * private native void init0(int sender, int receiver);
+ * private native void init0(int sender, int receiver, int maxQueued);
  */
 KNIEXPORT KNI_RETURNTYPE_VOID
 Java_com_sun_midp_links_Link_init0(void)
 {
     int sender;
     int receiver;
+    int maxQueued;
     rendezvous *rp;
 
     KNI_StartHandles(1);
@@ -475,9 +908,10 @@ Java_com_sun_midp_links_Link_init0(void)
 
     sender = KNI_GetParameterAsInt(1);
     receiver = KNI_GetParameterAsInt(2);
+    maxQueued = KNI_GetParameterAsInt(3);
     KNI_GetThisPointer(thisObj);
 
-    rp = rp_create(sender, receiver);
+    rp = rp_create(sender, receiver, maxQueued);
     if (rp == NULL) {
         KNI_ThrowNew(midpOutOfMemoryError, NULL);
     } else {
@@ -516,7 +950,7 @@ Java_com_sun_midp_links_Link_isOpen(void)
 
 
 /**
- * private native void receive0(LinkMessage msg, Link link)
+ * private native void receive0(LinkMessage msg, Link link, LinkBuffer buffer)
  *         throws ClosedLinkException,
  *                InterruptedIOException,
  *                IOException;
@@ -526,15 +960,17 @@ Java_com_sun_midp_links_Link_receive0(void)
 {
     rendezvous *rp;
 
-    KNI_StartHandles(4);
+    KNI_StartHandles(5);
     KNI_DeclareHandle(thisObj);
     KNI_DeclareHandle(recvMessageObj);
     KNI_DeclareHandle(sendMessageObj);
     KNI_DeclareHandle(linkObj);
+    KNI_DeclareHandle(bufferObj);
 
     KNI_GetThisPointer(thisObj);
     KNI_GetParameterAsObject(1, recvMessageObj);
     KNI_GetParameterAsObject(2, linkObj);
+    KNI_GetParameterAsObject(3, bufferObj);
 
     rp = getNativePointer(thisObj);
 
@@ -546,6 +982,18 @@ Java_com_sun_midp_links_Link_receive0(void)
         }
     } else if (JVM_CurrentIsolateID() != rp->receiver) {
         KNI_ThrowNew(midpIllegalArgumentException, NULL);
+    } else if (rp->maxQueued > 0 && (rp->state != CLOSED || rp->qcount > 0)) {
+        /*
+         * buffered link: take the oldest message or wait for one,
+         * messages queued before the sender closed the link are
+         * still delivered
+         */
+        if (rp->qcount == 0) {
+            midp_thread_wait(LINK_READY_SIGNAL, (int)rp, NULL);
+        } else if (dequeue(rp, recvMessageObj, linkObj, bufferObj)) {
+            /* there's room in the queue for a blocked sender */
+            midp_thread_signal(LINK_READY_SIGNAL, (int)rp, 0);
+        }
     } else {
         jboolean ok;
 
@@ -558,7 +1006,7 @@ Java_com_sun_midp_links_Link_receive0(void)
             case SENDING:
                 getReference(rp->msg, "receive0/SENDING",
                     sendMessageObj);
-                ok = copy(sendMessageObj, recvMessageObj, linkObj);
+                ok = copy(sendMessageObj, recvMessageObj, linkObj, bufferObj);
                 if (ok) {
                     rp->retcode = OK;
                 } else {
@@ -571,7 +1019,7 @@ Java_com_sun_midp_links_Link_receive0(void)
 
             case RENDEZVOUS:
                 getReference(rp->msg, "receive0/RENDEZVOUS", sendMessageObj);
-                ok = copy(sendMessageObj, recvMessageObj, linkObj);
+                ok = copy(sendMessageObj, recvMessageObj, linkObj, bufferObj);
                 if (ok) {
                     rp->retcode = OK;
                 } else {
@@ -633,6 +1081,13 @@ Java_com_sun_midp_links_Link_send0(void)
         }
     } else if (JVM_CurrentIsolateID() != rp->sender) {
         KNI_ThrowNew(midpIllegalArgumentException, NULL);
+    } else if (rp->maxQueued > 0 && rp->state != CLOSED) {
+        /* buffered link: queue the message or wait until there's room */
+        if (rp->qcount == rp->maxQueued) {
+            midp_thread_wait(LINK_READY_SIGNAL, (int)rp, NULL);
+        } else if (enqueue(rp, messageObj)) {
+            midp_thread_signal(LINK_READY_SIGNAL, (int)rp, 0);
+        }
     } else {
         switch (rp->state) {
             case IDLE:
@@ -692,6 +1147,139 @@ Java_com_sun_midp_links_Link_send0(void)
 }
 
 
+/**
+ * private native void init0(int newSize);
+ */
+KNIEXPORT KNI_RETURNTYPE_VOID
+Java_com_sun_midp_links_LinkBuffer_init0(void)
+{
+    int size;
+    linkbuf *lb;
+
+    KNI_StartHandles(1);
+    KNI_DeclareHandle(thisObj);
+
+    size = KNI_GetParameterAsInt(1);
+    KNI_GetThisPointer(thisObj);
+
+    lb = (linkbuf *)pcsl_mem_malloc(sizeof(linkbuf) + size);
+    if (lb == NULL) {
+        KNI_ThrowNew(midpOutOfMemoryError, NULL);
+    } else {
+        /* never hand stale heap contents to Java or another isolate */
+        memset(lb->data, 0, size);
+        lb->size = size;
+        setBufferPointer(thisObj, lb);
+    }
+
+    KNI_EndHandles();
+    KNI_ReturnVoid();
+}
+
+
+/**
+ * public synchronized native void release();
+ */
+KNIEXPORT KNI_RETURNTYPE_VOID
+Java_com_sun_midp_links_LinkBuffer_release(void)
+{
+    linkbuf *lb;
+
+    KNI_StartHandles(1);
+    KNI_DeclareHandle(thisObj);
+
+    KNI_GetThisPointer(thisObj);
+    lb = getBufferPointer(thisObj);
+
+    /* ignore if detached */
+    if (lb != NULL) {
+        setBufferPointer(thisObj, NULL);
+        pcsl_mem_free(lb);
+    }
+
+    KNI_EndHandles();
+    KNI_ReturnVoid();
+}
+
+
+/**
+ * private native void finalize();
+ */
+KNIEXPORT KNI_RETURNTYPE_VOID
+Java_com_sun_midp_links_LinkBuffer_finalize(void)
+{
+    Java_com_sun_midp_links_LinkBuffer_release();
+}
+
+
+/**
+ * private native void write0(int position, byte[] src, int offset,
+ *                            int length);
+ *
+ * The arguments are checked by the caller.
+ */
+KNIEXPORT KNI_RETURNTYPE_VOID
+Java_com_sun_midp_links_LinkBuffer_write0(void)
+{
+    linkbuf *lb;
+    int position = KNI_GetParameterAsInt(1);
+    int offset = KNI_GetParameterAsInt(3);
+    int length = KNI_GetParameterAsInt(4);
+
+    KNI_StartHandles(2);
+    KNI_DeclareHandle(thisObj);
+    KNI_DeclareHandle(arrayObj);
+
+    KNI_GetThisPointer(thisObj);
+    KNI_GetParameterAsObject(2, arrayObj);
+    lb = getBufferPointer(thisObj);
+
+    if (lb == NULL) {
+        KNI_ThrowNew(midpIllegalStateException, NULL);
+    } else {
+        KNI_GetRawArrayRegion(arrayObj, offset, length,
+            &lb->data[position]);
+    }
+
+    KNI_EndHandles();
+    KNI_ReturnVoid();
+}
+
+
+/**
+ * private native void read0(int position, byte[] dst, int offset,
+ *                           int length);
+ *
+ * The arguments are checked by the caller.
+ */
+KNIEXPORT KNI_RETURNTYPE_VOID
+Java_com_sun_midp_links_LinkBuffer_read0(void)
+{
+    linkbuf *lb;
+    int position = KNI_GetParameterAsInt(1);
+    int offset = KNI_GetParameterAsInt(3);
+    int length = KNI_GetParameterAsInt(4);
+
+    KNI_StartHandles(2);
+    KNI_DeclareHandle(thisObj);
+    KNI_DeclareHandle(arrayObj);
+
+    KNI_GetThisPointer(thisObj);
+    KNI_GetParameterAsObject(2, arrayObj);
+    lb = getBufferPointer(thisObj);
+
+    if (lb == NULL) {
+        KNI_ThrowNew(midpIllegalStateException, NULL);
+    } else {
+        KNI_SetRawArrayRegion(arrayObj, offset, length,
+            &lb->data[position]);
+    }
+
+    KNI_EndHandles();
+    KNI_ReturnVoid();
+}
+
+
 /**
  * Cleans up this portal entry. Frees the array of pointers to rendezvous 
  * points and sets the count to -1. If the count is already -1, does 
@@ -193,6 +193,211 @@ clipped_blit(gxj_screen_buffer* dst, int dstX, int dstY, gxj_screen_buffer* src,
 
 
 
+/** Side of the square tiles the rotating transforms are copied in. */
+#define BLIT_TILE_SIZE 16
+
+/**
+ * Blends a partially transparent source pixel into a destination pixel.
+ * Fully transparent pixels, with alpha of 3 or less, are left out.
+ */
+#define BLEND_PIXEL(_pDest, _src, _alpha) \
+  do { \
+    if ((_alpha) == 0xFF) { \
+      *(_pDest) = (_src); \
+    } else if ((_alpha) > 0x3) { \
+      int _a2 = (_alpha) >> 2; \
+      int _a3 = (_alpha) >> 3; \
+      int _r = (((_src) >> 11) * _a3 + (*(_pDest) >> 11) * (31 - _a3)) >> 5; \
+      int _g = ((((_src) >> 5) & 0x3F) * _a2 + \
+                ((*(_pDest) >> 5) & 0x3F) * (63 - _a2)) >> 6; \
+      int _b = (((_src) & 0x1F) * _a3 + (*(_pDest) & 0x1F) * (31 - _a3)) >> 5; \
+      *(_pDest) = (gxj_pixel_type)((_r << 11) | (_g << 5) | _b); \
+    } \
+  } while (0)
+
+/**
+ * Where the pixels of a transformed region come from: the pixel at
+ * row r and column c of the transformed region is the source pixel at
+ * index origin + r * rowStep + c * colStep.
+ */
+typedef struct {
+  int origin;
+  int rowStep;
+  int colStep;
+} blit_steps;
+
+/**
+ * Computes the source steps of a region for one of the TRANS_* modes.
+ * The transforms that swap the axes walk the source by columns, the
+ * others by rows, forwards or backwards.
+ *
+ * @param srcSpan             width of the source buffer
+ * @param x_src               x-coord of the region
+ * @param y_src               y-coord of the region
+ * @param width               width of the region
+ * @param height              height of the region
+ * @param transform           transform to be applied to the region
+ * @param steps               receives the source steps
+ */
+static void
+get_transform_steps(int srcSpan, jint x_src, jint y_src,
+                    jint width, jint height, jint transform,
+                    blit_steps *steps) {
+  int xStep = 1;
+  int yStep = srcSpan;
+
+  if (transform & TRANSFORM_X_FLIP) {
+    x_src += width - 1;
+    xStep = -1;
+  }
+
+  if (transform & TRANSFORM_Y_FLIP) {
+    y_src += height - 1;
+    yStep = -srcSpan;
+  }
+
+  steps->origin = y_src * srcSpan + x_src;
+  if (transform & TRANSFORM_INVERTED_AXES) {
+    steps->rowStep = xStep;
+    steps->colStep = yStep;
+  } else {
+    steps->rowStep = yStep;
+    steps->colStep = xStep;
+  }
+}
+
+/**
+ * Copies a region whose rows are source rows, read forwards
+ * (colStep of 1) or backwards (colStep of -1).
+ */
+static void
+blit_rows_opaque(gxj_pixel_type *pDest, int destSpan,
+                 const gxj_pixel_type *pSrc, int rowStep, int colStep,
+                 int width, int height) {
+  const gxj_pixel_type *s;
+  gxj_pixel_type *d;
+  gxj_pixel_type *limit;
+
+  for (; height > 0; height--, pDest += destSpan, pSrc += rowStep) {
+    if (colStep == 1) {
+      memcpy(pDest, pSrc, width * sizeof (gxj_pixel_type));
+    } else {
+      for (d = pDest, s = pSrc, limit = pDest + width; d < limit; d++, s--) {
+        *d = *s;
+      }
+    }
+  }
+}
+
+/** Blends a region whose rows are source rows, see blit_rows_opaque. */
+static void
+blit_rows_alpha(gxj_pixel_type *pDest, int destSpan,
+                const gxj_pixel_type *pSrc, const gxj_alpha_type *pSrcAlpha,
+                int rowStep, int colStep, int width, int height) {
+  const gxj_pixel_type *s;
+  const gxj_alpha_type *a;
+  gxj_pixel_type *d;
+  gxj_pixel_type *limit;
+
+  for (; height > 0;
+       height--, pDest += destSpan, pSrc += rowStep, pSrcAlpha += rowStep) {
+    if (colStep == 1) {
+      for (d = pDest, s = pSrc, a = pSrcAlpha, limit = pDest + width;
+           d < limit; d++, s++, a++) {
+        BLEND_PIXEL(d, *s, *a);
+      }
+    } else {
+      for (d = pDest, s = pSrc, a = pSrcAlpha, limit = pDest + width;
+           d < limit; d++, s--, a--) {
+        BLEND_PIXEL(d, *s, *a);
+      }
+    }
+  }
+}
+
+/**
+ * Copies a region whose rows are source columns. The region is done in
+ * square tiles so that the source lines a tile reads stay in the cache
+ * from one destination row to the next.
+ */
+static void
+blit_tiles_opaque(gxj_pixel_type *pDest, int destSpan,
+                  const gxj_pixel_type *pSrc, int rowStep, int colStep,
+                  int width, int height) {
+  int tileX, tileY, tileWidth, tileHeight, row, col;
+  const gxj_pixel_type *s;
+  gxj_pixel_type *d;
+
+  for (tileY = 0; tileY < height; tileY += BLIT_TILE_SIZE) {
+    tileHeight = height - tileY;
+    if (tileHeight > BLIT_TILE_SIZE) {
+      tileHeight = BLIT_TILE_SIZE;
+    }
+
+    for (tileX = 0; tileX < width; tileX += BLIT_TILE_SIZE) {
+      tileWidth = width - tileX;
+      if (tileWidth > BLIT_TILE_SIZE) {
+        tileWidth = BLIT_TILE_SIZE;
+      }
+
+      for (row = tileY; row < tileY + tileHeight; row++) {
+        d = pDest + row * destSpan + tileX;
+        s = pSrc + row * rowStep + tileX * colStep;
+        for (col = 0; col < tileWidth; col++, s += colStep) {
+          d[col] = *s;
+        }
+      }
+    }
+  }
+}
+
+/** Blends a region whose rows are source columns, see blit_tiles_opaque. */
+static void
+blit_tiles_alpha(gxj_pixel_type *pDest, int destSpan,
+                 const gxj_pixel_type *pSrc, const gxj_alpha_type *pSrcAlpha,
+                 int rowStep, int colStep, int width, int height) {
+  int tileX, tileY, tileWidth, tileHeight, row, col, offset;
+  gxj_pixel_type *d;
+
+  for (tileY = 0; tileY < height; tileY += BLIT_TILE_SIZE) {
+    tileHeight = height - tileY;
+    if (tileHeight > BLIT_TILE_SIZE) {
+      tileHeight = BLIT_TILE_SIZE;
+    }
+
+    for (tileX = 0; tileX < width; tileX += BLIT_TILE_SIZE) {
+      tileWidth = width - tileX;
+      if (tileWidth > BLIT_TILE_SIZE) {
+        tileWidth = BLIT_TILE_SIZE;
+      }
+
+      for (row = tileY; row < tileY + tileHeight; row++) {
+        d = pDest + row * destSpan + tileX;
+        offset = row * rowStep + tileX * colStep;
+        for (col = 0; col < tileWidth; col++, offset += colStep) {
+          BLEND_PIXEL(d + col, pSrc[offset], pSrcAlpha[offset]);
+        }
+      }
+    }
+  }
+}
+
+/**
+ * Copies the pixels of a transformed region, ignoring alpha.
+ */
+static void
+blit_region_opaque(gxj_pixel_type *pDest, int destSpan,
+                   const gxj_pixel_type *pSrc, const blit_steps *steps,
+                   int width, int height) {
+  if (steps->colStep == 1 || steps->colStep == -1) {
+    blit_rows_opaque(pDest, destSpan, pSrc, steps->rowStep, steps->colStep,
+                     width, height);
+  } else {
+    blit_tiles_opaque(pDest, destSpan, pSrc, steps->rowStep, steps->colStep,
+                      width, height);
+  }
+}
+
 /**
  * Renders the contents of the specified region of this
  * mutable image onto the destination specified.
@@ -208,16 +413,10 @@ clipped_blit(gxj_screen_buffer* dst, int dstX, int dstY, gxj_screen_buffer* src,
 void
 create_transformed_imageregion(gxj_screen_buffer* src, gxj_screen_buffer* dest, jint src_x, jint src_y,
                              jint width, jint height, jint transform) {
-  int srcX;
-  int srcY;
-  int xStart;
-  int yStart;
-  int xIncr;
-  int yIncr;
-  int destX;
-  int destY;
-  int yCounter;
-  int xCounter;
+  blit_steps steps;
+  const gxj_alpha_type *pSrcAlpha;
+  gxj_alpha_type *pDestAlpha;
+  int row, col, offset;
 
   /* set dimensions of image being created,
      depending on transform */
@@ -229,51 +428,23 @@ create_transformed_imageregion(gxj_screen_buffer* src, gxj_screen_buffer* dest,
     dest->height = height;
   }
 
-  if (transform & TRANSFORM_Y_FLIP) {
-    yStart = height-1;
-    yIncr = -1;
-  } else {
-    yStart = 0;
-    yIncr = +1;
-  }
-
-  if (transform & TRANSFORM_X_FLIP) {
-    xStart = width-1;
-    xIncr = -1;
-  } else {
-    xStart = 0;
-    xIncr = +1;
-  }
-
-  for (srcY = src_y, destY = yStart, yCounter = 0;
-       yCounter < height;
-       srcY++, destY+=yIncr, yCounter++) {
+  get_transform_steps(src->width, src_x, src_y, width, height, transform,
+                      &steps);
 
-    int srcYwidth = srcY * src->width;
-    int destYwidth = destY * dest->width;
+  blit_region_opaque(dest->pixelData, dest->width,
+                     src->pixelData + steps.origin, &steps,
+                     dest->width, dest->height);
 
-    for (srcX = src_x, destX = xStart, xCounter = 0;
-         xCounter < width;
-         srcX++, destX+=xIncr, xCounter++) {
-
-      if ( transform & TRANSFORM_INVERTED_AXES ) {
-          dest->pixelData[destX * dest->width + destY] =
-            src->pixelData[srcYwidth /*srcY*src->width*/ + srcX];
-        if (src->alphaData != NULL) {
-            dest->alphaData[destX * dest->width + destY] =
-                src->alphaData[srcYwidth /*srcY*src->width*/ + srcX];
-        }
-
-      } else {
-        dest->pixelData[destYwidth /*destY * dest->width*/ + destX] =
-                   src->pixelData[srcYwidth /*srcY*src->width*/ + srcX];
-        if (src->alphaData != NULL) {
-            dest->alphaData[destYwidth /*destY * dest->width*/ + destX] =
-                src->alphaData[srcYwidth /*srcY*src->width*/ + srcX];
-        }
+  if (src->alphaData != NULL) {
+    pSrcAlpha = src->alphaData + steps.origin;
+    pDestAlpha = dest->alphaData;
+    for (row = 0; row < dest->height; row++) {
+      offset = row * steps.rowStep;
+      for (col = 0; col < dest->width; col++, offset += steps.colStep) {
+        *pDestAlpha++ = pSrcAlpha[offset];
       }
-    } /*for x*/
-  } /* for y */
+    }
+  }
 }
 
 /**
@@ -302,6 +473,9 @@ copy_imageregion(gxj_screen_buffer* src, gxj_screen_buffer* dest, const jshort *
     int clipX2 = clip[2];
     int clipY2 = clip[3];
     int diff;
+    int destWidth, destHeight;  /* size of the region once transformed */
+    int skipX = 0, skipY = 0;   /* clipped off the transformed region */
+    blit_steps steps;
     gxj_screen_buffer newSrc;
 
     /*
@@ -363,11 +537,11 @@ copy_imageregion(gxj_screen_buffer* src, gxj_screen_buffer* dest, const jshort *
 
     /*
      * check if the source and destination are the same image,
-     * or a transform is needed
+     * the region may then overlap its destination
      */
     newSrc.pixelData = NULL;
     newSrc.alphaData = NULL;
-    if (dest == src || transform != 0) {
+    if (dest == src) {
         /*
          * create a new image that is a copy of the region with transform
          * applied
@@ -395,93 +569,69 @@ copy_imageregion(gxj_screen_buffer* src, gxj_screen_buffer* dest, const jshort *
         src = &newSrc;
         x_src = 0;
         y_src = 0;
+        width = src->width;
+        height = src->height;
+        transform = TRANS_NONE;
+    }
 
-        if (transform & TRANSFORM_INVERTED_AXES) {
-            // exchange the width and height
-            width = src->width;
-            height = src->height;
-        }
+    if (transform & TRANSFORM_INVERTED_AXES) {
+        destWidth = height;
+        destHeight = width;
+    } else {
+        destWidth = width;
+        destHeight = height;
     }
 
     /* Apply the clip region to the destination region */
     diff = clipX1 - x_dest;
     if (diff > 0) {
-        x_src += diff;
-        width -= diff;
+        skipX = diff;
+        destWidth -= diff;
         x_dest = clipX1;
     }
 
     diff = clipY1 - y_dest;
     if (diff > 0) {
-        y_src += diff;
-        height -= diff;
+        skipY = diff;
+        destHeight -= diff;
         y_dest = clipY1;
     }
 
-    diff = (x_dest + width) - clipX2;
+    diff = (x_dest + destWidth) - clipX2;
     if (diff > 0) {
-        width -= diff;
+        destWidth -= diff;
     }
 
-    diff = (y_dest + height) - clipY2;
+    diff = (y_dest + destHeight) - clipY2;
     if (diff > 0) {
-        height -= diff;
+        destHeight -= diff;
     }
 
-    if (width > 0) {
-        int rowsCopied;
+    if (destWidth > 0 && destHeight > 0) {
         gxj_pixel_type* pDest = dest->pixelData + (y_dest * dest->width) + x_dest;
-        gxj_pixel_type* pSrc = src->pixelData + (y_src * src->width) + x_src;
-        gxj_pixel_type* limit;
-        int destWidthDiff = dest->width - width;
-        int srcWidthDiff = src->width - width;
-        int r1, g1, b1, a2, a3, r2, b2, g2;
+        int offset;
+
+        get_transform_steps(src->width, x_src, y_src, width, height,
+                            transform, &steps);
+        offset = steps.origin + skipY * steps.rowStep + skipX * steps.colStep;
+
+        CHECK_PTR_CLIP(dest, pDest);
+        CHECK_PTR_CLIP(dest,
+            pDest + (destHeight - 1) * dest->width + destWidth - 1);
 
         if (src->alphaData != NULL) {
-            unsigned char *pSrcAlpha = src->alphaData + (y_src * src->width) + x_src;
-
-            /* copy the source to the destination */
-            for (rowsCopied = 0; rowsCopied < height; rowsCopied++) {
-                for (limit = pDest + width; pDest < limit; pDest++, pSrc++, pSrcAlpha++) {
-                    if ((*pSrcAlpha) == 0xFF) {
-                        CHECK_PTR_CLIP(dest, pDest);
-                        *pDest = *pSrc;
-                    }
-                    else if (*pSrcAlpha > 0x3) {
-                        r1 = (*pSrc >> 11);
-                        g1 = ((*pSrc >> 5) & 0x3F);
-                        b1 = (*pSrc & 0x1F);
-
-                        r2 = (*pDest >> 11);
-                        g2 = ((*pDest >> 5) & 0x3F);
-                        b2 = (*pDest & 0x1F);
-
-                        a2 = *pSrcAlpha >> 2;
-                        a3 = *pSrcAlpha >> 3;
-
-                        r1 = (r1 * a3 + r2 * (31 - a3)) >> 5;
-                        g1 = (g1 * a2 + g2 * (63 - a2)) >> 6;
-                        b1 = (b1 * a3 + b2 * (31 - a3)) >> 5;
-
-                        *pDest = (gxj_pixel_type)((r1 << 11) | (g1 << 5) | (b1));
-                    }
-                }
-
-                pDest += destWidthDiff;
-                pSrc += srcWidthDiff;
-                pSrcAlpha += srcWidthDiff;
+            if (steps.colStep == 1 || steps.colStep == -1) {
+                blit_rows_alpha(pDest, dest->width, src->pixelData + offset,
+                                src->alphaData + offset, steps.rowStep,
+                                steps.colStep, destWidth, destHeight);
+            } else {
+                blit_tiles_alpha(pDest, dest->width, src->pixelData + offset,
+                                 src->alphaData + offset, steps.rowStep,
+                                 steps.colStep, destWidth, destHeight);
             }
         } else {
-            /* copy the source to the destination */
-            for (rowsCopied = 0; rowsCopied < height; rowsCopied++) {
-                for (limit = pDest + width; pDest < limit; pDest++, pSrc++) {
-                    CHECK_PTR_CLIP(dest, pDest);
-                    *pDest = *pSrc;
-                }
-
-                pDest += destWidthDiff;
-                pSrc += srcWidthDiff;
-            }
+            blit_region_opaque(pDest, dest->width, src->pixelData + offset,
+                               &steps, destWidth, destHeight);
         }
     }
 
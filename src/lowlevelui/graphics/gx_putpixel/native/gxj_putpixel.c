@@ -692,6 +692,59 @@ drawClippedHorzLine(const jshort *clip, gxj_screen_buffer *sbuf,
   primDrawHorzLine(sbuf, color, x1, y1, x2, y1);
 }
 
+/**
+ * draw pixels from (x1,y) through (x2,y)
+ * x1 should be <= x2
+ * coordinates are clipped against the clip unless clip is NULL,
+ * nothing is drawn if no pixel is left inside the clip
+ */
+static void
+drawClippedSpan(gxj_screen_buffer *sbuf, const jshort *clip,
+    gxj_pixel_type color, int x1, int x2, int y) {
+
+  if (clip != NULL) {
+    const jshort clipX1 = clip[0];
+    const jshort clipY1 = clip[1];
+    const jshort clipX2 = clip[2];
+    const jshort clipY2 = clip[3];
+
+    if (y < clipY1 || y >= clipY2)
+      return;
+    x1 = (x1 <  clipX1) ? clipX1 : x1;
+    x2 = (x2 >= clipX2) ? clipX2-1 : x2;
+    if (x1 > x2)
+      return;
+  }
+  CHECK_XY_CLIP(sbuf, x1, y); CHECK_XY_CLIP(sbuf, x2, y);
+  primDrawHorzLine(sbuf, color, x1, y, x2, y);
+}
+
+/**
+ * draw pixels from (x,y1) through (x,y2), in either order
+ * coordinates are clipped against the clip,
+ * nothing is drawn if no pixel is left inside the clip
+ */
+static void
+drawClippedColumn(gxj_screen_buffer *sbuf, const jshort *clip,
+    gxj_pixel_type color, int x, int y1, int y2) {
+
+  const jshort clipX1 = clip[0];
+  const jshort clipY1 = clip[1];
+  const jshort clipX2 = clip[2];
+  const jshort clipY2 = clip[3];
+
+  if (x < clipX1 || x >= clipX2)
+    return;
+  if (y1 > y2)
+    SWAP(y1, y2);
+  y1 = (y1 <  clipY1) ? clipY1 : y1;
+  y2 = (y2 >= clipY2) ? clipY2-1 : y2;
+  if (y1 > y2)
+    return;
+  CHECK_XY_CLIP(sbuf, x, y1); CHECK_XY_CLIP(sbuf, x, y2);
+  primDrawVertLine(sbuf, color, x, y1, x, y2);
+}
+
 /**
  * Evaluate dotted stroke parameters for the point distant
  * from the current one by specified number of pixels.
@@ -1798,6 +1851,44 @@ done: ;
      }
 }
 
+/**
+ * Fills one row of each whole quadrant of a filled arc.
+ * The pixels of such a quadrant are those between the ellipse and
+ * the axes; row_y is the distance of the row from the horizontal axis
+ * and row_x the largest distance from the vertical axis the ellipse
+ * reaches on that row or the rows further from the axis.
+ */
+static void
+drawFilledArcRows(gxj_screen_buffer *sbuf, gxj_pixel_type color,
+    const jshort *clip, int nQuadrantsToDraw, const int quadrantsToDraw[4],
+    const int quadrantStatus[4], int xCenter, int yCenter,
+    int evenXOffset, int evenYOffset, int row_x, int row_y) {
+
+    int j, curQuadrant;
+
+    for (j = 0; j < nQuadrantsToDraw; ++j) {
+      curQuadrant = quadrantsToDraw[j];
+      if (!(quadrantStatus[curQuadrant - 1] & QUADRANT_STATUS_FULL_ARC)) {
+        continue;
+      }
+      if (curQuadrant == 1) {
+        drawClippedSpan(sbuf, clip, color,
+            xCenter, xCenter + row_x, yCenter - row_y);
+      } else if (curQuadrant == 2) {
+        drawClippedSpan(sbuf, clip, color,
+            xCenter - row_x - evenXOffset, xCenter - evenXOffset,
+            yCenter - row_y);
+      } else if (curQuadrant == 3) {
+        drawClippedSpan(sbuf, clip, color,
+            xCenter - row_x - evenXOffset, xCenter - evenXOffset,
+            yCenter + evenYOffset + row_y);
+      } else {
+        drawClippedSpan(sbuf, clip, color,
+            xCenter, xCenter + row_x, yCenter + evenYOffset + row_y);
+      }
+    }
+}
+
 static void
 drawClippedFilledArc(gxj_screen_buffer *sbuf, gxj_pixel_type color,
     const jshort *clip, int startQuadrant, int startRatio,
@@ -1814,6 +1905,7 @@ drawClippedFilledArc(gxj_screen_buffer *sbuf, gxj_pixel_type color,
         start_y1, start_y2, end_x1, end_x2, end_y1, end_y2;
     int nQuadrantsToDraw, curQuadrant, quadrantsToDraw[4];
     int point_x1, point_x2, point_y1, point_y2;
+    int row_x, row_y;
     int i,j;
 
     CHECK_SBUF_CLIP_BOUNDS(sbuf, clip);
@@ -1908,8 +2000,8 @@ drawClippedFilledArc(gxj_screen_buffer *sbuf, gxj_pixel_type color,
      * and finish drawing what's left of the arcs after the triangles
      * we already did SetUpEllipseParams above and didn't use
      * the variables which change */
-    x_point = 0;
-    y_point = b;
+    x_point = row_x = 0;
+    y_point = row_y = b;
     while (y_point >= 0) {
       point_x1 = xCenter + x_point;
       point_y1 = yCenter - y_point;
@@ -1919,106 +2011,103 @@ drawClippedFilledArc(gxj_screen_buffer *sbuf, gxj_pixel_type color,
       for (j = 0; j < nQuadrantsToDraw; ++j) {
         curQuadrant = quadrantsToDraw[j];
         if (quadrantStatus[curQuadrant - 1] & QUADRANT_STATUS_FULL_ARC) {
-          if (curQuadrant == 1) {
-            draw_clipped_line(sbuf, color, SOLID, clip, 
-                point_x1, point_y1, point_x1, yCenter);
-          } else if (curQuadrant == 2) {
-            draw_clipped_line(sbuf, color, SOLID, clip, 
-                point_x2, point_y1, point_x2, yCenter);
-          } else if (curQuadrant == 3) {
-            draw_clipped_line(sbuf, color, SOLID, clip, 
-                point_x2, point_y2, point_x2, yCenter + evenYOffset);
-          } else {
-            /* (curQuadrant == 4) */
-            draw_clipped_line(sbuf, color, SOLID, clip, 
-                point_x1, point_y2, point_x1, yCenter + evenYOffset);
+          /* whole quadrants are filled a row at a time */
+          continue;
+        }
+
+        /* must be partial arc
+         * case of pie slice fully inside quadrant */
+        if ((curQuadrant == startQuadrant) &&
+            (curQuadrant == endQuadrant) &&
+            ((((curQuadrant == 1) || (curQuadrant == 3)) &&
+               (startRatio <= endRatio)) ||
+               (((curQuadrant == 2) || (curQuadrant == 4)) &&
+                 (startRatio >= endRatio)))) {
+          if ((((curQuadrant == 1) || (curQuadrant == 3)) &&
+               ((x_point <= start_x) && (y_point >= start_y)) &&
+               ((x_point >= end_x) && (y_point <= end_y))) ||
+               (((curQuadrant == 2) || (curQuadrant == 4)) &&
+                ((x_point >= start_x) && (y_point <= start_y)) &&
+                ((x_point < end_x) || (y_point > end_y)))) {
+            if (curQuadrant == 1) {
+              drawClippedColumn(sbuf, clip, color, point_x1, point_y1,
+                  yCenter - start_y);
+            } else if (curQuadrant == 2) {
+              drawClippedColumn(sbuf, clip, color, point_x2, point_y1,
+                  yCenter - end_y);
+            } else if (curQuadrant == 3) {
+              drawClippedColumn(sbuf, clip, color, point_x2, point_y2,
+                  yCenter + evenYOffset + start_y);
+            } else if (curQuadrant == 4) {
+              drawClippedColumn(sbuf, clip, color, point_x1, point_y2,
+                  yCenter + evenYOffset + end_y);
+            }
           }
         } else {
-          /* must be partial arc
-           * case of pie slice fully inside quadrant */
+          /* case of pie slice overlapping end of quadrant */
           if ((curQuadrant == startQuadrant) &&
-              (curQuadrant == endQuadrant) &&
-              ((((curQuadrant == 1) || (curQuadrant == 3)) &&
-                 (startRatio <= endRatio)) ||
-                 (((curQuadrant == 2) || (curQuadrant == 4)) &&
-                   (startRatio >= endRatio)))) {
-            if ((((curQuadrant == 1) || (curQuadrant == 3)) &&
-                 ((x_point <= start_x) && (y_point >= start_y)) &&
-                 ((x_point >= end_x) && (y_point <= end_y))) ||
-                 (((curQuadrant == 2) || (curQuadrant == 4)) &&
-                  ((x_point >= start_x) && (y_point <= start_y)) &&
-                  ((x_point < end_x) || (y_point > end_y)))) {
-              if (curQuadrant == 1) {
-                draw_clipped_line(sbuf, color, SOLID, clip, 
-                    point_x1, point_y1, point_x1, yCenter - start_y);
-              } else if (curQuadrant == 2) {
-                draw_clipped_line(sbuf, color, SOLID, clip, 
-                    point_x2, point_y1, point_x2, yCenter - end_y);
-              } else if (curQuadrant == 3) {
-                draw_clipped_line(sbuf, color, SOLID, clip, 
-                    point_x2, point_y2, point_x2,
-                    yCenter + evenYOffset + start_y);
-              } else if (curQuadrant == 4) {
-                draw_clipped_line(sbuf, color, SOLID, clip, 
-                    point_x1, point_y2, point_x1,
-                    yCenter + evenYOffset + end_y);
-              }
-            }
-          } else {
-            /* case of pie slice overlapping end of quadrant */
-            if ((curQuadrant == startQuadrant) &&
-               ((((curQuadrant == 1) || (curQuadrant == 3)) &&
-               ((x_point <= start_x) && (y_point >= start_y))) ||
-               (((curQuadrant == 2) || (curQuadrant == 4)) &&
-               ((x_point >= start_x) && (y_point <= start_y))))) {
+             ((((curQuadrant == 1) || (curQuadrant == 3)) &&
+             ((x_point <= start_x) && (y_point >= start_y))) ||
+             (((curQuadrant == 2) || (curQuadrant == 4)) &&
+             ((x_point >= start_x) && (y_point <= start_y))))) {
 
-              if (curQuadrant == 1) {
-                draw_clipped_line(sbuf, color, SOLID, clip, 
-                    point_x1, point_y1, point_x1, yCenter - start_y);
-              } else if (curQuadrant == 2) {
-                draw_clipped_line(sbuf, color, SOLID, clip, 
-                    point_x2, point_y1, point_x2, yCenter);
-              } else if (curQuadrant == 3) {
-                draw_clipped_line(sbuf, color, SOLID, clip, 
-                    point_x2, point_y2, point_x2,
-                    yCenter + evenYOffset + start_y);
-              } else if (curQuadrant == 4) {
-                draw_clipped_line(sbuf, color, SOLID, clip, 
-                    point_x1, point_y2, point_x1, yCenter + evenYOffset);
-              }
+            if (curQuadrant == 1) {
+              drawClippedColumn(sbuf, clip, color, point_x1, point_y1,
+                  yCenter - start_y);
+            } else if (curQuadrant == 2) {
+              drawClippedColumn(sbuf, clip, color, point_x2, point_y1,
+                  yCenter);
+            } else if (curQuadrant == 3) {
+              drawClippedColumn(sbuf, clip, color, point_x2, point_y2,
+                  yCenter + evenYOffset + start_y);
+            } else if (curQuadrant == 4) {
+              drawClippedColumn(sbuf, clip, color, point_x1, point_y2,
+                  yCenter + evenYOffset);
             }
-            /* case of pie slice overlapping beginning of quadrant
-             * not that this is not mutually exclusive with the previous
-             * case of a pie slice overlapping the end of the quadrant.
-             * For example, the slice which starts at 60 and ends at 10
-             * (an "inverse" pie slice) */
-
-	    if ((curQuadrant == endQuadrant) &&
-               ((((curQuadrant == 1) || (curQuadrant == 3)) &&
-               ((x_point >= end_x) && (y_point <= end_y))) ||
-               (((curQuadrant == 2) || (curQuadrant == 4)) &&
-               ((x_point <= end_x) && (y_point >= end_y))))) {
-              if (curQuadrant == 1) {
-                draw_clipped_line(sbuf, color, SOLID, clip, 
-                    point_x1, point_y1, point_x1, yCenter);
-              } else if (curQuadrant == 2) {
-                draw_clipped_line(sbuf, color, SOLID, clip, 
-                    point_x2, point_y1, point_x2, yCenter - end_y);
-              } else if (curQuadrant == 3) {
-                draw_clipped_line(sbuf, color, SOLID, clip, 
-				  point_x2, point_y2, 
-				  point_x2, yCenter + evenYOffset);
-              } else if (curQuadrant == 4) {
-                draw_clipped_line(sbuf, color, SOLID, clip, 
-                    point_x1, point_y2,
-				  point_x1, yCenter + evenYOffset + end_y);
-              }
+          }
+          /* case of pie slice overlapping beginning of quadrant
+           * not that this is not mutually exclusive with the previous
+           * case of a pie slice overlapping the end of the quadrant.
+           * For example, the slice which starts at 60 and ends at 10
+           * (an "inverse" pie slice) */
+
+          if ((curQuadrant == endQuadrant) &&
+             ((((curQuadrant == 1) || (curQuadrant == 3)) &&
+             ((x_point >= end_x) && (y_point <= end_y))) ||
+             (((curQuadrant == 2) || (curQuadrant == 4)) &&
+             ((x_point <= end_x) && (y_point >= end_y))))) {
+            if (curQuadrant == 1) {
+              drawClippedColumn(sbuf, clip, color, point_x1, point_y1,
+                  yCenter);
+            } else if (curQuadrant == 2) {
+              drawClippedColumn(sbuf, clip, color, point_x2, point_y1,
+                  yCenter - end_y);
+            } else if (curQuadrant == 3) {
+              drawClippedColumn(sbuf, clip, color, point_x2, point_y2,
+                  yCenter + evenYOffset);
+            } else if (curQuadrant == 4) {
+              drawClippedColumn(sbuf, clip, color, point_x1, point_y2,
+                  yCenter + evenYOffset + end_y);
             }
           }
         }
       }
+
+      /* the rows above y_point are complete once the walk leaves them */
+      if (y_point != row_y) {
+        drawFilledArcRows(sbuf, color, clip, nQuadrantsToDraw,
+            quadrantsToDraw, quadrantStatus, xCenter, yCenter,
+            evenXOffset, evenYOffset, row_x, row_y);
+        row_y = y_point;
+      }
+      row_x = x_point;
+
       GetNextEllipsePoint(a2, b2, &S, &T, &x_point, &y_point);
     }
+
+    drawFilledArcRows(sbuf, color, clip, nQuadrantsToDraw,
+        quadrantsToDraw, quadrantStatus, xCenter, yCenter,
+        evenXOffset, evenYOffset, row_x, row_y);
 }
 
 
@@ -2197,6 +2286,25 @@ drawClippedFourWaySymetricPixels(gxj_screen_buffer *sbuf,
   }
 }
 
+/* draws the run of outline pixels x..xEnd of a row, in the four quadrants */
+static void 
+drawClippedFourWaySymetricSpans(gxj_screen_buffer *sbuf,
+    const jshort *clip, int xCenter, int yCenter, int x, int xEnd, int y,
+    int evenXOffset, int evenYOffset, gxj_pixel_type color) {
+
+  int     y1 = yCenter - y;
+  int     y2 = yCenter + y + evenYOffset;
+
+  drawClippedSpan(sbuf, clip, color, xCenter + x, xCenter + xEnd, y1);
+  drawClippedSpan(sbuf, clip, color, xCenter - xEnd - evenXOffset,
+                  xCenter - x - evenXOffset, y1);
+  if (y1 != y2) {
+    drawClippedSpan(sbuf, clip, color, xCenter + x, xCenter + xEnd, y2);
+    drawClippedSpan(sbuf, clip, color, xCenter - xEnd - evenXOffset,
+                    xCenter - x - evenXOffset, y2);
+  }
+}
+
 static void 
 drawClippedPixel(gxj_screen_buffer *sbuf, const jshort *clip,
     gxj_pixel_type color, int x, int y) {
@@ -2430,6 +2538,7 @@ drawCompleteOutlineEllipse(gxj_screen_buffer *sbuf, const jshort *clip,
   int     fourAsquared, fourBsquared;
   int     xSlope, ySlope;
   int     aSquaredTwo, bSquaredTwo;
+  int     xRun;
   int     decision;
   int     ret;
 
@@ -2447,12 +2556,14 @@ drawCompleteOutlineEllipse(gxj_screen_buffer *sbuf, const jshort *clip,
   }
   x = 0;
   y = b;
+  xRun = 0;
   decision = twoBsquared - aSquared - (ySlope >> 1) - aSquaredTwo;
-  /* X axis major region */
+  /* X axis major region, the pixels of a row are drawn as one run */
   while (decision <= ySlope) {
-    drawClippedFourWaySymetricPixels(sbuf, clip, XMAJOR, xCenter, yCenter,
-                              x, y, evenXOffset, evenYOffset, color);
     if (decision > 0) {
+      drawClippedFourWaySymetricSpans(sbuf, clip, xCenter, yCenter,
+                              xRun, x, y, evenXOffset, evenYOffset, color);
+      xRun = x + 1;
       decision -= ySlope;
       y -= 1;
       ySlope -= fourAsquared;
@@ -2461,6 +2572,10 @@ drawCompleteOutlineEllipse(gxj_screen_buffer *sbuf, const jshort *clip,
     x += 1;
     xSlope += fourBsquared;
   }
+  if (xRun < x) {
+    drawClippedFourWaySymetricSpans(sbuf, clip, xCenter, yCenter,
+                              xRun, x - 1, y, evenXOffset, evenYOffset, color);
+  }
   /* Y axis major region */
   decision += ((bSquared - aSquared) +
       (aSquaredTwo - bSquaredTwo) - (xSlope + ySlope)) >> 1;
@@ -2682,6 +2797,24 @@ drawClippedFourWayRoundRectPixels(gxj_screen_buffer * sbuf,
   }
 }
 
+/* draws the run of outline pixels x..xEnd of a row, in the four corners */
+static void 
+drawClippedFourWayRoundRectSpans(gxj_screen_buffer * sbuf,
+    const jshort *clip, int xOrigin, int yOrigin, int x, int xEnd, int y,
+    int width, int height, int arcWidth, int arcHeight,
+    gxj_pixel_type color) {
+
+  int     x1 = xOrigin + arcWidth;
+  int     y1 = yOrigin + arcHeight - y;
+  int     x2 = xOrigin + width - arcWidth;
+  int     y2 = yOrigin + height - arcHeight + y;
+
+  drawClippedSpan(sbuf, clip, color, x1 - xEnd, x1 - x, y1);
+  drawClippedSpan(sbuf, clip, color, x2 + x, x2 + xEnd, y1);
+  drawClippedSpan(sbuf, clip, color, x1 - xEnd, x1 - x, y2);
+  drawClippedSpan(sbuf, clip, color, x2 + x, x2 + xEnd, y2);
+}
+
 static void 
 drawClippedFourWayRoundRectLines(gxj_screen_buffer * sbuf,
     const jshort *clip, int xOrigin, int yOrigin, int x, int y,
@@ -2740,6 +2873,7 @@ drawCompleteOutlineRoundRect(gxj_screen_buffer * sbuf, const jshort *clip,
   int     aSquaredTwo, bSquaredTwo;
   int     xOrigin = x;
   int     yOrigin = y;
+  int     xRun;
   int     decision;
   int     ret;
 
@@ -2755,12 +2889,19 @@ drawCompleteOutlineRoundRect(gxj_screen_buffer * sbuf, const jshort *clip,
   }
   x = 0;
   y = arcHeight;
+  xRun = 0;
   decision = twoBsquared - aSquared - (ySlope >> 1) - aSquaredTwo;
-  /* X axis major region */
+  /* X axis major region, the pixels of a row are drawn as one run */
   while (decision <= ySlope) {
-    drawClippedFourWayRoundRectPixels(sbuf, clip, xOrigin, yOrigin,
+    if ((x == 0 && y == arcHeight) || (x == arcWidth && y == 0)) {
+      /* these points also draw the straight edges */
+      drawClippedFourWayRoundRectPixels(sbuf, clip, xOrigin, yOrigin,
                            x, y, width, height, arcWidth, arcHeight, color);
+    }
     if (decision > 0) {
+      drawClippedFourWayRoundRectSpans(sbuf, clip, xOrigin, yOrigin,
+                     xRun, x, y, width, height, arcWidth, arcHeight, color);
+      xRun = x + 1;
       decision -= ySlope;
       y -= 1;
       ySlope -= fourAsquared;
@@ -2769,6 +2910,10 @@ drawCompleteOutlineRoundRect(gxj_screen_buffer * sbuf, const jshort *clip,
     x += 1;
     xSlope += fourBsquared;
   }
+  if (xRun < x) {
+    drawClippedFourWayRoundRectSpans(sbuf, clip, xOrigin, yOrigin,
+                   xRun, x - 1, y, width, height, arcWidth, arcHeight, color);
+  }
   /* Y axis major region */
   decision += ((bSquared - aSquared) +
       (aSquaredTwo - bSquaredTwo) - (xSlope + ySlope)) >> 1;
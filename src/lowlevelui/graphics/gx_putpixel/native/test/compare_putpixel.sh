@@ -0,0 +1,104 @@
+#!/bin/sh
+#
+# Copyright  1990-2007 Sun Microsystems, Inc. All Rights Reserved.
+# DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER
+# 
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU General Public License version
+# 2 only, as published by the Free Software Foundation.
+# 
+# This program is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+# General Public License version 2 for more details (a copy is
+# included at /legal/license.txt).
+# 
+# You should have received a copy of the GNU General Public License
+# version 2 along with this work; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+# 02110-1301 USA
+# 
+# Please contact Sun Microsystems, Inc., 4150 Network Circle, Santa
+# Clara, CA 95054 or visit www.sun.com if you need additional
+# information or have any questions.
+#
+
+# Compares the shape primitives of gxj_putpixel.c and the region copies
+# of gxj_image.c with a previous revision of the files, see
+# gxj_putpixel_compare.c and gxj_image_compare.c. Run it from anywhere
+# in the git workspace:
+#
+#     compare_putpixel.sh <revision> [cases]
+#
+# e.g. compare_putpixel.sh HEAD~1 to check the last change of the files.
+# Exits with a non-zero status if the revisions draw different pixels.
+
+if [ "x$1" = "x" ]
+then
+    echo "Usage: $0 <revision> [cases]"
+    exit 1
+fi
+
+CC=${CC:-gcc}
+TEST_DIR=`cd ${0%/*} && pwd`
+NATIVE_DIR=${TEST_DIR%/*}
+LOWLEVELUI_DIR=${NATIVE_DIR%/*/*/*}
+SRC_DIR=${LOWLEVELUI_DIR%/*}
+WORK_DIR=${TMPDIR:-/tmp}/compare_putpixel.$$
+
+INCLUDES="-I$TEST_DIR/stubs -I$NATIVE_DIR \
+    -I$LOWLEVELUI_DIR/graphics/gx_putpixel/include \
+    -I$LOWLEVELUI_DIR/graphics/include \
+    -I$LOWLEVELUI_DIR/graphics_api/include \
+    -I$LOWLEVELUI_DIR/image_api/include \
+    -I$SRC_DIR/core/kni_util/include \
+    -I$LOWLEVELUI_DIR/putpixel_port/include \
+    -I$LOWLEVELUI_DIR/putpixel_port/stubs/include"
+
+# The symbols of gxj_<name>.c that are visible to the other files
+renames() {
+    case $1 in
+    putpixel)
+        symbols="draw_arc draw_roundrect fill_triangle \
+            draw_clipped_line aTangents"
+        ;;
+    image)
+        symbols="draw_image draw_imageregion copy_imageregion \
+            create_transformed_imageregion \
+            gx_render_image gx_render_imageregion"
+        ;;
+    esac
+
+    for symbol in $symbols
+    do
+        echo "-D$symbol=$2_$symbol"
+    done
+}
+
+mkdir -p $WORK_DIR || exit 1
+trap "rm -rf $WORK_DIR" 0
+
+cd $NATIVE_DIR
+status=0
+
+for name in putpixel image
+do
+    git show "$1:./gxj_$name.c" > $WORK_DIR/old_$name.c || exit 1
+    cp gxj_$name.c $WORK_DIR/new_$name.c
+
+    for version in old new
+    do
+        $CC -O2 -c $INCLUDES `renames $name $version` \
+            $WORK_DIR/${version}_$name.c \
+            -o $WORK_DIR/${version}_$name.o || exit 1
+    done
+
+    $CC -O2 $INCLUDES $TEST_DIR/gxj_${name}_compare.c \
+        $WORK_DIR/old_$name.o $WORK_DIR/new_$name.o \
+        -o $WORK_DIR/compare_$name || exit 1
+
+    echo "gxj_$name.c:"
+    $WORK_DIR/compare_$name $2 || status=1
+done
+
+exit $status
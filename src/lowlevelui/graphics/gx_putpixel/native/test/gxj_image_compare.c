@@ -0,0 +1,265 @@
+/*
+ *  
+ *
+ * Copyright  1990-2007 Sun Microsystems, Inc. All Rights Reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 only, as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details (a copy is
+ * included at /legal/license.txt).
+ * 
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this work; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ * 
+ * Please contact Sun Microsystems, Inc., 4150 Network Circle, Santa
+ * Clara, CA 95054 or visit www.sun.com if you need additional
+ * information or have any questions.
+ */
+
+/**
+ * @file
+ *
+ * Compares the region copies of gxj_image.c with those of a previous
+ * revision of the file: both copy the same random regions of a random
+ * source image, with every transform, with and without alpha and onto
+ * the source itself, into separate screen buffers that must end up
+ * identical. The previous revision is compiled with its symbols prefixed
+ * by old_, the current one with new_, see compare_putpixel.sh.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <kni.h>
+#include <gxj_putpixel.h>
+
+/** Declares the compared functions of one revision */
+#define DECLARE_COPIES(prefix) \
+    void prefix##copy_imageregion(gxj_screen_buffer *src, \
+        gxj_screen_buffer *dest, const jshort *clip, \
+        jint x_dest, jint y_dest, jint width, jint height, \
+        jint x_src, jint y_src, jint transform); \
+    void prefix##create_transformed_imageregion(gxj_screen_buffer *src, \
+        gxj_screen_buffer *dest, jint src_x, jint src_y, \
+        jint width, jint height, jint transform);
+
+DECLARE_COPIES(old_)
+DECLARE_COPIES(new_)
+
+/** Size of the destination screen buffers */
+#define BUFFER_WIDTH  96
+#define BUFFER_HEIGHT 96
+
+/** Size of the source image */
+#define IMAGE_WIDTH  64
+#define IMAGE_HEIGHT 48
+
+/** Number of pixels of a buffer */
+#define BUFFER_PIXELS (BUFFER_WIDTH * BUFFER_HEIGHT)
+
+/** Maximal number of mismatches reported */
+#define MAX_REPORTED 10
+
+/** Pixels and alpha of the source image */
+static gxj_pixel_type imagePixels[IMAGE_WIDTH * IMAGE_HEIGHT];
+static gxj_alpha_type imageAlpha[IMAGE_WIDTH * IMAGE_HEIGHT];
+
+/** Initial contents of the destination buffers */
+static gxj_pixel_type initialPixels[BUFFER_PIXELS];
+static gxj_alpha_type initialAlpha[BUFFER_PIXELS];
+
+/** Pixels and alpha written by the previous revision */
+static gxj_pixel_type oldPixels[BUFFER_PIXELS];
+static gxj_alpha_type oldAlpha[BUFFER_PIXELS];
+
+/** Pixels and alpha written by the current revision */
+static gxj_pixel_type newPixels[BUFFER_PIXELS];
+static gxj_alpha_type newAlpha[BUFFER_PIXELS];
+
+/** Needed by the screen buffer macros of gxj_image.c */
+gxj_screen_buffer gxj_system_screen_buffer;
+
+/**
+ * Stands for the platform blit of gxj_graphics_asm.c, which is only
+ * reached by draw_image and is not compared.
+ */
+void unclipped_blit(unsigned short *dstRaster, int dstSpan,
+                    unsigned short *srcRaster, int srcSpan,
+                    int height, int width, gxj_screen_buffer *dst) {
+    (void)dst;
+
+    for (; height > 0; height--) {
+        memcpy(dstRaster, srcRaster, width);
+        dstRaster += dstSpan >> 1;
+        srcRaster += srcSpan >> 1;
+    }
+}
+
+/**
+ * Stands for the image lookup of gxj_screen_buffer.c, which is only
+ * reached by gx_render_image and gx_render_imageregion.
+ */
+gxj_screen_buffer* gxj_get_image_screen_buffer_impl(const java_imagedata *img,
+                                                    gxj_screen_buffer *sbuf,
+                                                    jobject graphics) {
+    (void)img;
+    (void)graphics;
+    return sbuf;
+}
+
+/**
+ * Returns a random number.
+ *
+ * @param n the upper bound, exclusive
+ * @return a number from 0 to n - 1
+ */
+static int rnd(int n) {
+    return rand() % n;
+}
+
+/**
+ * Returns a random alpha value, with the opaque, transparent and nearly
+ * transparent values favoured as the blit kernels treat them apart.
+ *
+ * @return an alpha value
+ */
+static gxj_alpha_type rndAlpha() {
+    switch (rnd(5)) {
+    case 0:
+        return 0xFF;
+    case 1:
+        return 0;
+    case 2:
+        return (gxj_alpha_type)rnd(8);
+    default:
+        return (gxj_alpha_type)rnd(256);
+    }
+}
+
+/**
+ * Copies random regions with both revisions and compares the results.
+ *
+ * @param argc number of arguments
+ * @param argv the number of cases to copy, 200000 by default
+ * @return 0 if the revisions wrote the same pixels, 1 otherwise
+ */
+int main(int argc, char** argv) {
+    gxj_screen_buffer image = {IMAGE_WIDTH, IMAGE_HEIGHT, NULL, NULL};
+    gxj_screen_buffer oldBuffer = {BUFFER_WIDTH, BUFFER_HEIGHT, NULL, NULL};
+    gxj_screen_buffer newBuffer = {BUFFER_WIDTH, BUFFER_HEIGHT, NULL, NULL};
+    long cases = (argc > 1) ? atol(argv[1]) : 200000;
+    long mismatches = 0;
+    long i;
+    int j;
+
+    image.pixelData = imagePixels;
+    oldBuffer.pixelData = oldPixels;
+    newBuffer.pixelData = newPixels;
+    srand(1);
+
+    for (j = 0; j < IMAGE_WIDTH * IMAGE_HEIGHT; j++) {
+        imagePixels[j] = (gxj_pixel_type)rand();
+    }
+
+    for (j = 0; j < BUFFER_PIXELS; j++) {
+        initialPixels[j] = (gxj_pixel_type)rand();
+        initialAlpha[j] = rndAlpha();
+    }
+
+    for (i = 0; i < cases; i++) {
+        jshort clip[4];
+        int kind = rnd(3);
+        int alpha = rnd(2);
+        int transform = rnd(8);
+        int xSrc = rnd(IMAGE_WIDTH + 8) - 4;
+        int ySrc = rnd(IMAGE_HEIGHT + 8) - 4;
+        int w = rnd(IMAGE_WIDTH + 8) - 2;
+        int h = rnd(IMAGE_HEIGHT + 8) - 2;
+        int xDest = rnd(BUFFER_WIDTH + 40) - 20;
+        int yDest = rnd(BUFFER_HEIGHT + 40) - 20;
+
+        clip[0] = (jshort)(rnd(BUFFER_WIDTH + 8) - 4);
+        clip[1] = (jshort)(rnd(BUFFER_HEIGHT + 8) - 4);
+        clip[2] = (jshort)(clip[0] + rnd(BUFFER_WIDTH + 8));
+        clip[3] = (jshort)(clip[1] + rnd(BUFFER_HEIGHT + 8));
+        if (rnd(3) == 0) {
+            clip[0] = 0;
+            clip[1] = 0;
+            clip[2] = BUFFER_WIDTH;
+            clip[3] = BUFFER_HEIGHT;
+        }
+
+        if (alpha) {
+            for (j = 0; j < IMAGE_WIDTH * IMAGE_HEIGHT; j++) {
+                imageAlpha[j] = rndAlpha();
+            }
+        }
+        image.alphaData = alpha ? imageAlpha : NULL;
+        oldBuffer.alphaData = alpha ? oldAlpha : NULL;
+        newBuffer.alphaData = alpha ? newAlpha : NULL;
+
+        memcpy(oldPixels, initialPixels, sizeof (oldPixels));
+        memcpy(newPixels, initialPixels, sizeof (newPixels));
+        memcpy(oldAlpha, initialAlpha, sizeof (oldAlpha));
+        memcpy(newAlpha, initialAlpha, sizeof (newAlpha));
+
+        switch (kind) {
+        case 0:
+            /* from the image onto a screen buffer */
+            old_copy_imageregion(&image, &oldBuffer, clip, xDest, yDest,
+                                 w, h, xSrc, ySrc, transform);
+            new_copy_imageregion(&image, &newBuffer, clip, xDest, yDest,
+                                 w, h, xSrc, ySrc, transform);
+            break;
+
+        case 1:
+            /* within the same buffer, the regions may overlap */
+            old_copy_imageregion(&oldBuffer, &oldBuffer, clip, xDest, yDest,
+                                 w, h, xSrc, ySrc, transform);
+            new_copy_imageregion(&newBuffer, &newBuffer, clip, xDest, yDest,
+                                 w, h, xSrc, ySrc, transform);
+            break;
+
+        default:
+            /* into a new image, the region must lie within the source */
+            xSrc = rnd(IMAGE_WIDTH);
+            ySrc = rnd(IMAGE_HEIGHT);
+            w = 1 + rnd(IMAGE_WIDTH - xSrc);
+            h = 1 + rnd(IMAGE_HEIGHT - ySrc);
+            old_create_transformed_imageregion(&image, &oldBuffer,
+                                               xSrc, ySrc, w, h, transform);
+            new_create_transformed_imageregion(&image, &newBuffer,
+                                               xSrc, ySrc, w, h, transform);
+            if (oldBuffer.width != newBuffer.width ||
+                    oldBuffer.height != newBuffer.height) {
+                /* make the buffers differ to report the mismatch */
+                newPixels[0] = (gxj_pixel_type)~oldPixels[0];
+            }
+            oldBuffer.width = newBuffer.width = BUFFER_WIDTH;
+            oldBuffer.height = newBuffer.height = BUFFER_HEIGHT;
+            break;
+        }
+
+        if ((memcmp(oldPixels, newPixels, sizeof (oldPixels)) != 0 ||
+                memcmp(oldAlpha, newAlpha, sizeof (oldAlpha)) != 0) &&
+                mismatches++ < MAX_REPORTED) {
+            printf("mismatch: kind=%d alpha=%d transform=%d src=%d,%d "
+                   "size=%dx%d dest=%d,%d clip=%d,%d,%d,%d\n",
+                   kind, alpha, transform, xSrc, ySrc, w, h, xDest, yDest,
+                   clip[0], clip[1], clip[2], clip[3]);
+        }
+    }
+
+    printf("%ld cases, %ld mismatches\n", cases, mismatches);
+
+    return mismatches != 0;
+}
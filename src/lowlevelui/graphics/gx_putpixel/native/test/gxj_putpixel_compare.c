@@ -0,0 +1,179 @@
+/*
+ *  
+ *
+ * Copyright  1990-2007 Sun Microsystems, Inc. All Rights Reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 only, as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details (a copy is
+ * included at /legal/license.txt).
+ * 
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this work; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ * 
+ * Please contact Sun Microsystems, Inc., 4150 Network Circle, Santa
+ * Clara, CA 95054 or visit www.sun.com if you need additional
+ * information or have any questions.
+ */
+
+/**
+ * @file
+ *
+ * Compares the shape primitives of gxj_putpixel.c with those of a
+ * previous revision of the file: both are drawn with the same random
+ * arguments and clips into separate screen buffers that must end up
+ * identical. The previous revision is compiled with its symbols prefixed
+ * by old_, the current one with new_, see compare_putpixel.sh.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <kni.h>
+#include <gxj_putpixel.h>
+
+/** Declares the compared primitives of one revision */
+#define DECLARE_PRIMITIVES(prefix) \
+    void prefix##draw_arc(gxj_pixel_type color, const jshort *clip, \
+        gxj_screen_buffer *sbuf, int lineStyle, int x, int y, \
+        int width, int height, int fill, int startAngle, int arcAngle); \
+    void prefix##draw_roundrect(gxj_pixel_type color, const jshort *clip, \
+        gxj_screen_buffer *sbuf, int lineStyle, int x, int y, \
+        int width, int height, int fill, int arcWidth, int arcHeight); \
+    void prefix##fill_triangle(gxj_screen_buffer *sbuf, \
+        gxj_pixel_type color, const jshort *clip, \
+        int x1, int y1, int x2, int y2, int x3, int y3);
+
+DECLARE_PRIMITIVES(old_)
+DECLARE_PRIMITIVES(new_)
+
+/** Size of the screen buffers */
+#define BUFFER_WIDTH  160
+#define BUFFER_HEIGHT 160
+
+/** Color the shapes are drawn with */
+#define COLOR 0x1234
+
+/** Maximal number of mismatches reported */
+#define MAX_REPORTED 10
+
+/** Pixels drawn by the previous revision */
+static gxj_pixel_type oldPixels[BUFFER_WIDTH * BUFFER_HEIGHT];
+
+/** Pixels drawn by the current revision */
+static gxj_pixel_type newPixels[BUFFER_WIDTH * BUFFER_HEIGHT];
+
+/**
+ * Returns a random number.
+ *
+ * @param n the upper bound, exclusive
+ * @return a number from 0 to n - 1
+ */
+static int rnd(int n) {
+    return rand() % n;
+}
+
+/**
+ * Draws random arcs, round rectangles and triangles with both revisions
+ * and compares the results.
+ *
+ * @param argc number of arguments
+ * @param argv the number of cases to draw, 200000 by default
+ * @return 0 if the revisions drew the same pixels, 1 otherwise
+ */
+int main(int argc, char** argv) {
+    gxj_screen_buffer oldBuffer = {BUFFER_WIDTH, BUFFER_HEIGHT, NULL, NULL};
+    gxj_screen_buffer newBuffer = {BUFFER_WIDTH, BUFFER_HEIGHT, NULL, NULL};
+    long cases = (argc > 1) ? atol(argv[1]) : 200000;
+    long mismatches = 0;
+    long i;
+
+    oldBuffer.pixelData = oldPixels;
+    newBuffer.pixelData = newPixels;
+    srand(1);
+
+    for (i = 0; i < cases; i++) {
+        jshort clip[4];
+        int kind = rnd(3);
+        int x = rnd(200) - 20;
+        int y = rnd(200) - 20;
+        int w = rnd(140);
+        int h = rnd(140);
+        int lineStyle = (rnd(4) == 0);
+        int fill = rnd(2);
+        int a1 = 0, a2 = 0;
+        int p[6], j;
+
+        clip[0] = (jshort)rnd(BUFFER_WIDTH);
+        clip[1] = (jshort)rnd(BUFFER_HEIGHT);
+        clip[2] = (jshort)(clip[0] + rnd(BUFFER_WIDTH - clip[0] + 1));
+        clip[3] = (jshort)(clip[1] + rnd(BUFFER_HEIGHT - clip[1] + 1));
+        if (rnd(3) == 0) {
+            clip[0] = 0;
+            clip[1] = 0;
+            clip[2] = BUFFER_WIDTH;
+            clip[3] = BUFFER_HEIGHT;
+        }
+
+        memset(oldPixels, 0, sizeof (oldPixels));
+        memset(newPixels, 0, sizeof (newPixels));
+
+        switch (kind) {
+        case 0:
+            /* arcs, with complete and right angle cases favoured */
+            a1 = rnd(720) - 360;
+            a2 = (rnd(6) == 0) ? 360 : rnd(800) - 400;
+            if (rnd(4) == 0) {
+                a1 = rnd(8) * 45;
+            }
+            if (rnd(4) == 0) {
+                a2 = rnd(9) * 45;
+            }
+            old_draw_arc(COLOR, clip, &oldBuffer, lineStyle,
+                         x, y, w, h, fill, a1, a2);
+            new_draw_arc(COLOR, clip, &newBuffer, lineStyle,
+                         x, y, w, h, fill, a1, a2);
+            break;
+
+        case 1:
+            a1 = rnd(80) - 5;
+            a2 = rnd(80) - 5;
+            old_draw_roundrect(COLOR, clip, &oldBuffer, lineStyle,
+                               x, y, w, h, fill, a1, a2);
+            new_draw_roundrect(COLOR, clip, &newBuffer, lineStyle,
+                               x, y, w, h, fill, a1, a2);
+            break;
+
+        default:
+            for (j = 0; j < 6; j++) {
+                p[j] = rnd(240) - 40;
+            }
+            old_fill_triangle(&oldBuffer, COLOR, clip,
+                              p[0], p[1], p[2], p[3], p[4], p[5]);
+            new_fill_triangle(&newBuffer, COLOR, clip,
+                              p[0], p[1], p[2], p[3], p[4], p[5]);
+            break;
+        }
+
+        if (memcmp(oldPixels, newPixels, sizeof (oldPixels)) != 0 &&
+                mismatches++ < MAX_REPORTED) {
+            printf("mismatch: kind=%d x=%d y=%d w=%d h=%d lineStyle=%d "
+                   "fill=%d angles=%d,%d clip=%d,%d,%d,%d\n",
+                   kind, x, y, w, h, lineStyle, fill, a1, a2,
+                   clip[0], clip[1], clip[2], clip[3]);
+        }
+    }
+
+    printf("%ld cases, %ld mismatches\n", cases, mismatches);
+
+    return mismatches != 0;
+}
@@ -0,0 +1,45 @@
+/*
+ *  
+ *
+ * Copyright  1990-2007 Sun Microsystems, Inc. All Rights Reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 only, as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details (a copy is
+ * included at /legal/license.txt).
+ * 
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this work; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ * 
+ * Please contact Sun Microsystems, Inc., 4150 Network Circle, Santa
+ * Clara, CA 95054 or visit www.sun.com if you need additional
+ * information or have any questions.
+ */
+
+/**
+ * @file
+ *
+ * Logging turned off for building gxj_putpixel.c outside of MIDP,
+ * see compare_putpixel.sh.
+ */
+
+#ifndef _MIDP_LOGGING_H_
+#define _MIDP_LOGGING_H_
+
+#define REPORT_CALL_TRACE(ch, msg)
+#define REPORT_INFO(ch, msg)
+#define REPORT_INFO1(ch, msg, a1)
+#define REPORT_WARN(ch, msg)
+#define REPORT_ERROR(ch, msg)
+#define REPORT_ERROR1(ch, msg, a1)
+#define REPORT_ERROR2(ch, msg, a1, a2)
+
+#endif /* _MIDP_LOGGING_H_ */
@@ -2149,6 +2149,14 @@ public class Graphics {
         translate(ax-getTranslateX(), ay-getTranslateY());
     }
 
+    /**
+     * Draws the primitives recorded so far. Primitives are always
+     * drawn right away by this implementation, so there is nothing
+     * to do.
+     */
+    void flushCommands() {
+    }
+
     /**
      * Renders provided Image onto this Graphics object.
      *
@@ -1059,7 +1059,27 @@ public class Graphics {
      * @param x2 the x coordinate of the end of the line
      * @param y2 the y coordinate of the end of the line
      */
-    public native void drawLine(int x1, int y1, int x2, int y2);
+    public void drawLine(int x1, int y1, int x2, int y2) {
+        if (batching) {
+            int i = beginCommand(CMD_LINE, 5);
+            commands[i + 1] = x1 + transX;
+            commands[i + 2] = y1 + transY;
+            commands[i + 3] = x2 + transX;
+            commands[i + 4] = y2 + transY;
+        } else {
+            drawLine0(x1, y1, x2, y2);
+        }
+    }
+
+    /**
+     * Native implementation of drawLine method.
+     *
+     * @param x1 the x coordinate of the start of the line
+     * @param y1 the y coordinate of the start of the line
+     * @param x2 the x coordinate of the end of the line
+     * @param y2 the y coordinate of the end of the line
+     */
+    private native void drawLine0(int x1, int y1, int x2, int y2);
 
     /**
      * Fills the specified rectangle with the current color.
@@ -1071,7 +1091,29 @@ public class Graphics {
      * @param height the height of the rectangle to be filled
      * @see #drawRect(int, int, int, int)
      */
-    public native void fillRect(int x, int y, int width, int height);
+    public void fillRect(int x, int y, int width, int height) {
+        if (batching) {
+            if ((width >= 0) && (height >= 0)) {
+                int i = beginCommand(CMD_FILL_RECT, 5);
+                commands[i + 1] = x + transX;
+                commands[i + 2] = y + transY;
+                commands[i + 3] = width;
+                commands[i + 4] = height;
+            }
+        } else {
+            fillRect0(x, y, width, height);
+        }
+    }
+
+    /**
+     * Native implementation of fillRect method.
+     *
+     * @param x the x coordinate of the rectangle to be filled
+     * @param y the y coordinate of the rectangle to be filled
+     * @param width the width of the rectangle to be filled
+     * @param height the height of the rectangle to be filled
+     */
+    private native void fillRect0(int x, int y, int width, int height);
  
     /**
      * Draws the outline of the specified rectangle using the current
@@ -1086,7 +1128,29 @@ public class Graphics {
      * @param height the height of the rectangle to be drawn
      * @see #fillRect(int, int, int, int)
      */
-    public native void drawRect(int x, int y, int width, int height);
+    public void drawRect(int x, int y, int width, int height) {
+        if (batching) {
+            if ((width >= 0) && (height >= 0)) {
+                int i = beginCommand(CMD_RECT, 5);
+                commands[i + 1] = x + transX;
+                commands[i + 2] = y + transY;
+                commands[i + 3] = width;
+                commands[i + 4] = height;
+            }
+        } else {
+            drawRect0(x, y, width, height);
+        }
+    }
+
+    /**
+     * Native implementation of drawRect method.
+     *
+     * @param x the x coordinate of the rectangle to be drawn
+     * @param y the y coordinate of the rectangle to be drawn
+     * @param width the width of the rectangle to be drawn
+     * @param height the height of the rectangle to be drawn
+     */
+    private native void drawRect0(int x, int y, int width, int height);
 
     /**
      * Draws the outline of the specified rounded corner rectangle
@@ -1104,8 +1168,35 @@ public class Graphics {
      * @param arcHeight the vertical diameter of the arc at the four corners
      * @see #fillRoundRect(int, int, int, int, int, int)
      */
-    public native void drawRoundRect(int x, int y, int width, int height,
-                                     int arcWidth, int arcHeight);
+    public void drawRoundRect(int x, int y, int width, int height,
+                              int arcWidth, int arcHeight) {
+        if (batching) {
+            if ((width >= 0) && (height >= 0)) {
+                int i = beginCommand(CMD_ROUND_RECT, 7);
+                commands[i + 1] = x + transX;
+                commands[i + 2] = y + transY;
+                commands[i + 3] = width;
+                commands[i + 4] = height;
+                commands[i + 5] = arcWidth;
+                commands[i + 6] = arcHeight;
+            }
+        } else {
+            drawRoundRect0(x, y, width, height, arcWidth, arcHeight);
+        }
+    }
+
+    /**
+     * Native implementation of drawRoundRect method.
+     *
+     * @param x the x coordinate of the rectangle to be drawn
+     * @param y the y coordinate of the rectangle to be drawn
+     * @param width the width of the rectangle to be drawn
+     * @param height the height of the rectangle to be drawn
+     * @param arcWidth the horizontal diameter of the arc at the four corners
+     * @param arcHeight the vertical diameter of the arc at the four corners
+     */
+    private native void drawRoundRect0(int x, int y, int width, int height,
+                                       int arcWidth, int arcHeight);
  
     /**
      * Fills the specified rounded corner rectangle with the current color.
@@ -1120,8 +1211,35 @@ public class Graphics {
      * @param arcHeight the vertical diameter of the arc at the four corners
      * @see #drawRoundRect(int, int, int, int, int, int)
      */
-    public native void fillRoundRect(int x, int y, int width, int height,
-                                     int arcWidth, int arcHeight);
+    public void fillRoundRect(int x, int y, int width, int height,
+                              int arcWidth, int arcHeight) {
+        if (batching) {
+            if ((width >= 0) && (height >= 0)) {
+                int i = beginCommand(CMD_FILL_ROUND_RECT, 7);
+                commands[i + 1] = x + transX;
+                commands[i + 2] = y + transY;
+                commands[i + 3] = width;
+                commands[i + 4] = height;
+                commands[i + 5] = arcWidth;
+                commands[i + 6] = arcHeight;
+            }
+        } else {
+            fillRoundRect0(x, y, width, height, arcWidth, arcHeight);
+        }
+    }
+
+    /**
+     * Native implementation of fillRoundRect method.
+     *
+     * @param x the x coordinate of the rectangle to be filled
+     * @param y the y coordinate of the rectangle to be filled
+     * @param width the width of the rectangle to be filled
+     * @param height the height of the rectangle to be filled
+     * @param arcWidth the horizontal diameter of the arc at the four corners
+     * @param arcHeight the vertical diameter of the arc at the four corners
+     */
+    private native void fillRoundRect0(int x, int y, int width, int height,
+                                       int arcWidth, int arcHeight);
                           
     /**
      * Fills a circular or elliptical arc covering the specified rectangle.
@@ -1169,8 +1287,35 @@ public class Graphics {
      * relative to the start angle.
      * @see #drawArc(int, int, int, int, int, int)
      */
-    public native void fillArc(int x, int y, int width, int height,
-                               int startAngle, int arcAngle);
+    public void fillArc(int x, int y, int width, int height,
+                        int startAngle, int arcAngle) {
+        if (batching) {
+            if ((width >= 0) && (height >= 0)) {
+                int i = beginCommand(CMD_FILL_ARC, 7);
+                commands[i + 1] = x + transX;
+                commands[i + 2] = y + transY;
+                commands[i + 3] = width;
+                commands[i + 4] = height;
+                commands[i + 5] = startAngle;
+                commands[i + 6] = arcAngle;
+            }
+        } else {
+            fillArc0(x, y, width, height, startAngle, arcAngle);
+        }
+    }
+
+    /**
+     * Native implementation of fillArc method.
+     *
+     * @param x the x coordinate of the arc to be filled
+     * @param y the y coordinate of the arc to be filled
+     * @param width the width of the arc to be filled
+     * @param height the height of the arc to be filled
+     * @param startAngle the beginning angle
+     * @param arcAngle the angular extent of the arc, relative to the start angle
+     */
+    private native void fillArc0(int x, int y, int width, int height,
+                                 int startAngle, int arcAngle);
 
     /**
      * Draws the outline of a circular or elliptical arc
@@ -1214,8 +1359,35 @@ public class Graphics {
      * the start angle
      * @see #fillArc(int, int, int, int, int, int)
      */
-    public native void drawArc(int x, int y, int width, int height,
-                               int startAngle, int arcAngle);
+    public void drawArc(int x, int y, int width, int height,
+                        int startAngle, int arcAngle) {
+        if (batching) {
+            if ((width >= 0) && (height >= 0)) {
+                int i = beginCommand(CMD_ARC, 7);
+                commands[i + 1] = x + transX;
+                commands[i + 2] = y + transY;
+                commands[i + 3] = width;
+                commands[i + 4] = height;
+                commands[i + 5] = startAngle;
+                commands[i + 6] = arcAngle;
+            }
+        } else {
+            drawArc0(x, y, width, height, startAngle, arcAngle);
+        }
+    }
+
+    /**
+     * Native implementation of drawArc method.
+     *
+     * @param x the x coordinate of the arc to be drawn
+     * @param y the y coordinate of the arc to be drawn
+     * @param width the width of the arc to be drawn
+     * @param height the height of the arc to be drawn
+     * @param startAngle the beginning angle
+     * @param arcAngle the angular extent of the arc, relative to the start angle
+     */
+    private native void drawArc0(int x, int y, int width, int height,
+                                 int startAngle, int arcAngle);
 
     /**
      * Draws the specified <code>String</code> using the current font and color.
@@ -1229,8 +1401,22 @@ public class Graphics {
      * @throws IllegalArgumentException if anchor is not a legal value
      * @see #drawChars(char[], int, int, int, int, int)
      */
-    public native void drawString(java.lang.String str,
-                                  int x, int y, int anchor);
+    public void drawString(java.lang.String str,
+                           int x, int y, int anchor) {
+        flushCommands();
+        drawString0(str, x, y, anchor);
+    }
+
+    /**
+     * Native implementation of drawString method.
+     *
+     * @param str the <code>String</code> to be drawn
+     * @param x the x coordinate of the anchor point
+     * @param y the y coordinate of the anchor point
+     * @param anchor the anchor point for positioning the text
+     */
+    private native void drawString0(java.lang.String str,
+                                    int x, int y, int anchor);
 
     /**
      * Draws the specified <code>String</code> using the current font and color.
@@ -1260,8 +1446,24 @@ public class Graphics {
      * is not a legal value
      * @throws NullPointerException if <code>str</code> is <code>null</code>
      */
-    public native void drawSubstring(String str, int offset, int len,
-                                     int x, int y, int anchor);
+    public void drawSubstring(String str, int offset, int len,
+                              int x, int y, int anchor) {
+        flushCommands();
+        drawSubstring0(str, offset, len, x, y, anchor);
+    }
+
+    /**
+     * Native implementation of drawSubstring method.
+     *
+     * @param str the <code>String</code> to be drawn
+     * @param offset zero-based index of first character in the substring
+     * @param len length of the substring
+     * @param x the x coordinate of the anchor point
+     * @param y the y coordinate of the anchor point
+     * @param anchor the anchor point for positioning the text
+     */
+    private native void drawSubstring0(String str, int offset, int len,
+                                       int x, int y, int anchor);
 
     /**
      * Draws the specified character using the current font and color.
@@ -1277,7 +1479,20 @@ public class Graphics {
      * @see #drawString(java.lang.String, int, int, int)
      * @see #drawChars(char[], int, int, int, int, int)
      */
-    public native void drawChar(char character, int x, int y, int anchor);
+    public void drawChar(char character, int x, int y, int anchor) {
+        flushCommands();
+        drawChar0(character, x, y, anchor);
+    }
+
+    /**
+     * Native implementation of drawChar method.
+     *
+     * @param character the character to be drawn
+     * @param x the x coordinate of the anchor point
+     * @param y the y coordinate of the anchor point
+     * @param anchor the anchor point for positioning the text
+     */
+    private native void drawChar0(char character, int x, int y, int anchor);
 
     /**
      * Draws the specified characters using the current font and color.
@@ -1307,8 +1522,24 @@ public class Graphics {
      *
      * @see #drawString(java.lang.String, int, int, int)
      */
-    public native void drawChars(char[] data, int offset, int length,
-                                 int x, int y, int anchor);
+    public void drawChars(char[] data, int offset, int length,
+                          int x, int y, int anchor) {
+        flushCommands();
+        drawChars0(data, offset, length, x, y, anchor);
+    }
+
+    /**
+     * Native implementation of drawChars method.
+     *
+     * @param data the array of characters to be drawn
+     * @param offset the start offset in the data
+     * @param length the number of characters to be drawn
+     * @param x the x coordinate of the anchor point
+     * @param y the y coordinate of the anchor point
+     * @param anchor the anchor point for positioning the text
+     */
+    private native void drawChars0(char[] data, int offset, int length,
+                                   int x, int y, int anchor);
  
     /**
      * Draws the specified image by using the anchor point.
@@ -1341,6 +1572,7 @@ public class Graphics {
             throw new NullPointerException();
         }
 
+        flushCommands();
         if (!render(image, x, y, anchor)) {
             throw new IllegalArgumentException("");
         }
@@ -1451,6 +1683,7 @@ public class Graphics {
         if (src == null) {
             throw new NullPointerException();
         }
+        flushCommands();
         if (!renderRegion(src, x_src, y_src, width, height,
                           transform, x_dest, y_dest, anchor)) {
             throw new IllegalArgumentException("");
@@ -1533,6 +1766,7 @@ public class Graphics {
         if (isScreenGraphics()) {
             throw new IllegalStateException();
         } else {
+            flushCommands();
             doCopyArea(x_src, y_src, width, height, 
                        x_dest, y_dest, anchor);
         }
@@ -1551,9 +1785,35 @@ public class Graphics {
      * @param y3 the y coordinate of the third vertex of the triangle
      *
      */
-    public native void fillTriangle(int x1, int y1, 
-                                    int x2, int y2,
-                                    int x3, int y3);
+    public void fillTriangle(int x1, int y1, 
+                             int x2, int y2,
+                             int x3, int y3) {
+        if (batching) {
+            int i = beginCommand(CMD_FILL_TRIANGLE, 7);
+            commands[i + 1] = x1 + transX;
+            commands[i + 2] = y1 + transY;
+            commands[i + 3] = x2 + transX;
+            commands[i + 4] = y2 + transY;
+            commands[i + 5] = x3 + transX;
+            commands[i + 6] = y3 + transY;
+        } else {
+            fillTriangle0(x1, y1, x2, y2, x3, y3);
+        }
+    }
+
+    /**
+     * Native implementation of fillTriangle method.
+     *
+     * @param x1 the x coordinate of the first vertex of the triangle
+     * @param y1 the y coordinate of the first vertex of the triangle
+     * @param x2 the x coordinate of the second vertex of the triangle
+     * @param y2 the y coordinate of the second vertex of the triangle
+     * @param x3 the x coordinate of the third vertex of the triangle
+     * @param y3 the y coordinate of the third vertex of the triangle
+     */
+    private native void fillTriangle0(int x1, int y1, 
+                                      int x2, int y2,
+                                      int x3, int y3);
 
     /**
      * Native implementation of CopyArea method.
@@ -1668,9 +1928,32 @@ public class Graphics {
      * @throws NullPointerException if <code>rgbData</code> is <code>null</code>
      *
      */
-    public native void drawRGB(int[] rgbData, int offset, int scanlength,
-                               int x, int y, int width, int height,
-                               boolean processAlpha);
+    public void drawRGB(int[] rgbData, int offset, int scanlength,
+                        int x, int y, int width, int height,
+                        boolean processAlpha) {
+        flushCommands();
+        drawRGB0(rgbData, offset, scanlength, x, y, width, height,
+                 processAlpha);
+    }
+
+    /**
+     * Native implementation of drawRGB method.
+     *
+     * @param rgbData an array of ARGB values in the format
+     * <code>0xAARRGGBB</code>
+     * @param offset the array index of the first ARGB value
+     * @param scanlength the relative array offset between the
+     * corresponding pixels in consecutive rows
+     * @param x the horizontal location of the region to be rendered
+     * @param y the vertical location of the region to be rendered
+     * @param width the width of the region to be rendered
+     * @param height the height of the region to be rendered
+     * @param processAlpha <code>true</code> if <code>rgbData</code>
+     * has an alpha channel, false if all pixels are fully opaque
+     */
+    private native void drawRGB0(int[] rgbData, int offset, int scanlength,
+                                 int x, int y, int width, int height,
+                                 boolean processAlpha);
 
     /**
      * Gets the color that will be displayed if the specified color
@@ -1741,6 +2024,47 @@ public class Graphics {
      */
     private Image img;
 
+    /**
+     * Opcodes of the commands recorded in <code>commands</code>.
+     * They must match the <tt>GXAPI_CMD_*</tt> values in
+     * <tt>gxapi_intern_graphics.h</tt>.
+     */
+    private static final int CMD_STATE           = 0;
+    private static final int CMD_LINE            = 1;
+    private static final int CMD_RECT            = 2;
+    private static final int CMD_FILL_RECT       = 3;
+    private static final int CMD_ROUND_RECT      = 4;
+    private static final int CMD_FILL_ROUND_RECT = 5;
+    private static final int CMD_ARC             = 6;
+    private static final int CMD_FILL_ARC        = 7;
+    private static final int CMD_FILL_TRIANGLE   = 8;
+
+    /** Number of ints taken by a <code>CMD_STATE</code> command */
+    private static final int STATE_COMMAND_SIZE = 7;
+
+    /** Number of ints in the command buffer */
+    private static final int COMMAND_BUFFER_SIZE = 512;
+
+    /**
+     * True while shape primitives are recorded into
+     * <code>commands</code> instead of being drawn right away
+     */
+    private boolean batching;
+
+    /**
+     * Shape primitives recorded while batching. Each command is an
+     * opcode followed by its translated coordinates; a
+     * <code>CMD_STATE</code> command carrying the pixel, stroke style
+     * and clip is recorded whenever they change.
+     */
+    private int[] commands;
+
+    /** Number of ints used in <code>commands</code> */
+    private int commandsLength;
+
+    /** Index of the last <code>CMD_STATE</code> command, -1 if none */
+    private int stateCommand = -1;
+
     /**
      * Retrieve the Graphics context for the given Image
      *
@@ -1894,6 +2218,13 @@ public class Graphics {
         translate(systemX, systemY);
         ax = getTranslateX();
         ay = getTranslateY();
+
+        // The application paints with this GC until the runtime GC
+        // is restored, batch its shape primitives meanwhile
+        if (commands == null) {
+            commands = new int[COMMAND_BUFFER_SIZE];
+        }
+        batching = true;
     }
 
     /**
@@ -1903,10 +2234,72 @@ public class Graphics {
      * - Restore the original translation
      */
     void restoreMIDPRuntimeGC() {
+        flushCommands();
+        batching = false;
         runtimeClipEnforce = false;
         translate(ax-getTranslateX(), ay-getTranslateY());
     }
 
+    /**
+     * Starts a command of the given size in the command buffer,
+     * flushing the buffer first if the command and a state command
+     * might not fit. A state command is recorded before it if the
+     * pixel, stroke style or clip changed since the last one.
+     *
+     * @param opcode the opcode of the command
+     * @param size the number of ints taken by the command, including
+     *        the opcode
+     * @return the index of the command in <code>commands</code>
+     */
+    private int beginCommand(int opcode, int size) {
+        if (commandsLength + STATE_COMMAND_SIZE + size > commands.length) {
+            flushCommands();
+        }
+
+        int i = stateCommand;
+        if (i < 0 ||
+            commands[i + 1] != pixel || commands[i + 2] != style ||
+            commands[i + 3] != clipX1 || commands[i + 4] != clipY1 ||
+            commands[i + 5] != clipX2 || commands[i + 6] != clipY2) {
+            i = commandsLength;
+            commands[i]     = CMD_STATE;
+            commands[i + 1] = pixel;
+            commands[i + 2] = style;
+            commands[i + 3] = clipX1;
+            commands[i + 4] = clipY1;
+            commands[i + 5] = clipX2;
+            commands[i + 6] = clipY2;
+            stateCommand = i;
+            commandsLength = i + STATE_COMMAND_SIZE;
+        }
+
+        i = commandsLength;
+        commands[i] = opcode;
+        commandsLength = i + size;
+        return i;
+    }
+
+    /**
+     * Draws the shape primitives recorded so far. This must be done
+     * before any other drawing into, or reading from, the
+     * destination of this Graphics object.
+     */
+    void flushCommands() {
+        if (commandsLength > 0) {
+            executeCommands(commands, commandsLength);
+            commandsLength = 0;
+            stateCommand = -1;
+        }
+    }
+
+    /**
+     * Draws the recorded shape primitives in one native call.
+     *
+     * @param commands the recorded commands
+     * @param length the number of ints used in <code>commands</code>
+     */
+    private native void executeCommands(int[] commands, int length);
+
     /**
      * Renders provided Image onto this Graphics object.
      *
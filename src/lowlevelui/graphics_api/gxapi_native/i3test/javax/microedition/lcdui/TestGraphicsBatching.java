@@ -0,0 +1,140 @@
+/*
+ *   
+ *
+ * Copyright  1990-2007 Sun Microsystems, Inc. All Rights Reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 only, as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details (a copy is
+ * included at /legal/license.txt).
+ * 
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this work; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ * 
+ * Please contact Sun Microsystems, Inc., 4150 Network Circle, Santa
+ * Clara, CA 95054 or visit www.sun.com if you need additional
+ * information or have any questions.
+ */
+
+package javax.microedition.lcdui;
+
+import com.sun.midp.i3test.*;
+
+/**
+ * Checks that shape primitives recorded while the application paints
+ * give the same pixels as primitives drawn right away.
+ */
+public class TestGraphicsBatching extends TestCase {
+
+    int width = 40;
+    int height = 40;
+
+    /**
+     * Draws shapes with changing color, stroke style, clip and
+     * translation, with text in between, and enough of them to fill
+     * the command buffer several times.
+     *
+     * @param g the Graphics to draw with
+     */
+    void draw(Graphics g) {
+        g.setColor(0xffffff);
+        g.fillRect(0, 0, width, height);
+
+        for (int i = 0; i < 200; i++) {
+            g.setColor((i * 0x10305) & 0xffffff);
+            g.setStrokeStyle((i & 4) == 0 ? Graphics.SOLID : Graphics.DOTTED);
+            if ((i & 15) == 0) {
+                g.setClip(i % 7, i % 5, width - i % 11, height - i % 13);
+            }
+            if ((i & 31) == 0) {
+                g.translate(i % 3 - 1, i % 5 - 2);
+            }
+
+            int x = (i * 7) % width;
+            int y = (i * 11) % height;
+            switch (i % 9) {
+            case 0: g.drawLine(x, y, width - x, y / 2); break;
+            case 1: g.drawRect(x, y, i % 13, i % 9); break;
+            case 2: g.fillRect(x, y, i % 13, i % 9); break;
+            case 3: g.drawRoundRect(x, y, 12, 9, 5, 4); break;
+            case 4: g.fillRoundRect(x, y, 12, 9, 5, 4); break;
+            case 5: g.drawArc(x, y, 15, 10, i, i * 3 - 200); break;
+            case 6: g.fillArc(x, y, 15, 10, i, i * 3 - 200); break;
+            case 7: g.fillTriangle(x, y, y, x, width / 2, height / 2); break;
+            default: g.drawChar('x', x, y, Graphics.TOP | Graphics.LEFT);
+            }
+        }
+    }
+
+    /**
+     * Draws the same shapes with and without batching and
+     * compares the pixels.
+     */
+    void testSamePixels() {
+        int[] immediateData = new int[width * height];
+        int[] batchedData = new int[width * height];
+
+        Image image = Image.createImage(width, height);
+        Graphics g = image.getGraphics();
+        draw(g);
+        image.getRGB(immediateData, 0, width, 0, 0, width, height);
+
+        image = Image.createImage(width, height);
+        g = image.getGraphics();
+        g.preserveMIDPRuntimeGC(0, 0, width, height);
+        draw(g);
+        g.restoreMIDPRuntimeGC();
+        image.getRGB(batchedData, 0, width, 0, 0, width, height);
+
+        boolean same = true;
+        for (int i = 0; i < immediateData.length; i++) {
+            if (immediateData[i] != batchedData[i]) {
+                System.out.println("FAILURE: (" + (i % width) + "," +
+                                   (i / width) + ")" +
+                                   " batched=" +
+                                   Integer.toHexString(batchedData[i]) +
+                                   " immediate=" +
+                                   Integer.toHexString(immediateData[i]));
+                same = false;
+                break;
+            }
+        }
+        assertTrue(same);
+    }
+
+    /**
+     * Checks that nothing is left to draw once the runtime GC is
+     * restored, even if the application drew nothing after a
+     * shape.
+     */
+    void testFlushedOnRestore() {
+        int[] data = new int[1];
+
+        Image image = Image.createImage(4, 4);
+        Graphics g = image.getGraphics();
+        int black = g.getDisplayColor(0);
+
+        g.preserveMIDPRuntimeGC(0, 0, 4, 4);
+        g.setColor(0);
+        g.fillRect(0, 0, 4, 4);
+        g.restoreMIDPRuntimeGC();
+
+        image.getRGB(data, 0, 1, 1, 1, 1, 1);
+        assertEquals(black, data[0] & 0xffffff);
+    }
+
+    public void runTests() {
+        declare("testSamePixels");
+        testSamePixels();
+        declare("testFlushedOnRestore");
+        testFlushedOnRestore();
+    }
+}
@@ -85,7 +85,7 @@ extern void fast_rect_8x8(void*first_pixel, int ypitch, int pixel);
  * <p>
  * Java declaration:
  * <pre>
- *     drawLine(IIII)V
+ *     drawLine0(IIII)V
  * </pre>
  *
  * @param x1 The x coordinate of the start of the line
@@ -94,7 +94,7 @@ extern void fast_rect_8x8(void*first_pixel, int ypitch, int pixel);
  * @param y2 The y coordinate of the end of the line
  */
 KNIEXPORT KNI_RETURNTYPE_VOID
-KNIDECL(javax_microedition_lcdui_Graphics_drawLine) {
+KNIDECL(javax_microedition_lcdui_Graphics_drawLine0) {
     int y2 = KNI_GetParameterAsInt(4);
     int x2 = KNI_GetParameterAsInt(3);
     int y1 = KNI_GetParameterAsInt(2);
@@ -132,7 +132,7 @@ KNIDECL(javax_microedition_lcdui_Graphics_drawLine) {
  * <p>
  * Java declaration:
  * <pre>
- *     drawRect(IIII)V
+ *     drawRect0(IIII)V
  * </pre>
  *
  * @param x The x coordinate of the rectangle to be drawn
@@ -141,7 +141,7 @@ KNIDECL(javax_microedition_lcdui_Graphics_drawLine) {
  * @param height The height of the rectangle to be drawn
  */
 KNIEXPORT KNI_RETURNTYPE_VOID
-KNIDECL(javax_microedition_lcdui_Graphics_drawRect) {
+KNIDECL(javax_microedition_lcdui_Graphics_drawRect0) {
     int h = KNI_GetParameterAsInt(4);
     int w = KNI_GetParameterAsInt(3);
     int y = KNI_GetParameterAsInt(2);
@@ -185,7 +185,7 @@ KNIDECL(javax_microedition_lcdui_Graphics_drawRect) {
  * <p>
  * Java declaration:
  * <pre>
- *     fillRect(IIII)V
+ *     fillRect0(IIII)V
  * </pre>
  *
  * @param x The x coordinate of the rectangle to be drawn
@@ -194,7 +194,7 @@ KNIDECL(javax_microedition_lcdui_Graphics_drawRect) {
  * @param height The height of the rectangle to be drawn
  */
 KNIEXPORT KNI_RETURNTYPE_VOID
-KNIDECL(javax_microedition_lcdui_Graphics_fillRect) {
+KNIDECL(javax_microedition_lcdui_Graphics_fillRect0) {
     int h = KNI_GetParameterAsInt(4);
     int w = KNI_GetParameterAsInt(3);
     int y = KNI_GetParameterAsInt(2);
@@ -238,7 +238,7 @@ KNIDECL(javax_microedition_lcdui_Graphics_fillRect) {
  * <p>
  * Java declaration:
  * <pre>
- *     drawRoundRect(IIIIII)V
+ *     drawRoundRect0(IIIIII)V
  * </pre>
  *
  * @param x The x coordinate of the rectangle to be drawn
@@ -249,7 +249,7 @@ KNIDECL(javax_microedition_lcdui_Graphics_fillRect) {
  * @param arcHeight The vertical diameter of the arc at the four corners
  */
 KNIEXPORT KNI_RETURNTYPE_VOID
-KNIDECL(javax_microedition_lcdui_Graphics_drawRoundRect) {
+KNIDECL(javax_microedition_lcdui_Graphics_drawRoundRect0) {
     int arcHeight = KNI_GetParameterAsInt(6);
     int  arcWidth = KNI_GetParameterAsInt(5);
     int         h = KNI_GetParameterAsInt(4);
@@ -294,7 +294,7 @@ KNIDECL(javax_microedition_lcdui_Graphics_drawRoundRect) {
  * <p>
  * Java declaration:
  * <pre>
- *     fillRoundRect(IIIIII)V
+ *     fillRoundRect0(IIIIII)V
  * </pre>
  *
  * @param x The x coordinate of the rectangle to be drawn
@@ -305,7 +305,7 @@ KNIDECL(javax_microedition_lcdui_Graphics_drawRoundRect) {
  * @param arcHeight The vertical diameter of the arc at the four corners
  */
 KNIEXPORT KNI_RETURNTYPE_VOID
-KNIDECL(javax_microedition_lcdui_Graphics_fillRoundRect) {
+KNIDECL(javax_microedition_lcdui_Graphics_fillRoundRect0) {
     int arcHeight = KNI_GetParameterAsInt(6);
     int  arcWidth = KNI_GetParameterAsInt(5);
     int         h = KNI_GetParameterAsInt(4);
@@ -351,7 +351,7 @@ KNIDECL(javax_microedition_lcdui_Graphics_fillRoundRect) {
  * <p>
  * Java declaration:
  * <pre>
- *     drawArc(IIIIII)V
+ *     drawArc0(IIIIII)V
  * </pre>
  *
  * @param x The x coordinate of the upper-left corner of the arc
@@ -365,7 +365,7 @@ KNIDECL(javax_microedition_lcdui_Graphics_fillRoundRect) {
  *                 <tt>startAngle</tt>
  */
 KNIEXPORT KNI_RETURNTYPE_VOID
-KNIDECL(javax_microedition_lcdui_Graphics_drawArc) {
+KNIDECL(javax_microedition_lcdui_Graphics_drawArc0) {
     int   arcAngle = KNI_GetParameterAsInt(6);
     int startAngle = KNI_GetParameterAsInt(5);
     int          h = KNI_GetParameterAsInt(4);
@@ -426,7 +426,7 @@ KNIDECL(javax_microedition_lcdui_Graphics_drawArc) {
  * <p>
  * Java declaration:
  * <pre>
- *     fillArc(IIIIII)V
+ *     fillArc0(IIIIII)V
  * </pre>
  *
  * @param x The x coordinate of the upper-left corner of the arc
@@ -440,7 +440,7 @@ KNIDECL(javax_microedition_lcdui_Graphics_drawArc) {
  *                 <tt>startAngle</tt>
  */
 KNIEXPORT KNI_RETURNTYPE_VOID
-KNIDECL(javax_microedition_lcdui_Graphics_fillArc) {
+KNIDECL(javax_microedition_lcdui_Graphics_fillArc0) {
     int   arcAngle = KNI_GetParameterAsInt(6);
     int startAngle = KNI_GetParameterAsInt(5);
     int          h = KNI_GetParameterAsInt(4);
@@ -493,7 +493,7 @@ KNIDECL(javax_microedition_lcdui_Graphics_fillArc) {
  * <p>
  * Java declaration:
  * <pre>
- *     fillTriangle(IIIIII)V
+ *     fillTriangle0(IIIIII)V
  * </pre>
  *
  * @param x1 The x coordinate of the first vertices
@@ -504,7 +504,7 @@ KNIDECL(javax_microedition_lcdui_Graphics_fillArc) {
  * @param y3 The y coordinate of the third vertices
  */
 KNIEXPORT KNI_RETURNTYPE_VOID
-KNIDECL(javax_microedition_lcdui_Graphics_fillTriangle) {
+KNIDECL(javax_microedition_lcdui_Graphics_fillTriangle0) {
     int         y3 = KNI_GetParameterAsInt(6);
     int         x3 = KNI_GetParameterAsInt(5);
     int         y2 = KNI_GetParameterAsInt(4);
@@ -537,12 +537,136 @@ KNIDECL(javax_microedition_lcdui_Graphics_fillTriangle) {
     KNI_ReturnVoid();
 }
 
+/**
+ * Draws the shape primitives recorded by a batching <tt>Graphics</tt>
+ * object. The destination is looked up, and checked to be drawable,
+ * once for the whole buffer; the pixel, stroke style and clip come from
+ * the <tt>GXAPI_CMD_STATE</tt> commands recorded among the primitives.
+ * <p>
+ * Java declaration:
+ * <pre>
+ *     executeCommands([II)V
+ * </pre>
+ *
+ * @param commands The recorded commands
+ * @param length The number of ints used in <tt>commands</tt>
+ */
+KNIEXPORT KNI_RETURNTYPE_VOID
+KNIDECL(javax_microedition_lcdui_Graphics_executeCommands) {
+    int length = KNI_GetParameterAsInt(2);
+
+    KNI_StartHandles(2);
+    KNI_DeclareHandle(commands);
+    KNI_DeclareHandle(thisObject);
+
+    KNI_GetParameterAsObject(1, commands);
+    KNI_GetThisPointer(thisObject);
+
+    if (GRAPHICS_OP_IS_ALLOWED(thisObject)) {
+        const java_imagedata *dst =
+            GET_IMAGEDATA_PTR_FROM_GRAPHICS(thisObject);
+        jint *cmd = JavaIntArray(commands);
+        jint *end = cmd + length;
+        jshort clip[4] = {0, 0, 0, 0};
+        jint pixel = 0;
+        int style = SOLID;
+
+        while (cmd < end) {
+            switch (cmd[0]) {
+            case GXAPI_CMD_STATE:
+                pixel   = cmd[1];
+                style   = cmd[2];
+                clip[0] = (jshort)cmd[3];
+                clip[1] = (jshort)cmd[4];
+                clip[2] = (jshort)cmd[5];
+                clip[3] = (jshort)cmd[6];
+                cmd += 7;
+                break;
+
+            case GXAPI_CMD_LINE:
+                gx_draw_line(pixel, clip, dst, style,
+                             cmd[1], cmd[2], cmd[3], cmd[4]);
+                cmd += 5;
+                break;
+
+            case GXAPI_CMD_RECT:
+                gx_draw_rect(pixel, clip, dst, style,
+                             cmd[1], cmd[2], cmd[3], cmd[4]);
+                cmd += 5;
+                break;
+
+            case GXAPI_CMD_FILL_RECT:
+                gx_fill_rect(pixel, clip, dst, style,
+                             cmd[1], cmd[2], cmd[3], cmd[4]);
+                cmd += 5;
+                break;
+
+            case GXAPI_CMD_ROUND_RECT:
+                gx_draw_roundrect(pixel, clip, dst, style,
+                                  cmd[1], cmd[2], cmd[3], cmd[4],
+                                  cmd[5], cmd[6]);
+                cmd += 7;
+                break;
+
+            case GXAPI_CMD_FILL_ROUND_RECT:
+                gx_fill_roundrect(pixel, clip, dst, style,
+                                  cmd[1], cmd[2], cmd[3], cmd[4],
+                                  cmd[5], cmd[6]);
+                cmd += 7;
+                break;
+
+            case GXAPI_CMD_ARC:
+            case GXAPI_CMD_FILL_ARC: {
+                int startAngle = cmd[5];
+                int   arcAngle = cmd[6];
+
+#ifdef PLATFORM_SUPPORT_CCW_ARC_ONLY
+                /* Please see drawArc0 for explanation */
+                if (arcAngle < 0) {
+                    startAngle += arcAngle;
+                    arcAngle = -arcAngle;
+                }
+                startAngle = (startAngle + 360) % 360;
+#endif
+
+                if (cmd[0] == GXAPI_CMD_ARC) {
+                    gx_draw_arc(pixel, clip, dst, style,
+                                cmd[1], cmd[2], cmd[3], cmd[4],
+                                startAngle, arcAngle);
+                } else {
+                    gx_fill_arc(pixel, clip, dst, style,
+                                cmd[1], cmd[2], cmd[3], cmd[4],
+                                startAngle, arcAngle);
+                }
+                cmd += 7;
+                break;
+            }
+
+            case GXAPI_CMD_FILL_TRIANGLE:
+                gx_fill_triangle(pixel, clip, dst, style,
+                                 cmd[1], cmd[2], cmd[3], cmd[4],
+                                 cmd[5], cmd[6]);
+                cmd += 7;
+                break;
+
+            default:
+                /* The rest of the buffer cannot be parsed */
+                cmd = end;
+                break;
+            }
+        }
+    }
+
+    KNI_EndHandles();
+    KNI_ReturnVoid();
+}
+
 /**
  * Draws the specified <tt>String</tt> using the current font and color.
  * <p>
  * Java declaration:
  * <pre>
- *     drawString(Ljava/lang/String;III)V
+ *     drawString0(Ljava/lang/String;III)V
  * </pre>
  *
  * @param str The <tt>String</tt> to be drawn
@@ -551,7 +675,7 @@ KNIDECL(javax_microedition_lcdui_Graphics_fillTriangle) {
  * @param anchor The anchor point for positioning the text
  */
 KNIEXPORT KNI_RETURNTYPE_VOID
-KNIDECL(javax_microedition_lcdui_Graphics_drawString) {
+KNIDECL(javax_microedition_lcdui_Graphics_drawString0) {
     int anchor = KNI_GetParameterAsInt(4);
     int      y = KNI_GetParameterAsInt(3);
     int      x = KNI_GetParameterAsInt(2);
@@ -607,7 +731,7 @@ KNIDECL(javax_microedition_lcdui_Graphics_drawString) {
  * <p>
  * Java declaration:
  * <pre>
- *     drawSubstring(Ljava/lang/String;III)V
+ *     drawSubstring0(Ljava/lang/String;III)V
  * </pre>
  *
  * @param str The <tt>String</tt> to be drawn
@@ -618,7 +742,7 @@ KNIDECL(javax_microedition_lcdui_Graphics_drawString) {
  * @param anchor The anchor point for positioning the text
  */
 KNIEXPORT KNI_RETURNTYPE_VOID
-KNIDECL(javax_microedition_lcdui_Graphics_drawSubstring) {
+KNIDECL(javax_microedition_lcdui_Graphics_drawSubstring0) {
     int anchor = KNI_GetParameterAsInt(6);
     int      y = KNI_GetParameterAsInt(5);
     int      x = KNI_GetParameterAsInt(4);
@@ -683,7 +807,7 @@ KNIDECL(javax_microedition_lcdui_Graphics_drawSubstring) {
  * <p>
  * Java declaration:
  * <pre>
- *     drawChar(CIII)V
+ *     drawChar0(CIII)V
  * </pre>
  *
  * @param ch The character to be drawn
@@ -692,7 +816,7 @@ KNIDECL(javax_microedition_lcdui_Graphics_drawSubstring) {
  * @param anchor The anchor point for positioning the text
  */
 KNIEXPORT KNI_RETURNTYPE_VOID
-KNIDECL(javax_microedition_lcdui_Graphics_drawChar) {
+KNIDECL(javax_microedition_lcdui_Graphics_drawChar0) {
     int anchor = KNI_GetParameterAsInt(4);
     int      y = KNI_GetParameterAsInt(3);
     int      x = KNI_GetParameterAsInt(2);
@@ -736,7 +860,7 @@ KNIDECL(javax_microedition_lcdui_Graphics_drawChar) {
  * <p>
  * Java declaration:
  * <pre>
- *     drawChars([CIIIII)V
+ *     drawChars0([CIIIII)V
  * </pre>
  *
  * @param data The array of characters to be drawn
@@ -747,7 +871,7 @@ KNIDECL(javax_microedition_lcdui_Graphics_drawChar) {
  * @param anchor The anchor point for positioning the text
  */
 KNIEXPORT KNI_RETURNTYPE_VOID
-KNIDECL(javax_microedition_lcdui_Graphics_drawChars) {
+KNIDECL(javax_microedition_lcdui_Graphics_drawChars0) {
     int anchor = KNI_GetParameterAsInt(6);
     int      y = KNI_GetParameterAsInt(5);
     int      x = KNI_GetParameterAsInt(4);
@@ -809,7 +933,7 @@ KNIDECL(javax_microedition_lcdui_Graphics_drawChars) {
  * <p>
  * Java declaration:
  * <pre>
- *     drawRGB([IIIIIIIZ)V
+ *     drawRGB0([IIIIIIIZ)V
  * </pre>
  *
  * @param rgbData The array of argb pixels to draw
@@ -827,7 +951,7 @@ KNIDECL(javax_microedition_lcdui_Graphics_drawChars) {
  *                     be ignored
  */
 KNIEXPORT KNI_RETURNTYPE_VOID
-KNIDECL(javax_microedition_lcdui_Graphics_drawRGB) {
+KNIDECL(javax_microedition_lcdui_Graphics_drawRGB0) {
     jboolean processAlpha = KNI_GetParameterAsBoolean(8);
     jint height = KNI_GetParameterAsInt(7);
     jint width = KNI_GetParameterAsInt(6);
@@ -117,6 +117,32 @@ typedef struct Java_java_lang_String _JavaString;
 #define GRAPHICS_OP_IS_ALLOWED(G) 1
 #endif
 
+/**
+ * @name Opcodes of the commands recorded by a batching Graphics object
+ * They must match the <tt>CMD_*</tt> values in Graphics.java. Every
+ * command starts with its opcode; coordinates are already translated.
+ * @{
+ */
+/** Sets pixel, stroke style, clipX1, clipY1, clipX2 and clipY2 */
+#define GXAPI_CMD_STATE             0
+/** Draws a line: x1, y1, x2, y2 */
+#define GXAPI_CMD_LINE              1
+/** Draws a rectangle: x, y, width, height */
+#define GXAPI_CMD_RECT              2
+/** Fills a rectangle: x, y, width, height */
+#define GXAPI_CMD_FILL_RECT         3
+/** Draws a round rectangle: x, y, width, height, arcWidth, arcHeight */
+#define GXAPI_CMD_ROUND_RECT        4
+/** Fills a round rectangle: x, y, width, height, arcWidth, arcHeight */
+#define GXAPI_CMD_FILL_ROUND_RECT   5
+/** Draws an arc: x, y, width, height, startAngle, arcAngle */
+#define GXAPI_CMD_ARC               6
+/** Fills an arc: x, y, width, height, startAngle, arcAngle */
+#define GXAPI_CMD_FILL_ARC          7
+/** Fills a triangle: x1, y1, x2, y2, x3, y3 */
+#define GXAPI_CMD_FILL_TRIANGLE     8
+/** @} */
+
 /**
  * Checks that the anchor is set correctly.
  *
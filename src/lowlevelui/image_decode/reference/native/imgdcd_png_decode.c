@@ -27,7 +27,7 @@
 #include <string.h>
 
 #include <jar.h>
-#include <pcsl_memory.h>
+#include <midpArena.h>
 #include <midp_logging.h>
 
 #include "imgdcd_intern_image_decode.h"
@@ -44,7 +44,13 @@
 #define CT_COLOR    0x02
 #define CT_ALPHA    0x04
 
-#define freeBytes(p) pcsl_mem_free((p))
+#define freeBytes(p) midpTaggedFree((p))
+
+/*
+ * Size of the chunks of the arena the palette and transparency tables
+ * of a decoded image are taken from; both fit into one chunk.
+ */
+#define PNG_ARENA_CHUNK_SIZE 4096
 
 typedef struct _pngData {
       signed int   width;
@@ -163,13 +169,13 @@ static int PNGdecodeImage_seek(void* p, long offset, int whence) {
 /* returns a memory handle, call addrFromHandle to use */
 static void* allocFunction(void* state, int n) {
     (void)state;
-    return pcsl_mem_malloc(n);
+    return midpTaggedMalloc(n, MIDP_MEM_TAG_IMAGE);
 }
 
 /* handle, is a memory handle */
 static void freeFunction(void* state, void* handle) {
     (void)state;
-    pcsl_mem_free(handle);
+    midpTaggedFree(handle);
 }
 
 /* This function is to support heaps that compact memory. */
@@ -407,7 +413,8 @@ PNGdecodeImage_real(imageSrcPtr src, imageDstPtr dst,
 
             src->seek(src, startPos);    /* reset to the first IDAT_CHUNK */
 
-            decompBuf = (unsigned char*)pcsl_mem_malloc(decompLen);
+            decompBuf = (unsigned char*)midpTaggedMalloc(decompLen,
+                                                         MIDP_MEM_TAG_IMAGE);
             if (decompBuf == NULL) {
                 OK = FALSE;
 		goto done;
@@ -478,27 +485,22 @@ PNGdecodeImage_real(imageSrcPtr src, imageDstPtr dst,
 
 bool
 decode_png_image(imageSrcPtr src, imageDstPtr dst) {
+    MidpArena arena;
     long * paletteData;
     unsigned char * transData;
+    bool retval = FALSE;
 
-    paletteData = pcsl_mem_malloc(sizeof(long) * 256);
-    if (paletteData == NULL) {
-	/* out of memory */
-	return FALSE;
-    } else {
-	transData = pcsl_mem_malloc(sizeof(unsigned char) * 256);
-	if (transData == NULL) {
-	    /* out of memory */
-	    pcsl_mem_free(paletteData);
-	    return FALSE;
-	} else {
-	    bool retval = PNGdecodeImage_real(src, dst, 
-						  paletteData, transData);
-	    pcsl_mem_free(paletteData);
-	    pcsl_mem_free(transData);
-	    return retval;
-	}
+    /* The tables live as long as the decoding, release them at once */
+    midpArenaInit(&arena, MIDP_MEM_TAG_IMAGE, PNG_ARENA_CHUNK_SIZE, -1);
+
+    paletteData = midpArenaAlloc(&arena, sizeof(long) * 256);
+    transData = midpArenaAlloc(&arena, sizeof(unsigned char) * 256);
+    if (paletteData != NULL && transData != NULL) {
+	retval = PNGdecodeImage_real(src, dst, paletteData, transData);
     }
+
+    midpArenaDestroy(&arena);
+    return retval;
 }
 
 
@@ -1505,7 +1507,8 @@ handleImageData(unsigned char *pixels, int pixelsLength,
     filterAllRows(pixels, data);
 
     if (data->interlace) {
-        scanline = (unsigned char *) pcsl_mem_malloc(data->width * pixelSize);
+        scanline = (unsigned char *)midpTaggedMalloc(
+            data->width * pixelSize, MIDP_MEM_TAG_IMAGE);
         if (scanline == NULL) {
             return FALSE;
         }
@@ -1524,7 +1527,8 @@ handleImageData(unsigned char *pixels, int pixelsLength,
          i.e. 8 bit Palette or 8 bit RGB/gs without transparency*/
         sendDirect = TRUE;
     } else if (scanline == NULL) {
-        scanline = (unsigned char *) pcsl_mem_malloc(data->width * pixelSize);
+        scanline = (unsigned char *)midpTaggedMalloc(
+            data->width * pixelSize, MIDP_MEM_TAG_IMAGE);
         if (scanline == NULL) {
             return FALSE;
         }
@@ -1575,7 +1579,7 @@ handleImageData(unsigned char *pixels, int pixelsLength,
     }
 
     if (scanline != NULL) {
-        pcsl_mem_free(scanline);
+        midpTaggedFree(scanline);
     }
 
     return TRUE;
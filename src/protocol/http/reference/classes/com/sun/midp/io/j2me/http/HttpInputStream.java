@@ -0,0 +1,429 @@
+/*
+ *   
+ *
+ * Copyright  1990-2007 Sun Microsystems, Inc. All Rights Reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 only, as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details (a copy is
+ * included at /legal/license.txt).
+ * 
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this work; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ * 
+ * Please contact Sun Microsystems, Inc., 4150 Network Circle, Santa
+ * Clara, CA 95054 or visit www.sun.com if you need additional
+ * information or have any questions.
+ */
+
+package com.sun.midp.io.j2me.http;
+
+import java.io.IOException;
+import java.io.InputStream;
+
+/**
+ * Buffered input stream of an HTTP connection. Status lines, header
+ * lines and chunk size lines are scanned inside a reusable byte window,
+ * so parsing a response header takes a few reads from the socket
+ * instead of one read per byte.
+ * <p>
+ * The window belongs to the connection, not to a single request: bytes
+ * read beyond the end of a response stay here for the next response
+ * when the connection is kept in the persistent connection pool.
+ * <p>
+ * The window starts at the configured input buffer size and doubles
+ * when a line does not fit in it, or when the data keeps arriving
+ * faster than the window can hold it.
+ */
+class HttpInputStream extends InputStream {
+    /** Smallest window, enough for a typical status line. */
+    private static final int MIN_BUFFER_SIZE = 128;
+    /** The window only grows beyond this size to hold a long line. */
+    private static final int MAX_BUFFER_SIZE = 8192;
+    /** Number of reads filling the whole window before it grows. */
+    private static final int GROW_AFTER_FULL_READS = 2;
+
+    /** Underlying stream of the connection. */
+    private InputStream in;
+    /** Byte window. */
+    private byte[] buf;
+    /** Index of the next byte to return from the window. */
+    private int pos;
+    /** Index after the last valid byte in the window. */
+    private int count;
+    /** Number of consecutive reads that filled the window. */
+    private int fullReads;
+    /** Reusable characters of the line being converted to a string. */
+    private char[] lineChars;
+
+    /**
+     * Create a buffered stream.
+     *
+     * @param in underlying stream of the connection
+     * @param size initial size of the window
+     */
+    HttpInputStream(InputStream in, int size) {
+        this.in = in;
+
+        if (size < MIN_BUFFER_SIZE) {
+            size = MIN_BUFFER_SIZE;
+        }
+
+        buf = new byte[size];
+    }
+
+    /**
+     * Reads the next byte of data.
+     *
+     * @return the next byte or <code>-1</code> at the end of the stream
+     * @exception IOException if an I/O error occurs
+     */
+    public int read() throws IOException {
+        if (pos >= count && fill() < 0) {
+            return -1;
+        }
+
+        return buf[pos++] & 0xff;
+    }
+
+    /**
+     * Reads up to <code>len</code> bytes of data. Buffered data is
+     * returned first; a large read with an empty window goes directly
+     * to the underlying stream.
+     *
+     * @param      b     the buffer into which the data is read.
+     * @param      off   the start offset in array <code>b</code>
+     *                   at which the data is written.
+     * @param      len   the maximum number of bytes to read.
+     * @return     the total number of bytes read into the buffer, or
+     *             <code>-1</code> if there is no more data because the end of
+     *             the stream has been reached.
+     * @exception  IOException  if an I/O error occurs.
+     */
+    public int read(byte b[], int off, int len) throws IOException {
+        int avail;
+
+        if (len <= 0) {
+            return 0;
+        }
+
+        avail = count - pos;
+        if (avail <= 0) {
+            if (len >= buf.length) {
+                // No need to buffer, if the caller has given a big buffer.
+                return in.read(b, off, len);
+            }
+
+            if (fill() < 0) {
+                return -1;
+            }
+
+            avail = count - pos;
+        }
+
+        if (len > avail) {
+            len = avail;
+        }
+
+        System.arraycopy(buf, pos, b, off, len);
+        pos += len;
+        return len;
+    }
+
+    /**
+     * Returns the number of bytes that can be read without blocking.
+     *
+     * @return buffered bytes plus the bytes available in the
+     *         underlying stream
+     * @exception IOException if an I/O error occurs
+     */
+    public int available() throws IOException {
+        return (count - pos) + in.available();
+    }
+
+    /**
+     * Closes the underlying stream.
+     *
+     * @exception IOException if an I/O error occurs
+     */
+    public void close() throws IOException {
+        pos = count = 0;
+        in.close();
+    }
+
+    /**
+     * Reads a line terminated by LF, CR characters are dropped.
+     * Blocks until the line is done or end of stream.
+     *
+     * @return one line of input without the terminator or null if
+     *         the stream ended first
+     * @exception IOException if an I/O error occurs
+     */
+    String readLine() throws IOException {
+        int lf = findLineEnd();
+        int n = 0;
+
+        if (lf < 0) {
+            return null;
+        }
+
+        if (lineChars == null || lineChars.length < lf - pos) {
+            lineChars = new char[buf.length];
+        }
+
+        for (int i = pos; i < lf; i++) {
+            if (buf[i] != '\r') {
+                lineChars[n++] = (char)(buf[i] & 0xff);
+            }
+        }
+
+        pos = lf + 1;
+        return new String(lineChars, 0, n);
+    }
+
+    /**
+     * Reads a chunk size line: a hex length followed by optional
+     * extensions (ignored) and terminated with CRLF.
+     * Blocks until the line is done.
+     *
+     * @return size of the chunk
+     * @exception IOException if the stream ended or the size is not
+     *            a hex number
+     */
+    int readChunkSize() throws IOException {
+        int lf = findLineEnd();
+        int size;
+
+        if (lf < 0) {
+            throw new IOException("No Chunk Size");
+        }
+
+        size = parseChunkSize(pos, lf);
+        pos = lf + 1;
+        return size;
+    }
+
+    /**
+     * Reads the CRLF of the chunk that ends the previous chunk and
+     * the size line of the next chunk, only if they are completely
+     * available without blocking. Nothing is consumed otherwise.
+     *
+     * @return size of the next chunk or -1 if the size line has not
+     *         been received yet
+     * @exception IOException if the size is not a hex number
+     */
+    int readChunkSizeNonBlocking() throws IOException {
+        int start;
+        int lf;
+        int size;
+
+        fillAvailable();
+
+        start = pos;
+        if (start < count && buf[start] == '\r') {
+            start++;
+        }
+
+        if (start < count && buf[start] == '\n') {
+            start++;
+        }
+
+        lf = indexOfLF(start);
+        if (lf < 0) {
+            return -1;
+        }
+
+        size = parseChunkSize(start, lf);
+        pos = lf + 1;
+        return size;
+    }
+
+    /**
+     * Skips the CRLF at the end of chunk data. Does nothing if the
+     * next byte is not CR or LF, so the size line of the next chunk
+     * is left for {@link #readChunkSize}.
+     *
+     * @exception IOException if the LF half of the ending CRLF
+     * is missing.
+     */
+    void skipEndOfChunkCRLF() throws IOException {
+        if (pos >= count && fill() < 0) {
+            return;
+        }
+
+        if (buf[pos] == '\r') {
+            pos++;
+
+            if ((pos >= count && fill() < 0) || buf[pos] != '\n') {
+                throw new IOException("missing the LF of an expected CRLF");
+            }
+        } else if (buf[pos] != '\n') {
+            return;
+        }
+
+        pos++;
+    }
+
+    /**
+     * Makes sure a whole line is in the window, reading as needed.
+     *
+     * @return index of the LF ending the line or -1 at end of stream
+     * @exception IOException if an I/O error occurs
+     */
+    private int findLineEnd() throws IOException {
+        int scanned = 0;
+
+        for (;;) {
+            int lf = indexOfLF(pos + scanned);
+
+            if (lf >= 0) {
+                return lf;
+            }
+
+            // the window may be compacted by fill, so count from pos
+            scanned = count - pos;
+
+            if (fill() < 0) {
+                // drop a partial line
+                pos = count;
+                return -1;
+            }
+        }
+    }
+
+    /**
+     * Finds the next LF in the window.
+     *
+     * @param from index to start the search at
+     *
+     * @return index of the LF or -1 if there is none
+     */
+    private int indexOfLF(int from) {
+        for (int i = from; i < count; i++) {
+            if (buf[i] == '\n') {
+                return i;
+            }
+        }
+
+        return -1;
+    }
+
+    /**
+     * Parses the hex size at the start of a chunk size line.
+     *
+     * @param start index of the first character of the line
+     * @param end index of the LF ending the line
+     *
+     * @return chunk size
+     * @exception IOException if there is no hex number or it is too big
+     */
+    private int parseChunkSize(int start, int end) throws IOException {
+        int size = 0;
+        int i;
+
+        for (i = start; i < end; i++) {
+            int digit = Character.digit((char)(buf[i] & 0xff), 16);
+
+            if (digit < 0) {
+                break;
+            }
+
+            if (size > (Integer.MAX_VALUE >> 4)) {
+                throw new IOException("chunk size too large");
+            }
+
+            size = (size << 4) + digit;
+        }
+
+        if (i == start) {
+            throw new IOException("invalid chunk size number format");
+        }
+
+        return size;
+    }
+
+    /**
+     * Moves the unread bytes to the start of the window and
+     * makes room for more, growing the window if needed.
+     */
+    private void compact() {
+        int unread = count - pos;
+
+        if (pos > 0) {
+            System.arraycopy(buf, pos, buf, 0, unread);
+            pos = 0;
+            count = unread;
+        }
+
+        if (count == buf.length || (fullReads >= GROW_AFTER_FULL_READS &&
+                buf.length < MAX_BUFFER_SIZE)) {
+            byte[] newBuf = new byte[buf.length * 2];
+
+            System.arraycopy(buf, 0, newBuf, 0, count);
+            buf = newBuf;
+            fullReads = 0;
+        }
+    }
+
+    /**
+     * Reads more data into the window, blocking until some data
+     * is received.
+     *
+     * @return the number of bytes read or -1 at the end of stream
+     * @exception IOException if an I/O error occurs
+     */
+    private int fill() throws IOException {
+        int room;
+        int n;
+
+        compact();
+
+        room = buf.length - count;
+        n = in.read(buf, count, room);
+        if (n <= 0) {
+            return -1;
+        }
+
+        if (n == room) {
+            fullReads++;
+        } else {
+            fullReads = 0;
+        }
+
+        count += n;
+        return n;
+    }
+
+    /**
+     * Reads the data that is available without blocking into
+     * the window.
+     *
+     * @exception IOException if an I/O error occurs
+     */
+    private void fillAvailable() throws IOException {
+        int n = in.available();
+
+        if (n <= 0) {
+            return;
+        }
+
+        compact();
+
+        if (n > buf.length - count) {
+            n = buf.length - count;
+        }
+
+        n = in.read(buf, count, n);
+        if (n > 0) {
+            count += n;
+        }
+    }
+}
@@ -133,6 +133,11 @@ public class Protocol extends ConnectionBaseAdapter
     protected static StreamConnectionPool connectionPool; 
     /** True if com.sun.midp.io.http.force_non_persistent = true. */
     private static boolean nonPersistentFlag;
+    /**
+     * Maximum number of requests sent on a persistent connection before
+     * their responses are read, 1 disables pipelining.
+     */
+    private static int maxPipelinedRequests = 1;
     /**
      * The methods other than openPrim need to know that the
      * permission occurred. com.sun.midp.io.j2me.https.Protocol
@@ -187,13 +192,26 @@ public class Protocol extends ConnectionBaseAdapter
                 "com.sun.midp.io.http.persistent_connection_linger_time",
                 (int)connectionLingerTime);
 
+        /*
+         * Pipelining is off by default, since some servers and proxies
+         * do not handle it correctly. Only idempotent requests are
+         * pipelined.
+         */
+        flag = Configuration.getProperty("com.sun.midp.io.http.pipelining");
+        if ((flag != null) && (flag.equals("true"))) {
+            maxPipelinedRequests = Configuration.getPositiveIntProperty(
+                "com.sun.midp.io.http.max_pipelined_requests", 4);
+        }
+
         connectionPool = new StreamConnectionPool(
                                  maxNumberOfPersistentConnections,
-                                 connectionLingerTime);
+                                 connectionLingerTime,
+                                 maxPipelinedRequests);
 
         /*
          * Get the buffer sizes from the configuration file.
-         * 0 for the input buffer size shuts off input buffering.
+         * The input buffer size is the initial size of the connection
+         * input buffer, it grows as needed.
          * Output buffer must always be positive.
          */
         inputBufferSize = Configuration.getNonNegativeIntProperty(
@@ -245,6 +263,11 @@ public class Protocol extends ConnectionBaseAdapter
     protected DataOutputStream streamOutput;
     /** Low level socket input stream. */
     protected DataInputStream streamInput;
+    /**
+     * Buffered connection input under streamInput, used to parse the
+     * response headers and chunk sizes.
+     */
+    private HttpInputStream httpInput;
     /** A shared temporary header buffer. */
     private StringBuffer stringbuffer;
     /** HTTP version string set with all incoming HTTP responses. */
@@ -275,12 +298,6 @@ public class Protocol extends ConnectionBaseAdapter
     private boolean requestFinished;
     /** True if eof seen. */
     private boolean eof;           
-    /** Internal stream buffer to minimize the number of TCP socket reads. */
-    private byte[] readbuf;         
-    /** Number of bytes left in internal input stream buffer. */
-    private int bytesleft;
-    /** Number of bytes read from the internal input stream buffer. */ 
-    private int bytesread;     
     /** Buffered data output for content length calculation. */
     private byte[] writebuf;         
     /** Number of bytes of data that need to be written from the buffer. */
@@ -314,8 +331,6 @@ public class Protocol extends ConnectionBaseAdapter
         if (nonPersistentFlag) {
             ConnectionCloseFlag = true;
         }
-
-        readbuf = new byte[inputBufferSize];
     }
 
     /**
@@ -541,44 +556,19 @@ public class Protocol extends ConnectionBaseAdapter
             }
 
             /*
-             * Non-chunked unknown length
+             * Non-chunked unknown length, the connection input stream
+             * does the buffering
              */
-
-            if (bytesleft == 0) {
+            rc = httpInput.read(b, off, len);
+            if (rc == -1) {
                 /*
-                 * the internal input stream buffer is empty, read from the
-                 * stream
+                 * The next call to this method should not read.
                  */
-                if (len >= inputBufferSize) {
-                    /*
-                     * No need to buffer, if the caller has given a big buffer.
-                     */
-                    rc = streamInput.read(b, off, len);
-                } else {
-                    rc = streamInput.read(readbuf, 0, inputBufferSize);
-                    bytesleft = rc;
-                    bytesread = 0;
-                }
-
-                if (rc == -1) {
-                    /*
-                     * The next call to this method should not read.
-                     */
-                    eof = true;
-                    return -1;
-                }
-
-                totalbytesread += rc;
-
-                if (bytesleft == 0) {
-                    /*
-                     * The data was read directly into the caller's buffer.
-                     */
-                    return rc;
-                }
+                eof = true;
+                return -1;
             }
 
-            rc = readFromBuffer(b, off, len);
+            totalbytesread += rc;
             return rc;
         } finally {
             synchronized (streamInput) {
@@ -587,43 +577,6 @@ public class Protocol extends ConnectionBaseAdapter
         }
     }
     
-    /**
-     * Reads up to <code>len</code> bytes of data from the internal buffer into
-     * an array of bytes.
-     *
-     * @param      b     the buffer into which the data is read.
-     * @param      off   the start offset in array <code>b</code>
-     *                   at which the data is written.
-     * @param      len   the maximum number of bytes to read.
-     * @return     the total number of bytes read into the buffer, or
-     *             <code>-1</code> if there is no more data because the end of
-     *             the stream has been reached.
-     * @exception  IOException  if an I/O error occurs.
-     */
-    private int readFromBuffer(byte b[], int off, int len)
-        throws IOException {
-        
-        /*
-         * copy http buffer data into user buffer, then
-         * increment and decrement counters
-         */
-        
-        int rc;
-
-        if (len > bytesleft) {
-            rc = bytesleft;
-        } else {
-            rc = len;            
-        }
-
-        System.arraycopy(readbuf, bytesread, b, off, rc);
-
-        bytesleft -= rc;
-        bytesread += rc;
-        
-        return rc;
-    }
-
     /**
      * Returns the number of bytes that can be read (or skipped over) from
      * this input stream without blocking by the next caller of a method for
@@ -645,15 +598,6 @@ public class Protocol extends ConnectionBaseAdapter
             return 0;
         }
 
-        /*
-         * Regardless of chunked or non-chunked transfers -
-         * if data is already buffered return the amount 
-         * buffered.
-         */
-        if (bytesleft > 0) { 
-            return bytesleft; 
-        }
-                
         if (chunkedIn && totalbytesread == chunksize) { 
             /* 
              * Check if a new chunk size header is available.
@@ -662,12 +606,13 @@ public class Protocol extends ConnectionBaseAdapter
         } 
 
         /*
-         * Otherwise rely on the lower level stream available
-         * count for the nonchunked input stream.
+         * Otherwise rely on the connection input stream available
+         * count (buffered and received data) for the nonchunked
+         * input stream.
          */
-        bytesAvailable =  streamInput.available();
-        if (chunksize <= bytesAvailable) {
-            return chunksize;
+        bytesAvailable = httpInput.available();
+        if (chunksize >= 0 && chunksize - totalbytesread <= bytesAvailable) {
+            return chunksize - totalbytesread;
         }
 
         return bytesAvailable;
@@ -675,71 +620,17 @@ public class Protocol extends ConnectionBaseAdapter
 
 
     /** 
-     * Read a chunk size header into the readLine buffer
-     * without blocking. The stringbuffer is populated
-     * with characters one at a time. This routine is design
-     * so that a partial chunk size header could be read
-     * and then completed by a blocking read of the chunk 
-     * or a subsequent call to available.
+     * Read the end of the current chunk and the next chunk size header
+     * without blocking. The size is only consumed when the whole
+     * header is already received, otherwise it is left in the
+     * connection input buffer to be completed by a blocking read of
+     * the chunk or a subsequent call to available.
      *
      * @return available data that can be read
      */
     int readChunkSizeNonBlocking() throws IOException {
-        /*
-         * Check the underlying stream to see how many bytes are
-         * available. Do not read beyond the available characters,
-         * because that would block.
-         */
-        int len = streamInput.available();
-        
-        /* Reset the last character from the current readLine buffer. */
-        int sblen = stringbuffer.length();
-        char lastchar = '\0';
-        if (sblen > 0) {
-            lastchar = stringbuffer.charAt(sblen - 1);
-        }
-
-        int size = -1;
-        /*
-         * Loop through the available characters until a full 
-         * chunk size header is in the readLine buffer.
-         */
-        for (; len > 0; len--) {
-            char c = (char) streamInput.read();
-            
-            if (lastchar == '\r' && c == '\n') {
-                // remove the '\r' from the buffer
-                stringbuffer.setLength(stringbuffer.length() - 1);
-
-                if (stringbuffer.length() > 0) {
-                    // this is a size, not the CRLF at the end of a chunk
-                    try {
-                        String temp = stringbuffer.toString();
-                        int semi = temp.indexOf(';');
-
-                        // skip extensions
-                        if (semi > 0) {
-                            temp = temp.substring(0, semi);
-                        }
-
-                        /*
-                         * Reset the string buffer length so readline() will
-                         * not parse this line.
-                         */
-                        stringbuffer.setLength(0);
-
-                        size = Integer.parseInt(temp, 16);
-                    } catch (NumberFormatException nfe) {
-                        throw new IOException(
-                            "invalid chunk size number format");
-                    }
-                    break;
-                }
-            } else {
-                stringbuffer.append(c);
-                lastchar = c;
-            }
-        }
+        int len;
+        int size = httpInput.readChunkSizeNonBlocking();
         
         if (size < 0) {
             // did not get the size
@@ -764,6 +655,7 @@ public class Protocol extends ConnectionBaseAdapter
          * otherwise return the remainder of the available
          * bytes (e.g. partial chunk).
          */
+        len = httpInput.available();
         return (chunksize < len ? chunksize : len);
         
     }
@@ -789,99 +681,69 @@ public class Protocol extends ConnectionBaseAdapter
 
         int rc;
 
-
-        if (bytesleft == 0) {
+        if (totalbytesread == chunksize) {
             /*
-             * the internal input stream buffer is empty, read from the stream
+             * read the end of the chunk and get the size of the
+             * the next if there is one
              */
 
-            if (totalbytesread == chunksize) {
+            if (!chunkedIn) {
                 /*
-                 * read the end of the chunk and get the size of the
-                 * the next if there is one
+                 * non-chucked data is treated as one big chunk so there
+                 * is no more data so just return as if there are no
+                 * more chunks
                  */
-
-                if (!chunkedIn) {
-                    /*
-                     * non-chucked data is treated as one big chunk so there
-                     * is no more data so just return as if there are no
-                     * more chunks
-                     */
-                    eof = true;
-                    return -1;
-                }
-
-                skipEndOfChunkCRLF();
-
-                chunksize = readChunkSize();
-                if (chunksize == 0) {
-                    eof = true;
-
-                    /*
-                     * REFERENCE: HTTP1.1 document 
-                     * SECTION: 3.6.1 Chunked Transfer Coding
-                     * in some cases there may be an OPTIONAL trailer
-                     * containing entity-header fields. since we don't support
-                     * the available() method for TCP socket input streams and
-                     * for performance and reuse reasons we do not attempt to
-                     * clean up the current connections input stream. 
-                     * check readResponseMessage() method in this class for
-                     * more details
-                     */
-                    return -1;
-                }
-
-                /*
-                 * we have not read any bytes from this new chunk
-                 */
-                totalbytesread = 0;
+                eof = true;
+                return -1;
             }
 
-            int bytesToRead = chunksize - totalbytesread;
-
-            if (len >= bytesToRead) {
+            httpInput.skipEndOfChunkCRLF();
 
-                /*
-                 * No need to buffer, if the caller has given a big buffer.
-                 */
-                rc = streamInput.read(b, off, bytesToRead);
+            chunksize = readChunkSize();
+            if (chunksize == 0) {
+                eof = true;
 
-            } else if (len >= inputBufferSize) {
                 /*
-                 * No need to buffer, if the caller has given a big buffer.
+                 * REFERENCE: HTTP1.1 document 
+                 * SECTION: 3.6.1 Chunked Transfer Coding
+                 * in some cases there may be an OPTIONAL trailer
+                 * containing entity-header fields. since we don't support
+                 * the available() method for TCP socket input streams and
+                 * for performance and reuse reasons we do not attempt to
+                 * clean up the current connections input stream. 
+                 * check readResponseMessage() method in this class for
+                 * more details
                  */
-                rc = streamInput.read(b, off, len);
-            } else {
-                if (inputBufferSize >= bytesToRead) {
-                    rc = streamInput.read(readbuf, 0, bytesToRead);
-                } else {
-                    rc = streamInput.read(readbuf, 0, inputBufferSize);
-                }
-
-                bytesleft = rc;
-                bytesread = 0;
+                return -1;
             }
 
-            if (rc == -1) {
-                /*
-                 * Network problem or the wrong length was sent by the server.
-                 */
-                eof = true;
-                throw new IOException("unexpected end of stream");
-            }
+            /*
+             * we have not read any bytes from this new chunk
+             */
+            totalbytesread = 0;
+        }
 
-            totalbytesread += rc;
+        int bytesToRead = chunksize - totalbytesread;
 
-            if (bytesleft == 0) {
-                /*
-                 * The data was read directly into the caller's buffer.
-                 */
-                return rc;
-            }
+        if (len > bytesToRead) {
+            len = bytesToRead;
         }
 
-        rc = readFromBuffer(b, off, len);
+        /*
+         * The connection input stream returns buffered data first and
+         * reads directly into the caller's buffer if it is big.
+         */
+        rc = httpInput.read(b, off, len);
+
+        if (rc == -1) {
+            /*
+             * Network problem or the wrong length was sent by the server.
+             */
+            eof = true;
+            throw new IOException("unexpected end of stream");
+        }
 
+        totalbytesread += rc;
         return rc;
     }
 
@@ -895,6 +757,11 @@ public class Protocol extends ConnectionBaseAdapter
     private int readChunkSize() throws IOException {
         int size = -1;
 
+        if (httpInput != null) {
+            return httpInput.readChunkSize();
+        }
+
+        // the proxy handshake reads from the unbuffered stream
         try {
             String chunk = null;
 
@@ -923,57 +790,6 @@ public class Protocol extends ConnectionBaseAdapter
         
         return size;
     }
-    
-    /**
-     * Skips the CRLF at the end of each chunk in the InputStream.
-     *
-     * @exception IOException if the LF half of the ending CRLF
-     * is missing.
-     */
-    private void skipEndOfChunkCRLF() throws IOException { 
-        int ch;
-
-        if (stringbuffer.length() > 1) {
-            /*
-             * readChunkSizeNonBlocking does not leave CRLF in the buffer
-             * so assume that the ending CRLF has been skipped already
-             */
-            return;
-        }
-
-        // readChunkSizeNonBlocking could have left a \r single in the buffer
-        if (stringbuffer.length() == 1) {
-            if (stringbuffer.charAt(0) != '\r') {
-                // assume that the ending CRLF has been skipped already
-                return;
-            }
-             
-            // remove the '\r'
-            stringbuffer.setLength(0);
-            ch = streamInput.read();
-            if (ch != '\n') {
-                throw new IOException("missing the LF of an expected CRLF");
-            }
-
-            return;
-        }
-                
-        ch = streamInput.read();
-        if (ch != '\r') {
-            /*
-             * assume readChunkSizeNonBlocking has read the end of the chunk
-             * and that this is the next chunk size, so put the char in the
-             * buffer for readChunkSize and return
-             */
-            stringbuffer.append((char)ch);
-            return;
-        }
-
-        ch = streamInput.read();
-        if (ch != '\n') {
-            throw new IOException("missing the LF of an expected CRLF");
-        }
-    } 
 
     /**
      * Writes <code>len</code> bytes from the specified byte array
@@ -1571,6 +1387,7 @@ public class Protocol extends ConnectionBaseAdapter
 
                 streamConnection = null;
                 streamInput = null;
+                httpInput = null;
                 streamOutput = null;
                 bytesToWrite = bytesToRetry;
 
@@ -1631,18 +1448,30 @@ public class Protocol extends ConnectionBaseAdapter
 
         streamConnection = connect();
 
+        if (streamConnection instanceof StreamConnectionElement) {
+            // the pool keeps the buffered input with the connection
+            StreamConnectionElement sce =
+                (StreamConnectionElement)streamConnection;
+
+            streamOutput = sce.openDataOutputStream();
+            streamInput = sce.openDataInputStream();
+            httpInput = sce.getHttpInputStream();
+            return;
+        }
+
         /*
          * Because StreamConnection.open*Stream cannot be called twice
          * the HTTP connect method may have already open the streams
          * to connect to the proxy and saved them in the field variables
          * already.
          */
-        if (streamOutput != null) {
-            return;
+        if (streamOutput == null) {
+            streamOutput = streamConnection.openDataOutputStream();
+            streamInput = streamConnection.openDataInputStream();
         }
 
-        streamOutput = streamConnection.openDataOutputStream();
-        streamInput = streamConnection.openDataInputStream();
+        httpInput = new HttpInputStream(streamInput, inputBufferSize);
+        streamInput = new DataInputStream(httpInput);
     }
 
     /**
@@ -1916,6 +1745,18 @@ public class Protocol extends ConnectionBaseAdapter
 
         streamOutput.flush();
 
+        if (streamConnection instanceof StreamConnectionElement) {
+            StreamConnectionElement sce =
+                (StreamConnectionElement)streamConnection;
+
+            /*
+             * Let the next request be pipelined on this connection,
+             * then wait for the responses to the requests sent before
+             * this one to be consumed.
+             */
+            sce.awaitResponse(sce.requestSent(isPipelineable()));
+        }
+
         readResponseMessage(streamInput);
         
         readHeaders(streamInput);
@@ -1930,6 +1771,17 @@ public class Protocol extends ConnectionBaseAdapter
         }
     }
 
+    /**
+     * Check if the request may be sent on a connection before the
+     * response to the previous request has been read.
+     *
+     * @return true if pipelining is enabled and the request is idempotent
+     */
+    private boolean isPipelineable() {
+        return maxPipelinedRequests > 1 && !ConnectionCloseFlag &&
+            (method.equals(GET) || method.equals(HEAD));
+    }
+
     /**
      * Connect to the underlying network TCP transport.
      * If the proxy is configured, connect to it as tunnel first.
@@ -1949,7 +1801,7 @@ public class Protocol extends ConnectionBaseAdapter
         }
 
         sc = connectionPool.get(classSecurityToken, protocol,
-                                              url.host, url.port);
+                                url.host, url.port, isPipelineable());
 
         if (sc != null) {
             return sc;
@@ -2214,9 +2066,7 @@ public class Protocol extends ConnectionBaseAdapter
         /*
          * Initialize and set the current input stream variables
          */
-        bytesleft = 0;
         chunksize = -1;
-        bytesread = 0;
         totalbytesread = 0;
         chunkedIn = false;
         eof = false;
@@ -2327,9 +2177,10 @@ public class Protocol extends ConnectionBaseAdapter
     }
 
     /**
-     * Uses the shared stringbuffer to read a line terminated by CRLF 
-     * and return it as string. Blocks until the line is done or end of
-     * stream.
+     * Reads a line terminated by CRLF and returns it as string. Lines
+     * of the connection input stream are scanned in its buffer, other
+     * streams are read using the shared stringbuffer. Blocks until the
+     * line is done or end of stream.
      *
      * @param     in  InputStream to read the data
      * @return    one line of input header or null if end of stream
@@ -2338,6 +2189,10 @@ public class Protocol extends ConnectionBaseAdapter
     private String readLine(InputStream in) throws IOException {
         int c;
 
+        if (httpInput != null && in == streamInput) {
+            return httpInput.readLine();
+        }
+
         try {
             for (;;) {
                 c = in.read();
@@ -2455,7 +2310,7 @@ public class Protocol extends ConnectionBaseAdapter
 
         // save the connection for reuse
         if (!connectionPool.add(protocol, url.host, url.port,
-                 streamConnection, streamOutput, streamInput)) {
+                 streamConnection, streamOutput, streamInput, httpInput)) {
             // pool full, disconnect
             disconnect(streamConnection);
             connReused = false;
@@ -2494,6 +2349,7 @@ public class Protocol extends ConnectionBaseAdapter
                 if (streamInput != null) {
                     streamInput.close();
                     streamInput = null;
+                    httpInput = null;
                 }
             }
         }
@@ -64,12 +64,31 @@ public class StreamConnectionElement
     private DataInputStream             m_data_input_stream;
     /** Output stream to http server. */
     private DataOutputStream            m_data_output_stream;
+    /** Buffered input under the data input stream. */
+    private HttpInputStream             m_http_input_stream;
     /** In use flag. */
     boolean                   m_in_use;
     /** Start time in milliseconds. */
     long                      m_time;
     /** Removed from pool flag while in use. (lingered too long) */
     boolean m_removed;
+    /**
+     * Number of requests taken from the pool on this connection whose
+     * responses have not been consumed yet. More than one only when
+     * requests are pipelined.
+     */
+    int m_requests;
+    /**
+     * True if the last request written was idempotent and completely
+     * sent, so another idempotent request may be pipelined behind it.
+     */
+    boolean m_pipelineOpen;
+    /** Sequence number to give to the next request written. */
+    private int m_nextTicket;
+    /** Sequence number of the request whose response may be read. */
+    private int m_nowServing;
+    /** True after the underlying connection was closed. */
+    private boolean m_closed;
     
     /**
      * Create a new instance of this class.
@@ -80,19 +99,22 @@ public class StreamConnectionElement
      * @param p_sc       stream connection
      * @param p_dos      data output stream from the stream connection
      * @param p_dis      data input stream from the stream connection
+     * @param p_his      buffered input under the data input stream
      */
     StreamConnectionElement(String p_protocol,
                             String p_host,
                             int p_port,
                             StreamConnection p_sc,
                             DataOutputStream p_dos,
-                            DataInputStream p_dis) {
+                            DataInputStream p_dis,
+                            HttpInputStream p_his) {
         m_protocol = p_protocol;
         m_host = p_host;
         m_port = p_port;
         m_stream = p_sc;
         m_data_output_stream = p_dos;
         m_data_input_stream = p_dis;
+        m_http_input_stream = p_his;
         m_time = System.currentTimeMillis();
     }
 
@@ -102,6 +124,13 @@ public class StreamConnectionElement
      * as well as the connection itself.
      */
     public void close() {
+        synchronized (this) {
+            m_closed = true;
+            m_pipelineOpen = false;
+            // wake up the pipelined requests waiting for their responses
+            notifyAll();
+        }
+
         try {
             if (m_data_output_stream != null) {
                 m_data_output_stream.close();
@@ -110,6 +139,7 @@ public class StreamConnectionElement
             if (m_data_input_stream != null) {
                 m_data_input_stream.close();
                 m_data_input_stream = null;
+                m_http_input_stream = null;
             }
             if (m_stream != null) {
                 m_stream.close();
@@ -129,6 +159,90 @@ public class StreamConnectionElement
         }
     }
 
+    /**
+     * Check if another request can be pipelined on this connection.
+     * Called by the pool with the pool locked.
+     *
+     * @param maxRequests maximum number of outstanding requests
+     *                    on one connection
+     *
+     * @return true if a request may be written now
+     */
+    synchronized boolean canPipeline(int maxRequests) {
+        return m_pipelineOpen && !m_closed && !m_removed &&
+               m_requests < maxRequests;
+    }
+
+    /**
+     * Take this connection for one more request. The caller gets
+     * the right to write its request; nobody else may write until
+     * the request is sent, see {@link #requestSent}.
+     */
+    synchronized void startRequest() {
+        m_requests++;
+        m_pipelineOpen = false;
+    }
+
+    /**
+     * Record that a request has been completely written to the
+     * connection.
+     *
+     * @param pipelineable true if the request is idempotent and
+     *                     another request may follow it before its
+     *                     response has been read
+     *
+     * @return sequence number of the request, to be passed to
+     *         {@link #awaitResponse}
+     */
+    synchronized int requestSent(boolean pipelineable) {
+        m_pipelineOpen = pipelineable && !m_closed;
+        return m_nextTicket++;
+    }
+
+    /**
+     * Wait until the responses to all requests sent before the
+     * given one have been consumed. Responses arrive in the order
+     * the requests were written, so only one reader may be
+     * parsing the input stream at a time.
+     *
+     * @param ticket sequence number returned by {@link #requestSent}
+     *
+     * @exception IOException if the connection was closed before
+     *            the response could be read
+     */
+    synchronized void awaitResponse(int ticket) throws IOException {
+        while (m_nowServing != ticket && !m_closed) {
+            try {
+                wait();
+            } catch (InterruptedException ie) {
+                throw new IOException("interrupted waiting for response");
+            }
+        }
+
+        if (m_closed) {
+            throw new IOException("Pipelined connection closed");
+        }
+    }
+
+    /**
+     * Record that the current response has been consumed and let
+     * the next pipelined request read its response.
+     *
+     * @return number of requests still using this connection
+     */
+    synchronized int responseDone() {
+        m_nowServing++;
+        m_requests--;
+
+        if (m_requests <= 0) {
+            m_requests = 0;
+            m_pipelineOpen = false;
+        }
+
+        notifyAll();
+        return m_requests;
+    }
+
     /**
      * Get the stream connection for this element.
      *
@@ -172,5 +286,13 @@ public class StreamConnectionElement
         return m_data_input_stream;
     }
 
+    /**
+     * Get the buffered input of the connection, that holds the data
+     * received after the previous response.
+     *
+     * @return                     buffered input stream
+     */
+    HttpInputStream getHttpInputStream() {
+        return m_http_input_stream;
+    }
 }
-                        
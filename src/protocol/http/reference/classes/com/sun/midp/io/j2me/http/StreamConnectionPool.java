@@ -29,7 +29,9 @@ package com.sun.midp.io.j2me.http;
 /**
  * A class representing a persistent connection pool that is used by the http
  * connection class to store persistent connections. Stream Connection 
- * Element are stored in the internal vector located in this class.
+ * Element are stored in an internal hash table located in this class,
+ * keyed by "host:port", so finding a connection does not depend on the
+ * number of connections kept.
  * Each stream connection element is marked when either in use or
  * not. As new connections are requested - the current connections in the pool
  * are searched for a match and inactivity.
@@ -48,6 +50,12 @@ package com.sun.midp.io.j2me.http;
  * in-use flag is set to (true) and once that is closed its set to (false).
  * Once the connection stream element is (false) its available for reuse.
  *
+ * <p> When request pipelining is enabled, an idempotent request may also
+ * take a connection that is in use, once the request ahead of it has been
+ * completely sent. The responses are then read in the order the requests
+ * were written, and the connection is returned to the pool when the last
+ * response has been consumed.
+ *
  */
 
 import java.io.IOException;
@@ -57,6 +65,7 @@ import java.io.DataInputStream;
 import java.io.DataOutputStream;
 
 import java.util.Vector;
+import java.util.Hashtable;
 import java.util.Enumeration;
 
 import javax.microedition.io.StreamConnection;
@@ -78,10 +87,19 @@ import com.sun.midp.security.SecurityToken;
 public class StreamConnectionPool {
     /** How long a connection can linger after its last use. */
     private long m_connectionLingerTime;
-    /** internal connection hash table */
-    private Vector m_connections;
+    /**
+     * internal connection hash table, maps "host:port" to a vector of
+     * stream connection elements
+     */
+    private Hashtable m_connections;
+    /** number of connections in the pool */
+    private int m_count;
     /** maximum connections */
     private int m_max_connections;
+    /** maximum requests outstanding on one connection, 1 - no pipelining */
+    private int m_max_pipelined;
+    /** when to look for lingering connections to other hosts next time */
+    private long m_nextSweepTime;
 
     /**
      * Create a new instance of this class.
@@ -95,11 +113,106 @@ public class StreamConnectionPool {
      */
     StreamConnectionPool(int number_of_connections,
                          long connectionLingerTime) {
+        this(number_of_connections, connectionLingerTime, 1);
+    }
+
+    /**
+     * Create a new instance of this class.
+     *
+     * @param number_of_connections initial number of connections 
+     *       must greater than zero.
+     * @param connectionLingerTime how many milliseconds a connection should
+     *       stay in the pool after its last use
+     * @param maxPipelinedRequests how many requests can be outstanding on
+     *       one connection, 1 disables pipelining
+     */
+    StreamConnectionPool(int number_of_connections,
+                         long connectionLingerTime,
+                         int maxPipelinedRequests) {
         this.m_max_connections = number_of_connections;
         this.m_connectionLingerTime = connectionLingerTime;
-        m_connections = new Vector(m_max_connections);
+        this.m_max_pipelined = maxPipelinedRequests;
+        m_connections = new Hashtable(m_max_connections + 1);
     }
-    
+
+    /**
+     * Build the hash table key of a connection.
+     *
+     * @param p_host                The Hostname for the connection
+     * @param p_port                The port number for the connection
+     *
+     * @return "host:port"
+     */
+    private static String makeKey(String p_host, int p_port) {
+        return p_host + ":" + p_port;
+    }
+
+    /**
+     * Remove an element from its hash table bucket without
+     * closing it.
+     *
+     * @param sce                 The stream connection element to remove
+     */
+    private void detach(StreamConnectionElement sce) {
+        String key = makeKey(sce.m_host, sce.m_port);
+        Vector bucket = (Vector)m_connections.get(key);
+
+        if (bucket == null || !bucket.removeElement(sce)) {
+            return;
+        }
+
+        m_count--;
+        if (bucket.isEmpty()) {
+            m_connections.remove(key);
+        }
+    }
+
+    /**
+     * Take a connection that lingered too long out of the pool.
+     * An unused connection is closed, a connection in use will be
+     * closed when it is returned.
+     *
+     * @param sce                 The stream connection element to remove
+     */
+    private void removeStale(StreamConnectionElement sce) {
+        if (!sce.m_in_use) {
+            sce.close();
+        } else {
+            // signal returnToUse() to close
+            sce.m_removed = true;
+        }
+
+        detach(sce);
+    }
+
+    /**
+     * Remove all the connections that lingered too long.
+     *
+     * @param c_time              The current time
+     */
+    private void sweep(long c_time) {
+        Vector stale = new Vector();
+        Enumeration buckets = m_connections.elements();
+
+        while (buckets.hasMoreElements()) {
+            Vector bucket = (Vector)buckets.nextElement();
+
+            for (int i = 0; i < bucket.size(); i++) {
+                StreamConnectionElement sce =
+                    (StreamConnectionElement)bucket.elementAt(i);
+
+                if ((c_time - sce.m_time) > m_connectionLingerTime) {
+                    stale.addElement(sce);
+                }
+            }
+        }
+
+        // the table cannot be changed while it is enumerated
+        for (int i = 0; i < stale.size(); i++) {
+            removeStale((StreamConnectionElement)stale.elementAt(i));
+        }
+    }
+
     /**
      * Tries to add a reuseable connection to the connection pool.
      * Replace any not in use connections to the same host and port.
@@ -114,61 +227,75 @@ public class StreamConnectionPool {
      *                                connection
      * @param dis                   The data input stream from the base
      *                                connection
+     * @param his                   The buffered input under the data
+     *                                input stream
      *
      * @return true if the connection was added, otherwise false
      */
     synchronized boolean add(String p_protocol,
             String p_host, int p_port, StreamConnection sc,
-            DataOutputStream dos, DataInputStream dis) {
-
-        StreamConnectionElement oldestNotInUse = null;
+            DataOutputStream dos, DataInputStream dis,
+            HttpInputStream his) {
 
-        // find the last unused element
-        Enumeration cons = m_connections.elements();
-        while (cons.hasMoreElements()) {
-            StreamConnectionElement sce =
-                (StreamConnectionElement)cons.nextElement();
+        String key = makeKey(p_host, p_port);
+        Vector bucket = (Vector)m_connections.get(key);
 
-            if (sce.m_in_use) {
-                if (p_host.equals(sce.m_host) && p_port == sce.m_port) {
+        if (bucket != null) {
+            for (int i = 0; i < bucket.size(); i++) {
+                if (((StreamConnectionElement)bucket.elementAt(i)).m_in_use) {
                     return false;
                 }
-
-                continue;
             }
 
-            // if the connection is a duplicate, delete it
-            if (p_host.equals(sce.m_host) && p_port == sce.m_port) {
-                // no protocol duplicates on host and port
+            // no protocol duplicates on host and port
+            for (int i = bucket.size() - 1; i >= 0; i--) {
+                StreamConnectionElement sce =
+                    (StreamConnectionElement)bucket.elementAt(i);
+
                 sce.close();
-                m_connections.removeElement(sce);
-                break;
-            } else {
-                if (oldestNotInUse == null ||
-                    sce.m_time < oldestNotInUse.m_time) {
-                    // save the oldest not in use, it may be removed later
-                    oldestNotInUse = sce;
-                }
+                detach(sce);
             }
         }
 
         /*
          * first check and see if the maximum number of connections
-         * has been reached - if so delete the first one in the list (FIFO)
-         *   or
-         * if this port and host are already in the pool.
+         * has been reached - if so delete the oldest one not in use.
          */
-        if (m_connections.size() >= m_max_connections) {
+        if (m_count >= m_max_connections) {
+            StreamConnectionElement oldestNotInUse = null;
+            Enumeration buckets = m_connections.elements();
+
+            while (buckets.hasMoreElements()) {
+                Vector other = (Vector)buckets.nextElement();
+
+                for (int i = 0; i < other.size(); i++) {
+                    StreamConnectionElement sce =
+                        (StreamConnectionElement)other.elementAt(i);
+
+                    if (!sce.m_in_use && (oldestNotInUse == null ||
+                            sce.m_time < oldestNotInUse.m_time)) {
+                        oldestNotInUse = sce;
+                    }
+                }
+            }
+
             if (oldestNotInUse == null) {
                 return false;
             }
 
             oldestNotInUse.close();
-            m_connections.removeElement(oldestNotInUse);
+            detach(oldestNotInUse);
         }
-     
-        m_connections.addElement(new StreamConnectionElement(p_protocol,
-                          p_host, p_port, sc, dos, dis));
+
+        bucket = (Vector)m_connections.get(key);
+        if (bucket == null) {
+            bucket = new Vector(1);
+            m_connections.put(key, bucket);
+        }
+
+        bucket.addElement(new StreamConnectionElement(p_protocol,
+                          p_host, p_port, sc, dos, dis, his));
+        m_count++;
         return true;
     }
     
@@ -180,7 +307,7 @@ public class StreamConnectionPool {
      */
     synchronized void remove(StreamConnectionElement sce) {
 	sce.close();
-        m_connections.removeElement(sce);
+        detach(sce);
     }
     
     /**
@@ -197,56 +324,98 @@ public class StreamConnectionPool {
      * @return                      A stream connection element or
      *                              null if not found
      */
-    public synchronized StreamConnectionElement get(
+    public StreamConnectionElement get(
             SecurityToken callerSecurityToken,
             String p_protocol, String p_host, int p_port) {
+        return get(callerSecurityToken, p_protocol, p_host, p_port, false);
+    }
 
-        StreamConnectionElement result = null;
+    /**
+     * get an available connection and set the boolean flag to 
+     * true (unavailable) in the connection pool. If there is no
+     * connection available and the request can be pipelined, a
+     * connection in use that accepts another request is returned.
+     * Also removes any stale connections, since this method gets
+     * called more than add or remove.
+     *
+     * @param callerSecurityToken   The security token of the caller
+     * @param p_protocol            The protocol for the connection
+     * @param p_host                The Hostname for the connection
+     * @param p_port                The port number for the connection
+     * @param pipelineable          true if the request is idempotent
+     *
+     * @return                      A stream connection element or
+     *                              null if not found
+     */
+    public synchronized StreamConnectionElement get(
+            SecurityToken callerSecurityToken,
+            String p_protocol, String p_host, int p_port,
+            boolean pipelineable) {
+
+        StreamConnectionElement busy = null;
         long c_time = System.currentTimeMillis();
-        Enumeration cons = m_connections.elements();
+        Vector bucket;
 
         callerSecurityToken.checkIfPermissionAllowed(Permissions.MIDP);
 
-        while (cons.hasMoreElements()) {
+        // connections to other hosts only need to be checked once a while
+        if (c_time >= m_nextSweepTime) {
+            sweep(c_time);
+            m_nextSweepTime = c_time + m_connectionLingerTime;
+        }
+
+        bucket = (Vector)m_connections.get(makeKey(p_host, p_port));
+        if (bucket == null) {
+            return null;
+        }
+
+        // go backwards so old connections can be removed
+        for (int i = bucket.size() - 1; i >= 0; i--) {
             StreamConnectionElement sce =
-                (StreamConnectionElement)cons.nextElement();
-            
+                (StreamConnectionElement)bucket.elementAt(i);
+
             if ((c_time - sce.m_time) > m_connectionLingerTime) {
-                if (!sce.m_in_use) {
-                    sce.close();
-                } else {
-                    // signal returnToUse() to close
-                    sce.m_removed = true;
-                }
+                removeStale(sce);
+                continue;
+            }
 
-                m_connections.removeElement(sce);
+            if (!p_protocol.equals(sce.m_protocol)) {
                 continue;
             }
 
-            if (p_host.equals(sce.m_host) && p_port == sce.m_port &&
-                    p_protocol.equals(sce.m_protocol) && !sce.m_in_use) {
-                result = sce;
+            if (!sce.m_in_use) {
+                sce.m_in_use = true;
+                sce.startRequest();
+                return sce;
+            }
 
-                // do not break out so old connections can be removed
-                continue;
+            if (pipelineable && m_max_pipelined > 1 &&
+                    sce.canPipeline(m_max_pipelined)) {
+                busy = sce;
             }
         }
 
-        if (result != null) {
-            result.m_in_use = true;
+        if (busy != null) {
+            busy.startRequest();
         }
 
-        return result;
+        return busy;
     }
 
     /**
      * Return an instance of the stream connection element to the 
      * connection pool so it can be reused. It is done in the method
-     * so it can be synchronized with the get method.
+     * so it can be synchronized with the get method. If pipelined
+     * requests still use the connection it stays in use.
      *
      * @param returned            The stream connection element to return
      */
     synchronized void returnForReuse(StreamConnectionElement returned) {
+        if (returned.responseDone() > 0) {
+            // the next pipelined request reads its response now
+            return;
+        }
+
         returned.m_in_use = false;
 
         if (returned.m_removed) {
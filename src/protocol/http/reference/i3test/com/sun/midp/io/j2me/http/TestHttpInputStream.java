@@ -0,0 +1,202 @@
+/*
+ *  
+ *
+ * Copyright  1990-2007 Sun Microsystems, Inc. All Rights Reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 only, as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details (a copy is
+ * included at /legal/license.txt).
+ * 
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this work; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ * 
+ * Please contact Sun Microsystems, Inc., 4150 Network Circle, Santa
+ * Clara, CA 95054 or visit www.sun.com if you need additional
+ * information or have any questions.
+ */
+
+
+package com.sun.midp.io.j2me.http;
+
+import java.io.IOException;
+import java.io.ByteArrayInputStream;
+import java.io.InputStream;
+
+import com.sun.midp.i3test.TestCase;
+
+/**
+ * Tests the buffered parsing of HTTP response lines and chunks.
+ */
+public class TestHttpInputStream extends TestCase {
+
+    /**
+     * Creates a stream over the given data that returns at most
+     * the given number of bytes per read.
+     *
+     * @param data stream content
+     * @param step bytes per read
+     * @param size initial buffer size
+     *
+     * @return buffered stream
+     */
+    HttpInputStream makeStream(String data, int step, int size) {
+        return new HttpInputStream(new TrickleInputStream(data.getBytes(),
+            step), size);
+    }
+
+    /**
+     * Tests reading lines that span several reads and that are longer
+     * than the initial buffer.
+     */
+    void testReadLine() throws IOException {
+        StringBuffer longValue = new StringBuffer();
+
+        for (int i = 0; i < 300; i++) {
+            longValue.append((char)('a' + (i % 26)));
+        }
+
+        HttpInputStream in = makeStream("HTTP/1.1 200 OK\r\n" +
+            "X-Long: " + longValue + "\r\n\r\nbody", 7, 0);
+
+        assertEquals("status", "HTTP/1.1 200 OK", in.readLine());
+        assertEquals("long", "X-Long: " + longValue, in.readLine());
+        assertEquals("empty", "", in.readLine());
+        assertEquals("body", 'b', in.read());
+        assertNull("partial", in.readLine());
+        assertEquals("eof", -1, in.read());
+    }
+
+    /**
+     * Tests the chunk size parsing, with extensions and the CRLF
+     * ending the chunk data.
+     */
+    void testChunkSize() throws IOException {
+        byte[] data = new byte[5];
+        HttpInputStream in = makeStream("1a;name=value\r\n", 3, 0);
+
+        assertEquals("size", 0x1a, in.readChunkSize());
+
+        in = makeStream("5\r\nhello\r\n0\r\n", 1, 0);
+        assertEquals("first", 5, in.readChunkSize());
+        assertEquals("data", 5, readFully(in, data));
+        assertEquals("content", "hello", new String(data));
+        in.skipEndOfChunkCRLF();
+        assertEquals("last", 0, in.readChunkSize());
+
+        in = makeStream("zz\r\n", 1, 0);
+        try {
+            in.readChunkSize();
+            fail("no exception for a bad size");
+        } catch (IOException ioe) {
+            assertTrue(true);
+        }
+    }
+
+    /**
+     * Tests that the non-blocking chunk size read only consumes
+     * a completely received size line.
+     */
+    void testChunkSizeNonBlocking() throws IOException {
+        HttpInputStream in = makeStream("\r\n10\r\n", 100, 0);
+
+        assertEquals("complete", 16, in.readChunkSizeNonBlocking());
+
+        in = new HttpInputStream(new ByteArrayInputStream(
+            "\r\n1".getBytes()), 0);
+        assertEquals("partial", -1, in.readChunkSizeNonBlocking());
+        assertEquals("kept", 3, in.available());
+    }
+
+    /**
+     * Tests reading a chunked response through the HTTP protocol.
+     */
+    void testChunkedResponse() throws IOException {
+        StubHttpProtocol conn = new StubHttpProtocol();
+        byte[] data = new byte[32];
+        InputStream in;
+        int n = 0;
+        int rc;
+
+        conn.openPrim(getSecurityToken(),
+            "http://nonexistent.example.com:8080/");
+        conn.setInputBuffer("HTTP/1.1 200 OK\r\n" +
+            "Connection: close\r\n" +
+            "Transfer-Encoding: chunked\r\n\r\n" +
+            "5\r\nhello\r\n6;ext=1\r\n world\r\n0\r\n\r\n");
+
+        in = conn.openInputStream();
+        assertEquals("code", 200, conn.getResponseCode());
+
+        while ((rc = in.read(data, n, data.length - n)) > 0) {
+            n += rc;
+        }
+
+        assertEquals("content", "hello world", new String(data, 0, n));
+        in.close();
+        conn.close();
+    }
+
+    /**
+     * Reads until the buffer is full or end of stream.
+     *
+     * @param in stream to read
+     * @param data buffer to fill
+     *
+     * @return number of bytes read
+     */
+    int readFully(InputStream in, byte[] data) throws IOException {
+        int n = 0;
+        int rc;
+
+        while (n < data.length &&
+               (rc = in.read(data, n, data.length - n)) > 0) {
+            n += rc;
+        }
+
+        return n;
+    }
+
+    /**
+     * Runs all the tests.
+     */
+    public void runTests() throws Throwable {
+        declare("testReadLine");
+        testReadLine();
+
+        declare("testChunkSize");
+        testChunkSize();
+
+        declare("testChunkSizeNonBlocking");
+        testChunkSizeNonBlocking();
+
+        declare("testChunkedResponse");
+        testChunkedResponse();
+    }
+}
+
+/**
+ * An input stream returning at most a few bytes per read, like a socket
+ * receiving data in small segments.
+ */
+class TrickleInputStream extends ByteArrayInputStream {
+    /** Maximum number of bytes returned by one read. */
+    int step;
+
+    TrickleInputStream(byte[] data, int step) {
+        super(data);
+        this.step = step;
+    }
+
+    public synchronized int read(byte b[], int off, int len) {
+        return super.read(b, off, len > step ? step : len);
+    }
+}
@@ -88,6 +88,40 @@ public class Protocol
         return n;
     }
 
+    protected int nonBufferedRead(byte[][] b, int[] off, int[] len,
+                                  int regions) throws IOException {
+        int n = super.nonBufferedRead(b, off, len, regions);
+
+        // report the data region by region
+        for (int i = 0, left = n; i < regions && left > 0; i++) {
+            int chunk = len[i] < left ? len[i] : left;
+
+            if (chunk > 0) {
+                read0(md, b[i], off[i], chunk);
+                left -= chunk;
+            }
+        }
+
+        return n;
+    }
+
+    public int writeBytes(byte[][] b, int[] off, int[] len)
+                   throws IOException {
+
+        int n = super.writeBytes(b, off, len);
+
+        for (int i = 0, left = n; i < b.length && left > 0; i++) {
+            int chunk = len[i] < left ? len[i] : left;
+
+            if (chunk > 0) {
+                write0(md, b[i], off[i], chunk);
+                left -= chunk;
+            }
+        }
+
+        return n;
+    }
+
     public void setSocketOption(byte option, int value)
                          throws IOException {
         super.setSocketOption(option, value);
@@ -81,6 +81,13 @@ public class Protocol extends NetworkConnectionBase
     /** Lock object for writing to the socket */
     private final Object writerLock = new Object();
 
+    /** Arrays of the scatter read in readBytes, guarded by readerLock. */
+    private final byte[][] scatterBuffers = new byte[2][];
+    /** Offsets of the scatter read in readBytes. */
+    private final int[] scatterOffsets = new int[2];
+    /** Lengths of the scatter read in readBytes. */
+    private final int[] scatterLengths = new int[2];
+
     /**
      * Class initializer
      */
@@ -472,6 +479,149 @@ public class Protocol extends NetworkConnectionBase
         }
     }
 
+    /**
+     * Reads up to <code>len</code> bytes of data from the input stream into
+     * an array of bytes, blocks until at least one byte is available.
+     * When the read ahead buffer is empty and smaller than the
+     * caller's buffer, the caller's buffer and the read ahead buffer
+     * are filled by one native scatter read, so the data goes straight
+     * to the caller and what arrives beyond it is kept for the next read.
+     *
+     * @param      b     the buffer into which the data is read.
+     * @param      off   the start offset in array <code>b</code>
+     *                   at which the data is written.
+     * @param      len   the maximum number of bytes to read.
+     * @return     the total number of bytes read into the buffer, or
+     *             <code>-1</code> if there is no more data because the end of
+     *             the stream has been reached.
+     * @exception  IOException  if an I/O error occurs.
+     */
+    public int readBytes(byte b[], int off, int len) throws IOException {
+        int bytesRead;
+
+        if (count > 0 || eof || buf == null || len == 0 ||
+                len >= buf.length) {
+            return super.readBytes(b, off, len);
+        }
+
+        synchronized (readerLock) {
+            scatterBuffers[0] = b;
+            scatterOffsets[0] = off;
+            scatterLengths[0] = len;
+            scatterBuffers[1] = buf;
+            scatterOffsets[1] = 0;
+            scatterLengths[1] = buf.length;
+
+            try {
+                bytesRead = nonBufferedRead(scatterBuffers, scatterOffsets,
+                                            scatterLengths, 2);
+            } finally {
+                // do not keep the caller's buffer reachable
+                scatterBuffers[0] = null;
+            }
+        }
+
+        if (bytesRead <= len) {
+            return bytesRead;
+        }
+
+        pos = 0;
+        count = bytesRead - len;
+        return len;
+    }
+
+    /**
+     * Reads data into several array regions with one native call
+     * ("scatter" read). Data already in the read ahead buffer is returned
+     * first without reading from the network. Otherwise blocks until
+     * at least one byte is available, then fills the regions in order
+     * with the data that has arrived.
+     *
+     * @param      b     the buffers into which the data is read.
+     * @param      off   the start offsets in the buffers.
+     * @param      len   the maximum numbers of bytes to read into
+     *                   the buffers.
+     * @return     the total number of bytes read, or <code>-1</code>
+     *             if there is no more data because the end of the stream
+     *             has been reached.
+     * @exception  IOException  if an I/O error occurs.
+     * @exception  IndexOutOfBoundsException if a region is outside
+     *             of its buffer
+     */
+    public int readBytes(byte[][] b, int[] off, int[] len)
+        throws IOException {
+
+        int total = 0;
+        int regions = b.length;
+        byte[][] buffers = new byte[regions][];
+        int[] offsets = new int[regions];
+        int[] lengths = new int[regions];
+
+        // check and use a copy the caller cannot change under the native
+        copyRegions(b, off, len, buffers, offsets, lengths);
+
+        if (count == 0) {
+            if (eof) {
+                return -1;
+            }
+
+            return nonBufferedRead(buffers, offsets, lengths, regions);
+        }
+
+        for (int i = 0; i < regions && count > 0; i++) {
+            int n = lengths[i] < count ? lengths[i] : count;
+
+            System.arraycopy(buf, pos, buffers[i], offsets[i], n);
+            pos += n;
+            count -= n;
+            total += n;
+        }
+
+        return total;
+    }
+
+    /**
+     * Reads data into several array regions, blocks until at least one
+     * byte is available. Sets the <code>eof</code> field of the
+     * connection when the native read returns -1.
+     *
+     * @param      b       the buffers into which the data is read.
+     * @param      off     the start offsets in the buffers.
+     * @param      len     the maximum numbers of bytes to read into
+     *                     the buffers.
+     * @param      regions number of regions to use
+     * @return     the total number of bytes read, or <code>-1</code>
+     *             if there is no more data because the end of the stream
+     *             has been reached.
+     * @exception  IOException  if an I/O error occurs.
+     */
+    protected int nonBufferedRead(byte[][] b, int[] off, int[] len,
+                                  int regions) throws IOException {
+
+        int bytesRead;
+
+        for (;;) {
+            try {
+                synchronized (readerLock) {
+                    bytesRead = readv0(b, off, len, regions);
+                }
+            } finally {
+                if (iStreams == 0) {
+                    throw new InterruptedIOException("Stream closed");
+                }
+            }
+
+            if (bytesRead == -1) { 
+                eof = true;
+                return -1;
+            }
+
+            if (bytesRead != 0) {
+                return bytesRead;
+            }
+        }
+    }
+
     /**
      * Returns the number of bytes that can be read (or skipped over) from
      * this input stream without blocking by the next caller of a method for
@@ -524,6 +674,75 @@ public class Protocol extends NetworkConnectionBase
         }
     }
 
+    /**
+     * Writes several array regions with one native call ("gather"
+     * write), for example a protocol header and the data following it.
+     * Writes at least one byte, and as much of the regions as the
+     * socket takes without blocking; the caller writes the rest.
+     *
+     * @param      b     the buffers of the data.
+     * @param      off   the start offsets in the buffers.
+     * @param      len   the numbers of bytes to write from the buffers.
+     * @return     number of bytes written
+     * @exception  IOException  if an I/O error occurs. In particular,
+     *             an <code>IOException</code> is thrown if the output
+     *             stream is closed.
+     * @exception  IndexOutOfBoundsException if a region is outside
+     *             of its buffer
+     */
+    public int writeBytes(byte[][] b, int[] off, int[] len) 
+           throws IOException {
+        int regions = b.length;
+        byte[][] buffers = new byte[regions][];
+        int[] offsets = new int[regions];
+        int[] lengths = new int[regions];
+
+        // check and use a copy the caller cannot change under the native
+        copyRegions(b, off, len, buffers, offsets, lengths);
+
+        synchronized (writerLock) {
+            return writev0(buffers, offsets, lengths, regions);
+        }
+    }
+
+    /**
+     * Copies the regions of a scatter read or gather write and checks
+     * the copy. Another thread may change the caller's arrays at any
+     * time, so only the copy is passed to the native method.
+     *
+     * @param b the buffers
+     * @param off the start offsets in the buffers
+     * @param len the numbers of bytes in the buffers
+     * @param buffers receives the buffers, as long as <code>b</code>
+     * @param offsets receives the start offsets
+     * @param lengths receives the numbers of bytes
+     *
+     * @exception IndexOutOfBoundsException if a region is outside
+     *            of its buffer
+     */
+    private static void copyRegions(byte[][] b, int[] off, int[] len,
+                                    byte[][] buffers, int[] offsets,
+                                    int[] lengths) {
+        int regions = buffers.length;
+
+        if (off.length < regions || len.length < regions) {
+            throw new IndexOutOfBoundsException();
+        }
+
+        System.arraycopy(b, 0, buffers, 0, regions);
+        System.arraycopy(off, 0, offsets, 0, regions);
+        System.arraycopy(len, 0, lengths, 0, regions);
+
+        for (int i = 0; i < regions; i++) {
+            int end = offsets[i] + lengths[i];
+
+            if ((offsets[i] | lengths[i] | end |
+                    (buffers[i].length - end)) < 0) {
+                throw new IndexOutOfBoundsException();
+            }
+        }
+    }
+
     /**
      * Called once by the child output stream. The output side of the socket
      * will be shutdown and then the parent method will be called.
@@ -722,6 +941,35 @@ public class Protocol extends NetworkConnectionBase
     private native int write0(byte b[], int off, int len)
         throws IOException;
 
+    /**
+     * Reads from the open socket connection into several array regions.
+     *
+     * @param      b      the buffers into which the data is read.
+     * @param      off    the start offsets in the buffers.
+     * @param      len    the maximum numbers of bytes to read into
+     *                    the buffers.
+     * @param      count  the number of regions.
+     * @return     the total number of bytes read, or <code>-1</code>
+     *             if there is no more data because the end of the stream
+     *             has been reached.
+     * @exception  IOException  if an I/O error occurs.
+     */
+    private native int readv0(byte[][] b, int[] off, int[] len, int count)
+        throws IOException;
+
+    /**
+     * Writes several array regions to the open socket connection.
+     *
+     * @param      b      the buffers of the data to write.
+     * @param      off    the start offsets in the buffers.
+     * @param      len    the numbers of bytes to write from the buffers.
+     * @param      count  the number of regions.
+     * @return     the total number of bytes written
+     * @exception  IOException  if an I/O error occurs.
+     */
+    private native int writev0(byte[][] b, int[] off, int[] len, int count)
+        throws IOException;
+
     /**
      * Gets the number of bytes that can be read without blocking.
      *
@@ -0,0 +1,180 @@
+/*
+ * 	
+ *
+ * Copyright  1990-2007 Sun Microsystems, Inc. All Rights Reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 only, as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details (a copy is
+ * included at /legal/license.txt).
+ * 
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this work; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ * 
+ * Please contact Sun Microsystems, Inc., 4150 Network Circle, Santa
+ * Clara, CA 95054 or visit www.sun.com if you need additional
+ * information or have any questions.
+ */
+
+
+package com.sun.midp.io.j2me.socket;
+
+import java.io.*;
+import javax.microedition.io.*;
+import com.sun.midp.i3test.*;
+
+/**
+ * Test of the scatter read and gather write of a socket connection,
+ * over a loopback connection to a server socket of this VM.
+ */
+public class TestScatterGather extends TestCase implements Runnable {
+
+    /** Port of the loopback server socket. */
+    static private final int PORT = 1225;
+
+    /** Server socket accepting the loopback connection. */
+    ServerSocketConnection server;
+
+    /** Error of the echo thread, null if none. */
+    Throwable echoError;
+
+    /**
+     * Accepts one connection and echoes the first 8 bytes received
+     * with a single write.
+     */
+    public void run() {
+        StreamConnection conn = null;
+
+        try {
+            byte[] data = new byte[8];
+            int n = 0;
+            int rc;
+            InputStream in;
+            OutputStream out;
+
+            conn = server.acceptAndOpen();
+            in = conn.openInputStream();
+            out = conn.openOutputStream();
+
+            while (n < data.length &&
+                   (rc = in.read(data, n, data.length - n)) > 0) {
+                n += rc;
+            }
+
+            out.write(data, 0, n);
+            out.flush();
+            in.close();
+            out.close();
+        } catch (Throwable t) {
+            echoError = t;
+        } finally {
+            try {
+                if (conn != null) {
+                    conn.close();
+                }
+            } catch (IOException ioe) {
+                // ignore
+            }
+        }
+    }
+
+    /**
+     * Writes three regions, one of them empty, and reads the echo
+     * into two regions.
+     */
+    void testEcho() throws IOException, InterruptedException {
+        Protocol client;
+        Thread echo;
+        byte[] first = "xabc".getBytes();
+        byte[] second = new byte[0];
+        byte[] third = "defgh".getBytes();
+        byte[] head = new byte[3];
+        byte[] tail = new byte[10];
+        int written = 0;
+        int n = 0;
+
+        server = (ServerSocketConnection)Connector.open("socket://:" + PORT);
+        echo = new Thread(this);
+        echo.start();
+
+        client = (Protocol)Connector.open("socket://localhost:" + PORT);
+
+        try {
+            byte[][] out = { first, second, third };
+            int[] outOff = { 1, 0, 0 };
+            int[] outLen = { 3, 0, 5 };
+
+            // write the rest after a short gather write
+            while (written < 8) {
+                int rc = client.writeBytes(out, outOff, outLen);
+
+                written += rc;
+                for (int i = 0; i < out.length && rc > 0; i++) {
+                    int step = outLen[i] < rc ? outLen[i] : rc;
+
+                    outOff[i] += step;
+                    outLen[i] -= step;
+                    rc -= step;
+                }
+            }
+
+            while (n < 8) {
+                byte[][] in = { head, tail };
+                int[] inOff = { n < 3 ? n : 3, n < 3 ? 0 : n - 3 };
+                int[] inLen = { 3 - inOff[0], tail.length - inOff[1] };
+                int rc = client.readBytes(in, inOff, inLen);
+
+                if (rc < 0) {
+                    break;
+                }
+
+                n += rc;
+            }
+
+            assertEquals("written", 8, written);
+            assertEquals("read", 8, n);
+            assertEquals("head", "abc", new String(head));
+            assertEquals("tail", "defgh", new String(tail, 0, 5));
+        } finally {
+            client.close();
+            echo.join();
+            server.close();
+        }
+
+        assertNull("echo error", echoError);
+    }
+
+    /**
+     * Tests that a region outside of its buffer is rejected.
+     */
+    void testBadRegion() throws IOException {
+        Protocol client = new Protocol();
+        byte[][] b = { new byte[4] };
+
+        try {
+            client.writeBytes(b, new int[] { 2 }, new int[] { 3 });
+            fail("no exception for a region outside of the buffer");
+        } catch (IndexOutOfBoundsException e) {
+            assertTrue(true);
+        }
+    }
+
+    /**
+     * Runs all the tests.
+     */
+    public void runTests() throws Throwable {
+        declare("testEcho");
+        testEcho();
+
+        declare("testBadRegion");
+        testBadRegion();
+    }
+}
@@ -65,6 +65,236 @@
 typedef struct Java_com_sun_midp_io_j2me_socket_Protocol _socketProtocol;
 #define getMidpSocketProtocolPtr(handle) (unhand(_socketProtocol,(handle)))
 
+/**
+ * Reads the data that has already arrived into a region of a Java byte
+ * array, without blocking. Called after a read returned less than the
+ * caller asked for, so a streaming download fills the whole caller
+ * buffer in one native call instead of one call per network packet.
+ *
+ * @param pcslHandle handle of the open socket
+ * @param bufferObject Java byte array to read into
+ * @param offset start offset in the array
+ * @param length maximum number of bytes to read
+ *
+ * @return number of bytes read, 0 if no data is available
+ */
+static int read_available(void *pcslHandle, jobject bufferObject,
+                          int offset, int length) {
+    int total = 0;
+    int available;
+    int bytesRead;
+    int status;
+    void *context = NULL;
+
+    while (length > 0) {
+        if (pcsl_socket_available(pcslHandle, &available) !=
+                PCSL_NET_SUCCESS || available <= 0) {
+            break;
+        }
+
+        if (available > length) {
+            available = length;
+        }
+
+        bytesRead = 0;
+        SNI_BEGIN_RAW_POINTERS;
+        status = pcsl_socket_read_start(pcslHandle,
+                     (unsigned char*)&(JavaByteArray(bufferObject)[offset]),
+                     available, &bytesRead, &context);
+        SNI_END_RAW_POINTERS;
+
+        if (status != PCSL_NET_SUCCESS || bytesRead <= 0) {
+            break;
+        }
+
+        total += bytesRead;
+        offset += bytesRead;
+        length -= bytesRead;
+    }
+
+    return total;
+}
+
+/**
+ * Continues a scatter read with the data that has already arrived:
+ * fills the rest of region <tt>index</tt> after its first <tt>done</tt>
+ * bytes, then the following regions, stopping at the first region
+ * that cannot be filled completely.
+ *
+ * @param pcslHandle handle of the open socket
+ * @param buffersObject Java array of byte arrays
+ * @param offsetsObject Java array of start offsets
+ * @param lengthsObject Java array of region lengths
+ * @param bufferObject handle to use for the current byte array
+ * @param index index of the region to continue
+ * @param done number of bytes already read into that region
+ * @param count number of regions
+ *
+ * @return number of bytes read
+ */
+static int readv_available(void *pcslHandle, jobject buffersObject,
+                           jobject offsetsObject, jobject lengthsObject,
+                           jobject bufferObject, int index, int done,
+                           int count) {
+    int total = 0;
+    int offset;
+    int length;
+    int bytesRead;
+
+    for (; index < count; index++) {
+        offset = (int)KNI_GetIntArrayElement(offsetsObject, index) + done;
+        length = (int)KNI_GetIntArrayElement(lengthsObject, index) - done;
+        done = 0;
+
+        if (length <= 0) {
+            continue;
+        }
+
+        KNI_GetObjectArrayElement(buffersObject, index, bufferObject);
+        bytesRead = read_available(pcslHandle, bufferObject, offset, length);
+        total += bytesRead;
+
+        if (bytesRead < length) {
+            break;
+        }
+    }
+
+    return total;
+}
+
+/**
+ * Continues a gather write with the regions following a region that
+ * has been completely written, as long as the socket accepts data
+ * without blocking.
+ *
+ * @param pcslHandle handle of the open socket
+ * @param buffersObject Java array of byte arrays
+ * @param offsetsObject Java array of start offsets
+ * @param lengthsObject Java array of region lengths
+ * @param bufferObject handle to use for the current byte array
+ * @param index index of the first region to write
+ * @param count number of regions
+ *
+ * @return number of bytes written
+ */
+static int writev_available(void *pcslHandle, jobject buffersObject,
+                            jobject offsetsObject, jobject lengthsObject,
+                            jobject bufferObject, int index, int count) {
+    int total = 0;
+    int offset;
+    int length;
+    int bytesWritten;
+    int status;
+    void *context = NULL;
+
+    for (; index < count; index++) {
+        offset = (int)KNI_GetIntArrayElement(offsetsObject, index);
+        length = (int)KNI_GetIntArrayElement(lengthsObject, index);
+
+        if (length <= 0) {
+            continue;
+        }
+
+        KNI_GetObjectArrayElement(buffersObject, index, bufferObject);
+
+        bytesWritten = 0;
+        SNI_BEGIN_RAW_POINTERS;
+        status = pcsl_socket_write_start(pcslHandle,
+                       (char*)&(JavaByteArray(bufferObject)[offset]),
+                       length, &bytesWritten, &context);
+        SNI_END_RAW_POINTERS;
+
+        /*
+         * A would-block here is not waited for: the bytes written so
+         * far are returned and the caller writes the rest.
+         */
+        if (status != PCSL_NET_SUCCESS) {
+            break;
+        }
+
+        total += bytesWritten;
+
+        if (bytesWritten < length) {
+            break;
+        }
+    }
+
+    return total;
+}
+
+/**
+ * Finds the first region of a scatter/gather request that has a
+ * positive length.
+ *
+ * @param lengthsObject Java array of region lengths
+ * @param count number of regions
+ *
+ * @return index of the region or <tt>count</tt> if all are empty
+ */
+static int first_region(jobject lengthsObject, int count) {
+    int i;
+
+    for (i = 0; i < count; i++) {
+        if (KNI_GetIntArrayElement(lengthsObject, i) > 0) {
+            break;
+        }
+    }
+
+    return i;
+}
+
+/**
+ * Checks that every region of a scatter/gather request lies inside its
+ * byte array. The Java caller checks a private copy of the regions, but
+ * they are checked again on every (re)entry because raw pointers into
+ * the arrays are made from them.
+ *
+ * @param buffersObject Java array of byte arrays
+ * @param offsetsObject Java array of start offsets
+ * @param lengthsObject Java array of region lengths
+ * @param bufferObject handle to use for the current byte array
+ * @param count number of regions
+ *
+ * @return <tt>KNI_TRUE</tt> if the regions are valid, otherwise
+ *         <tt>KNI_FALSE</tt>
+ */
+static jboolean check_regions(jobject buffersObject, jobject offsetsObject,
+                              jobject lengthsObject, jobject bufferObject,
+                              int count) {
+    int i;
+    jint offset;
+    jint length;
+    jint arrayLength;
+
+    if (count < 0 || KNI_IsNullHandle(buffersObject) ||
+            KNI_IsNullHandle(offsetsObject) ||
+            KNI_IsNullHandle(lengthsObject) ||
+            KNI_GetArrayLength(buffersObject) < count ||
+            KNI_GetArrayLength(offsetsObject) < count ||
+            KNI_GetArrayLength(lengthsObject) < count) {
+        return KNI_FALSE;
+    }
+
+    for (i = 0; i < count; i++) {
+        KNI_GetObjectArrayElement(buffersObject, i, bufferObject);
+        if (KNI_IsNullHandle(bufferObject)) {
+            return KNI_FALSE;
+        }
+
+        offset = KNI_GetIntArrayElement(offsetsObject, i);
+        length = KNI_GetIntArrayElement(lengthsObject, i);
+        arrayLength = KNI_GetArrayLength(bufferObject);
+
+        /* written so that offset + length cannot overflow */
+        if (offset < 0 || length < 0 || offset > arrayLength ||
+                length > arrayLength - offset) {
+            return KNI_FALSE;
+        }
+    }
+
+    return KNI_TRUE;
+}
+
 /**
  * Opens a TCP connection to a server.
  * <p>
@@ -277,6 +507,14 @@ Java_com_sun_midp_io_j2me_socket_Protocol_read0(void) {
             }
         }
 
+        if (status == PCSL_NET_SUCCESS && bytesRead > 0 &&
+                bytesRead < length) {
+            /* take the rest of the data that has arrived as well */
+            bytesRead += read_available(pcslHandle, bufferObject,
+                                        offset + bytesRead,
+                                        length - bytesRead);
+        }
+
         REPORT_INFO1(LC_PROTOCOL, "socket::read0 bytesRead=%d\n", bytesRead);
 
         if (INVALID_HANDLE != pcslHandle) {
@@ -428,6 +666,323 @@ Java_com_sun_midp_io_j2me_socket_Protocol_write0(void) {
     KNI_ReturnInt((jint)bytesWritten);
 }
 
+/**
+ * Reads from the open socket connection into several regions of Java
+ * byte arrays with one native call ("scatter" read). The first region
+ * with room is read like in <tt>read0</tt>, waiting for data if none
+ * has arrived; the data that has arrived beyond it is read into the
+ * following regions without blocking.
+ * <p>
+ * Java declaration:
+ * <pre>
+ *     readv0([[B[I[II)I
+ * </pre>
+ *
+ * @param b the buffers into which the data is read
+ * @param off the start offsets in the buffers
+ * @param len the maximum numbers of bytes to read into the buffers
+ * @param count the number of regions
+ *
+ * @return the total number of bytes read, or <tt>-1</tt> if there is no
+ *         more data because the end of the stream has been reached
+ */
+KNIEXPORT KNI_RETURNTYPE_INT
+Java_com_sun_midp_io_j2me_socket_Protocol_readv0(void) {
+    int count;
+    int index;
+    int length = 0;
+    int offset = 0;
+    int iStreams;
+    void *pcslHandle;
+    int bytesRead = -1;
+    int status = PCSL_NET_INVALID;
+    void* context = NULL;
+    MidpReentryData* info;
+
+    count = (int)KNI_GetParameterAsInt(4);
+
+    KNI_StartHandles(5);
+
+    KNI_DeclareHandle(buffersObject);
+    KNI_DeclareHandle(offsetsObject);
+    KNI_DeclareHandle(lengthsObject);
+    KNI_DeclareHandle(bufferObject);
+    KNI_DeclareHandle(thisObject);
+    KNI_GetThisPointer(thisObject);
+    KNI_GetParameterAsObject(1, buffersObject);
+    KNI_GetParameterAsObject(2, offsetsObject);
+    KNI_GetParameterAsObject(3, lengthsObject);
+
+    pcslHandle = (void *)(getMidpSocketProtocolPtr(thisObject)->handle);
+    iStreams = (int)(getMidpSocketProtocolPtr(thisObject)->iStreams); 
+
+    if (!check_regions(buffersObject, offsetsObject, lengthsObject,
+                       bufferObject, count)) {
+        KNI_ThrowNew(midpArrayIndexOutOfBoundsException,
+                     "invalid region during socket::readv");
+        /* with no regions nothing below touches the arrays */
+        count = 0;
+    }
+
+    index = first_region(lengthsObject, count);
+    if (index < count) {
+        KNI_GetObjectArrayElement(buffersObject, index, bufferObject);
+        offset = (int)KNI_GetIntArrayElement(offsetsObject, index);
+        length = (int)KNI_GetIntArrayElement(lengthsObject, index);
+    }
+
+    REPORT_INFO3(LC_PROTOCOL, "socket::readv0 n=%d l=%d fd=%d\n",
+                 count, length, (int)pcslHandle);
+
+    if (index == count) {
+        /* nothing to read into */
+        bytesRead = 0;
+    } else if (pcslHandle != INVALID_HANDLE) {
+        int ipAddress;
+        int port;
+
+        /* Check the push cache for a waiting packet. */
+        SNI_BEGIN_RAW_POINTERS;
+        bytesRead = pushgetcachedpacket((int)pcslHandle, &ipAddress, &port,
+            (char*)&(JavaByteArray(bufferObject)[offset]), length);
+        SNI_END_RAW_POINTERS;
+    }
+
+    if (bytesRead < 0 || (bytesRead == 0 && index < count)) {
+        info = (MidpReentryData*)SNI_GetReentryData(NULL);
+
+        ANC_IND_NETWORK_INDICATOR;
+
+        if (info == NULL) {   /* First invocation */
+            if (INVALID_HANDLE == pcslHandle) {
+                KNI_ThrowNew(midpIOException,
+                             "invalid handle during socket::readv");
+            } else {
+                SOCK_ANC_INC_NETWORK_INDICATOR;
+                SNI_BEGIN_RAW_POINTERS;
+                status = pcsl_socket_read_start(pcslHandle,
+                               (unsigned char*)&(JavaByteArray(bufferObject)[offset]),
+                               length, &bytesRead, &context);
+                SNI_END_RAW_POINTERS;
+            }
+        } else {  /* Reinvocation after unblocking the thread */
+            if (INVALID_HANDLE == pcslHandle || iStreams == 0) {
+                /* connection or its input streams are closed by another thread */
+                KNI_ThrowNew(midpInterruptedIOException,
+                             "Interrupted IO error during socket::readv");
+                if (INVALID_HANDLE == pcslHandle) {
+                    SOCK_ANC_DEC_NETWORK_INDICATOR;
+                }
+            } else {
+                if ((void *)info->descriptor != pcslHandle) {
+                    REPORT_CRIT2(LC_PROTOCOL,
+                                 "socket::readv Handles mismatched 0x%x != 0x%x\n",
+                                 pcslHandle,
+                                 info->descriptor);
+                }
+                context = info->pResult;
+                SNI_BEGIN_RAW_POINTERS;
+                status = pcsl_socket_read_finish(pcslHandle,
+                           (unsigned char*)&(JavaByteArray(bufferObject)[offset]),
+                           length, &bytesRead, context);
+                SNI_END_RAW_POINTERS;
+            }
+        }
+
+        if (status == PCSL_NET_SUCCESS && bytesRead > 0) {
+            /* scatter the rest of the data that has arrived */
+            bytesRead += readv_available(pcslHandle, buffersObject,
+                                         offsetsObject, lengthsObject,
+                                         bufferObject, index, bytesRead,
+                                         count);
+        }
+
+        REPORT_INFO1(LC_PROTOCOL, "socket::readv0 bytesRead=%d\n", bytesRead);
+
+        if (INVALID_HANDLE != pcslHandle) {
+            if (status == PCSL_NET_SUCCESS) {
+                if (bytesRead == 0) {
+                    /* end of stream */
+                    bytesRead = -1;
+                }
+                SOCK_ANC_DEC_NETWORK_INDICATOR;
+            } else {
+                REPORT_INFO1(LC_PROTOCOL, "socket::readv error=%d\n",
+                             pcsl_network_error(pcslHandle));
+
+                if (status == PCSL_NET_WOULDBLOCK) {
+                    midp_thread_wait(NETWORK_READ_SIGNAL, (int)pcslHandle, context);
+                } else if (status == PCSL_NET_INTERRUPTED) {
+                    midp_snprintf(gKNIBuffer, KNI_BUFFER_SIZE,
+                            "Interrupted IO error %d during socket::readv ",
+                            pcsl_network_error(pcslHandle));
+                    KNI_ThrowNew(midpInterruptedIOException, gKNIBuffer);
+                    SOCK_ANC_DEC_NETWORK_INDICATOR;
+                } else {
+                    midp_snprintf(gKNIBuffer, KNI_BUFFER_SIZE,
+                            "Unknown error %d during socket::readv ",
+                            pcsl_network_error(pcslHandle));
+                    KNI_ThrowNew(midpIOException, gKNIBuffer);
+                    SOCK_ANC_DEC_NETWORK_INDICATOR;
+                }
+            }
+        }
+
+        ANC_IND_NETWORK_INDICATOR;
+    }
+
+    KNI_EndHandles();
+    KNI_ReturnInt((jint)bytesRead);
+}
+
+/**
+ * Writes several regions of Java byte arrays to the open socket
+ * connection with one native call ("gather" write). The first region
+ * with data is written like in <tt>write0</tt>, waiting if the socket
+ * cannot take any data; the following regions are written as long as
+ * the socket takes them without blocking.
+ * <p>
+ * Java declaration:
+ * <pre>
+ *     writev0([[B[I[II)I
+ * </pre>
+ *
+ * @param b the buffers of the data to write
+ * @param off the start offsets in the buffers
+ * @param len the numbers of bytes to write from the buffers
+ * @param count the number of regions
+ *
+ * @return the total number of bytes written
+ */
+KNIEXPORT KNI_RETURNTYPE_INT
+Java_com_sun_midp_io_j2me_socket_Protocol_writev0(void) { 
+    int count;
+    int index;
+    int length = 0;
+    int offset = 0;
+    int oStreams;
+    void *pcslHandle;
+    int bytesWritten = 0;
+    int status = PCSL_NET_INVALID;
+    void *context = NULL;
+    MidpReentryData* info;
+
+    count = (int)KNI_GetParameterAsInt(4);
+
+    KNI_StartHandles(5);
+
+    KNI_DeclareHandle(buffersObject);
+    KNI_DeclareHandle(offsetsObject);
+    KNI_DeclareHandle(lengthsObject);
+    KNI_DeclareHandle(bufferObject);
+    KNI_DeclareHandle(thisObject);
+    KNI_GetThisPointer(thisObject);
+    KNI_GetParameterAsObject(1, buffersObject);
+    KNI_GetParameterAsObject(2, offsetsObject);
+    KNI_GetParameterAsObject(3, lengthsObject);
+
+    pcslHandle = (void *)(getMidpSocketProtocolPtr(thisObject)->handle);
+    oStreams = (int)(getMidpSocketProtocolPtr(thisObject)->oStreams);
+
+    if (!check_regions(buffersObject, offsetsObject, lengthsObject,
+                       bufferObject, count)) {
+        KNI_ThrowNew(midpArrayIndexOutOfBoundsException,
+                     "invalid region during socket::writev");
+        /* with no regions nothing below touches the arrays */
+        count = 0;
+    }
+
+    index = first_region(lengthsObject, count);
+    if (index < count) {
+        KNI_GetObjectArrayElement(buffersObject, index, bufferObject);
+        offset = (int)KNI_GetIntArrayElement(offsetsObject, index);
+        length = (int)KNI_GetIntArrayElement(lengthsObject, index);
+    }
+
+    REPORT_INFO3(LC_PROTOCOL, "socket::writev0 n=%d l=%d fd=%d\n", 
+                 count, length, pcslHandle);
+
+    if (index < count) {
+        info = (MidpReentryData*)SNI_GetReentryData(NULL);
+
+        ANC_IND_NETWORK_INDICATOR;
+
+        if (info == NULL) {   /* First invocation */
+            if (INVALID_HANDLE == pcslHandle) {
+                KNI_ThrowNew(midpIOException, 
+                             "invalid handle during socket::writev");
+            } else {
+                SOCK_ANC_INC_NETWORK_INDICATOR;
+                SNI_BEGIN_RAW_POINTERS;
+                status = pcsl_socket_write_start(pcslHandle, 
+                               (char*)&(JavaByteArray(bufferObject)[offset]),
+                               length, &bytesWritten, &context);
+                SNI_END_RAW_POINTERS;
+            }
+        } else { /* Reinvocation after unblocking the thread */
+            if (INVALID_HANDLE == pcslHandle || oStreams == 0) {
+                /* connection or its output streams are closed by another thread */
+                KNI_ThrowNew(midpInterruptedIOException, 
+                             "Interrupted IO error during socket::writev");
+                SOCK_ANC_DEC_NETWORK_INDICATOR;
+            } else {
+                if ((void *)info->descriptor != pcslHandle) {
+                    REPORT_CRIT2(LC_PROTOCOL, 
+                                 "socket::writev Handles mismatched 0x%x != 0x%x\n", 
+                                 pcslHandle,
+                                 info->descriptor);
+                }
+                context = info->pResult;
+                SNI_BEGIN_RAW_POINTERS;
+                status = pcsl_socket_write_finish(pcslHandle, 
+                           (char*)&(JavaByteArray(bufferObject)[offset]),
+                           length, &bytesWritten, context);
+                SNI_END_RAW_POINTERS;
+            }
+        }
+
+        if (INVALID_HANDLE != pcslHandle) {
+            if (status == PCSL_NET_SUCCESS) {
+                if (bytesWritten == length) {
+                    /* gather the following regions */
+                    bytesWritten += writev_available(pcslHandle,
+                                        buffersObject, offsetsObject,
+                                        lengthsObject, bufferObject,
+                                        index + 1, count);
+                }
+                SOCK_ANC_DEC_NETWORK_INDICATOR;
+            } else {
+                REPORT_INFO1(LC_PROTOCOL, "socket::writev error=%d\n", 
+                             (int)pcsl_network_error(pcslHandle));
+
+                if (status == PCSL_NET_WOULDBLOCK) {
+                    midp_thread_wait(NETWORK_WRITE_SIGNAL, (int)pcslHandle, context);
+                } else if (status == PCSL_NET_INTERRUPTED) {
+                    midp_snprintf(gKNIBuffer, KNI_BUFFER_SIZE,
+                            "Interrupted IO error %d during socket::writev ", 
+                            pcsl_network_error(pcslHandle));
+                    KNI_ThrowNew(midpInterruptedIOException, gKNIBuffer);
+                    SOCK_ANC_DEC_NETWORK_INDICATOR;
+                } else {
+                    midp_snprintf(gKNIBuffer, KNI_BUFFER_SIZE,
+                            "IOError %d during socket::writev \n", 
+                            pcsl_network_error(pcslHandle));
+                    KNI_ThrowNew(midpIOException, gKNIBuffer);
+                    SOCK_ANC_DEC_NETWORK_INDICATOR;
+                }
+            }
+        }
+
+        ANC_IND_NETWORK_INDICATOR;
+    }
+
+    REPORT_INFO1(LC_PROTOCOL, "socket::writev0 bytesWritten=%d\n", 
+                 bytesWritten);
+    KNI_EndHandles();
+
+    KNI_ReturnInt((jint)bytesWritten);
+}
+
 /**
  * Gets the number of bytes that can be read without blocking.
  * <p>
@@ -327,12 +327,16 @@ Java_com_sun_midp_io_j2me_datagram_Protocol_receive0(void) {
         int bytesReceived;
 
         /*
-         * Check the push cache for a waiting datagram.
+         * Check the push cache for waiting datagrams. The push registry
+         * may have queued several datagrams that arrived while the MIDlet
+         * was being launched; they are returned one per call, in the
+         * order of arrival, copied straight from the push packet pool
+         * into the Java buffer.
          *
-         * If pushgetcachedpacket() returns -1 [IMPL NOTE: the code checks for
-         * less than zero; which is correct?], we need to read a datagram
-         * ourselves. Otherwise, pushgetcachedpacket() has returned a waiting
-         * datagram and has set ipAddress and port to valid values.
+         * If pushgetcachedpacket() returns a negative value, nothing is
+         * cached and we need to read a datagram ourselves. Otherwise,
+         * pushgetcachedpacket() has returned a waiting datagram and has
+         * set ipAddress and port to valid values.
          */
         SNI_BEGIN_RAW_POINTERS;
         bytesReceived = pushgetcachedpacket((int)socketHandle, &ipAddress,
@@ -49,6 +49,7 @@
 #include <pcsl_string.h>
 
 #include <midpMalloc.h>
+#include <midpArena.h>
 #include <midpStorage.h>
 #include <midp_properties_port.h>
 #include <midpResourceLimit.h>
@@ -93,6 +94,29 @@
     #define MAX_CACHED_DATA_SIZE 1500
 #endif /* MAX_CACHED_DATA_SIZE */
 
+/**
+ * Maximum number of packets buffered by the push registry at a time,
+ * over all push entries. This caps the memory used by the packet cache
+ * to MAX_CACHED_PACKETS * MAX_CACHED_DATA_SIZE bytes plus headers.
+ */
+#ifndef MAX_CACHED_PACKETS
+    #define MAX_CACHED_PACKETS 32
+#endif /* MAX_CACHED_PACKETS */
+
+/** Maximum number of packets buffered for a single push entry. */
+#ifndef MAX_CACHED_PACKETS_PER_ENTRY
+    #define MAX_CACHED_PACKETS_PER_ENTRY 8
+#endif /* MAX_CACHED_PACKETS_PER_ENTRY */
+
+/** Number of packets allocated at once when the packet pool grows. */
+#define PACKETS_PER_SLAB 8
+
+/**
+ * Number of objects allocated at once by each size class pool of the
+ * push memory tag, which the push entries are taken from.
+ */
+#define PUSH_OBJECTS_PER_CHUNK 16
+
 /** For build a parameter string. */
 PCSL_DEFINE_STATIC_ASCII_STRING_LITERAL_START(COMMA_STRING)
 {',', '\0'}
@@ -108,23 +132,32 @@ PCSL_DEFINE_STATIC_ASCII_STRING_LITERAL_START(ALARM_LIST_FILENAME)
 {'a', 'l', 'a', 'r', 'm', 'l', 'i', 's', 't', '.', 't', 'x', 't', '\0'}
 PCSL_DEFINE_STATIC_ASCII_STRING_LITERAL_END(ALARM_LIST_FILENAME);
 
+/** Suffix of the temporary file used to rewrite a registry file. (".tmp") */
+PCSL_DEFINE_STATIC_ASCII_STRING_LITERAL_START(TMP_FILE_SUFFIX)
+{'.', 't', 'm', 'p', '\0'}
+PCSL_DEFINE_STATIC_ASCII_STRING_LITERAL_END(TMP_FILE_SUFFIX);
+
+/**
+ * Suffix of the previous registry file, kept while the temporary file is
+ * renamed over the registry file. (".bak")
+ */
+PCSL_DEFINE_STATIC_ASCII_STRING_LITERAL_START(BAK_FILE_SUFFIX)
+{'.', 'b', 'a', 'k', '\0'}
+PCSL_DEFINE_STATIC_ASCII_STRING_LITERAL_END(BAK_FILE_SUFFIX);
+
 /** Pathname for persistent push connection list. */
 static pcsl_string pushpathname = PCSL_STRING_NULL_INITIALIZER;
 /** Pathname for persistent alarm notification list. */
 static pcsl_string alarmpathname = PCSL_STRING_NULL_INITIALIZER;
 
-/** Pointer to error message. */
-static char *errStr = NULL;
-
-/* Maximum buffer size for line parsing. */
-#define MAX_LINE 512
-
 /**
  * The internal representation of a datagram or TCP packet.
  * Datagrams read by the push mechanism are buffered in the push
  * registry for use by the midlet after it is invoked by push.
  */
 typedef struct _packetentry {
+    /** Next packet cached for the same push entry, or next free packet. */
+    struct _packetentry *next;
     /** The IP Address of the sender. */
     int ipAddress;
     /** The port ID on which the packet was received. */
@@ -147,6 +180,25 @@ typedef struct _packetentry {
 typedef struct _pushentry {
     /** Pointer to the next entry in the list. Last entry has NULL here. */
     struct _pushentry *next;
+    /** Pointer to the previous entry in the list. First entry has NULL here. */
+    struct _pushentry *prev;
+    /** Next entry in the same bucket of the descriptor index. */
+    struct _pushentry *nextByFd;
+    /** Next entry in the same bucket of the port index. */
+    struct _pushentry *nextByPort;
+    /** Next entry in the same bucket of the suite index. */
+    struct _pushentry *nextBySuite;
+    /** Previous entry in the list of entries with the same state. */
+    struct _pushentry *prevInState;
+    /** Next entry in the list of entries with the same state. */
+    struct _pushentry *nextInState;
+    /**
+     * Insertion sequence number. Entries with a greater number come first
+     * in the list, this keeps lookups through the indexes in list order.
+     */
+    int seq;
+    /** True if the entry is in the list and in the indexes. */
+    jboolean isIndexed;
     /** The full text entry from the persistent store. */
     char *value;
     /** The name of the midletsuitestorage persistent store. */
@@ -165,7 +217,10 @@ typedef struct _pushentry {
     char *appID;
     /** Current state of the connection. */
     int state;
-    /** Pointers for packets that have already arrived. */
+    /**
+     * Packets that have already arrived, in the order of arrival.
+     * The first packet is the one being read.
+     */
     PacketEntry *pCachedData;
     /** Flag denoting whether a WMA message has arrived and been cached. */
     jboolean isWMAMessCached;
@@ -215,6 +270,43 @@ typedef struct _alarmentry {
 static PushEntry *pushlist = NULL;
 static AlarmEntry *alarmlist = NULL;
 
+/**
+ * Pool of the packets cached for the push entries, limited to
+ * MAX_CACHED_PACKETS packets. It is set up by the first allocation and
+ * its memory is kept until the push registry is closed.
+ */
+static MidpPool packetPool;
+
+/** Number of buckets in each of the push registry hash indexes. */
+#define PUSH_INDEX_SIZE 64
+
+/** Hash function of the descriptor index. */
+#define PUSH_FD_HASH(fd) \
+    ((((unsigned int)(fd)) ^ (((unsigned int)(fd)) >> 7)) & \
+     (PUSH_INDEX_SIZE - 1))
+
+/** Hash function of the port index. */
+#define PUSH_PORT_HASH(port) (((unsigned int)(port)) & (PUSH_INDEX_SIZE - 1))
+
+/** Number of push entry states, see push_server_resource_mgmt.h. */
+#define PUSH_STATE_COUNT 6
+
+/** Maps a push entry state (AVAILABLE .. WAITING_DATA) to 0 .. 5. */
+#define PUSH_STATE_INDEX(state) (-(state) - 1)
+
+/** Push entries hashed by the listening descriptor. */
+static PushEntry *pushFdIndex[PUSH_INDEX_SIZE];
+/** Push entries hashed by the port. */
+static PushEntry *pushPortIndex[PUSH_INDEX_SIZE];
+/** Push entries hashed by the storage name of the suite. */
+static PushEntry *pushSuiteIndex[PUSH_INDEX_SIZE];
+/** First push entry in each state, in the order of state changes. */
+static PushEntry *pushStateHead[PUSH_STATE_COUNT];
+/** Last push entry in each state. */
+static PushEntry *pushStateTail[PUSH_STATE_COUNT];
+/** Sequence number of the last entry added to the list. */
+static int pushSequence = 0;
+
 typedef enum {
     NET_STATUS_DOWN       = -3,
     NET_STATUS_GOING_DOWN = -2, /* network finalization is in progress */
@@ -244,17 +336,32 @@ static int alarmopen();
 static void alarmsave();
 static void pushListFree();
 static void alarmListFree();
-static int parsePushList(int);
-static int parseAlarmList(int);
+static int parsePushList(char *buffer, long length);
+static int parseAlarmList(char *buffer, long length);
 static int checkfilter(char *filter, char *ip);
 static void pushcheckinentry(PushEntry *p);
 static void pushcleanupentry(PushEntry *p);
 static void pushDeleteSuiteNoVM(SuiteIdType id);
 static void pushDeleteSuiteLive(SuiteIdType id);
 static int pushOpenInternal(int startListening);
-static void pushDeleteEntry(PushEntry *p, PushEntry **pPrevNext);
+static void pushDeleteEntry(PushEntry *p);
+static void pushLinkEntry(PushEntry *pe);
+static void pushSetState(PushEntry *pe, int state);
+static void pushSetFd(PushEntry *pe, int fd);
+static int pushProcessPortIndexed(PushEntry *pe);
+static PushEntry *pushFindByFd(int fd);
+static PacketEntry *pushAllocPacket();
+static void pushFreeCachedPackets(PushEntry *pe);
+static void pushFreePacketPool();
+static int pushCacheNextDatagram(PushEntry *pe);
+static unsigned int pushSuiteHash(const char *storagename);
 static void alarmstart(AlarmEntry *entry, jlong alarm);
-static long readLine(char** ppszError, int handle, char* buffer, long length);
+static int readRegistryFile(const pcsl_string* pPathName,
+                            char** ppBuffer, long* pLength);
+static void writeRegistryFile(const pcsl_string* pPathName,
+                              char* buffer, long length);
+static void recoverRegistryFile(const pcsl_string* pPathName);
+static char* nextRegistryLine(char** ppPos, char* pEnd);
 
 static void pcsl_network_initialized(int isInit, int status);
 
@@ -457,6 +564,377 @@ static void pushAddNetworkNotifier(PushEntry* pe) {
     }
 }
 
+/**
+ * Removes an entry from a bucket of one of the push registry hash indexes.
+ *
+ * @param head address of the bucket
+ * @param pe entry to remove
+ * @param link name of the field that links the bucket
+ */
+#define PUSH_BUCKET_REMOVE(head, pe, link) {       \
+    PushEntry **pp = &(head);                      \
+    while (*pp != NULL) {                          \
+        if (*pp == (pe)) {                         \
+            *pp = (pe)->link;                      \
+            break;                                 \
+        }                                          \
+        pp = &(*pp)->link;                         \
+    }                                              \
+    (pe)->link = NULL;                             \
+}
+
+/**
+ * Computes the bucket of the suite index for a suite storage name.
+ *
+ * @param storagename storage name of the suite
+ * @return bucket number
+ */
+static unsigned int pushSuiteHash(const char *storagename) {
+    unsigned int hash = 0;
+
+    for (; *storagename; storagename++) {
+        hash = hash * 31 + (unsigned char)*storagename;
+    }
+
+    return hash & (PUSH_INDEX_SIZE - 1);
+}
+
+/**
+ * Adds an entry to the list of entries in the same state.
+ *
+ * @param pe push entry
+ */
+static void pushStateListAdd(PushEntry *pe) {
+    int i = PUSH_STATE_INDEX(pe->state);
+
+    if (i < 0 || i >= PUSH_STATE_COUNT) {
+        return;
+    }
+
+    pe->nextInState = NULL;
+    pe->prevInState = pushStateTail[i];
+    if (pushStateTail[i] != NULL) {
+        pushStateTail[i]->nextInState = pe;
+    } else {
+        pushStateHead[i] = pe;
+    }
+    pushStateTail[i] = pe;
+}
+
+/**
+ * Removes an entry from the list of entries in the same state.
+ *
+ * @param pe push entry
+ */
+static void pushStateListRemove(PushEntry *pe) {
+    int i = PUSH_STATE_INDEX(pe->state);
+
+    if (i < 0 || i >= PUSH_STATE_COUNT) {
+        return;
+    }
+
+    if (pe->prevInState != NULL) {
+        pe->prevInState->nextInState = pe->nextInState;
+    } else {
+        pushStateHead[i] = pe->nextInState;
+    }
+
+    if (pe->nextInState != NULL) {
+        pe->nextInState->prevInState = pe->prevInState;
+    } else {
+        pushStateTail[i] = pe->prevInState;
+    }
+
+    pe->prevInState = NULL;
+    pe->nextInState = NULL;
+}
+
+/**
+ * Adds an entry to the descriptor and port indexes.
+ *
+ * @param pe push entry
+ */
+static void pushIndexConnection(PushEntry *pe) {
+    unsigned int i;
+
+    if (pe->fd != -1) {
+        i = PUSH_FD_HASH(pe->fd);
+        pe->nextByFd = pushFdIndex[i];
+        pushFdIndex[i] = pe;
+    }
+
+    i = PUSH_PORT_HASH(pe->port);
+    pe->nextByPort = pushPortIndex[i];
+    pushPortIndex[i] = pe;
+}
+
+/**
+ * Removes an entry from the descriptor and port indexes.
+ *
+ * @param pe push entry
+ */
+static void pushUnindexConnection(PushEntry *pe) {
+    if (pe->fd != -1) {
+        PUSH_BUCKET_REMOVE(pushFdIndex[PUSH_FD_HASH(pe->fd)], pe, nextByFd);
+    }
+
+    PUSH_BUCKET_REMOVE(pushPortIndex[PUSH_PORT_HASH(pe->port)], pe,
+                       nextByPort);
+}
+
+/**
+ * Adds a new entry to the top of the push cached list and to all
+ * the indexes.
+ *
+ * @param pe push entry
+ */
+static void pushLinkEntry(PushEntry *pe) {
+    unsigned int i;
+
+    pe->prev = NULL;
+    pe->next = pushlist;
+    if (pushlist != NULL) {
+        pushlist->prev = pe;
+    }
+    pushlist = pe;
+    pushlength++;
+
+    pe->seq = ++pushSequence;
+
+    i = pushSuiteHash(pe->storagename);
+    pe->nextBySuite = pushSuiteIndex[i];
+    pushSuiteIndex[i] = pe;
+
+    pushIndexConnection(pe);
+    pushStateListAdd(pe);
+
+    pe->isIndexed = KNI_TRUE;
+}
+
+/**
+ * Removes an entry from the push cached list and from all the indexes.
+ *
+ * @param pe push entry
+ */
+static void pushUnlinkEntry(PushEntry *pe) {
+    if (!pe->isIndexed) {
+        return;
+    }
+
+    pushStateListRemove(pe);
+    pushUnindexConnection(pe);
+    PUSH_BUCKET_REMOVE(pushSuiteIndex[pushSuiteHash(pe->storagename)], pe,
+                       nextBySuite);
+
+    if (pe->prev != NULL) {
+        pe->prev->next = pe->next;
+    } else {
+        pushlist = pe->next;
+    }
+
+    if (pe->next != NULL) {
+        pe->next->prev = pe->prev;
+    }
+
+    pe->next = NULL;
+    pe->prev = NULL;
+    pushlength--;
+
+    pe->isIndexed = KNI_FALSE;
+}
+
+/**
+ * Changes the state of a push entry, keeping the state lists up to date.
+ *
+ * @param pe push entry
+ * @param state new state
+ */
+static void pushSetState(PushEntry *pe, int state) {
+    if (pe->state == state) {
+        return;
+    }
+
+    if (pe->isIndexed) {
+        pushStateListRemove(pe);
+        pe->state = state;
+        pushStateListAdd(pe);
+    } else {
+        pe->state = state;
+    }
+}
+
+/**
+ * Changes the listening descriptor of a push entry, keeping the
+ * descriptor index up to date.
+ *
+ * @param pe push entry
+ * @param fd new descriptor
+ */
+static void pushSetFd(PushEntry *pe, int fd) {
+    if (pe->isIndexed) {
+        pushUnindexConnection(pe);
+        pe->fd = fd;
+        pushIndexConnection(pe);
+    } else {
+        pe->fd = fd;
+    }
+}
+
+/**
+ * Calls pushProcessPort for an entry that is already in the list,
+ * keeping the descriptor and port indexes up to date.
+ *
+ * @param pe push entry
+ * @return the result of pushProcessPort
+ */
+static int pushProcessPortIndexed(PushEntry *pe) {
+    int status;
+
+    pushUnindexConnection(pe);
+    status = pushProcessPort(pe);
+    pushIndexConnection(pe);
+
+    return status;
+}
+
+/**
+ * Looks up the push entry listening on the given descriptor. When several
+ * entries share the descriptor, the one that comes first in the list is
+ * returned.
+ *
+ * @param fd listening descriptor
+ * @return the push entry or NULL if not found
+ */
+static PushEntry *pushFindByFd(int fd) {
+    PushEntry *p;
+    PushEntry *found = NULL;
+
+    for (p = pushFdIndex[PUSH_FD_HASH(fd)]; p != NULL; p = p->nextByFd) {
+        if (p->fd == fd && (found == NULL || p->seq > found->seq)) {
+            found = p;
+        }
+    }
+
+    return found;
+}
+
+/**
+ * Takes a packet from the packet pool, growing the pool by a slab of
+ * PACKETS_PER_SLAB packets if there is no free packet and the pool is
+ * below MAX_CACHED_PACKETS.
+ *
+ * @return an empty packet, or <tt>NULL</tt> if the limit is reached or
+ *         there is not enough memory
+ */
+static PacketEntry *pushAllocPacket() {
+    PacketEntry *pkt;
+
+    if (packetPool.objectSize == 0) {
+        midpPoolInit(&packetPool, MIDP_MEM_TAG_PUSH, sizeof (PacketEntry),
+                     PACKETS_PER_SLAB, MAX_CACHED_PACKETS);
+    }
+
+    pkt = (PacketEntry *)midpPoolAlloc(&packetPool);
+    if (pkt == NULL) {
+        return NULL;
+    }
+
+    pkt->next = NULL;
+    pkt->length = 0;
+    pkt->offs = 0;
+
+    return pkt;
+}
+
+/**
+ * Returns a packet to the packet pool.
+ *
+ * @param pkt packet taken with pushAllocPacket()
+ */
+static void pushFreePacket(PacketEntry *pkt) {
+    midpPoolFree(&packetPool, pkt);
+}
+
+/**
+ * Returns all the packets cached for a push entry to the packet pool.
+ *
+ * @param pe push entry
+ */
+static void pushFreeCachedPackets(PushEntry *pe) {
+    PacketEntry *pkt;
+
+    while (pe->pCachedData != NULL) {
+        pkt = pe->pCachedData;
+        pe->pCachedData = pkt->next;
+        pushFreePacket(pkt);
+    }
+}
+
+/**
+ * Releases the memory of the packet pool. All of the packets must have
+ * been returned to the pool.
+ */
+static void pushFreePacketPool() {
+    ASSERT(packetPool.inUse == 0);
+
+    midpPoolDestroy(&packetPool);
+}
+
+/**
+ * Reads one more datagram for a datagram push entry whose MIDlet is
+ * being launched and appends it to the packets cached for the entry,
+ * so a burst arriving during the MIDlet startup is not lost.
+ *
+ * @param pe push entry in LAUNCH_PENDING state
+ *
+ * @return <tt>1</tt> if a datagram was cached, <tt>0</tt> if it was
+ *         left in the socket
+ */
+static int pushCacheNextDatagram(PushEntry *pe) {
+    PacketEntry *pkt;
+    PacketEntry *last = NULL;
+    int count = 0;
+    int status;
+    unsigned char ipBytes[MAX_ADDR_LENGTH];
+    void *context = NULL;
+
+    for (pkt = pe->pCachedData; pkt != NULL; pkt = pkt->next) {
+        last = pkt;
+        count++;
+    }
+
+    if (count >= MAX_CACHED_PACKETS_PER_ENTRY) {
+        return 0;
+    }
+
+    pkt = pushAllocPacket();
+    if (pkt == NULL) {
+        return 0;
+    }
+
+    status = pcsl_datagram_read_finish((void *)pe->fd, ipBytes,
+                                       &pkt->senderport, pkt->buffer,
+                                       MAX_CACHED_DATA_SIZE, &pkt->length,
+                                       context);
+    if (status != PCSL_NET_SUCCESS) {
+        pushFreePacket(pkt);
+        return 0;
+    }
+
+    memcpy(&pkt->ipAddress, ipBytes, MAX_ADDR_LENGTH);
+
+    if (last == NULL) {
+        pe->pCachedData = pkt;
+    } else {
+        last->next = pkt;
+    }
+
+    /* Keep reading the burst until the MIDlet checks the connection out. */
+    pcsl_add_network_notifier((void *)pe->fd, PCSL_NET_CHECK_READ);
+
+    return 1;
+}
+
 /**
  * Opens the pushregistry files and populate the push memory structures.
  *
@@ -480,11 +958,15 @@ int pushopen() {
  * @return 0 for success else non-zero if a resource problem
  */
 static int pushOpenInternal(int startListening) {
-    int pushfd;
+    char *buffer;
+    long length;
     int status, push_status, alarm_status;
 
     push_status = alarm_status = 0;
 
+    /* Push entries are small and many, take them from size class pools */
+    midpEnableSizeClasses(MIDP_MEM_TAG_PUSH, PUSH_OBJECTS_PER_CHUNK);
+
     /* Check whether the alarm file has been already read. */
     if (PCSL_TRUE == pcsl_string_is_null(&alarmpathname)) {
         /*
@@ -518,19 +1000,12 @@ static int pushOpenInternal(int startListening) {
             push_status = -1;
         } else {
             /* Now read the registered connections. */
-            pushfd = storage_open(&errStr, &pushpathname, OPEN_READ);
-            if (errStr == NULL) {
-                /* Read through the file one line at a time */
-                status = parsePushList(pushfd);
+            status = readRegistryFile(&pushpathname, &buffer, &length);
+            if (status == 0) {
+                /* Parse the whole file in memory */
+                status = parsePushList(buffer, length);
+                midpFree(buffer);
 
-                /* Close the storage handle */
-                storageClose (&errStr, pushfd);
-                storageFreeError(errStr);
-
-                /*
-                 * IMPL_NOTE: don't check for -1 because in this case some
-                 * entries can be read anyway
-                 */
                 if (status != -2) { /* out of memory */
                     if (startListening) {
                         pushStartListening();
@@ -538,15 +1013,15 @@ static int pushOpenInternal(int startListening) {
                 } else {
                     push_status = -1;
                 }
+            } else if (status == -2) {
+                push_status = -1;
             } else {
-                REPORT_WARN1(LC_PROTOCOL,
-                             "Warning: could not open push registration file: %s",
-                             errStr);
+                REPORT_WARN(LC_PROTOCOL,
+                            "Warning: could not read push registration file");
                 /* 
                  * This is normal until the first push registration
                  * is created.
                  */
-                storageFreeError(errStr);
             }
         }
 
@@ -566,6 +1041,8 @@ static int pushOpenInternal(int startListening) {
 void pushclose() {
     pushListFree();
     alarmListFree();
+    pushFreePacketPool();
+    midpReleaseSizeClasses(MIDP_MEM_TAG_PUSH);
 #if ENABLE_JSR_82
     bt_push_shutdown();
 #endif
@@ -578,24 +1055,33 @@ void pushclose() {
  * file for use in subsequent runs.
  */
 static void pushsave() {
-    int  pushfd;
     PushEntry *p;
+    char *buffer;
+    long length = 0;
+    long pos = 0;
+    int len;
 
-    pushfd = storage_open(&errStr, &pushpathname, OPEN_READ_WRITE_TRUNCATE);
-    if (errStr == NULL){
-        /* Write a new list of push registrations to the persistent file */
-        for (p = pushlist; p != NULL ; p = p->next) {
-            storageWrite(&errStr, pushfd, p->value, strlen(p->value));
-            storageWrite(&errStr, pushfd, "\n", 1);
-        }
-        /* Close the storage handle */
-        storageClose (&errStr, pushfd);
-    } else {
-        REPORT_WARN1(LC_PROTOCOL,
-                     "Warning: could not write push registration file: %s",
-                     errStr);
-        storageFreeError(errStr);
+    for (p = pushlist; p != NULL ; p = p->next) {
+        length += strlen(p->value) + 1;
+    }
+
+    buffer = (char *)midpMalloc(length > 0 ? length : 1);
+    if (buffer == NULL) {
+        REPORT_WARN(LC_PROTOCOL,
+                    "Warning: out of memory saving push registration file");
+        return;
+    }
+
+    /* Write a new list of push registrations with a single write */
+    for (p = pushlist; p != NULL ; p = p->next) {
+        len = strlen(p->value);
+        memcpy(buffer + pos, p->value, len);
+        pos += len;
+        buffer[pos++] = '\n';
     }
+
+    writeRegistryFile(&pushpathname, buffer, length);
+    midpFree(buffer);
 }
 
 /**
@@ -725,7 +1211,7 @@ int pushadd(char *str) {
     }
 
     /* Add the new entry. */
-    pe = (PushEntry *)midpMalloc(sizeof(PushEntry));
+    pe = (PushEntry *)midpTaggedMalloc(sizeof(PushEntry), MIDP_MEM_TAG_PUSH);
     if (NULL == pe) {
         return -2;
     }
@@ -739,13 +1225,15 @@ int pushadd(char *str) {
         midpFree(pe->value);
         midpFree(pe->storagename);
         midpFree(pe->filter);
-        midpFree(pe);
+        midpTaggedFree(pe);
 
         return -2;
     }
 
+    pe->isIndexed = KNI_FALSE;
     pe->state = AVAILABLE;
     pe->fd = -1;
+    pe->port = -1;
     pe->fdsock = -1;
     pe->fdAccepted = -1;
     pe->pCachedData = NULL;
@@ -779,7 +1267,7 @@ int pushadd(char *str) {
             midpFree(pe->value);
             midpFree(pe->storagename);
             midpFree(pe->filter);
-            midpFree(pe);
+            midpTaggedFree(pe);
             return -3;
         }
 
@@ -789,13 +1277,11 @@ int pushadd(char *str) {
          * there is a chance network is just not up yet.
          */
     } else {
-        pe->state = CHECKED_IN;
+        pushSetState(pe, CHECKED_IN);
         pushAddNetworkNotifier(pe);
     }
 
-    pe->next = pushlist;
-    pushlist = pe;
-    pushlength++;
+    pushLinkEntry(pe);
 
     pushsave();
 
@@ -814,12 +1300,9 @@ int pushadd(char *str) {
  */
 int pushdel(char *str, char *store) {
     PushEntry *p;
-    PushEntry **pPrevNext = &pushlist;
-    PushEntry *tmp;
 
     /* Find the entry to remove. */
-    for (p = pushlist; p != NULL ; p = tmp) {
-        tmp = p->next;
+    for (p = pushlist; p != NULL ; p = p->next) {
         if (strncmp (str, p->value, strlen(str)) == 0) {
             /* Check if the connection belongs to another suite. */
             if (strcmp(store, p->storagename) != 0) {
@@ -828,12 +1311,10 @@ int pushdel(char *str, char *store) {
 #if ENABLE_JSR_82
             bt_push_unregister_url(str);
 #endif
-            pushDeleteEntry(p, pPrevNext);
+            pushDeleteEntry(p);
             pushsave();
             return 0;
         }
-
-        pPrevNext = &p->next;
     }
     return -1;
 }
@@ -843,11 +1324,13 @@ int pushdel(char *str, char *store) {
  * This function does the actual work.
  *
  * @param p A pointer to the push entry to be removed
- * @param pPrevNext Address of the <tt>Next</tt> field of the
- *        previous push entry
  */
-static void pushDeleteEntry(PushEntry *p, PushEntry **pPrevNext) {
+static void pushDeleteEntry(PushEntry *p) {
     void *context = NULL;
+
+    /* Remove the registration entry from the list and the indexes. */
+    pushUnlinkEntry(p);
+
     if (p->fd != -1) {
         /*
          * Cleanup any connections before closing
@@ -890,7 +1373,7 @@ static void pushDeleteEntry(PushEntry *p, PushEntry **pPrevNext) {
         p->fd = -1;
     }
 
-    p->state = AVAILABLE;
+    pushSetState(p, AVAILABLE);
 
     midpFree(p->value);
     p->value = NULL;
@@ -901,13 +1384,7 @@ static void pushDeleteEntry(PushEntry *p, PushEntry **pPrevNext) {
     midpFree(p->storagename);
     p->storagename = NULL;
 
-    /* Remove the registration entry from the list. */
-    *pPrevNext = p->next;
-
-    midpFree(p);
-
-    pushlength--;
-
+    midpTaggedFree(p);
 }
 
 /**
@@ -919,6 +1396,10 @@ static void pushDeleteEntry(PushEntry *p, PushEntry **pPrevNext) {
 int pushcacheddatasize(int fd) {
     PushEntry *p;
 
+    if (packetPool.inUse == 0) {
+        return -1;
+    }
+
     for (p = pushlist; p != NULL ; p = p->next) {
         if ((p->fd == fd && p->pCachedData != NULL) ||
             (p->fdAccepted == fd && p->pCachedData != NULL)) {
@@ -942,8 +1423,14 @@ int pushcacheddatasize(int fd) {
  */
 int pushgetcachedpacket(int fd, int *ip, int *sndport, char *buf, int len) {
     PushEntry *p;
+    PacketEntry *pkt;
     int length = -1;
 
+    /* Nothing to look up on the common path of a non-push connection. */
+    if (packetPool.inUse == 0) {
+        return -1;
+    }
+
     /* Find the entry to pass off the open file descriptor. */
     for (p = pushlist; p != NULL; p = p->next) {
         if (((p->fd == fd && p->fdAccepted == -1) || (p->fdAccepted == fd)) &&
@@ -965,10 +1452,17 @@ int pushgetcachedpacket(int fd, int *ip, int *sndport, char *buf, int len) {
             }
 
             if (p->pCachedData->offs >= p->pCachedData->length) {
-                p->fdAccepted = -1;
-                /* Destroy the cached entry after it has been read. */
-                midpFree(p->pCachedData);
-                p->pCachedData = NULL;
+                /*
+                 * Return the packet to the pool after it has been read,
+                 * the next cached packet (if any) is read next time.
+                 */
+                pkt = p->pCachedData;
+                p->pCachedData = pkt->next;
+                pushFreePacket(pkt);
+
+                if (p->pCachedData == NULL) {
+                    p->fdAccepted = -1;
+                }
             }
 
             return length;
@@ -988,17 +1482,47 @@ int pushcheckoutaccept(int fd) {
     int temp;
 
     /* Find the entry to pass off the open file descriptor. */
-    for (p = pushlist; p != NULL ; p = p->next) {
-        if (p->fd == fd) {
-            temp = p->fdsock;
-            p->fdsock = -1;
-            return temp;
-        }
+    p = pushFindByFd(fd);
+    if (p != NULL) {
+        temp = p->fdsock;
+        p->fdsock = -1;
+        return temp;
     }
 
     return -1;
 }
 
+/**
+ * Checks out a push entry matching the requested connection.
+ *
+ * @param p The matching push entry
+ * @param store The storage name of the requesting Suite
+ *
+ * @return <tt>-2</tt> if the connection is reserved by another suite,
+ * otherwise returns the previously opened file descriptor.
+ */
+static int pushCheckoutEntry(PushEntry *p, char *store) {
+    int fd;
+
+    /* Check if the current suite reserved the port. */
+    if (strcmp(store, p->storagename) != 0) {
+        return -2;
+    }
+
+    fd = p->fd;
+
+    /* The push system should stop monitoring this connection. */
+    if (pushIsSocketConnection(p->value)) {
+        pcsl_remove_network_notifier((void*)fd, PCSL_NET_CHECK_ACCEPT);
+    } else if (pushIsDatagramConnection(p->value)) {
+        pcsl_remove_network_notifier((void*)fd, PCSL_NET_CHECK_READ);
+    }
+
+    pushSetState(p, CHECKED_OUT);
+
+    return fd;
+}
+
 /**
  * Checks out the handle for the requested connection.
  * The CHECKED_OUT token
@@ -1014,14 +1538,18 @@ int pushcheckoutaccept(int fd) {
  */
 int pushcheckout(char* protocol, int port, char * store) {
     PushEntry *p;
-    int fd;
-    jboolean wmaProtocol = KNI_FALSE;
+    PushEntry *found = NULL;
     jboolean standardProtocol = KNI_FALSE;
+#if (ENABLE_JSR_82 || ENABLE_JSR_205 || ENABLE_JSR_120)
+    jboolean wmaProtocol = KNI_FALSE;
 #if ENABLE_JSR_82
     bt_bool_t is_bluetooth = bt_is_bluetooth_url(protocol);
 #endif
 
-    /* Find the entry to pass off the open file descriptor. */
+    /*
+     * Bluetooth and WMA connections are not matched by the port alone,
+     * so the whole list is checked.
+     */
     for (p = pushlist; p != NULL ; p = p->next) {
 #if ENABLE_JSR_82
         if (is_bluetooth == BT_BOOL_TRUE &&
@@ -1037,7 +1565,11 @@ int pushcheckout(char* protocol, int port, char * store) {
         wmaProtocol = isWmaProtocol(p->port, p->value,
                                     p->storagename, port, store);
 #endif
-
+#else
+    /* Only the entries registered for the port can match. */
+    for (p = pushPortIndex[PUSH_PORT_HASH(port)]; p != NULL;
+            p = p->nextByPort) {
+#endif
 
 #if ENABLE_JSR_180
         /*
@@ -1059,27 +1591,19 @@ int pushcheckout(char* protocol, int port, char * store) {
         standardProtocol = (p->port == port &&
                             strncmp(p->value, protocol, strlen(protocol)) == 0);
 #endif
-        if (standardProtocol || wmaProtocol) {
-            /* Check if the current suite reserved the port. */
-            if (strcmp(store, p->storagename) != 0) {
-                return -2;
-            }
-
-            fd = p->fd;
-
-            /* The push system should stop monitoring this connection. */
-            if (pushIsSocketConnection(p->value)) {
-                pcsl_remove_network_notifier((void*)fd, PCSL_NET_CHECK_ACCEPT);
-            } else if (pushIsDatagramConnection(p->value)) {
-                pcsl_remove_network_notifier((void*)fd, PCSL_NET_CHECK_READ);
-            }
-
-            p->state = CHECKED_OUT;
-
-            return fd;
+#if (ENABLE_JSR_82 || ENABLE_JSR_205 || ENABLE_JSR_120)
+        standardProtocol = standardProtocol || wmaProtocol;
+#endif
+        /* The entry that comes first in the list wins. */
+        if (standardProtocol && (found == NULL || p->seq > found->seq)) {
+            found = p;
         }
     }
 
+    if (found != NULL) {
+        return pushCheckoutEntry(found, store);
+    }
+
     return -1;
 }
 
@@ -1093,14 +1617,13 @@ int pushcheckin(int fd) {
     PushEntry *p;
 
     /* Find the entry to check in the open file descriptor. */
-    for (p = pushlist; p != NULL ; p = p->next) {
-        if (p->fd == fd) {
-            if (p->state == CHECKED_OUT) {
-                pushcheckinentry(p);
-            }
-
-            return 0;
+    p = pushFindByFd(fd);
+    if (p != NULL) {
+        if (p->state == CHECKED_OUT) {
+            pushcheckinentry(p);
         }
+
+        return 0;
     }
 
     return -1;
@@ -1166,7 +1689,17 @@ pushcheckinbymidlet(SuiteIdType suiteId, char* pszClassName) {
     const pcsl_string* strId = midp_suiteid2pcsl_string(suiteId);
     const char* pszSuiteId = (char*)pcsl_string_get_utf8_data(strId);
 
+    if (pszSuiteId == NULL) {
+        return;
+    }
+
+#ifdef ENABLE_JSR_82
+    /* Bluetooth services of all the suites are re-activated below. */
     for (p = pushlist; p != NULL ; p = p->next) {
+#else
+    for (p = pushSuiteIndex[pushSuiteHash(pszSuiteId)]; p != NULL;
+            p = p->nextBySuite) {
+#endif
 #ifdef ENABLE_JSR_82
         /* IMPL_NOTE: Provide a separate function for this functionality.
          * This function is called when a MIDlet terminates, and we use it to
@@ -1177,7 +1710,7 @@ pushcheckinbymidlet(SuiteIdType suiteId, char* pszClassName) {
         if (bt_push_parse_url(p->value, &port, NULL) == BT_RESULT_SUCCESS) {
             bt_handle_t handle = bt_push_start_server(&port);
             if (handle != BT_INVALID_HANDLE) {
-                p->fd = (int)handle;
+                pushSetFd(p, (int)handle);
             }
             continue;
         }
@@ -1230,7 +1763,7 @@ static void pushcheckinentry(PushEntry *pe) {
     pushcleanupentry(pe);
 
     if (pe->fd != -1) {
-        pe->state = CHECKED_IN;
+        pushSetState(pe, CHECKED_IN);
         pushAddNetworkNotifier(pe);
     }
 }
@@ -1268,11 +1801,8 @@ static void pushcleanupentry(PushEntry *p) {
         p->fdAccepted = -1;
     }
 
-    /* Remove the cached datagram (if any). */
-    if (p->pCachedData != NULL) {
-        midpFree(p->pCachedData);
-        p->pCachedData = NULL;
-    }
+    /* Remove the cached datagrams (if any). */
+    pushFreeCachedPackets(p);
 }
 
 #if ENABLE_JSR_180
@@ -1384,13 +1914,12 @@ static char* pushApplySipFilter(PushEntry* pushp) {
                    and last entry of shared connections chain */
                 pushcheckinentry(next);
                 /* and clear chached data for shared connection */
-                midpFree(pushp->pCachedData);
-                pushp->pCachedData = NULL;
+                pushFreeCachedPackets(pushp);
                 break;
             } else if (pushp == next) {
                 /*  mark first chain element as checked in and look for
                     next element */
-                next->state = CHECKED_IN;
+                pushSetState(next, CHECKED_IN);
             } else {
                 /*  keep the state for the rest:
                     non-sip and  intermediate chanin member */
@@ -1405,7 +1934,7 @@ static char* pushApplySipFilter(PushEntry* pushp) {
     midpFree(sender);
 
     if (found && LAUNCH_PENDING != next->state) {
-        next->state = LAUNCH_PENDING;
+        pushSetState(next, LAUNCH_PENDING);
         return midpStrdup(next->value);
     }
 
@@ -1442,7 +1971,7 @@ static char* pushAcceptConnection(PushEntry* pushp, int prevState) {
         REPORT_INFO(LC_PROTOCOL, "(Push)Resource limit exceeded for"
                     " TCP client sockets");
         pushp->fdsock = -1;
-        pushp->state = prevState;
+        pushSetState(pushp, prevState);
         return NULL;
     }
 
@@ -1470,10 +1999,10 @@ static char* pushAcceptConnection(PushEntry* pushp, int prevState) {
         if (checkForEndOfHeader(pushp->pCachedData->buffer, 
                                 MAX_CACHED_DATA_SIZE)){
             pushp->fdAccepted = pushp->fdsock;
-            pushp->state = prevState;
+            pushSetState(pushp, prevState);
             return pushApplySipFilter(pushp);
         } else {
-            pushp->state = WAITING_DATA;
+            pushSetState(pushp, WAITING_DATA);
             /* wait for end of header */
             pcsl_add_network_notifier((void *)pushp->fdsock,
                                       PCSL_NET_CHECK_READ);
@@ -1519,7 +2048,7 @@ static char* pushAcceptConnection(PushEntry* pushp, int prevState) {
         unsigned char ipBytes[MAX_ADDR_LENGTH];
 
 
-        pushp->pCachedData = (PacketEntry*) midpMalloc(sizeof (PacketEntry));
+        pushp->pCachedData = pushAllocPacket();
         if (pushp->pCachedData == NULL) {
             pushcheckinentry(pushp);
             return NULL;
@@ -1558,13 +2087,13 @@ static char* pushAcceptConnection(PushEntry* pushp, int prevState) {
             if (checkForEndOfHeader(pushp->pCachedData->buffer, 
                                     MAX_CACHED_DATA_SIZE)){
                 pushp->fdAccepted = pushp->fdsock;
-                pushp->state = prevState;
+                pushSetState(pushp, prevState);
             return pushApplySipFilter(pushp);
             }
             /* notifier will be added below */
         }
         if (status == PCSL_NET_WOULDBLOCK) {
-            pushp->state = WAITING_DATA;
+            pushSetState(pushp, WAITING_DATA);
             pcsl_add_network_notifier((void *)pushp->fdsock,
                                       PCSL_NET_CHECK_READ);
             return NULL;
@@ -1611,178 +2140,189 @@ char *pushfindfd(int fd) {
     void *context = NULL;
 
     /* Find the entry to pass off the open file descriptor. */
-    for (pushp = pushlist; pushp != NULL ; pushp = pushp->next) {
-        if ((pushp->fd == (int)fd)) {
-            for (pushtmp = pushp; pushtmp != NULL; pushtmp = pushtmp->next) {
-                if ((pushtmp->fd == fd) &&
-                    (pushtmp->state == LAUNCH_PENDING)) {
-                    /*
-                     * Some MIDlet is launching and expecting to
-                     * read from this fd. Don't steal its traffic.
-                     */
-                    return NULL;
-                }
-            }
+    pushp = NULL;
+    for (pushtmp = pushFdIndex[PUSH_FD_HASH(fd)]; pushtmp != NULL;
+            pushtmp = pushtmp->nextByFd) {
+        if (pushtmp->fd != fd) {
+            continue;
+        }
+
+        if (pushtmp->state == LAUNCH_PENDING) {
+            /*
+             * Some MIDlet is launching and expecting to
+             * read from this fd. Don't steal its traffic.
+             */
+            return NULL;
+        }
+
+        /* Entries sharing a descriptor are served in the list order. */
+        if (pushp == NULL || pushtmp->seq > pushp->seq) {
+            pushp = pushtmp;
+        }
+    }
 
-            temp_state = pushp->state;
-            pushp->state = LAUNCH_PENDING;
+    if (pushp != NULL) {
+        temp_state = pushp->state;
+        pushSetState(pushp, LAUNCH_PENDING);
 
 #ifdef ENABLE_JSR_82
-            if (bt_is_bluetooth_url(pushp->value)) {
-                bt_pushid_t id = bt_push_find_server((bt_handle_t)fd);
-                if (id != BT_INVALID_PUSH_HANDLE) {
-                    if (bt_push_accept(id, pushp->filter,
-                                       (bt_handle_t *)(void*)&pushp->fdsock)) {
-                        return midpStrdup(pushp->value);
-                    }
+        if (bt_is_bluetooth_url(pushp->value)) {
+            bt_pushid_t id = bt_push_find_server((bt_handle_t)fd);
+            if (id != BT_INVALID_PUSH_HANDLE) {
+                if (bt_push_accept(id, pushp->filter,
+                                   (bt_handle_t *)(void*)&pushp->fdsock)) {
+                    return midpStrdup(pushp->value);
                 }
-                pushcheckinentry(pushp);
-                return NULL;
             }
+            pushcheckinentry(pushp);
+            return NULL;
+        }
 #endif
 
+        /*
+         * Check the push filter, to see if this connection
+         * is acceptable.
+         */
+        if (strncmp(pushp->value, "datagram://:", 12) == 0) {
             /*
-             * Check the push filter, to see if this connection
-             * is acceptable.
+             * Read the datagram and save it til the application reads it.
+             * Datagrams that follow it before the application checks
+             * the connection out are queued after it, see
+             * findPushBlockedHandle().
              */
-            if (strncmp(pushp->value, "datagram://:", 12) == 0) {
-                /*
-                 * Read the datagram and save it til the application reads it.
-                 * This is a one datagram message queue.
-                 */
-                pushp->pCachedData = (PacketEntry*)
-                                     midpMalloc(sizeof (PacketEntry));
-                if (pushp->pCachedData == NULL) {
-                    pushcheckinentry(pushp);
-                    return NULL;
-                }
-
-                pushp->pCachedData->offs = 0;
-
-                status = pcsl_datagram_read_finish(
-                                                  (void *)pushp->fd,
-                                                  ipBytes,
-                                                  &(pushp->pCachedData->senderport),
-                                                  pushp->pCachedData->buffer,
-                                                  MAX_CACHED_DATA_SIZE,
-                                                  &(pushp->pCachedData->length),
-                                                  context);
-
-                if (status != PCSL_NET_SUCCESS) {
-                    /*
-                     * Receive failed - no data available.
-                     * cancel the launch pending
-                     * set listening state to CHECKED_IN
-                     * to prevent forever loop
-                     */
-                    pushcheckinentry(pushp);
-                    return NULL;
-                }
-
-                /* Set the raw IP address */
-                memcpy(&(pushp->pCachedData->ipAddress),
-                       ipBytes, MAX_ADDR_LENGTH);
+            pushp->pCachedData = pushAllocPacket();
+            if (pushp->pCachedData == NULL) {
+                pushcheckinentry(pushp);
+                return NULL;
+            }
 
-                memset(ipAddress, '\0', MAX_HOST_LENGTH);
-                strcpy(ipAddress, pcsl_inet_ntoa(&ipBytes));
+            pushp->pCachedData->offs = 0;
 
-                /* Datagram and Socket connections use the IP filter. */
-                if (checkfilter(pushp->filter, ipAddress)) {
-                    return midpStrdup(pushp->value);
-                }
+            status = pcsl_datagram_read_finish(
+                                              (void *)pushp->fd,
+                                              ipBytes,
+                                              &(pushp->pCachedData->senderport),
+                                              pushp->pCachedData->buffer,
+                                              MAX_CACHED_DATA_SIZE,
+                                              &(pushp->pCachedData->length),
+                                              context);
 
+            if (status != PCSL_NET_SUCCESS) {
                 /*
-                 * Dispose of the filtered push request.
-                 * Release any cached datagrams.
+                 * Receive failed - no data available.
+                 * cancel the launch pending
+                 * set listening state to CHECKED_IN
+                 * to prevent forever loop
                  */
                 pushcheckinentry(pushp);
                 return NULL;
+            }
+
+            /* Set the raw IP address */
+            memcpy(&(pushp->pCachedData->ipAddress),
+                   ipBytes, MAX_ADDR_LENGTH);
+
+            memset(ipAddress, '\0', MAX_HOST_LENGTH);
+            strcpy(ipAddress, pcsl_inet_ntoa(&ipBytes));
+
+            /* Datagram and Socket connections use the IP filter. */
+            if (checkfilter(pushp->filter, ipAddress)) {
+                /* Catch the datagrams sent during the MIDlet startup. */
+                pcsl_add_network_notifier((void *)pushp->fd,
+                                          PCSL_NET_CHECK_READ);
+                return midpStrdup(pushp->value);
+            }
+
+            /*
+             * Dispose of the filtered push request.
+             * Release any cached datagrams.
+             */
+            pushcheckinentry(pushp);
+            return NULL;
 #if ENABLE_SERVER_SOCKET
-            } else if (pushIsSocketConnection(pushp->value)) {
-                return pushAcceptConnection(pushp, temp_state);
+        } else if (pushIsSocketConnection(pushp->value)) {
+            return pushAcceptConnection(pushp, temp_state);
 #endif
-            }
+        }
 #if ENABLE_JSR_180
-            /* Check for JSR180 SIP/SIPS connections (UDP). */
-            else if (pushp->isSIPEntry) {
+        /* Check for JSR180 SIP/SIPS connections (UDP). */
+        else if (pushp->isSIPEntry) {
 
-                /* Special case: shared connection. Cached datagram is stored 
-                   at first push entry buffer */
-                /*
-                 * Read the SIP datagram and save it til the
-                 * application reads it.
-                 * This is a one SIP datagram message queue.
-                 */
-                pushp->pCachedData = (PacketEntry*)
-                                     midpMalloc(sizeof (PacketEntry));
-                if (pushp->pCachedData == NULL) {
-                    pushcheckinentry(pushp);
-                    return NULL;
-                }
+            /* Special case: shared connection. Cached datagram is stored 
+               at first push entry buffer */
+            /*
+             * Read the SIP datagram and save it til the
+             * application reads it.
+             * This is a one SIP datagram message queue.
+             */
+            pushp->pCachedData = pushAllocPacket();
+            if (pushp->pCachedData == NULL) {
+                pushcheckinentry(pushp);
+                return NULL;
+            }
 
-                pushp->pCachedData->offs = 0;
+            pushp->pCachedData->offs = 0;
 
-                status = pcsl_datagram_read_finish(
-                                                  (void *)pushp->fd,
-                                                  ipBytes,
-                                                  &(pushp->pCachedData->senderport),
-                                                  pushp->pCachedData->buffer,
-                                                  MAX_CACHED_DATA_SIZE,
-                                                  &(pushp->pCachedData->length),
-                                                  context);
+            status = pcsl_datagram_read_finish(
+                                              (void *)pushp->fd,
+                                              ipBytes,
+                                              &(pushp->pCachedData->senderport),
+                                              pushp->pCachedData->buffer,
+                                              MAX_CACHED_DATA_SIZE,
+                                              &(pushp->pCachedData->length),
+                                              context);
 
-                if (status != PCSL_NET_SUCCESS) {
-                    /*
-                     * Receive failed - no data available.
-                     * cancel the launch pending
-                     */
-                    pushcheckinentry(pushp);
-                    return NULL;
-                }
+            if (status != PCSL_NET_SUCCESS) {
+                /*
+                 * Receive failed - no data available.
+                 * cancel the launch pending
+                 */
+                pushcheckinentry(pushp);
+                return NULL;
+            }
 
-                /* Set the raw IP address */
-                memcpy(&(pushp->pCachedData->ipAddress),
-                       ipBytes, MAX_ADDR_LENGTH);
+            /* Set the raw IP address */
+            memcpy(&(pushp->pCachedData->ipAddress),
+                   ipBytes, MAX_ADDR_LENGTH);
 
-                REPORT_INFO1(LC_PROTOCOL,
-                             "SIP Push Message: %s",
-                             pushp->pCachedData->buffer);
-                /* restore state that will be processed separately at 
-                   pushApplySipFilter */
-                pushp->state = temp_state;
+            REPORT_INFO1(LC_PROTOCOL,
+                         "SIP Push Message: %s",
+                         pushp->pCachedData->buffer);
+            /* restore state that will be processed separately at 
+               pushApplySipFilter */
+            pushSetState(pushp, temp_state);
 
-                return pushApplySipFilter(pushp);
-            }
+            return pushApplySipFilter(pushp);
+        }
 #endif
 
 #if ENABLE_JSR_257
-            else if(pushp->isNFCEntry) {
-                char *entry = pushp->value;
-                if(strncmp(entry, "ndef:",5) == 0) {
-                    return pcsl_mem_strdup(entry);
-                } else {
-                    return NULL;
-                }
-            }        
+        else if(pushp->isNFCEntry) {
+            char *entry = pushp->value;
+            if(strncmp(entry, "ndef:",5) == 0) {
+                return pcsl_mem_strdup(entry);
+            } else {
+                return NULL;
+            }
+        }        
 #endif 
 
 #if (ENABLE_JSR_205 || ENABLE_JSR_120)
-            else{
-                /*
-                 * Return a valid push entry, if the WMA message has been
-                 * succesfully received (which for sms, mms includes a
-                 * filter check); otherwise return NULL.
-                 */
-                if (pushp->isWMAMessCached){
-                    return getWmaPushEntry(pushp->value);
-                } else{
-                    pushp->state = temp_state;
-                    return NULL;
-                }
+        else{
+            /*
+             * Return a valid push entry, if the WMA message has been
+             * succesfully received (which for sms, mms includes a
+             * filter check); otherwise return NULL.
+             */
+            if (pushp->isWMAMessCached){
+                return getWmaPushEntry(pushp->value);
+            } else{
+                pushSetState(pushp, temp_state);
+                return NULL;
             }
-#endif
-            return NULL;
         }
+#endif
+        return NULL;
     }
 
     /*
@@ -1937,8 +2477,9 @@ char *pushfindsuite(char *store, int available){
     char *connlist = NULL;
     int connlistlen = 0;
 
-    /* Find the entry to pass off the open file descriptor. */
-    for (p = pushlist; p != NULL ; p = p->next){
+    /* Walk only the entries hashed to this suite. */
+    for (p = pushSuiteIndex[pushSuiteHash(store)]; p != NULL;
+            p = p->nextBySuite){
         if (strcmp(store, p->storagename) == 0){
             for (ptr = p->value, len=0; *ptr && (*ptr != ','); ptr++, len++) {
             }
@@ -2007,49 +2548,43 @@ char *pushfindsuite(char *store, int available){
 }
 
 /**
- * Parses the persistent push registry from disk into the
+ * Parses the persistent push registry read from disk into the
  * in memory cache representation.
  *
- * @param pushfd file descriptor for reading
- * @return <tt>0</tt> if successful, <tt>-1</tt> if there was an error opening
- * the push registry file, <tt>-2</tt> if there was a memory allocation failure
+ * @param buffer contents of the push registry file, modified in place
+ * @param length length of the contents in bytes
+ * @return <tt>0</tt> if successful, <tt>-2</tt> if there was a memory
+ * allocation failure
  */
-static int parsePushList(int pushfd){
-    char buffer[MAX_LINE+1];
-    char *errStr = NULL;
+static int parsePushList(char *buffer, long length){
+    char *pos = buffer;
+    char *line;
     PushEntry *pe;
 
-    /* Read a line at a time */
-    while (readLine(&errStr, pushfd, buffer, sizeof(buffer)) != 0){
-
-        if (errStr != NULL){
-            REPORT_WARN2(LC_PROTOCOL,
-                         "Warning: could not read push registration: %s; buffer = '%s'",
-                         errStr, buffer);
-            storageFreeError(errStr);
-            return -1;
-        }
-
-        pe = (PushEntry *) midpMalloc (sizeof(PushEntry));
+    /* Walk through the buffer a line at a time */
+    while ((line = nextRegistryLine(&pos, buffer + length)) != NULL){
+        pe = (PushEntry *)midpTaggedMalloc(sizeof(PushEntry),
+                                         MIDP_MEM_TAG_PUSH);
 
         if (pe == NULL){
             pushListFree();
             return -2;
         }
 
-        pe->next = pushlist;
-        pe->value = midpStrdup(buffer);
+        pe->isIndexed = KNI_FALSE;
+        pe->value = midpStrdup(line);
         pe->storagename = midpStrdup(pushstorage(pe->value, 3));
 
         if ((pe->value == NULL) || (pe->storagename == NULL)){
             midpFree(pe->value);
             midpFree(pe->storagename);
-            midpFree(pe);
+            midpTaggedFree(pe);
             pushListFree();
             return -2;
         } else{
             pe->filter = pushfilter(pe->value);
             pe->fd = -1;
+            pe->port = -1;
             pe->fdsock = -1;
             pe->fdAccepted = -1;
             pe->state = AVAILABLE;
@@ -2072,18 +2607,7 @@ static int parsePushList(int pushfd){
          * Add the new entry to the top of the push cached
          * list.
          */
-        pushlist = pe;
-        pushlength++;
-    }
-
-    /* This check is required for the case when readLine() didn't put
-       any characters into the buffer and while() was not executed */
-    if (errStr != NULL){
-        REPORT_WARN1(LC_PROTOCOL,
-                     "Warning: could not read push registration: %s",
-                     errStr);
-        storageFreeError(errStr);
-        return -1;
+        pushLinkEntry(pe);
     }
 
     return 0;
@@ -2091,14 +2615,15 @@ static int parsePushList(int pushfd){
 
 static void pushStartListening(){
     PushEntry *pe;
+    PushEntry *penext;
 
-    for (pe = pushlist; pe != NULL ; pe = pe->next){
-        if (pe->state == AVAILABLE){
-            pushProcessPort(pe);
-            if (pe->fd != -1){
-                pe->state = CHECKED_IN;
-                pushAddNetworkNotifier(pe);
-            }
+    for (pe = pushStateHead[PUSH_STATE_INDEX(AVAILABLE)]; pe != NULL;
+            pe = penext){
+        penext = pe->nextInState;
+        pushProcessPortIndexed(pe);
+        if (pe->fd != -1){
+            pushSetState(pe, CHECKED_IN);
+            pushAddNetworkNotifier(pe);
         }
     }
 }
@@ -2584,7 +3109,7 @@ static void pushListFree(){
 
     /* clean up the list */
     for (pushp = pushlist; pushp != NULL; pushp = pushlist){
-        pushDeleteEntry(pushp, &pushlist);
+        pushDeleteEntry(pushp);
     }
 }
 
@@ -2599,17 +3124,45 @@ static void pushListFree(){
  *         returned
  */
 int findPushBlockedHandle(int handle){
-    PushEntry *pushp, *pushtmp;
+    PushEntry *pushp;
+    PushEntry *found = NULL;
+
     if (pushlength > 0 ){
-        for (pushp = pushlist; pushp != NULL; pushp = pushtmp){
-            pushtmp = pushp->next;
-            if ((handle == pushp->fd &&
-                 pushp->state != CHECKED_OUT &&
-                 pushp->state != LAUNCH_PENDING) ||
-                (handle == pushp->fdsock && pushp->state == WAITING_DATA)){
-                pushp->state = RECEIVED_EVENT;
-                return handle;
+        /* Listening descriptors are looked up through the fd index. */
+        for (pushp = pushFdIndex[PUSH_FD_HASH(handle)]; pushp != NULL;
+                pushp = pushp->nextByFd){
+            if (handle == pushp->fd &&
+                pushp->state == LAUNCH_PENDING &&
+                pushp->pCachedData != NULL &&
+                strncmp(pushp->value, "datagram://:", 12) == 0){
+                /*
+                 * More datagrams while the MIDlet is starting up,
+                 * buffer them for the MIDlet. Nobody has to be woken up.
+                 */
+                pushCacheNextDatagram(pushp);
+                return 0;
             }
+
+            if (handle == pushp->fd &&
+                pushp->state != CHECKED_OUT &&
+                pushp->state != LAUNCH_PENDING &&
+                (found == NULL || pushp->seq > found->seq)){
+                found = pushp;
+            }
+        }
+
+        /* Accepted sockets are only of interest while waiting for data. */
+        for (pushp = pushStateHead[PUSH_STATE_INDEX(WAITING_DATA)];
+                pushp != NULL; pushp = pushp->nextInState){
+            if (handle == pushp->fdsock &&
+                (found == NULL || pushp->seq > found->seq)){
+                found = pushp;
+            }
+        }
+
+        if (found != NULL){
+            pushSetState(found, RECEIVED_EVENT);
+            return handle;
         }
     }
     return 0;
@@ -2653,8 +3206,8 @@ int findPushTimerBlockedHandle(int handle){
  *         <tt>-1</tt> if the currently running Java thread is to block.
  */
 int pushpoll(){
-    int i;
     PushEntry * pe;
+    PushEntry * penext;
 
     AlarmEntry *alarmp;
     AlarmEntry *alarmtmp;
@@ -2668,27 +3221,27 @@ int pushpoll(){
 
     /* Find pending network push. */
     if (pushlength > 0 ){
-        for (i = 0, pe = pushlist; i < pushlength && pe != NULL; i++){
-            if (pe->state == AVAILABLE){
-                /*
-                 * When pushopen was called the port for this entry was busy,
-                 * so try again.
-                 */
-                pushProcessPort(pe);
-                if (pe->fd != -1){
-                    REPORT_INFO1(LC_PUSH,
-                                 "Push network signal on descriptor %x", pe->fd);
-
-                    pe->state = CHECKED_IN;
-                    pushAddNetworkNotifier(pe);
-                }
-            }
+        for (pe = pushStateHead[PUSH_STATE_INDEX(AVAILABLE)]; pe != NULL;
+                pe = penext){
+            penext = pe->nextInState;
+            /*
+             * When pushopen was called the port for this entry was busy,
+             * so try again.
+             */
+            pushProcessPortIndexed(pe);
+            if (pe->fd != -1){
+                REPORT_INFO1(LC_PUSH,
+                             "Push network signal on descriptor %x", pe->fd);
 
-            if (pe->state == RECEIVED_EVENT){
-                return pe->fd;
+                pushSetState(pe, CHECKED_IN);
+                pushAddNetworkNotifier(pe);
             }
+        }
 
-            pe = pe->next;
+        /* The RECEIVED_EVENT list is the ready list, oldest event first. */
+        pe = pushStateHead[PUSH_STATE_INDEX(RECEIVED_EVENT)];
+        if (pe != NULL){
+            return pe->fd;
         }
     }
 
@@ -2752,7 +3305,6 @@ static void pushDeleteSuiteNoVM(SuiteIdType id){
  */
 static void pushDeleteSuiteLive(SuiteIdType id){
     PushEntry *pushp;
-    PushEntry **pPrevNext = &pushlist;
     PushEntry *pushnext;
 
     AlarmEntry *alarmp;
@@ -2766,18 +3318,15 @@ static void pushDeleteSuiteLive(SuiteIdType id){
     }
 
     /* Find all of the entries to remove. */
-    for (pushp = pushlist; pushp != NULL; pushp = pushnext){
-        pushnext = pushp->next;
+    for (pushp = pushSuiteIndex[pushSuiteHash(pszID)]; pushp != NULL;
+            pushp = pushnext){
+        pushnext = pushp->nextBySuite;
         if (strcmp(pszID, pushp->storagename) == 0){
 #if ENABLE_JSR_82
             bt_push_unregister_url(pushp->value);
 #endif
-            pushDeleteEntry(pushp, pPrevNext);
-            /* Do not change push prev next */
-            continue;
+            pushDeleteEntry(pushp);
         }
-
-        pPrevNext = &pushp->next;
     }
 
     pushsave();
@@ -2805,33 +3354,24 @@ static void pushDeleteSuiteLive(SuiteIdType id){
 }
 
 /**
- * Parses the persistent alarm registry from disk into the
+ * Parses the persistent alarm registry read from disk into the
  * in memory cache representation.
  *
- * @param pushfd file descriptor for reading
- * @return <tt>0</tt> if successful, <tt>-1</tt> if an I/O error occurs,
- * <tt>-2</tt> if out of memory
+ * @param buffer contents of the alarm registry file, modified in place
+ * @param length length of the contents in bytes
+ * @return <tt>0</tt> if successful, <tt>-2</tt> if out of memory
  */
-static int parseAlarmList(int pushfd){
-    char buffer[MAX_LINE+1];
-    char *errStr = NULL;
+static int parseAlarmList(char *buffer, long length){
+    char *pos = buffer;
+    char *line;
     jlong alarm  = 0;
     AlarmEntry *pe = NULL;
     char *p;
 
-    /* Read a line at a time. */
-    while ( readLine(&errStr, pushfd, buffer, sizeof(buffer)) != 0 ){
-
-        if (errStr != NULL){
-            REPORT_WARN2(LC_PROTOCOL,
-                         "Warning: could not read alarm registration: %s; buffer = '%s'",
-                         errStr, buffer);
-            storageFreeError(errStr);
-            return -1;
-        }
-
+    /* Walk through the buffer a line at a time. */
+    while ((line = nextRegistryLine(&pos, buffer + length)) != NULL){
         /* Find the alarm time field. */
-        for (p = buffer; *p != 0; p++){
+        for (p = line; *p != 0; p++){
             if (*p == ','){
                 p++;
                 sscanf(p, PCSL_LLD, &alarm);
@@ -2855,7 +3395,7 @@ static int parseAlarmList(int pushfd){
         }
 
         pe->next = alarmlist;
-        pe->midlet = midpStrdup(buffer);
+        pe->midlet = midpStrdup(line);
         alarmstart(pe, alarm);
         pe->storagename = midpStrdup(pushstorage(pe->midlet, 2));
 
@@ -2874,18 +3414,6 @@ static int parseAlarmList(int pushfd){
         alarmlist = pe;
     }
 
-    /*
-     * This check is required for the case when readLine() didn't put
-     * any characters into the buffer and while() was not executed.
-     */
-    if (errStr != NULL){
-        REPORT_WARN1(LC_PROTOCOL,
-                     "Warning: could not read alarm registration: %s",
-                     errStr);
-        storageFreeError(errStr);
-        return -1;
-    }
-
     return 0;
 }
 
@@ -2896,30 +3424,27 @@ static int parseAlarmList(int pushfd){
  * @return <tt>0</tt> if successful, <tt>-1</tt> if a memory error occurred
  */
 static int alarmopen(){
-    int  pushfd;
-    int status = 0;
-
-    /* Now read the registered connections. */
-    pushfd = storage_open(&errStr, &alarmpathname, OPEN_READ);
-    if (errStr == NULL){
-        /* Read through the file one line at a time. */
-        status = parseAlarmList(pushfd);
+    char *buffer;
+    long length;
+    int status;
 
-        /* Close the storage handle. */
-        storageClose (&errStr, pushfd);
-        storageFreeError(errStr);
-        if (status == -2){
-            REPORT_ERROR(LC_PROTOCOL,
-                         "Error: alarmopen out of memory when parsing alarm list");
-            return -1;
-        }
+    /* Now read the registered alarms. */
+    status = readRegistryFile(&alarmpathname, &buffer, &length);
+    if (status == 0){
+        /* Parse the whole file in memory. */
+        status = parseAlarmList(buffer, length);
+        midpFree(buffer);
+    }
 
+    if (status == -2){
+        REPORT_ERROR(LC_PROTOCOL,
+                     "Error: alarmopen out of memory when parsing alarm list");
+        return -1;
+    }
 
-    } else{
-        REPORT_WARN1(LC_PROTOCOL,
-                     "Warning: could not open alarm registration file: %s",
-                     errStr);
-        storageFreeError(errStr);
+    if (status != 0){
+        REPORT_WARN(LC_PROTOCOL,
+                    "Warning: could not read alarm registration file");
     }
 
     return 0;
@@ -2930,29 +3455,33 @@ static int alarmopen(){
  * file for use in subsequent runs.
  */
 static void alarmsave(){
-    int pushfd;
     AlarmEntry *alarmp;
-    AlarmEntry *alarmtmp=NULL;
+    char *buffer;
+    long length = 0;
+    long pos = 0;
+    int len;
 
-    pushfd = storage_open(&errStr, &alarmpathname, OPEN_READ_WRITE_TRUNCATE);
-    if (errStr == NULL){
-        /* Write a new list of push registrations to the persistent file */
-        for (alarmp = alarmlist; alarmp != NULL ; alarmp = alarmtmp){
-            alarmtmp = alarmp->next;
-            storageWrite(&errStr, pushfd, alarmp->midlet,
-                         strlen(alarmp->midlet));
-            storageWrite(&errStr, pushfd, "\n", 1);
-        }
+    for (alarmp = alarmlist; alarmp != NULL ; alarmp = alarmp->next){
+        length += strlen(alarmp->midlet) + 1;
+    }
 
-        /* Close the storage handle */
-        storageClose (&errStr, pushfd);
-    } else{
-        REPORT_WARN1(LC_PROTOCOL,
-                     "Warning: could not write alarm registration file: %s",
-                     errStr);
-        storageFreeError(errStr);
+    buffer = (char *)midpMalloc(length > 0 ? length : 1);
+    if (buffer == NULL){
+        REPORT_WARN(LC_PROTOCOL,
+                    "Warning: out of memory saving alarm registration file");
         return;
     }
+
+    /* Write a new list of alarm registrations with a single write */
+    for (alarmp = alarmlist; alarmp != NULL ; alarmp = alarmp->next){
+        len = strlen(alarmp->midlet);
+        memcpy(buffer + pos, alarmp->midlet, len);
+        pos += len;
+        buffer[pos++] = '\n';
+    }
+
+    writeRegistryFile(&alarmpathname, buffer, length);
+    midpFree(buffer);
 }
 /**
  * Starts a timer for a single alarm entry.
@@ -3078,66 +3607,277 @@ int alarmadd(char *str, jlong alarm, jlong *lastalarm){
     return 0 ;
 }
 
-/*
- * Reads from an open file in storage, returning the number of bytes read.
- * May read less than the length of the buffer.
+/**
+ * Reads the whole registry file into a newly allocated buffer with
+ * a single storage read. The buffer is one byte longer than the file
+ * so the last line can always be zero terminated in place.
+ *
+ * @param pPathName name of the file to read
+ * @param ppBuffer receives the buffer, must be freed by the caller with
+ *        midpFree; NULL on error
+ * @param pLength receives the length of the file contents
  *
- * If not successful *ppszError will be set to point to an error string,
- * on success it will be set to NULL.
+ * @return <tt>0</tt> if successful, <tt>-1</tt> if the file could not be
+ *         read, <tt>-2</tt> if out of memory
  */
-static long
-readLine(char** ppszError, int handle, char* buffer, long length){
-    long pos = 0;
-    char ch;
-    jboolean comments_on = KNI_FALSE;
+static int readRegistryFile(const pcsl_string* pPathName,
+                            char** ppBuffer, long* pLength){
+    char *pszError = NULL;
+    char *pszTemp;
+    char *buffer = NULL;
+    long size = 0;
+    long len;
+    int handle;
+    int status = 0;
 
-    /* Buffer must be at least 2 bytes long to keep the ending zero. */
-    if (length <= 1){
-        *ppszError = NULL;
-        return 0;
+    *ppBuffer = NULL;
+    *pLength = 0;
+
+    recoverRegistryFile(pPathName);
+
+    handle = storage_open(&pszError, pPathName, OPEN_READ);
+    if (pszError != NULL){
+        storageFreeError(pszError);
+        return -1;
     }
 
-    while ( storageRead(ppszError, handle, &ch, 1) != -1 ){
-        if (*ppszError != NULL){
+    do {
+        size = storageSizeOf(&pszError, handle);
+        if (pszError != NULL || size < 0){
+            status = -1;
             break;
         }
 
-        /* End of Line. */
-        if ( ch == '\n' ){
+        buffer = (char *)midpMalloc(size + 1);
+        if (buffer == NULL){
+            status = -2;
+            break;
+        }
 
-            /* If the current line is a comment, go to the next one. */
-            if (comments_on == KNI_TRUE){
-                comments_on = KNI_FALSE;
-                continue;
+        if (size > 0){
+            len = storageRead(&pszError, handle, buffer, size);
+            if (pszError != NULL || len != size){
+                midpFree(buffer);
+                buffer = NULL;
+                status = -1;
+                break;
             }
+        }
 
-            break;
+        buffer[size] = 0;
+    } while (0);
+
+    storageFreeError(pszError);
+
+    storageClose(&pszTemp, handle);
+    storageFreeError(pszTemp);
+
+    if (status == 0){
+        *ppBuffer = buffer;
+        *pLength = size;
+    }
+
+    return status;
+}
+
+/**
+ * Makes the names of the temporary and previous files of a registry file.
+ *
+ * @param pPathName name of the registry file
+ * @param pTmpPathName receives the name of the temporary file
+ * @param pBakPathName receives the name of the previous file
+ *
+ * @return 0 for success, -2 if there is not enough memory
+ */
+static int getRegistryPathNames(const pcsl_string* pPathName,
+                                pcsl_string* pTmpPathName,
+                                pcsl_string* pBakPathName){
+    if (PCSL_STRING_OK !=
+            pcsl_string_cat(pPathName, &TMP_FILE_SUFFIX, pTmpPathName)){
+        return -2;
+    }
+
+    if (PCSL_STRING_OK !=
+            pcsl_string_cat(pPathName, &BAK_FILE_SUFFIX, pBakPathName)){
+        pcsl_string_free(pTmpPathName);
+        return -2;
+    }
+
+    return 0;
+}
+
+/**
+ * Deletes a file if it exists, ignoring errors.
+ *
+ * @param pPathName name of the file
+ */
+static void deleteRegistryLeftover(const pcsl_string* pPathName){
+    char *pszError;
+
+    if (storage_file_exists(pPathName)){
+        storage_delete_file(&pszError, pPathName);
+        storageFreeError(pszError);
+    }
+}
+
+/**
+ * Completes or rolls back a rewrite of a registry file that was
+ * interrupted, see writeRegistryFile(). If the registry file exists, it
+ * is the last complete one and the leftovers are deleted. If only the
+ * previous file is left, the temporary file is complete and becomes the
+ * registry file, or, if it is gone too, the previous file is put back.
+ * A temporary file alone is an incomplete first write and is deleted.
+ *
+ * @param pPathName name of the registry file
+ */
+static void recoverRegistryFile(const pcsl_string* pPathName){
+    pcsl_string tmpPathName = PCSL_STRING_NULL;
+    pcsl_string bakPathName = PCSL_STRING_NULL;
+    char *pszError = NULL;
+
+    if (getRegistryPathNames(pPathName, &tmpPathName, &bakPathName) != 0){
+        return;
+    }
+
+    if (!storage_file_exists(pPathName) &&
+            storage_file_exists(&bakPathName)){
+        if (storage_file_exists(&tmpPathName)){
+            storage_rename_file(&pszError, &tmpPathName, pPathName);
+        } else {
+            storage_rename_file(&pszError, &bakPathName, pPathName);
         }
 
-        /* Ignore carriage returns and skip comment lines. */
-        if (ch == '\r' || comments_on == KNI_TRUE){
-            continue;
+        if (pszError != NULL){
+            REPORT_WARN1(LC_PROTOCOL,
+                         "Warning: could not recover registration file: %s",
+                         pszError);
+            storageFreeError(pszError);
         }
+    }
 
-        /* Skip comment lines which begin with '#'. */
-        if (ch == '#' && pos == 0){
-            comments_on = KNI_TRUE;
-            continue;
+    if (storage_file_exists(pPathName)){
+        deleteRegistryLeftover(&tmpPathName);
+        deleteRegistryLeftover(&bakPathName);
+    } else if (!storage_file_exists(&bakPathName)){
+        deleteRegistryLeftover(&tmpPathName);
+    }
+
+    pcsl_string_free(&tmpPathName);
+    pcsl_string_free(&bakPathName);
+}
+
+/**
+ * Writes the given buffer to a temporary file with a single storage write
+ * and then replaces the registry file with it. The storage layer deletes
+ * the target of a rename first, so the old registry file is moved aside
+ * to a previous file and only deleted once the temporary file has taken
+ * its place. Whatever point the write stops at, readRegistryFile() finds
+ * either the old or the new contents, never a truncated registry.
+ *
+ * @param pPathName name of the registry file
+ * @param buffer contents to write
+ * @param length number of bytes to write, the file is truncated if zero
+ */
+static void writeRegistryFile(const pcsl_string* pPathName,
+                              char* buffer, long length){
+    pcsl_string tmpPathName = PCSL_STRING_NULL;
+    pcsl_string bakPathName = PCSL_STRING_NULL;
+    char *pszError = NULL;
+    char *pszTemp;
+    int handle;
+
+    if (getRegistryPathNames(pPathName, &tmpPathName, &bakPathName) != 0){
+        REPORT_WARN(LC_PROTOCOL,
+                    "Warning: out of memory writing registration file");
+        return;
+    }
+
+    handle = storage_open(&pszError, &tmpPathName, OPEN_READ_WRITE_TRUNCATE);
+    if (pszError == NULL){
+        if (length > 0){
+            storageWrite(&pszError, handle, buffer, length);
         }
 
-        buffer[pos] = ch;
+        storageClose(&pszTemp, handle);
+        storageFreeError(pszTemp);
 
-        pos++;
-        if (pos == length-1){
-            break;
+        /* Keep the old contents until the new ones are in place */
+        if (pszError == NULL && storage_file_exists(pPathName)){
+            storage_rename_file(&pszError, pPathName, &bakPathName);
         }
 
+        if (pszError == NULL){
+            storage_rename_file(&pszError, &tmpPathName, pPathName);
+            if (pszError != NULL && storage_file_exists(&bakPathName)){
+                storage_rename_file(&pszTemp, &bakPathName, pPathName);
+                storageFreeError(pszTemp);
+            }
+        }
+
+        if (pszError == NULL){
+            deleteRegistryLeftover(&bakPathName);
+        } else {
+            deleteRegistryLeftover(&tmpPathName);
+        }
+    }
 
+    if (pszError != NULL){
+        REPORT_WARN1(LC_PROTOCOL,
+                     "Warning: could not write registration file: %s",
+                     pszError);
+        storageFreeError(pszError);
     }
 
-    buffer[pos] = 0;
+    pcsl_string_free(&tmpPathName);
+    pcsl_string_free(&bakPathName);
+}
+
+/**
+ * Returns the next registry entry from a buffer holding the contents of
+ * a registry file. The entry is zero terminated in place. Carriage returns
+ * are dropped, empty lines and comment lines that begin with '#' are
+ * skipped.
+ *
+ * @param ppPos current parsing position, updated to point past the
+ *        returned line
+ * @param pEnd end of the file contents; the byte at this address must be
+ *        writable
+ *
+ * @return the next entry or NULL if there are no more entries
+ */
+static char* nextRegistryLine(char** ppPos, char* pEnd){
+    char *pos = *ppPos;
+    char *line;
+    char *dst;
+
+    while (pos < pEnd){
+        line = pos;
+        dst = pos;
+
+        /* Compact the line in place removing carriage returns. */
+        while (pos < pEnd && *pos != '\n'){
+            if (*pos != '\r'){
+                *dst++ = *pos;
+            }
+            pos++;
+        }
+
+        /* Step over the end of line. */
+        if (pos < pEnd){
+            pos++;
+        }
+
+        *dst = 0;
 
-    return pos;
+        /* Skip empty lines and comment lines which begin with '#'. */
+        if (dst != line && *line != '#'){
+            *ppPos = pos;
+            return line;
+        }
+    }
+
+    *ppPos = pos;
+    return NULL;
 }
 
 /**
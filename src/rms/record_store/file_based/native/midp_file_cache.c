@@ -27,6 +27,7 @@
 #include <kni.h>
 #include "midp_file_cache.h"
 #include <midpMalloc.h>
+#include <midpServices.h>
 #include <midpStorage.h> /* IMPL_NOTE: use PCSL File API */
 #include <midp_logging.h>
 #include <midp_properties_port.h>
@@ -43,6 +44,12 @@
 
 #define UNINITIALIZED_CACHED_VALUE (-1)
 
+/*
+ * Size of the chunks the cache blocks are carved from. The blocks are
+ * released together once the cache has been flushed.
+ */
+#define FILE_CACHE_CHUNK_SIZE 4096
+
 /* Cache for a single file */
 static MidpFileCache *mFileCache;
 
@@ -149,12 +156,31 @@ static void midp_file_cache_finalize(char **ppszError, int stayOpen) {
             storagePosition(ppszError, mFileCache->handle,
                 mFileCache->cachedPosition);
         }
-        /* If read is cached, free all read blocks here */
+        /* Free the blocks a failed flush may have left */
+        midpArenaDestroy(&mFileCache->arena);
         midpFree(mFileCache);
         mFileCache = NULL;
     }
 }
 
+/**
+ * Called for the cache arena when the isolate that opened the cached file
+ * ends with the file still open. Writes the cached blocks out and stops
+ * caching, which releases the arena.
+ *
+ * @param pArena arena of the cache
+ */
+static void midp_file_cache_release(MidpArena* pArena) {
+    char* pszError;
+
+    (void)pArena;
+    midp_file_cache_finalize(&pszError, KNI_TRUE);
+    if (pszError != NULL) {
+        REPORT_ERROR1(LC_RMS, "File cache release failed: %s", pszError);
+        storageFreeError(pszError);
+    }
+}
+
 /** A helper function for midp_file_cache_flush(). */
 static
 void midp_file_cache_flush_using_buffer(char** ppszError, int handle,
@@ -205,11 +231,10 @@ void midp_file_cache_flush_using_buffer(char** ppszError, int handle,
                 storageWrite(ppszError, handle, buf, endPos-startPos);
                 CHECK_ERROR(*ppszError);
 
-                /* write successful, now free the cache blocks */
+                /* write successful, now drop the cache blocks */
                 while ( q != (b = mFileCache->blocks)) {
                     mFileCache->size -= b->length + sizeof(MidpFileCacheBlock);
                     mFileCache->blocks = b->next;
-                        midpFree(b);
                 }
         } else {
             storagePosition(ppszError, handle, b->position);
@@ -219,9 +244,12 @@ void midp_file_cache_flush_using_buffer(char** ppszError, int handle,
 
             mFileCache->size -= b->length + sizeof(MidpFileCacheBlock);
             mFileCache->blocks = b->next;
-            midpFree(b);
         }
     }
+
+    /* All the blocks are written, release their memory at once */
+    midpArenaReset(&mFileCache->arena);
+
     storageCommitWrite(ppszError, handle);
     CHECK_ERROR(*ppszError);
 
@@ -282,6 +310,11 @@ int midp_file_cache_open(char** ppszError, StorageIdType storageId,
             mFileCache->cachedAvailableSpace = UNINITIALIZED_CACHED_VALUE;
             mFileCache->cachedFileSize = storageSizeOf(ppszError, h);
             mFileCache->blocks = NULL;
+            /* The blocks belong to the isolate writing the file */
+            midpArenaInit(&mFileCache->arena, MIDP_MEM_TAG_RMS,
+                          FILE_CACHE_CHUNK_SIZE, getCurrentIsolateId());
+            midpArenaSetReleaseHook(&mFileCache->arena,
+                                    midp_file_cache_release);
         } else {
             /* More than one file is open. Available space can no longer been
              * cached. Stop caching completely. */
@@ -384,7 +417,8 @@ void midp_file_cache_write(char** ppszError, int handle,
     }
 
     /* Cache is not full, check if memory is full */
-    b = (MidpFileCacheBlock *)midpMalloc(sizeof(MidpFileCacheBlock)+length);
+    b = (MidpFileCacheBlock *)midpArenaAlloc(&mFileCache->arena,
+        sizeof(MidpFileCacheBlock)+length);
     if (b == NULL) {
         /* Out of memory. Write directly to storage */
         uncachedWrite(ppszError, handle, buffer, length);
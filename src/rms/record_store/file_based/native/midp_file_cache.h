@@ -30,6 +30,7 @@
 #include <midpStorage.h>
 #include <midp_constants_data.h>
 #include <java_types.h>
+#include <midpArena.h>
 
 typedef struct _MidpFileCacheBlock {
     struct _MidpFileCacheBlock *next;	/* next cache block */
@@ -46,6 +47,7 @@ typedef struct _MidpFileCache {
     long cachedFileSize;
     jlong cachedAvailableSpace;
     MidpFileCacheBlock *blocks;
+    MidpArena arena;			/* memory of the cache blocks */
 } MidpFileCache;
 
 void midp_file_cache_flush(char** ppszError, int handle);
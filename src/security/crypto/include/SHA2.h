@@ -0,0 +1,83 @@
+/*
+ *   
+ *
+ * Copyright  1990-2007 Sun Microsystems, Inc. All Rights Reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 only, as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details (a copy is
+ * included at /legal/license.txt).
+ * 
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this work; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ * 
+ * Please contact Sun Microsystems, Inc., 4150 Network Circle, Santa
+ * Clara, CA 95054 or visit www.sun.com if you need additional
+ * information or have any questions.
+ */
+
+/**
+ * @file
+ *
+ * SHA-256 and SHA-512 message digests (FIPS 180-2).
+ */
+
+#ifndef HEADER_SHA2_H
+#define HEADER_SHA2_H
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+#define SHA256_CBLOCK        64
+#define SHA256_DIGEST_LENGTH 32
+#define SHA512_CBLOCK        128
+#define SHA512_DIGEST_LENGTH 64
+
+/** Unsigned 32-bit word used by SHA-256. */
+typedef unsigned int SHA2_WORD32;
+
+/** Unsigned 64-bit word used by SHA-512. */
+#if defined(_MSC_VER)
+typedef unsigned __int64 SHA2_WORD64;
+#else
+typedef unsigned long long SHA2_WORD64;
+#endif
+
+typedef struct SHA256state_st {
+    SHA2_WORD32 h[8];
+    SHA2_WORD32 Nl, Nh;                 /* message length in bits */
+    unsigned char data[SHA256_CBLOCK];  /* partial block */
+    int num;                            /* bytes in data */
+} SHA256_CTX;
+
+typedef struct SHA512state_st {
+    SHA2_WORD64 h[8];
+    SHA2_WORD64 Nl, Nh;                 /* message length in bits */
+    unsigned char data[SHA512_CBLOCK];  /* partial block */
+    int num;                            /* bytes in data */
+} SHA512_CTX;
+
+void SHA256_Init(SHA256_CTX *c);
+void SHA256_Update(SHA256_CTX *c, const unsigned char *data,
+                   unsigned long len);
+void SHA256_Final(unsigned char *md, SHA256_CTX *c);
+
+void SHA512_Init(SHA512_CTX *c);
+void SHA512_Update(SHA512_CTX *c, const unsigned char *data,
+                   unsigned long len);
+void SHA512_Final(unsigned char *md, SHA512_CTX *c);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif /* HEADER_SHA2_H */
@@ -33,24 +33,26 @@ package com.sun.midp.crypto;
 final class MD5 extends MessageDigest {
     /*
      * The compute intensive operations are implemented in C
-     * based on the OpenSSL MD5 code (from pilotSSLeay). Here we
-     * replicate the state the C code needs.
+     * based on the OpenSSL MD5 code (from pilotSSLeay). The hash
+     * state stays in native memory between calls.
      */
 
-    /** State needed for MD5 hash, four elements correspond to A, B, C, D. */
-    private int[] state = new int[4];
-    /** State needed for MD5 hash. */
-    private int[] num = new int[1];
-    /** Number of bits modulo 2^64 (LSB first) */
-    private int[] count = new int[2];
-    /** Input data. */
-    private int[] data = new int[16];
-    
+    /** Native hash state, updated in place. */
+    private NativeDigestContext context;
+
     /** Create an MD5 digest object. */
     MD5() {
-        reset();
+        context = new NativeDigestContext(NativeDigestContext.MD5);
     }
-    
+
+    /**
+     * Create an MD5 digest object with the given state.
+     * @param context native hash state
+     */
+    private MD5(NativeDigestContext context) {
+        this.context = context;
+    }
+
     /** 
      * Gets the message digest algorithm.
      * @return algorithm implemented by this MessageDigest object
@@ -71,19 +73,7 @@ final class MD5 extends MessageDigest {
      * Resets the MessageDigest to the initial state for further use.
      */
     public void reset() {
-        count[0] = 0;
-        count[1] = 0;
-
-        // Load magic initialization constants.
-        state[0] = 0x67452301;
-        state[1] = 0xefcdab89;
-        state[2] = 0x98badcfe;
-        state[3] = 0x10325476;
-        
-        for (int i = 0; i < 16; i++) 
-            data[i] = 0;
-
-        num[0] = 0;
+        context.reset();
     }
 
     /**
@@ -103,24 +93,9 @@ final class MD5 extends MessageDigest {
         // check parameters to prevent VM from crashing
         int test = inBuf[inOff] + inBuf[inLen - 1] + inBuf[inOff + inLen - 1];
         
-        nativeUpdate(inBuf, inOff, inLen, state, num, count, data);
+        context.update(inBuf, inOff, inLen);
     }
     
-    /**
-     * Accumulates a hash of the input data. Continues an MD5
-     * message-digest operation, processing another message
-     * block, and updating the internal context.
-     * @param inBuf input buffer of data to be hashed
-     * @param inOff offset within inBuf where input data begins
-     * @param inLen length (in bytes) of data to be hashed
-     * @param state internal hash state
-     * @param num internal hash state
-     * @param count internal hash state
-     * @param data internal hash state
-     */
-    private static native void nativeUpdate(byte[] inBuf, int inOff,
-            int inLen, int[] state, int[] num, int[] count, int[] data);
-
     /**
      * Completes the hash computation by performing final operations
      * such as padding. The digest is reset after this call is made.
@@ -143,39 +118,15 @@ final class MD5 extends MessageDigest {
         // check the parameters to prevent a VM crash
         int test = buf[offset] + buf[offset + getDigestLength() - 1];
         
-        nativeFinal(null, 0, 0, buf, offset, state, num, count, data);
+        context.doFinal(buf, offset);
         return getDigestLength();
     }
 
-    /** 
-     * Generates a hash of all/last input data. Completes and returns the
-     * hash compuatation after performing final operations such as padding.
-     * The MessageDigest object is reset after this call. 
-     * @param inBuf input buffer of data to be hashed
-     * @param inOff offset within inBuf where input data begins
-     * @param inLen length (in bytes) of data to be hashed
-     * @param outBuf output buffer where the hash should be placed
-     * @param outOff offset within outBuf where the resulting hash begins
-     * @param state internal hash state
-     * @param num internal hash state
-     * @param count internal hash state
-     * @param data internal hash state
-     */ 
-    private static native void nativeFinal(byte[] inBuf, int inOff, 
-                           int inLen, byte[] outBuf, int outOff, 
-                           int[] state, int[] num, int[] count, int[] data);
-    
     /** 
      * Clones the MessageDigest object.
      * @return a clone of this object
      */
     public Object clone() {
-        MD5 cpy = new MD5();
-        
-        System.arraycopy(this.state, 0, cpy.state, 0, 4);
-        System.arraycopy(this.num, 0, cpy.num, 0, 1);
-        System.arraycopy(this.data, 0, cpy.data, 0, 16);
-        System.arraycopy(this.count, 0, cpy.count, 0, 2);
-        return cpy;
+        return new MD5(context.copy());
     }
 }
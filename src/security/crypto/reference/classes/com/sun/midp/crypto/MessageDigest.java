@@ -80,6 +80,10 @@ public abstract class MessageDigest {
             return new MD5();
         } else if (algorithm.equals("SHA-1")) {
             return new SHA();
+        } else if (algorithm.equals("SHA-256")) {
+            return new SHA256();
+        } else if (algorithm.equals("SHA-512")) {
+            return new SHA512();
         }
 
         throw new NoSuchAlgorithmException(algorithm);
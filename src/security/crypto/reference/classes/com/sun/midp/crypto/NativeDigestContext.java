@@ -0,0 +1,146 @@
+/*
+ *   
+ *
+ * Copyright  1990-2007 Sun Microsystems, Inc. All Rights Reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 only, as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details (a copy is
+ * included at /legal/license.txt).
+ * 
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this work; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ * 
+ * Please contact Sun Microsystems, Inc., 4150 Network Circle, Santa
+ * Clara, CA 95054 or visit www.sun.com if you need additional
+ * information or have any questions.
+ */
+
+package com.sun.midp.crypto;
+
+/**
+ * Message digest state held in native memory. The state stays resident
+ * between calls, so an update only hands the input data to native code.
+ * The native memory is released when the object is finalized.
+ */
+final class NativeDigestContext {
+    /** MD5 algorithm identifier. */
+    static final int MD5 = 0;
+    /** SHA-1 algorithm identifier. */
+    static final int SHA1 = 1;
+    /** SHA-256 algorithm identifier. */
+    static final int SHA256 = 2;
+    /** SHA-512 algorithm identifier. */
+    static final int SHA512 = 3;
+
+    /** Address of the native context, read by the native finalizer. */
+    private int nativePointer;
+
+    /**
+     * Creates a context in the initial state of an algorithm.
+     *
+     * @param algorithm algorithm identifier
+     */
+    NativeDigestContext(int algorithm) {
+        nativePointer = init0(algorithm);
+    }
+
+    /** Creates an empty context for {@link #copy()}. */
+    private NativeDigestContext() {
+    }
+
+    /**
+     * Accumulates a hash of the input data. The caller checks the
+     * arguments.
+     *
+     * @param inBuf input buffer of data to be hashed
+     * @param inOff offset within inBuf where input data begins
+     * @param inLen length (in bytes) of data to be hashed
+     */
+    void update(byte[] inBuf, int inOff, int inLen) {
+        update0(nativePointer, inBuf, inOff, inLen);
+    }
+
+    /**
+     * Completes the hash computation and resets the context. The caller
+     * checks that the output buffer can hold the digest.
+     *
+     * @param outBuf output buffer where the hash should be placed
+     * @param outOff offset within outBuf where the resulting hash begins
+     */
+    void doFinal(byte[] outBuf, int outOff) {
+        final0(nativePointer, outBuf, outOff);
+    }
+
+    /** Resets the context to its initial state. */
+    void reset() {
+        reset0(nativePointer);
+    }
+
+    /**
+     * Copies the context.
+     *
+     * @return independent context in the same state
+     */
+    NativeDigestContext copy() {
+        NativeDigestContext cpy = new NativeDigestContext();
+
+        cpy.nativePointer = copy0(nativePointer);
+        return cpy;
+    }
+
+    /**
+     * Allocates a native context.
+     *
+     * @param algorithm algorithm identifier
+     * @return address of the context
+     */
+    private static native int init0(int algorithm);
+
+    /**
+     * Allocates a copy of a native context.
+     *
+     * @param context address of the context to copy
+     * @return address of the copy
+     */
+    private static native int copy0(int context);
+
+    /**
+     * Accumulates a hash of the input data.
+     *
+     * @param context address of the native context
+     * @param inBuf input buffer of data to be hashed
+     * @param inOff offset within inBuf where input data begins
+     * @param inLen length (in bytes) of data to be hashed
+     */
+    private static native void update0(int context, byte[] inBuf,
+                                       int inOff, int inLen);
+
+    /**
+     * Completes the hash computation and resets the native context.
+     *
+     * @param context address of the native context
+     * @param outBuf output buffer where the hash should be placed
+     * @param outOff offset within outBuf where the resulting hash begins
+     */
+    private static native void final0(int context, byte[] outBuf,
+                                      int outOff);
+
+    /**
+     * Resets a native context.
+     *
+     * @param context address of the native context
+     */
+    private static native void reset0(int context);
+
+    /** Frees the native context. */
+    private native void finalize();
+}
@@ -32,22 +32,24 @@ package com.sun.midp.crypto;
 final class SHA extends MessageDigest {
     /*
      * The compute intensive operations are implemented in C
-     * based on the OpenSSL SHA code (from pilotSSLeay). Here we
-     * replicate the state the C code needs.
+     * based on the OpenSSL SHA code (from pilotSSLeay). The hash
+     * state stays in native memory between calls.
      */
 
-    /** State needed for SHA hash. */
-    private int[] state = new int[5]; // h0 ... h4
-    /** State needed for SHA hash. */
-    private int[] num = new int[1];
-    /** State needed for SHA hash. */
-    private int[] count = new int[2]; // Nl and Nh 
-    /** State needed for SHA hash. */
-    private int[] data = new int[16]; // data block 
+    /** Native hash state, updated in place. */
+    private NativeDigestContext context;
 
     /** Create SHA digest object. */
     SHA() {
-        reset();
+        context = new NativeDigestContext(NativeDigestContext.SHA1);
+    }
+
+    /**
+     * Create SHA digest object with the given state.
+     * @param context native hash state
+     */
+    private SHA(NativeDigestContext context) {
+        this.context = context;
     }
 
     /** 
@@ -70,16 +72,7 @@ final class SHA extends MessageDigest {
      * Resets the MessageDigest to the initial state for further use.
      */
     public void reset() {
-        // SHA1 initialization constants
-        state[0] = 0x67452301;
-        state[1] = 0xEFCDAB89;
-        state[2] = 0x98BADCFE;
-        state[3] = 0x10325476;
-        state[4] = 0xC3D2E1F0;
-        num[0] = 0;
-        count[0] = count[1] = 0;
-        for (int i = 0; i < data.length; i++)
-             data[i] = 0;
+        context.reset();
     }
 
     /**
@@ -97,23 +90,9 @@ final class SHA extends MessageDigest {
 
         // check parameters to avoid a VM crash
         int test = inBuf[inOff] + inBuf[inLen - 1] + inBuf[inOff + inLen - 1];
-        nativeUpdate(inBuf, inOff, inLen, state, num, count, data);
+        context.update(inBuf, inOff, inLen);
     }
 
-    /**
-     * Accumulates a hash of the input data. This method is useful when
-     * the input data to be hashed is not available in one byte array. 
-     * @param inBuf input buffer of data to be hashed
-     * @param inOff offset within inBuf where input data begins
-     * @param inLen length (in bytes) of data to be hashed
-     * @param state internal hash state
-     * @param num internal hash state
-     * @param count internal hash state
-     * @param data internal hash state
-     */
-    private static native void nativeUpdate(byte[] inBuf, int inOff, 
-	     int inLen, int[] state, int[] num, int[] count, int[] data);
-
 
     /**
      * Completes the hash computation by performing final operations
@@ -137,39 +116,15 @@ final class SHA extends MessageDigest {
         // check the parameters to prevent a VM crash
         int test = buf[offset] + buf[offset + getDigestLength() - 1];
         
-        nativeFinal(null, 0, 0, buf, offset, state, num, count, data);
+        context.doFinal(buf, offset);
         return getDigestLength();
     }
 
-    /** 
-     * Generates a hash of all/last input data. Completes and returns the
-     * hash compuatation after performing final operations such as padding.
-     * The MessageDigest object is reset after this call. 
-     * @param inBuf input buffer of data to be hashed
-     * @param inOff offset within inBuf where input data begins
-     * @param inLen length (in bytes) of data to be hashed
-     * @param outBuf output buffer where the hash should be placed
-     * @param outOff offset within outBuf where the resulting hash begins
-     * @param state internal hash state
-     * @param num internal hash state
-     * @param count internal hash state
-     * @param data internal hash state
-     */ 
-    private static native void nativeFinal(byte[] inBuf, int inOff, 
-		    int inLen, byte[] outBuf, int outOff,
-		    int[] state, int[] num, int[] count, int[] data);
-
     /** 
      * Clones the MessageDigest object.
      * @return a clone of this object
      */
     public Object clone() {
-	SHA cpy = new SHA();
-
-	System.arraycopy(this.state, 0, cpy.state, 0, this.state.length);
-	System.arraycopy(this.num, 0, cpy.num, 0, this.num.length);
-	System.arraycopy(this.count, 0, cpy.count, 0, this.count.length);
-	System.arraycopy(this.data, 0, cpy.data, 0, this.data.length);
-	return cpy;
+	return new SHA(context.copy());
     }
 }
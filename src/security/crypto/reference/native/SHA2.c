@@ -0,0 +1,395 @@
+/*
+ *   
+ *
+ * Copyright  1990-2007 Sun Microsystems, Inc. All Rights Reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 only, as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details (a copy is
+ * included at /legal/license.txt).
+ * 
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this work; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ * 
+ * Please contact Sun Microsystems, Inc., 4150 Network Circle, Santa
+ * Clara, CA 95054 or visit www.sun.com if you need additional
+ * information or have any questions.
+ */
+
+/*
+ * SHA-256 and SHA-512 as specified in FIPS 180-2.
+ *
+ * Both digests work on whole machine words: a block is loaded as
+ * big-endian words in one pass, the message schedule is kept in a
+ * 16-word circular window and the rounds are unrolled eight at a time
+ * so that the working variables are renamed rather than shuffled.
+ * Full blocks are hashed straight from the caller's buffer; only a
+ * trailing partial block is copied into the context.
+ */
+
+#include <string.h>
+
+#include <SHA2.h>
+
+#define LOAD32(p) \
+    (((SHA2_WORD32)(p)[0] << 24) | ((SHA2_WORD32)(p)[1] << 16) | \
+     ((SHA2_WORD32)(p)[2] <<  8) |  (SHA2_WORD32)(p)[3])
+
+#define STORE32(p, v) \
+    ((p)[0] = (unsigned char)((v) >> 24), \
+     (p)[1] = (unsigned char)((v) >> 16), \
+     (p)[2] = (unsigned char)((v) >>  8), \
+     (p)[3] = (unsigned char)(v))
+
+#define LOAD64(p) \
+    (((SHA2_WORD64)LOAD32(p) << 32) | (SHA2_WORD64)LOAD32((p) + 4))
+
+#define STORE64(p, v) \
+    (STORE32((p), (SHA2_WORD32)((v) >> 32)), \
+     STORE32((p) + 4, (SHA2_WORD32)(v)))
+
+#define ROTR32(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+#define ROTR64(x, n) (((x) >> (n)) | ((x) << (64 - (n))))
+
+#define CH(x, y, z)  (((x) & (y)) ^ (~(x) & (z)))
+#define MAJ(x, y, z) (((x) & (y)) ^ ((x) & (z)) ^ ((y) & (z)))
+
+#define S256_0(x) (ROTR32((x),  2) ^ ROTR32((x), 13) ^ ROTR32((x), 22))
+#define S256_1(x) (ROTR32((x),  6) ^ ROTR32((x), 11) ^ ROTR32((x), 25))
+#define s256_0(x) (ROTR32((x),  7) ^ ROTR32((x), 18) ^ ((x) >>  3))
+#define s256_1(x) (ROTR32((x), 17) ^ ROTR32((x), 19) ^ ((x) >> 10))
+
+#define S512_0(x) (ROTR64((x), 28) ^ ROTR64((x), 34) ^ ROTR64((x), 39))
+#define S512_1(x) (ROTR64((x), 14) ^ ROTR64((x), 18) ^ ROTR64((x), 41))
+#define s512_0(x) (ROTR64((x),  1) ^ ROTR64((x),  8) ^ ((x) >> 7))
+#define s512_1(x) (ROTR64((x), 19) ^ ROTR64((x), 61) ^ ((x) >> 6))
+
+/*
+ * Next schedule word W[i] for i >= 16. X[i & 15] still holds W[i - 16]
+ * and is replaced in place.
+ */
+#define SCHEDULE(X, i, s0, s1) \
+    (X[(i) & 15] += s1(X[((i) - 2) & 15]) + X[((i) - 7) & 15] + \
+                    s0(X[((i) - 15) & 15]))
+
+/* One round; the caller rotates the variable names for the next one. */
+#define ROUND(a, b, c, d, e, f, g, h, K, W, S0, S1) { \
+    T1 = (h) + S1(e) + CH((e), (f), (g)) + (K) + (W); \
+    (d) += T1; \
+    (h) = T1 + S0(a) + MAJ((a), (b), (c)); \
+}
+
+#define ROUND256(a, b, c, d, e, f, g, h, i, W) \
+    ROUND(a, b, c, d, e, f, g, h, K256[i], W, S256_0, S256_1)
+
+#define ROUND512(a, b, c, d, e, f, g, h, i, W) \
+    ROUND(a, b, c, d, e, f, g, h, K512[i], W, S512_0, S512_1)
+
+/* Eight rounds with the working variables renamed after each one. */
+#define EIGHT_ROUNDS(R, i, W) { \
+    R(a, b, c, d, e, f, g, h, (i),     W((i))); \
+    R(h, a, b, c, d, e, f, g, (i) + 1, W((i) + 1)); \
+    R(g, h, a, b, c, d, e, f, (i) + 2, W((i) + 2)); \
+    R(f, g, h, a, b, c, d, e, (i) + 3, W((i) + 3)); \
+    R(e, f, g, h, a, b, c, d, (i) + 4, W((i) + 4)); \
+    R(d, e, f, g, h, a, b, c, (i) + 5, W((i) + 5)); \
+    R(c, d, e, f, g, h, a, b, (i) + 6, W((i) + 6)); \
+    R(b, c, d, e, f, g, h, a, (i) + 7, W((i) + 7)); \
+}
+
+#define W_LOADED(i) X[i]
+#define W256_NEXT(i) SCHEDULE(X, i, s256_0, s256_1)
+#define W512_NEXT(i) SCHEDULE(X, i, s512_0, s512_1)
+
+static const SHA2_WORD32 K256[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+    0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+    0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+    0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+    0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+    0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+/* 64-bit constants are built from halves to stay within C89 literals. */
+#define W64(hi, lo) (((SHA2_WORD64)(hi) << 32) | (SHA2_WORD64)(lo))
+
+static const SHA2_WORD64 K512[80] = {
+    W64(0x428a2f98, 0xd728ae22), W64(0x71374491, 0x23ef65cd),
+    W64(0xb5c0fbcf, 0xec4d3b2f), W64(0xe9b5dba5, 0x8189dbbc),
+    W64(0x3956c25b, 0xf348b538), W64(0x59f111f1, 0xb605d019),
+    W64(0x923f82a4, 0xaf194f9b), W64(0xab1c5ed5, 0xda6d8118),
+    W64(0xd807aa98, 0xa3030242), W64(0x12835b01, 0x45706fbe),
+    W64(0x243185be, 0x4ee4b28c), W64(0x550c7dc3, 0xd5ffb4e2),
+    W64(0x72be5d74, 0xf27b896f), W64(0x80deb1fe, 0x3b1696b1),
+    W64(0x9bdc06a7, 0x25c71235), W64(0xc19bf174, 0xcf692694),
+    W64(0xe49b69c1, 0x9ef14ad2), W64(0xefbe4786, 0x384f25e3),
+    W64(0x0fc19dc6, 0x8b8cd5b5), W64(0x240ca1cc, 0x77ac9c65),
+    W64(0x2de92c6f, 0x592b0275), W64(0x4a7484aa, 0x6ea6e483),
+    W64(0x5cb0a9dc, 0xbd41fbd4), W64(0x76f988da, 0x831153b5),
+    W64(0x983e5152, 0xee66dfab), W64(0xa831c66d, 0x2db43210),
+    W64(0xb00327c8, 0x98fb213f), W64(0xbf597fc7, 0xbeef0ee4),
+    W64(0xc6e00bf3, 0x3da88fc2), W64(0xd5a79147, 0x930aa725),
+    W64(0x06ca6351, 0xe003826f), W64(0x14292967, 0x0a0e6e70),
+    W64(0x27b70a85, 0x46d22ffc), W64(0x2e1b2138, 0x5c26c926),
+    W64(0x4d2c6dfc, 0x5ac42aed), W64(0x53380d13, 0x9d95b3df),
+    W64(0x650a7354, 0x8baf63de), W64(0x766a0abb, 0x3c77b2a8),
+    W64(0x81c2c92e, 0x47edaee6), W64(0x92722c85, 0x1482353b),
+    W64(0xa2bfe8a1, 0x4cf10364), W64(0xa81a664b, 0xbc423001),
+    W64(0xc24b8b70, 0xd0f89791), W64(0xc76c51a3, 0x0654be30),
+    W64(0xd192e819, 0xd6ef5218), W64(0xd6990624, 0x5565a910),
+    W64(0xf40e3585, 0x5771202a), W64(0x106aa070, 0x32bbd1b8),
+    W64(0x19a4c116, 0xb8d2d0c8), W64(0x1e376c08, 0x5141ab53),
+    W64(0x2748774c, 0xdf8eeb99), W64(0x34b0bcb5, 0xe19b48a8),
+    W64(0x391c0cb3, 0xc5c95a63), W64(0x4ed8aa4a, 0xe3418acb),
+    W64(0x5b9cca4f, 0x7763e373), W64(0x682e6ff3, 0xd6b2b8a3),
+    W64(0x748f82ee, 0x5defb2fc), W64(0x78a5636f, 0x43172f60),
+    W64(0x84c87814, 0xa1f0ab72), W64(0x8cc70208, 0x1a6439ec),
+    W64(0x90befffa, 0x23631e28), W64(0xa4506ceb, 0xde82bde9),
+    W64(0xbef9a3f7, 0xb2c67915), W64(0xc67178f2, 0xe372532b),
+    W64(0xca273ece, 0xea26619c), W64(0xd186b8c7, 0x21c0c207),
+    W64(0xeada7dd6, 0xcde0eb1e), W64(0xf57d4f7f, 0xee6ed178),
+    W64(0x06f067aa, 0x72176fba), W64(0x0a637dc5, 0xa2c898a6),
+    W64(0x113f9804, 0xbef90dae), W64(0x1b710b35, 0x131c471b),
+    W64(0x28db77f5, 0x23047d84), W64(0x32caab7b, 0x40c72493),
+    W64(0x3c9ebe0a, 0x15c9bebc), W64(0x431d67c4, 0x9c100d4c),
+    W64(0x4cc5d4be, 0xcb3e42b6), W64(0x597f299c, 0xfc657e2a),
+    W64(0x5fcb6fab, 0x3ad6faec), W64(0x6c44198c, 0x4a475817)
+};
+
+/**
+ * Hashes <code>blocks</code> consecutive 64-byte blocks.
+ *
+ * @param ctx SHA-256 context
+ * @param p first block, no alignment required
+ * @param blocks number of blocks
+ */
+static void sha256_blocks(SHA256_CTX *ctx, const unsigned char *p,
+                          unsigned long blocks) {
+    SHA2_WORD32 a, b, c, d, e, f, g, h, T1;
+    SHA2_WORD32 X[16];
+    int i;
+
+    while (blocks-- > 0) {
+        for (i = 0; i < 16; i++, p += 4) {
+            X[i] = LOAD32(p);
+        }
+
+        a = ctx->h[0]; b = ctx->h[1]; c = ctx->h[2]; d = ctx->h[3];
+        e = ctx->h[4]; f = ctx->h[5]; g = ctx->h[6]; h = ctx->h[7];
+
+        EIGHT_ROUNDS(ROUND256, 0, W_LOADED);
+        EIGHT_ROUNDS(ROUND256, 8, W_LOADED);
+        for (i = 16; i < 64; i += 8) {
+            EIGHT_ROUNDS(ROUND256, i, W256_NEXT);
+        }
+
+        ctx->h[0] += a; ctx->h[1] += b; ctx->h[2] += c; ctx->h[3] += d;
+        ctx->h[4] += e; ctx->h[5] += f; ctx->h[6] += g; ctx->h[7] += h;
+    }
+}
+
+/**
+ * Hashes <code>blocks</code> consecutive 128-byte blocks.
+ *
+ * @param ctx SHA-512 context
+ * @param p first block, no alignment required
+ * @param blocks number of blocks
+ */
+static void sha512_blocks(SHA512_CTX *ctx, const unsigned char *p,
+                          unsigned long blocks) {
+    SHA2_WORD64 a, b, c, d, e, f, g, h, T1;
+    SHA2_WORD64 X[16];
+    int i;
+
+    while (blocks-- > 0) {
+        for (i = 0; i < 16; i++, p += 8) {
+            X[i] = LOAD64(p);
+        }
+
+        a = ctx->h[0]; b = ctx->h[1]; c = ctx->h[2]; d = ctx->h[3];
+        e = ctx->h[4]; f = ctx->h[5]; g = ctx->h[6]; h = ctx->h[7];
+
+        EIGHT_ROUNDS(ROUND512, 0, W_LOADED);
+        EIGHT_ROUNDS(ROUND512, 8, W_LOADED);
+        for (i = 16; i < 80; i += 8) {
+            EIGHT_ROUNDS(ROUND512, i, W512_NEXT);
+        }
+
+        ctx->h[0] += a; ctx->h[1] += b; ctx->h[2] += c; ctx->h[3] += d;
+        ctx->h[4] += e; ctx->h[5] += f; ctx->h[6] += g; ctx->h[7] += h;
+    }
+}
+
+void SHA256_Init(SHA256_CTX *c) {
+    c->h[0] = 0x6a09e667; c->h[1] = 0xbb67ae85;
+    c->h[2] = 0x3c6ef372; c->h[3] = 0xa54ff53a;
+    c->h[4] = 0x510e527f; c->h[5] = 0x9b05688c;
+    c->h[6] = 0x1f83d9ab; c->h[7] = 0x5be0cd19;
+    c->Nl = 0;
+    c->Nh = 0;
+    c->num = 0;
+}
+
+void SHA256_Update(SHA256_CTX *c, const unsigned char *data,
+                   unsigned long len) {
+    SHA2_WORD32 l;
+    unsigned long n;
+
+    if (len == 0) {
+        return;
+    }
+
+    l = c->Nl + ((SHA2_WORD32)len << 3);
+    if (l < c->Nl) {
+        c->Nh++;
+    }
+    c->Nh += (SHA2_WORD32)(len >> 29);
+    c->Nl = l;
+
+    if (c->num != 0) {
+        n = SHA256_CBLOCK - c->num;
+        if (len < n) {
+            memcpy(c->data + c->num, data, len);
+            c->num += (int)len;
+            return;
+        }
+
+        memcpy(c->data + c->num, data, n);
+        sha256_blocks(c, c->data, 1);
+        data += n;
+        len -= n;
+        c->num = 0;
+    }
+
+    n = len / SHA256_CBLOCK;
+    if (n > 0) {
+        sha256_blocks(c, data, n);
+        n *= SHA256_CBLOCK;
+        data += n;
+        len -= n;
+    }
+
+    if (len > 0) {
+        memcpy(c->data, data, len);
+        c->num = (int)len;
+    }
+}
+
+void SHA256_Final(unsigned char *md, SHA256_CTX *c) {
+    unsigned char *p = c->data;
+    int n = c->num;
+    int i;
+
+    p[n++] = 0x80;
+    if (n > SHA256_CBLOCK - 8) {
+        memset(p + n, 0, SHA256_CBLOCK - n);
+        sha256_blocks(c, p, 1);
+        n = 0;
+    }
+    memset(p + n, 0, SHA256_CBLOCK - 8 - n);
+    STORE32(p + SHA256_CBLOCK - 8, c->Nh);
+    STORE32(p + SHA256_CBLOCK - 4, c->Nl);
+    sha256_blocks(c, p, 1);
+
+    for (i = 0; i < 8; i++, md += 4) {
+        STORE32(md, c->h[i]);
+    }
+}
+
+void SHA512_Init(SHA512_CTX *c) {
+    c->h[0] = W64(0x6a09e667, 0xf3bcc908);
+    c->h[1] = W64(0xbb67ae85, 0x84caa73b);
+    c->h[2] = W64(0x3c6ef372, 0xfe94f82b);
+    c->h[3] = W64(0xa54ff53a, 0x5f1d36f1);
+    c->h[4] = W64(0x510e527f, 0xade682d1);
+    c->h[5] = W64(0x9b05688c, 0x2b3e6c1f);
+    c->h[6] = W64(0x1f83d9ab, 0xfb41bd6b);
+    c->h[7] = W64(0x5be0cd19, 0x137e2179);
+    c->Nl = 0;
+    c->Nh = 0;
+    c->num = 0;
+}
+
+void SHA512_Update(SHA512_CTX *c, const unsigned char *data,
+                   unsigned long len) {
+    SHA2_WORD64 l;
+    unsigned long n;
+
+    if (len == 0) {
+        return;
+    }
+
+    l = c->Nl + ((SHA2_WORD64)len << 3);
+    if (l < c->Nl) {
+        c->Nh++;
+    }
+    c->Nh += (SHA2_WORD64)len >> 61;
+    c->Nl = l;
+
+    if (c->num != 0) {
+        n = SHA512_CBLOCK - c->num;
+        if (len < n) {
+            memcpy(c->data + c->num, data, len);
+            c->num += (int)len;
+            return;
+        }
+
+        memcpy(c->data + c->num, data, n);
+        sha512_blocks(c, c->data, 1);
+        data += n;
+        len -= n;
+        c->num = 0;
+    }
+
+    n = len / SHA512_CBLOCK;
+    if (n > 0) {
+        sha512_blocks(c, data, n);
+        n *= SHA512_CBLOCK;
+        data += n;
+        len -= n;
+    }
+
+    if (len > 0) {
+        memcpy(c->data, data, len);
+        c->num = (int)len;
+    }
+}
+
+void SHA512_Final(unsigned char *md, SHA512_CTX *c) {
+    unsigned char *p = c->data;
+    int n = c->num;
+    int i;
+
+    p[n++] = 0x80;
+    if (n > SHA512_CBLOCK - 16) {
+        memset(p + n, 0, SHA512_CBLOCK - n);
+        sha512_blocks(c, p, 1);
+        n = 0;
+    }
+    memset(p + n, 0, SHA512_CBLOCK - 16 - n);
+    STORE64(p + SHA512_CBLOCK - 16, c->Nh);
+    STORE64(p + SHA512_CBLOCK - 8, c->Nl);
+    sha512_blocks(c, p, 1);
+
+    for (i = 0; i < 8; i++, md += 8) {
+        STORE64(md, c->h[i]);
+    }
+}
@@ -35,10 +35,32 @@
 #include <commonKNIMacros.h>
 
 #include <midpError.h>
+#include <midpMalloc.h>
 #include <SHA.h>
+#include <SHA2.h>
 #include <MD5.h>
 #include <MD2.h>
 
+/* Algorithm identifiers, see com.sun.midp.crypto.NativeDigestContext. */
+#define DIGEST_MD5    0
+#define DIGEST_SHA1   1
+#define DIGEST_SHA256 2
+#define DIGEST_SHA512 3
+
+/**
+ * Digest state kept in native memory between calls. The Java object
+ * holds the address in its <code>nativePointer</code> field.
+ */
+typedef struct _DigestContext {
+    int algorithm;
+    union {
+        MD5_CTX md5;
+        SHA_CTX sha1;
+        SHA256_CTX sha256;
+        SHA512_CTX sha512;
+    } u;
+} DigestContext;
+
 KNIEXPORT KNI_RETURNTYPE_VOID
 Java_com_sun_midp_crypto_MD2_nativeUpdate() {
     unsigned long  inlen = KNI_GetParameterAsInt(3);
@@ -179,315 +201,248 @@ Java_com_sun_midp_crypto_MD2_nativeFinal() {
     KNI_ReturnVoid();
 }
 
-KNIEXPORT KNI_RETURNTYPE_VOID
-Java_com_sun_midp_crypto_MD5_nativeFinal() {
-    unsigned long outoff = KNI_GetParameterAsInt(5);
-    unsigned long  inlen = KNI_GetParameterAsInt(3);
-    unsigned long  inoff = KNI_GetParameterAsInt(2);
-    unsigned char md[16];
-    int i,j;
-    MD5_CTX c;
-
-    KNI_StartHandles(6);
-
-    KNI_DeclareHandle(data);
-    KNI_DeclareHandle(count);
-    KNI_DeclareHandle(num);
-    KNI_DeclareHandle(state);
-    KNI_DeclareHandle(outbuf);
-    KNI_DeclareHandle(inbuf);
-
-    KNI_GetParameterAsObject(9, data);
-    KNI_GetParameterAsObject(8, count);
-    KNI_GetParameterAsObject(7, num);
-    KNI_GetParameterAsObject(6, state);
-    KNI_GetParameterAsObject(4, outbuf);
-    KNI_GetParameterAsObject(1, inbuf);
-
-    /* Copy the context in */
-    KNI_GetRawArrayRegion(state,  0, 4, (jbyte*)&(c.A));
-    KNI_GetRawArrayRegion(state,  4, 4, (jbyte*)&(c.B));
-    KNI_GetRawArrayRegion(state,  8, 4, (jbyte*)&(c.C));
-    KNI_GetRawArrayRegion(state, 12, 4, (jbyte*)&(c.D));
-    KNI_GetRawArrayRegion(count,  0, 4, (jbyte*)&(c.Nl));
-    KNI_GetRawArrayRegion(count,  4, 4, (jbyte*)&(c.Nh));
-    KNI_GetRawArrayRegion(num,    0, 4, (jbyte*)&(c.num));
-    for (i = 0, j = 0 ; i < 16; i ++) {
-        KNI_GetRawArrayRegion(data, j, 4, (jbyte*)&(c.data[i]));
-        j += 4;
-    }
-        
-    /* Perform MD5Update if necessary */
-    if (inlen != 0) {
-        /* Do MD5 Update */
-        SNI_BEGIN_RAW_POINTERS;
-
-        MD5_Update(&c, (unsigned char*)&(JavaByteArray(inbuf)[inoff]), inlen);
-        
-        SNI_END_RAW_POINTERS;
-
+/**
+ * Sets a digest context to the initial state of its algorithm.
+ *
+ * @param ctx digest context, its algorithm field must be set
+ */
+static void digestReset(DigestContext* ctx) {
+    switch (ctx->algorithm) {
+    case DIGEST_MD5:
+        memset(&ctx->u.md5, 0, sizeof (MD5_CTX));
+        ctx->u.md5.A = (unsigned long)0x67452301L;
+        ctx->u.md5.B = (unsigned long)0xefcdab89L;
+        ctx->u.md5.C = (unsigned long)0x98badcfeL;
+        ctx->u.md5.D = (unsigned long)0x10325476L;
+        break;
+
+    case DIGEST_SHA1:
+        memset(&ctx->u.sha1, 0, sizeof (SHA_CTX));
+        ctx->u.sha1.h0 = (unsigned long)0x67452301L;
+        ctx->u.sha1.h1 = (unsigned long)0xefcdab89L;
+        ctx->u.sha1.h2 = (unsigned long)0x98badcfeL;
+        ctx->u.sha1.h3 = (unsigned long)0x10325476L;
+        ctx->u.sha1.h4 = (unsigned long)0xc3d2e1f0L;
+        break;
+
+    case DIGEST_SHA256:
+        SHA256_Init(&ctx->u.sha256);
+        break;
+
+    case DIGEST_SHA512:
+        SHA512_Init(&ctx->u.sha512);
+        break;
     }
+}
 
-    /* Create and initialize the mesage digest buffer */
-    for (i = 0; i < 16; i++) {
-        md[i] = 0;
+/**
+ * Allocates a digest context in its initial state.
+ * <p>
+ * Java declaration:
+ * <pre>
+ *     private static native int init0(int algorithm);
+ * </pre>
+ *
+ * @param algorithm one of the DIGEST_* identifiers
+ * @return address of the new context
+ * @exception OutOfMemoryError if the context cannot be allocated
+ */
+KNIEXPORT KNI_RETURNTYPE_INT
+Java_com_sun_midp_crypto_NativeDigestContext_init0() {
+    int algorithm = KNI_GetParameterAsInt(1);
+    DigestContext* ctx;
+
+    ctx = (DigestContext*)midpMalloc(sizeof (DigestContext));
+    if (ctx == NULL) {
+        KNI_ThrowNew(midpOutOfMemoryError, NULL);
+        KNI_ReturnInt(0);
     }
 
-    /* Do MD5 final */
-    MD5_Final(md, &c);
-
-    /* Copy the message digest into output buffer at offset outoff */
-    for (i = 0; i < 16; i++) {
-	KNI_SetRawArrayRegion(outbuf,  i+outoff, 1, (jbyte*)&(md[i]));
-    }
+    ctx->algorithm = algorithm;
+    digestReset(ctx);
+    KNI_ReturnInt((jint)ctx);
+}
 
-    /* Reset the context */
-    c.A = (unsigned long)0x67452301L;
-    c.B = (unsigned long)0xefcdab89L;
-    c.C = (unsigned long)0x98badcfeL;
-    c.D = (unsigned long)0x10325476L;
-    c.Nl= 0;
-    c.Nh = 0;
-    c.num = 0;
-    for (i = 0; i < 16; i ++) {
-        c.data[i] = 0;
+/**
+ * Allocates a copy of a digest context.
+ * <p>
+ * Java declaration:
+ * <pre>
+ *     private static native int copy0(int context);
+ * </pre>
+ *
+ * @param context address of the context to copy
+ * @return address of the new context
+ * @exception OutOfMemoryError if the context cannot be allocated
+ */
+KNIEXPORT KNI_RETURNTYPE_INT
+Java_com_sun_midp_crypto_NativeDigestContext_copy0() {
+    DigestContext* src = (DigestContext*)KNI_GetParameterAsInt(1);
+    DigestContext* ctx;
+
+    ctx = (DigestContext*)midpMalloc(sizeof (DigestContext));
+    if (ctx == NULL) {
+        KNI_ThrowNew(midpOutOfMemoryError, NULL);
+        KNI_ReturnInt(0);
     }
-        
 
-    /* Copy back the context for next use. */
-    KNI_SetRawArrayRegion(state,  0, 4, (jbyte*)&(c.A));
-    KNI_SetRawArrayRegion(state,  4, 4, (jbyte*)&(c.B));
-    KNI_SetRawArrayRegion(state,  8, 4, (jbyte*)&(c.C));
-    KNI_SetRawArrayRegion(state, 12, 4, (jbyte*)&(c.D));
-    KNI_SetRawArrayRegion(count,  0, 4, (jbyte*)&(c.Nl));
-    KNI_SetRawArrayRegion(count,  4, 4, (jbyte*)&(c.Nh));
-    KNI_SetRawArrayRegion(num,    0, 4, (jbyte*)&(c.num));
-    for (i = 0, j = 0 ; i < 16; i ++) {
-        KNI_SetRawArrayRegion(data, j, 4, (jbyte*)&(c.data[i]));
-        j += 4;
-    }
-        
-    KNI_EndHandles();
-    KNI_ReturnVoid();
+    memcpy(ctx, src, sizeof (DigestContext));
+    KNI_ReturnInt((jint)ctx);
 }
 
-
+/**
+ * Accumulates a hash of the input data. The context is updated in
+ * place; the arguments are checked by the caller.
+ * <p>
+ * Java declaration:
+ * <pre>
+ *     private static native void update0(int context, byte[] inBuf,
+ *                                        int inOff, int inLen);
+ * </pre>
+ *
+ * @param context address of the digest context
+ * @param inBuf input buffer of data to be hashed
+ * @param inOff offset within inBuf where input data begins
+ * @param inLen length (in bytes) of data to be hashed
+ */
 KNIEXPORT KNI_RETURNTYPE_VOID
-Java_com_sun_midp_crypto_MD5_nativeUpdate() {
-    unsigned long  inlen = KNI_GetParameterAsInt(3);
-    unsigned long  inoff = KNI_GetParameterAsInt(2);
-    int i, j;
-    MD5_CTX c;
-        
-    KNI_StartHandles(5);
+Java_com_sun_midp_crypto_NativeDigestContext_update0() {
+    DigestContext* ctx = (DigestContext*)KNI_GetParameterAsInt(1);
+    unsigned long inoff = KNI_GetParameterAsInt(3);
+    unsigned long inlen = KNI_GetParameterAsInt(4);
+    unsigned char* data;
 
-    KNI_DeclareHandle(data);
-    KNI_DeclareHandle(count);
-    KNI_DeclareHandle(num);
-    KNI_DeclareHandle(state);
+    KNI_StartHandles(1);
     KNI_DeclareHandle(inbuf);
 
-    KNI_GetParameterAsObject(7, data);
-    KNI_GetParameterAsObject(6, count);
-    KNI_GetParameterAsObject(5, num);
-    KNI_GetParameterAsObject(4, state);
-    KNI_GetParameterAsObject(1, inbuf);
+    KNI_GetParameterAsObject(2, inbuf);
 
-    /* Copy the context in */
-    KNI_GetRawArrayRegion(state,  0, 4, (jbyte*)&(c.A));
-    KNI_GetRawArrayRegion(state,  4, 4, (jbyte*)&(c.B));
-    KNI_GetRawArrayRegion(state,  8, 4, (jbyte*)&(c.C));
-    KNI_GetRawArrayRegion(state, 12, 4, (jbyte*)&(c.D));
-    KNI_GetRawArrayRegion(count,  0, 4, (jbyte*)&(c.Nl));
-    KNI_GetRawArrayRegion(count,  4, 4, (jbyte*)&(c.Nh));
-    KNI_GetRawArrayRegion(num,    0, 4, (jbyte*)&(c.num));
-    for (i = 0, j = 0 ; i < 16; i ++) {
-        KNI_GetRawArrayRegion(data, j, 4, (jbyte*)&(c.data[i]));
-        j += 4;
-    }
-        
-    /* Do MD5 Update */
     SNI_BEGIN_RAW_POINTERS;
 
-    MD5_Update(&c, (unsigned char*)&(JavaByteArray(inbuf)[inoff]), inlen);
+    data = (unsigned char*)&(JavaByteArray(inbuf)[inoff]);
 
-    SNI_END_RAW_POINTERS;
+    switch (ctx->algorithm) {
+    case DIGEST_MD5:
+        MD5_Update(&ctx->u.md5, data, inlen);
+        break;
 
-    /* Copy back the context for next use. */
-    KNI_SetRawArrayRegion(state,  0, 4, (jbyte*)&(c.A));
-    KNI_SetRawArrayRegion(state,  4, 4, (jbyte*)&(c.B));
-    KNI_SetRawArrayRegion(state,  8, 4, (jbyte*)&(c.C));
-    KNI_SetRawArrayRegion(state, 12, 4, (jbyte*)&(c.D));
-    KNI_SetRawArrayRegion(count,  0, 4, (jbyte*)&(c.Nl));
-    KNI_SetRawArrayRegion(count,  4, 4, (jbyte*)&(c.Nh));
-    KNI_SetRawArrayRegion(num,    0, 4, (jbyte*)&(c.num));
-    for (i = 0, j = 0 ; i < 16; i ++) {
-        KNI_SetRawArrayRegion(data, j, 4, (jbyte*)&(c.data[i]));
-        j += 4;
+    case DIGEST_SHA1:
+        SHA1_Update(&ctx->u.sha1, data, inlen);
+        break;
+
+    case DIGEST_SHA256:
+        SHA256_Update(&ctx->u.sha256, data, inlen);
+        break;
+
+    case DIGEST_SHA512:
+        SHA512_Update(&ctx->u.sha512, data, inlen);
+        break;
     }
-        
+
+    SNI_END_RAW_POINTERS;
+
     KNI_EndHandles();
     KNI_ReturnVoid();
 }
 
+/**
+ * Completes the hash computation and resets the context. The arguments
+ * are checked by the caller.
+ * <p>
+ * Java declaration:
+ * <pre>
+ *     private static native void final0(int context, byte[] outBuf,
+ *                                       int outOff);
+ * </pre>
+ *
+ * @param context address of the digest context
+ * @param outBuf output buffer where the hash should be placed
+ * @param outOff offset within outBuf where the resulting hash begins
+ */
 KNIEXPORT KNI_RETURNTYPE_VOID
-Java_com_sun_midp_crypto_SHA_nativeFinal() {
-    unsigned long outoff = KNI_GetParameterAsInt(5);
-    unsigned long  inlen = KNI_GetParameterAsInt(3);
-    unsigned long  inoff = KNI_GetParameterAsInt(2);
-    unsigned char md[20];
-    int i, j;
-    SHA_CTX c;
-        
-    KNI_StartHandles(6);
+Java_com_sun_midp_crypto_NativeDigestContext_final0() {
+    DigestContext* ctx = (DigestContext*)KNI_GetParameterAsInt(1);
+    unsigned long outoff = KNI_GetParameterAsInt(3);
+    unsigned char* md;
 
-    KNI_DeclareHandle(data);
-    KNI_DeclareHandle(count);
-    KNI_DeclareHandle(num);
-    KNI_DeclareHandle(state);
+    KNI_StartHandles(1);
     KNI_DeclareHandle(outbuf);
-    KNI_DeclareHandle(inbuf);
 
-    KNI_GetParameterAsObject(9, data);
-    KNI_GetParameterAsObject(8, count);
-    KNI_GetParameterAsObject(7, num);
-    KNI_GetParameterAsObject(6, state);
-    KNI_GetParameterAsObject(4, outbuf);
-    KNI_GetParameterAsObject(1, inbuf);
+    KNI_GetParameterAsObject(2, outbuf);
 
-    /* Copy the context in */
-    KNI_GetRawArrayRegion(state,  0, 4, (jbyte*)&(c.h0));
-    KNI_GetRawArrayRegion(state,  4, 4, (jbyte*)&(c.h1));
-    KNI_GetRawArrayRegion(state,  8, 4, (jbyte*)&(c.h2));
-    KNI_GetRawArrayRegion(state, 12, 4, (jbyte*)&(c.h3));
-    KNI_GetRawArrayRegion(state, 16, 4, (jbyte*)&(c.h4));
-    KNI_GetRawArrayRegion(count,  0, 4, (jbyte*)&(c.Nl));
-    KNI_GetRawArrayRegion(count,  4, 4, (jbyte*)&(c.Nh));
-    KNI_GetRawArrayRegion(num,    0, 4, (jbyte*)&(c.num));
-    for (i = 0, j = 0 ; i < 16; i ++) {
-        KNI_GetRawArrayRegion(data, j, 4, (jbyte*)&(c.data[i]));
-        j += 4;
-    }
-        
-    /* Perform SHA update if necessary */
-    if (inlen != 0) {
-        /* Do SHA Update */
-        SNI_BEGIN_RAW_POINTERS;
+    SNI_BEGIN_RAW_POINTERS;
 
-        SHA1_Update(&c, (unsigned char*)&(JavaByteArray(inbuf)[inoff]), inlen);
+    md = (unsigned char*)&(JavaByteArray(outbuf)[outoff]);
 
-        SNI_END_RAW_POINTERS;
-    }
+    switch (ctx->algorithm) {
+    case DIGEST_MD5:
+        MD5_Final(md, &ctx->u.md5);
+        break;
 
-    /* Create and initialize the mesage digest buffer */
-    for (i=0; i < 20; i++) {
-        md[i] = 0;
-    }
+    case DIGEST_SHA1:
+        SHA1_Final(md, &ctx->u.sha1);
+        break;
 
-    /* Do SHA */
-    SHA1_Final(md, &c);
+    case DIGEST_SHA256:
+        SHA256_Final(md, &ctx->u.sha256);
+        break;
 
-    /* Copy message digest into output buffer at offset outoff */
-    for (i = 0; i < 20; i++) {
-        KNI_SetRawArrayRegion(outbuf, i+outoff, 1, (jbyte*)&(md[i]));
+    case DIGEST_SHA512:
+        SHA512_Final(md, &ctx->u.sha512);
+        break;
     }
 
-    /* Reset the context */
-    c.h0 = (unsigned long)0x67452301L;
-    c.h1 = (unsigned long)0xefcdab89L;
-    c.h2 = (unsigned long)0x98badcfeL;
-    c.h3 = (unsigned long)0x10325476L;
-    c.h4 = (unsigned long)0xc3d2e1f0L;
-    c.Nl = 0;
-    c.Nh = 0;
-    c.num = 0;
-        
-    /* Copy back the context for next use. */
-    KNI_SetRawArrayRegion(state,  0, 4, (jbyte*)&(c.h0));
-    KNI_SetRawArrayRegion(state,  4, 4, (jbyte*)&(c.h1));
-    KNI_SetRawArrayRegion(state,  8, 4, (jbyte*)&(c.h2));
-    KNI_SetRawArrayRegion(state, 12, 4, (jbyte*)&(c.h3));
-    KNI_SetRawArrayRegion(state, 16, 4, (jbyte*)&(c.h4));
-    KNI_SetRawArrayRegion(count,  0, 4, (jbyte*)&(c.Nl));
-    KNI_SetRawArrayRegion(count,  4, 4, (jbyte*)&(c.Nh));
-    KNI_SetRawArrayRegion(num,    0, 4, (jbyte*)&(c.num));
-    for (i = 0, j = 0 ; i < 16; i ++) {
-        KNI_SetRawArrayRegion(data, j, 4, (jbyte*)&(c.data[i]));
-        j += 4;
-    }
-        
+    SNI_END_RAW_POINTERS;
+
+    digestReset(ctx);
+
     KNI_EndHandles();
     KNI_ReturnVoid();
 }
 
 /**
- * Accumulates a hash of the input data. This method is useful when
- * the input data to be hashed is not available in one byte array. 
- * @param inBuf input buffer of data to be hashed
- * @param inOff offset within inBuf where input data begins
- * @param inLen length (in bytes) of data to be hashed
- * @param state internal hash state
- * @param num internal hash state
- * @param count internal hash state
- * @param data internal hash state
+ * Resets a digest context to its initial state.
+ * <p>
+ * Java declaration:
+ * <pre>
+ *     private static native void reset0(int context);
+ * </pre>
+ *
+ * @param context address of the digest context
  */
 KNIEXPORT KNI_RETURNTYPE_VOID
-Java_com_sun_midp_crypto_SHA_nativeUpdate() {
-    unsigned long  inlen = KNI_GetParameterAsInt(3);
-    unsigned long  inoff = KNI_GetParameterAsInt(2);
-    int i, j;
-    SHA_CTX c;
-        
-    KNI_StartHandles(5);
-
-    KNI_DeclareHandle(data);
-    KNI_DeclareHandle(count);
-    KNI_DeclareHandle(num);
-    KNI_DeclareHandle(state);
-    KNI_DeclareHandle(inbuf);
-
-    KNI_GetParameterAsObject(7, data);
-    KNI_GetParameterAsObject(6, count);
-    KNI_GetParameterAsObject(5, num);
-    KNI_GetParameterAsObject(4, state);
-    KNI_GetParameterAsObject(1, inbuf);
+Java_com_sun_midp_crypto_NativeDigestContext_reset0() {
+    digestReset((DigestContext*)KNI_GetParameterAsInt(1));
+    KNI_ReturnVoid();
+}
 
-    /* Copy the context in */
-    KNI_GetRawArrayRegion(state,  0, 4, (jbyte*)&(c.h0));
-    KNI_GetRawArrayRegion(state,  4, 4, (jbyte*)&(c.h1));
-    KNI_GetRawArrayRegion(state,  8, 4, (jbyte*)&(c.h2));
-    KNI_GetRawArrayRegion(state, 12, 4, (jbyte*)&(c.h3));
-    KNI_GetRawArrayRegion(state, 16, 4, (jbyte*)&(c.h4));
-    KNI_GetRawArrayRegion(count,  0, 4, (jbyte*)&(c.Nl));
-    KNI_GetRawArrayRegion(count,  4, 4, (jbyte*)&(c.Nh));
-    KNI_GetRawArrayRegion(num,    0, 4, (jbyte*)&(c.num));
-    for (i = 0, j = 0 ; i < 16; i ++) {
-        KNI_GetRawArrayRegion(data, j, 4, (jbyte*)&(c.data[i]));
-        j += 4;
+/**
+ * Frees the native context of a digest that is no longer referenced.
+ * <p>
+ * Java declaration:
+ * <pre>
+ *     private native void finalize();
+ * </pre>
+ */
+KNIEXPORT KNI_RETURNTYPE_VOID
+Java_com_sun_midp_crypto_NativeDigestContext_finalize() {
+    jfieldID nativePointerField;
+    DigestContext* ctx;
+
+    KNI_StartHandles(2);
+    KNI_DeclareHandle(thisObj);
+    KNI_DeclareHandle(thisClass);
+
+    KNI_GetThisPointer(thisObj);
+    KNI_GetObjectClass(thisObj, thisClass);
+    nativePointerField = KNI_GetFieldID(thisClass, "nativePointer", "I");
+    ctx = (DigestContext*)KNI_GetIntField(thisObj, nativePointerField);
+
+    if (ctx != NULL) {
+        KNI_SetIntField(thisObj, nativePointerField, 0);
+        midpFree(ctx);
     }
 
-    /* Do SHA Update */
-    SNI_BEGIN_RAW_POINTERS;
-
-    SHA1_Update(&c, (unsigned char*)&(JavaByteArray(inbuf)[inoff]), inlen);
-
-    SNI_END_RAW_POINTERS;
-
-    /* Copy Context back */
-    KNI_SetRawArrayRegion(state,  0, 4, (jbyte*)&(c.h0));
-    KNI_SetRawArrayRegion(state,  4, 4, (jbyte*)&(c.h1));
-    KNI_SetRawArrayRegion(state,  8, 4, (jbyte*)&(c.h2));
-    KNI_SetRawArrayRegion(state, 12, 4, (jbyte*)&(c.h3));
-    KNI_SetRawArrayRegion(state, 16, 4, (jbyte*)&(c.h4));
-    KNI_SetRawArrayRegion(count,  0, 4, (jbyte*)&(c.Nl));
-    KNI_SetRawArrayRegion(count,  4, 4, (jbyte*)&(c.Nh));
-    KNI_SetRawArrayRegion(num,    0, 4, (jbyte*)&(c.num));
-    for (i = 0, j = 0 ; i < 16; i ++) {
-        KNI_SetRawArrayRegion(data, j, 4, (jbyte*)&(c.data[i]));
-        j += 4;
-    }
-        
     KNI_EndHandles();
     KNI_ReturnVoid();
 }
-
@@ -45,10 +45,18 @@ extern "C" {
 #define MIDP_HASH_OUT_OF_MEM_ERROR  -2
 /* Data read error */
 #define MIDP_HASH_IO_ERROR  -3
+/* Hash value differs from the expected one */
+#define MIDP_HASH_MISMATCH  -4
 
 /* Data portion size (in bytes) for hash evaluation */
 #define HASH_CHUNK_SIZE  10240
 
+/*
+ * Preferred data portion size (in bytes) for hash evaluation of files,
+ * HASH_CHUNK_SIZE is used if there is not enough memory for it
+ */
+#define HASH_PIPELINE_SIZE  (8 * HASH_CHUNK_SIZE)
+
 /**
  * Evaluates hash value for the file.
  * Current implementation uses MD5 digest to evaluate the value,
@@ -70,6 +78,25 @@ extern "C" {
 int midp_get_file_hash(const pcsl_string* filename_str,
     unsigned char **hashValue, int *hashLen);
 
+/**
+ * Checks that the hash value of the file is equal to the expected one.
+ *
+ * Once the file has been verified, its identity (size and time of the
+ * last modification) is recorded in a file next to it, and the file is
+ * not hashed again until its identity changes.
+ *
+ * @param filename_str file name whose hash value is to be checked
+ * @param hashValue expected hash value
+ * @param hashLen length of the expected hash value
+ * @return one of the error codes:
+ * <pre>
+ *       MIDP_HASH_OK, MIDP_HASH_MISMATCH, MIDP_HASH_IO_ERROR,
+ *       MIDP_HASH_OUT_OF_MEM_ERROR
+ * </pre>
+ */
+int midp_check_file_hash(const pcsl_string* filename_str,
+    const unsigned char *hashValue, int hashLen);
+
 /**
  * Evaluates hash value for the data block.
  * Current implementation uses MD5 digest to evaluate the value,
@@ -24,12 +24,36 @@
  * information or have any questions.
  */
 
+#include <string.h>
+
 #include <MD5.h>
 #include <midpString.h>
 #include <midpMalloc.h>
 #include <midpStorage.h>
 #include <midpDataHash.h>
 
+/** Suffix of the file recording a verified hash value. (".hvc") */
+PCSL_DEFINE_STATIC_ASCII_STRING_LITERAL_START(VERIFIED_HASH_SUFFIX)
+{'.', 'h', 'v', 'c', '\0'}
+PCSL_DEFINE_STATIC_ASCII_STRING_LITERAL_END(VERIFIED_HASH_SUFFIX);
+
+/** Version of the layout of the verified hash record. */
+#define VERIFIED_HASH_VERSION 1
+
+/** Record of a file whose hash value has been verified. */
+typedef struct _verifiedhash {
+    /** Layout version, VERIFIED_HASH_VERSION. */
+    int version;
+    /** Size of the file when it was verified. */
+    long size;
+    /** Time of the last modification of the file when it was verified. */
+    long lastModified;
+    /** Length of the verified hash value. */
+    int hashLen;
+    /** The verified hash value. */
+    unsigned char hash[MD5_DIGEST_LENGTH];
+} VerifiedHash;
+
 /* Reset the context of MD5 message digest*/
 static void resetContext(MD5_CTX *c) {
     int i;
@@ -72,6 +96,7 @@ int midp_get_file_hash(const pcsl_string* filename_str,
     char *pszError;
     unsigned char *buffer;
     long bytesRead;
+    long chunkSize;
 
     *hashLen = 0;
     *hashValue = NULL;
@@ -87,7 +112,13 @@ int midp_get_file_hash(const pcsl_string* filename_str,
     do {
         resetContext(&ctx);
 
-        buffer = midpMalloc(HASH_CHUNK_SIZE);
+        /* Prefer fewer, larger reads; fall back to the small chunk. */
+        chunkSize = HASH_PIPELINE_SIZE;
+        buffer = midpMalloc(chunkSize);
+        if (buffer == NULL) {
+            chunkSize = HASH_CHUNK_SIZE;
+            buffer = midpMalloc(chunkSize);
+        }
         if (buffer == NULL) {
             status = MIDP_HASH_OUT_OF_MEM_ERROR;
             break;
@@ -97,7 +128,7 @@ int midp_get_file_hash(const pcsl_string* filename_str,
          * and update digest value for each portion. */
         do {
             bytesRead = storageRead(&pszError, handle,
-                (char*)buffer, HASH_CHUNK_SIZE);
+                (char*)buffer, chunkSize);
             if (pszError != NULL) {
                 status = MIDP_HASH_IO_ERROR;
                 break;
@@ -111,13 +142,13 @@ int midp_get_file_hash(const pcsl_string* filename_str,
             break;
 
         /* Allocate and fill result hash value */
-        *hashValue = midpMalloc(MD5_LBLOCK);
+        *hashValue = midpMalloc(MD5_DIGEST_LENGTH);
         if (*hashValue == NULL) {
             status = MIDP_HASH_OUT_OF_MEM_ERROR;
             break;
         }
         MD5_Final(*hashValue, &ctx);
-        *hashLen = MD5_LBLOCK;
+        *hashLen = MD5_DIGEST_LENGTH;
     } while(0);
 
     storageClose(&pszError, handle);
@@ -125,6 +156,182 @@ int midp_get_file_hash(const pcsl_string* filename_str,
     return status;
 }
 
+/**
+ * Gets the identity of a file: its size and the time of its last
+ * modification.
+ *
+ * @param filename_str file name
+ * @param pSize receives the size of the file
+ * @param pLastModified receives the time of the last modification
+ * @return <tt>0</tt> on success, <tt>-1</tt> if the identity is unknown
+ */
+static int getFileIdentity(const pcsl_string* filename_str,
+                           long *pSize, long *pLastModified) {
+    char *pszError = NULL;
+
+    *pSize = storage_size_of_file_by_name(&pszError, filename_str);
+    if (pszError != NULL) {
+        storageFreeError(pszError);
+        return -1;
+    }
+
+    *pLastModified = storage_get_last_modified(&pszError, filename_str);
+    if (pszError != NULL) {
+        storageFreeError(pszError);
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * Reads the verified hash record.
+ *
+ * @param record_str name of the record file
+ * @param pRecord receives the record
+ * @return <tt>0</tt> on success, <tt>-1</tt> if there is no valid record
+ */
+static int readVerifiedHash(const pcsl_string* record_str,
+                            VerifiedHash *pRecord) {
+    char *pszError = NULL;
+    int handle;
+    long bytesRead;
+
+    if (!storage_file_exists(record_str)) {
+        return -1;
+    }
+
+    handle = storage_open(&pszError, record_str, OPEN_READ);
+    if (pszError != NULL) {
+        storageFreeError(pszError);
+        return -1;
+    }
+
+    bytesRead = storageRead(&pszError, handle, (char*)pRecord,
+                            sizeof (VerifiedHash));
+    storageFreeError(pszError);
+    pszError = NULL;
+
+    storageClose(&pszError, handle);
+    storageFreeError(pszError);
+
+    if (bytesRead != (long)sizeof (VerifiedHash) ||
+            pRecord->version != VERIFIED_HASH_VERSION ||
+            pRecord->hashLen <= 0 ||
+            pRecord->hashLen > MD5_DIGEST_LENGTH) {
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * Writes the verified hash record. Failures are ignored, the file is
+ * simply hashed again next time.
+ *
+ * @param record_str name of the record file
+ * @param pRecord the record to write
+ */
+static void writeVerifiedHash(const pcsl_string* record_str,
+                              VerifiedHash *pRecord) {
+    char *pszError = NULL;
+    int handle;
+
+    handle = storage_open(&pszError, record_str, OPEN_READ_WRITE_TRUNCATE);
+    if (pszError != NULL) {
+        storageFreeError(pszError);
+        return;
+    }
+
+    storageWrite(&pszError, handle, (char*)pRecord, sizeof (VerifiedHash));
+    if (pszError != NULL) {
+        storageFreeError(pszError);
+        pszError = NULL;
+        storageClose(&pszError, handle);
+        storageFreeError(pszError);
+        pszError = NULL;
+        /* Never leave a partial record behind. */
+        storage_delete_file(&pszError, record_str);
+        storageFreeError(pszError);
+        return;
+    }
+
+    storageClose(&pszError, handle);
+    storageFreeError(pszError);
+}
+
+/**
+ * Checks that the hash value of the file is equal to the expected one.
+ *
+ * Once the file has been verified, its identity (size and time of the
+ * last modification) is recorded in a file next to it, and the file is
+ * not hashed again until its identity changes.
+ *
+ * @param filename_str file name whose hash value is to be checked
+ * @param hashValue expected hash value
+ * @param hashLen length of the expected hash value
+ * @return one of the error codes:
+ * <pre>
+ *       MIDP_HASH_OK, MIDP_HASH_MISMATCH, MIDP_HASH_IO_ERROR,
+ *       MIDP_HASH_OUT_OF_MEM_ERROR
+ * </pre>
+ */
+int midp_check_file_hash(const pcsl_string* filename_str,
+    const unsigned char *hashValue, int hashLen) {
+
+    pcsl_string record_str = PCSL_STRING_NULL;
+    VerifiedHash record;
+    unsigned char *fileHash = NULL;
+    int fileHashLen = 0;
+    long size;
+    long lastModified;
+    int knownIdentity;
+    int status;
+    char *pszError = NULL;
+
+    /* The identity is taken before hashing, so a later change is seen. */
+    knownIdentity =
+        (getFileIdentity(filename_str, &size, &lastModified) == 0) &&
+        (pcsl_string_cat(filename_str, &VERIFIED_HASH_SUFFIX,
+                         &record_str) == PCSL_STRING_OK);
+
+    if (knownIdentity && readVerifiedHash(&record_str, &record) == 0 &&
+            record.size == size && record.lastModified == lastModified &&
+            record.hashLen == hashLen &&
+            memcmp(record.hash, hashValue, hashLen) == 0) {
+        pcsl_string_free(&record_str);
+        return MIDP_HASH_OK;
+    }
+
+    status = midp_get_file_hash(filename_str, &fileHash, &fileHashLen);
+    if (status == MIDP_HASH_OK) {
+        if (fileHashLen == hashLen &&
+                memcmp(fileHash, hashValue, hashLen) == 0) {
+            if (knownIdentity && hashLen <= MD5_DIGEST_LENGTH) {
+                memset(&record, 0, sizeof (VerifiedHash));
+                record.version = VERIFIED_HASH_VERSION;
+                record.size = size;
+                record.lastModified = lastModified;
+                record.hashLen = hashLen;
+                memcpy(record.hash, hashValue, hashLen);
+                writeVerifiedHash(&record_str, &record);
+            }
+        } else {
+            status = MIDP_HASH_MISMATCH;
+            if (knownIdentity && storage_file_exists(&record_str)) {
+                /* Drop the stale record of a previous version. */
+                storage_delete_file(&pszError, &record_str);
+                storageFreeError(pszError);
+            }
+        }
+
+        midpFree(fileHash);
+    }
+
+    pcsl_string_free(&record_str);
+    return status;
+}
+
 /**
  * Evaluates hash value for the data block.
  * Current implementation uses MD5 digest to evaluate the value,
@@ -146,13 +353,13 @@ int midpGetDataHash(unsigned char *data, int dataLen,
     MD5_CTX ctx;
     *hashLen = 0;
     *hashValue = NULL;
-    *hashValue = midpMalloc(MD5_LBLOCK);
+    *hashValue = midpMalloc(MD5_DIGEST_LENGTH);
     if (*hashValue == NULL)
         return MIDP_HASH_OUT_OF_MEM_ERROR;
 
     resetContext(&ctx);
     MD5_Update(&ctx, data, dataLen);
     MD5_Final(*hashValue, &ctx);
-    *hashLen = MD5_LBLOCK;
+    *hashLen = MD5_DIGEST_LENGTH;
     return MIDP_HASH_OK;
 }